@@ -0,0 +1,35 @@
+#ifndef BENCH_CODEC_H
+#define BENCH_CODEC_H
+
+#include <stdint.h>
+
+/**
+  * @brief  Compresses PGM file with coder library.
+  * @param  inputPath Path to PGM file
+  * @param  outputPath Path to compressed file
+  * @param  modeName Name of coding mode accepted by coder
+  * @retval 0 if file was compressed successfully, 1 otherwise
+  */
+uint8_t encodeImage(const char* inputPath, const char* outputPath, const char* modeName);
+
+/**
+  * @brief  Decompresses file with decoder library.
+  * @param  inputPath Path to compressed file
+  * @param  outputPath Path to decompressed PGM file
+  * @retval 0 if file was decompressed successfully, 1 otherwise
+  */
+uint8_t decodeImage(const char* inputPath, const char* outputPath);
+
+/**
+  * @brief  Compresses batch of images into directory with coder library.
+  * @param  outputDirectory Directory of compressed files
+  * @param  inputPaths Paths to PGM files
+  * @param  numberOfInputs Number of images
+  * @param  engineName Name of I/O engine accepted by coder
+  * @param  usedEngine Pointer receiving name of I/O engine that was used
+  * @retval 0 if every image was compressed, 1 otherwise
+  */
+uint8_t encodeBatch(const char* outputDirectory, char** inputPaths, uint32_t numberOfInputs, const char* engineName,
+                    const char** usedEngine);
+
+#endif // BENCH_CODEC_H
@@ -0,0 +1,247 @@
+#include "benchCodec.h"
+#include "imageGenerator.h"
+
+#include <time.h>
+
+#define DEFAULT_REPEATS 3
+#define PATH_LENGTH 512
+// Large image sweep starts at this side and doubles it up to requested side
+#define LARGE_FIRST_SIDE 1024
+#define LARGE_BAND_ROWS 64
+
+static const char* syntheticPatterns[] = { "constant", "gradient", "checker", "skewed", "noise" };
+static const uint32_t syntheticSides[] = { 256, 512 };
+static const char* allModes[] = { "auto", "adaptive", "pair", "bitplane", "static", "periodic", "range", "stored", "runlength", "tiled" };
+static const char* ioEngines[] = { "uring", "blocking" };
+// Batch images are as large as the larger synthetic images
+#define BATCH_SIDE 512
+
+/**
+  * @brief  Returns monotonic time in seconds.
+  */
+static double now()
+{
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/**
+  * @brief  Returns size of file in bytes, or 0 if it cannot be opened.
+  */
+static long fileSize(const char* filePath)
+{
+    FILE* file = fopen(filePath, "rb");
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+/**
+  * @brief  Reads number of pixels from PGM header.
+  */
+static uint64_t pgmPixels(const char* filePath)
+{
+    char line[128];
+    unsigned width = 0, height = 0;
+    uint8_t lines = 0;
+    FILE* file = fopen(filePath, "rb");
+    if (!file) return 0;
+    while (lines < 2 && fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') continue;
+        if (lines == 1) sscanf(line, "%u %u", &width, &height);
+        lines++;
+    }
+    fclose(file);
+    return (uint64_t)width * height;
+}
+
+/**
+  * @brief  Writes square PGM with skewed distribution band by band, so images larger than
+  *         memory can be generated.
+  * @retval 0 on success, 1 if file could not be written
+  */
+static uint8_t writeLargePgm(const char* filePath, uint32_t side)
+{
+    uint8_t* band = malloc((uint64_t)side * LARGE_BAND_ROWS);
+    FILE* file = fopen(filePath, "wb");
+    uint8_t status = !band || !file;
+
+    if (!status)
+        fprintf(file, "P5\n%u %u\n255\n", side, side);
+    for (uint32_t row = 0; row < side && !status; row += LARGE_BAND_ROWS) {
+        uint32_t rows = side - row < LARGE_BAND_ROWS ? side - row : LARGE_BAND_ROWS;
+        uint64_t length = (uint64_t)side * rows;
+        status = generateImage("skewed", side, rows, 12345 + row, band) || fwrite(band, 1, length, file) != length;
+    }
+    if (file && fclose(file))
+        status = 1;
+    if (status)
+        printf("Error: Could not write %s\n", filePath);
+    free(band);
+    return status;
+}
+
+/**
+  * @brief  Compresses and decompresses one image several times and prints throughput.
+  * @retval 0 on success, 1 if any codec call failed
+  */
+static uint8_t benchImage(const char* name, const char* original, const char* workDir, const char* mode, uint32_t repeats)
+{
+    char compressed[PATH_LENGTH];
+    char decompressed[PATH_LENGTH];
+    snprintf(compressed, sizeof(compressed), "%s/bench_out.bin", workDir);
+    snprintf(decompressed, sizeof(decompressed), "%s/bench_out.pgm", workDir);
+
+    double encodeTime = 1e30, decodeTime = 1e30;
+    for (uint32_t i = 0; i < repeats; i++) {
+        double start = now();
+        if (encodeImage(original, compressed, mode)) return 1;
+        double middle = now();
+        if (decodeImage(compressed, decompressed)) return 1;
+        double end = now();
+        if (middle - start < encodeTime) encodeTime = middle - start;
+        if (end - middle < decodeTime) decodeTime = end - middle;
+    }
+
+    uint64_t pixels = pgmPixels(original);
+    double megabytes = pixels / 1e6;
+    fprintf(stderr, "%-24s %-10s %12llu %10.3f %12.2f %12.2f\n", name, mode, (unsigned long long)pixels,
+            pixels ? fileSize(compressed) * 8.0 / pixels : 0.0, megabytes / encodeTime, megabytes / decodeTime);
+    return 0;
+}
+
+/**
+  * @brief  Compresses batch of synthetic images with every I/O engine and prints number of
+  *         images compressed per second. Engine that is not available is reported with engine
+  *         used in its place.
+  * @retval 0 on success, 1 if images could not be written or compressed
+  */
+static uint8_t benchBatch(const char* workDir, uint32_t numberOfImages, uint32_t repeats)
+{
+    char** paths = calloc(numberOfImages, sizeof(char*));
+    uint8_t* pixels = malloc((uint64_t)BATCH_SIDE * BATCH_SIDE);
+    uint8_t status = !paths || !pixels;
+    uint64_t bytes = 0;
+
+    for (uint32_t i = 0; i < numberOfImages && !status; i++) {
+        paths[i] = malloc(PATH_LENGTH);
+        status = !paths[i];
+        if (status) break;
+        snprintf(paths[i], PATH_LENGTH, "%s/bench_batch_%u.pgm", workDir, i);
+        const char* pattern = syntheticPatterns[i % (sizeof(syntheticPatterns) / sizeof(syntheticPatterns[0]))];
+        status = generateImage(pattern, BATCH_SIDE, BATCH_SIDE, 12345 + i, pixels) ||
+                 writePgm(paths[i], pixels, BATCH_SIDE, BATCH_SIDE);
+        bytes += fileSize(paths[i]);
+    }
+
+    fprintf(stderr, "%-10s %-10s %8s %12s %12s\n", "engine", "used", "images", "images/s", "MB/s");
+    for (size_t e = 0; e < sizeof(ioEngines) / sizeof(ioEngines[0]) && !status; e++) {
+        const char* used = ioEngines[e];
+        double best = 1e30;
+        for (uint32_t r = 0; r < repeats && !status; r++) {
+            double start = now();
+            status = encodeBatch(workDir, paths, numberOfImages, ioEngines[e], &used);
+            double elapsed = now() - start;
+            if (elapsed < best) best = elapsed;
+        }
+        if (!status)
+            fprintf(stderr, "%-10s %-10s %8u %12.2f %12.2f\n", ioEngines[e], used, numberOfImages, numberOfImages / best,
+                    bytes / 1e6 / best);
+    }
+
+    for (uint32_t i = 0; paths && i < numberOfImages && paths[i]; i++) {
+        remove(paths[i]);
+        // Compressed file has name of image with .bin extension
+        strcpy(strrchr(paths[i], '.'), ".bin");
+        remove(paths[i]);
+        free(paths[i]);
+    }
+    free(paths);
+    free(pixels);
+    return status;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t repeats = DEFAULT_REPEATS;
+    const char* workDir = ".";
+    uint32_t largeSide = 0;
+    uint32_t batchImages = 0;
+    const char** modes = allModes;
+    size_t numberOfModes = sizeof(allModes) / sizeof(allModes[0]);
+    int firstFile = 1;
+
+    while (firstFile < argc && argv[firstFile][0] == '-') {
+        if (!strcmp(argv[firstFile], "--repeat") && firstFile + 1 < argc) {
+            repeats = strtoul(argv[firstFile + 1], NULL, 10);
+        } else if (!strcmp(argv[firstFile], "--work-dir") && firstFile + 1 < argc) {
+            workDir = argv[firstFile + 1];
+        } else if (!strcmp(argv[firstFile], "--large") && firstFile + 1 < argc) {
+            largeSide = strtoul(argv[firstFile + 1], NULL, 10);
+        } else if (!strcmp(argv[firstFile], "--batch") && firstFile + 1 < argc) {
+            batchImages = strtoul(argv[firstFile + 1], NULL, 10);
+        } else if (!strcmp(argv[firstFile], "--mode") && firstFile + 1 < argc) {
+            modes = (const char**)&argv[firstFile + 1];
+            numberOfModes = 1;
+        } else {
+            printf("Usage: %s [--repeat N] [--work-dir DIR] [--mode MODE] [--large SIDE] [--batch IMAGES] [image.pgm ...]\n", argv[0]);
+            return 1;
+        }
+        firstFile += 2;
+    }
+    if (!repeats) repeats = 1;
+    if (batchImages)
+        return benchBatch(workDir, batchImages, repeats);
+
+    // Results go to stderr so they are not mixed with codec progress messages
+    fprintf(stderr, "%-24s %-10s %12s %10s %12s %12s\n", "image", "mode", "pixels", "bits/px", "enc MB/s", "dec MB/s");
+
+    if (firstFile < argc) {
+        for (int i = firstFile; i < argc; i++) {
+            const char* name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+            for (size_t m = 0; m < numberOfModes; m++)
+                if (benchImage(name, argv[i], workDir, modes[m], repeats)) return 1;
+        }
+        return 0;
+    }
+
+    char original[PATH_LENGTH];
+    char name[64];
+    snprintf(original, sizeof(original), "%s/bench_in.pgm", workDir);
+
+    // Throughput of growing images, it should stay flat as long as memory and disk hold them
+    if (largeSide) {
+        for (uint64_t side = LARGE_FIRST_SIDE; ; side *= 2) {
+            if (side > largeSide) side = largeSide;
+            if (writeLargePgm(original, (uint32_t)side)) return 1;
+            snprintf(name, sizeof(name), "large_%llu", (unsigned long long)side);
+            for (size_t m = 0; m < numberOfModes; m++)
+                if (benchImage(name, original, workDir, modes[m], repeats)) return 1;
+            if (side == largeSide) break;
+        }
+        return 0;
+    }
+    for (size_t s = 0; s < sizeof(syntheticSides) / sizeof(syntheticSides[0]); s++) {
+        uint32_t side = syntheticSides[s];
+        uint8_t* pixels = malloc((uint64_t)side * side);
+        if (!pixels) return 1;
+        for (size_t p = 0; p < sizeof(syntheticPatterns) / sizeof(syntheticPatterns[0]); p++) {
+            if (generateImage(syntheticPatterns[p], side, side, 12345, pixels) || writePgm(original, pixels, side, side)) {
+                free(pixels);
+                return 1;
+            }
+            snprintf(name, sizeof(name), "%s_%u", syntheticPatterns[p], side);
+            for (size_t m = 0; m < numberOfModes; m++) {
+                if (benchImage(name, original, workDir, modes[m], repeats)) {
+                    free(pixels);
+                    return 1;
+                }
+            }
+        }
+        free(pixels);
+    }
+    return 0;
+}
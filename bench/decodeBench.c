@@ -0,0 +1,13 @@
+#include "benchCodec.h"
+#include "decoderOperations.h"
+#include "outputSink.h"
+
+uint8_t decodeImage(const char* inputPath, const char* outputPath)
+{
+    tree* tree = createTree(inputPath);
+    if (!tree) return 1;
+    uint8_t status = openOutputFile(tree->output, &tree->header, outputPath, preferredOutput(&tree->header, 0)) ||
+                     decodeData(tree) || finishOutput(tree->output);
+    freeTree(&tree);
+    return status;
+}
@@ -0,0 +1,26 @@
+#include "benchCodec.h"
+#include "fileOperations.h"
+#include "batchCoder.h"
+
+uint8_t encodeImage(const char* inputPath, const char* outputPath, const char* modeName)
+{
+    uint8_t mode;
+    if (parseMode(modeName, &mode)) return 1;
+    handler* handler = createHandler();
+    if (!handler) return 1;
+    handler->mode = mode;
+    uint8_t status = initialize(handler, inputPath, outputPath) || compressData(handler);
+    freeAlocatedMemory(handler);
+    free(handler);
+    return status;
+}
+
+uint8_t encodeBatch(const char* outputDirectory, char** inputPaths, uint32_t numberOfInputs, const char* engineName,
+                    const char** usedEngine)
+{
+    batchSettings settings = { .mode = MODE_AUTO, .tileSide = DEFAULT_TILE_SIDE, .scanOrder = SCAN_ROW, .bitPlaneFlags = 0, .threads = 0, .queueDepth = DEFAULT_QUEUE_DEPTH };
+    if (parseIoEngine(engineName, &settings.engine)) return 1;
+    uint8_t status = compressBatch(outputDirectory, inputPaths, numberOfInputs, &settings);
+    *usedEngine = ioEngineName(settings.engine);
+    return status;
+}
@@ -0,0 +1,75 @@
+# Compiler flags shared by every KODA target: warnings, instruction set,
+# link-time and profile-guided optimisation and reproducible output.
+
+include(CheckIPOSupported)
+
+if(KODA_LTO)
+    check_ipo_supported(RESULT KODA_IPO_SUPPORTED OUTPUT KODA_IPO_MESSAGE LANGUAGES C)
+    if(NOT KODA_IPO_SUPPORTED)
+        message(WARNING "LTO requested but not supported: ${KODA_IPO_MESSAGE}")
+    endif()
+endif()
+
+string(TOUPPER "${KODA_PGO}" KODA_PGO)
+if(NOT KODA_PGO MATCHES "^(OFF|GENERATE|USE)$")
+    message(FATAL_ERROR "KODA_PGO must be OFF, GENERATE or USE, got '${KODA_PGO}'")
+endif()
+if(NOT KODA_PGO STREQUAL "OFF" AND NOT CMAKE_C_COMPILER_ID STREQUAL "GNU")
+    message(FATAL_ERROR "KODA_PGO is only implemented for GCC")
+endif()
+
+if(KODA_FUZZ AND NOT CMAKE_C_COMPILER_ID MATCHES "Clang")
+    message(FATAL_ERROR "KODA_FUZZ needs Clang with libFuzzer")
+endif()
+
+# Static archives without timestamps or uids
+set(CMAKE_C_ARCHIVE_CREATE "<CMAKE_AR> qcD <TARGET> <LINK_FLAGS> <OBJECTS>")
+set(CMAKE_C_ARCHIVE_APPEND "<CMAKE_AR> qD <TARGET> <LINK_FLAGS> <OBJECTS>")
+set(CMAKE_C_ARCHIVE_FINISH "<CMAKE_RANLIB> -D <TARGET>")
+
+function(koda_target_options target)
+    if(MSVC)
+        target_compile_options(${target} PRIVATE /W3)
+        target_compile_definitions(${target} PRIVATE _CRT_SECURE_NO_WARNINGS)
+        return()
+    endif()
+
+    target_compile_options(${target} PRIVATE -Wall)
+
+    if(KODA_MARCH)
+        target_compile_options(${target} PRIVATE -march=${KODA_MARCH})
+    endif()
+    if(KODA_MTUNE)
+        target_compile_options(${target} PRIVATE -mtune=${KODA_MTUNE})
+    endif()
+
+    # Build paths must not leak into binaries, so the same sources give the same output
+    target_compile_options(${target} PRIVATE
+        -ffile-prefix-map=${PROJECT_SOURCE_DIR}=.
+        -ffile-prefix-map=${PROJECT_BINARY_DIR}=build)
+    if(NOT APPLE)
+        target_link_options(${target} PRIVATE -Wl,--build-id=sha1)
+    endif()
+
+    # Libraries are instrumented too, so fuzzer sees coverage of decoder and sanitizers check it
+    if(KODA_SANITIZE)
+        target_compile_options(${target} PRIVATE -fsanitize=${KODA_SANITIZE} -fno-omit-frame-pointer)
+        target_link_options(${target} PRIVATE -fsanitize=${KODA_SANITIZE})
+    endif()
+    if(KODA_FUZZ)
+        target_compile_options(${target} PRIVATE -fsanitize=fuzzer-no-link)
+    endif()
+
+    if(KODA_LTO AND KODA_IPO_SUPPORTED)
+        set_property(TARGET ${target} PROPERTY INTERPROCEDURAL_OPTIMIZATION ON)
+    endif()
+
+    # Profiles are written next to object files, so GENERATE and USE must share a build directory
+    if(KODA_PGO STREQUAL "GENERATE")
+        target_compile_options(${target} PRIVATE -fprofile-generate -fprofile-update=atomic)
+        target_link_options(${target} PRIVATE -fprofile-generate)
+    elseif(KODA_PGO STREQUAL "USE")
+        target_compile_options(${target} PRIVATE -fprofile-use -fprofile-partial-training -fprofile-correction -Wno-missing-profile)
+        target_link_options(${target} PRIVATE -fprofile-use)
+    endif()
+endfunction()
@@ -0,0 +1,564 @@
+// Memory streams, file locks and fseeko() are POSIX, images are compressed through temporary
+// file and archive is positioned with fseek() elsewhere
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+#define KODA_ARCHIVE_STREAMS
+#endif
+#include "archiveWriter.h"
+#include "fileOperations.h"
+#ifdef KODA_ARCHIVE_STREAMS
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+#else
+#define fseeko fseek
+#define ftello ftell
+typedef long off_t;
+#endif
+
+// Compressed file of image is written next to archive where memory streams are missing
+#define ARCHIVE_PART_EXTENSION ".part"
+#define ARCHIVE_FIRST_SLOTS 16
+
+/**
+ * @brief:  Entry of archive directory held in memory while appending.
+ * @nameHash: Hash of name.
+ * @offset: Offset of compressed file in archive.
+ * @length: Length of compressed file.
+ * @checksum: Hash of compressed file.
+ * @name: Allocated name, not terminated.
+ * @nameLength: Length of name.
+ * @channels: Number of channels of image.
+ * @mode: Coding mode from header of compressed file.
+ * @width: Width of image.
+ * @height: Height of image.
+ * @maxGreyLevel: Maximum grey level of image.
+ */
+typedef struct archiveEntry {
+    uint64_t nameHash;
+    uint64_t offset;
+    uint64_t length;
+    uint64_t checksum;
+    char* name;
+    uint16_t nameLength;
+    uint8_t channels;
+    uint8_t mode;
+    uint32_t width;
+    uint32_t height;
+    uint16_t maxGreyLevel;
+} archiveEntry;
+
+/**
+ * @brief:  Archive opened for appending.
+ * @file: Archive file opened for reading and appending, locked where locks are available.
+ * @end: Length of archive, offset of next compressed file.
+ * @entries: Entries of directory, old ones followed by appended ones.
+ * @numberOfEntries: Number of entries.
+ * @capacity: Number of entries memory is allocated for.
+ * @slots: Hash table of names, number of entry plus 1 in each used slot.
+ * @payloadSlots: Hash table of checksums of compressed files with as many slots as table of
+ *                names, entries are added to it when they are appended.
+ * @numberOfSlots: Number of slots, power of two.
+ */
+typedef struct archive {
+    FILE* file;
+    uint64_t end;
+    archiveEntry* entries;
+    uint32_t numberOfEntries;
+    uint32_t capacity;
+    uint32_t* slots;
+    uint32_t* payloadSlots;
+    uint32_t numberOfSlots;
+} archive;
+
+/**
+  * @brief  Stores value on given number of bytes in big-endian order.
+  * @param  destination Pointer to first byte of value
+  * @param  value Stored value
+  * @param  bytes Number of bytes used to store value
+  * @retval None
+  */
+static void storeLong(uint8_t* destination, uint64_t value, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; i++)
+        destination[i] = (uint8_t)(value >> (BITS_IN_BYTE * (bytes - 1 - i)));
+}
+
+/**
+  * @brief  Reads value stored on given number of bytes in big-endian order.
+  * @param  source Pointer to first byte of value
+  * @param  bytes Number of bytes of value
+  * @retval Read value
+  */
+static uint64_t loadLong(const uint8_t* source, uint8_t bytes)
+{
+    uint64_t value = 0;
+    for (uint8_t i = 0; i < bytes; i++)
+        value = (value << BITS_IN_BYTE) | source[i];
+    return value;
+}
+
+/**
+  * @brief  Finds slot of name: slot holding entry with this name or first empty slot after
+  *         slots of other names.
+  * @param  this Pointer to archive with at least one empty slot
+  * @param  name Name of entry
+  * @param  nameLength Length of name
+  * @param  hash Hash of name
+  * @retval Pointer to found slot
+  */
+static uint32_t* findSlot(archive* this, const char* name, uint16_t nameLength, uint64_t hash)
+{
+    uint32_t mask = this->numberOfSlots - 1;
+    for (uint32_t slot = (uint32_t)hash & mask;; slot = (slot + 1) & mask) {
+        uint32_t index = this->slots[slot];
+        if (!index) return &this->slots[slot];
+        const archiveEntry* entry = &this->entries[index - 1];
+        if (entry->nameHash == hash && entry->nameLength == nameLength && !memcmp(entry->name, name, nameLength))
+            return &this->slots[slot];
+    }
+}
+
+/**
+  * @brief  Finds first empty slot of checksum in table of compressed files.
+  * @param  this Pointer to archive with at least one empty slot
+  * @param  checksum Checksum of compressed file
+  * @retval Pointer to found slot
+  */
+static uint32_t* findPayloadSlot(archive* this, uint64_t checksum)
+{
+    uint32_t mask = this->numberOfSlots - 1;
+    uint32_t slot = (uint32_t)checksum & mask;
+    while (this->payloadSlots[slot])
+        slot = (slot + 1) & mask;
+    return &this->payloadSlots[slot];
+}
+
+/**
+  * @brief  Replaces hash tables of names and compressed files with larger ones and inserts
+  *         every entry again.
+  * @param  this Pointer to archive whose entries have different names
+  * @param  numberOfSlots New number of slots, power of two larger than twice number of entries
+  * @retval 0 on success, 1 if memory could not be allocated
+  */
+static uint8_t growSlots(archive* this, uint32_t numberOfSlots)
+{
+    uint32_t* slots = (uint32_t*)calloc(numberOfSlots, sizeof(uint32_t));
+    uint32_t* payloadSlots = (uint32_t*)calloc(numberOfSlots, sizeof(uint32_t));
+    if (!slots || !payloadSlots) {
+        printf("Error: Cannot allocate memory for archive directory\n");
+        free(slots);
+        free(payloadSlots);
+        return 1;
+    }
+    free(this->slots);
+    free(this->payloadSlots);
+    this->slots = slots;
+    this->payloadSlots = payloadSlots;
+    this->numberOfSlots = numberOfSlots;
+    for (uint32_t i = 0; i < this->numberOfEntries; i++) {
+        const archiveEntry* entry = &this->entries[i];
+        *findSlot(this, entry->name, entry->nameLength, entry->nameHash) = i + 1;
+        *findPayloadSlot(this, entry->checksum) = i + 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief  Looks for compressed file already in archive equal to given one. Candidates with
+  *         equal checksum and length are read back and compared byte by byte.
+  * @param  this Pointer to opened archive
+  * @param  data Compressed file
+  * @param  length Length of compressed file
+  * @param  checksum Checksum of compressed file
+  * @param  offset Pointer receiving offset of equal compressed file
+  * @retval 1 if equal compressed file was found, 0 otherwise
+  */
+static uint8_t findPayload(archive* this, const uint8_t* data, uint64_t length, uint64_t checksum, uint64_t* offset)
+{
+    uint32_t mask = this->numberOfSlots - 1;
+    uint8_t found = 0;
+    uint8_t* stored = NULL;
+    for (uint32_t slot = (uint32_t)checksum & mask; this->payloadSlots[slot] && !found; slot = (slot + 1) & mask) {
+        const archiveEntry* entry = &this->entries[this->payloadSlots[slot] - 1];
+        if (entry->checksum != checksum || entry->length != length) continue;
+        if (!stored) stored = (uint8_t*)malloc(length ? length : 1);
+        if (!stored) break;
+        if (fseeko(this->file, (off_t)entry->offset, SEEK_SET) || fread(stored, 1, length, this->file) != length) break;
+        found = !memcmp(stored, data, length);
+        if (found) *offset = entry->offset;
+    }
+    free(stored);
+    // Stream switching from reading to writing must be positioned first
+    if (fseeko(this->file, 0, SEEK_END)) return 0;
+    return found;
+}
+
+/**
+  * @brief  Adds entry to directory, replacing entry of the same name. Name of replaced entry
+  *         is freed, archive takes over name of added entry. Replacing entry keeps slot of
+  *         replaced compressed file, so it may not be found by checksum until tables grow.
+  * @param  this Pointer to archive
+  * @param  entry Pointer to filled entry
+  * @retval 0 on success, 1 if memory could not be allocated
+  */
+static uint8_t addEntry(archive* this, const archiveEntry* entry)
+{
+    uint32_t* slot = findSlot(this, entry->name, entry->nameLength, entry->nameHash);
+    if (*slot) {
+        free(this->entries[*slot - 1].name);
+        this->entries[*slot - 1] = *entry;
+        return 0;
+    }
+    if ((uint64_t)(this->numberOfEntries + 1) * 2 > this->numberOfSlots) {
+        if (this->numberOfSlots > UINT32_MAX / 2) {
+            printf("Error: Archive has too many entries\n");
+            return 1;
+        }
+        if (growSlots(this, this->numberOfSlots * 2)) return 1;
+        slot = findSlot(this, entry->name, entry->nameLength, entry->nameHash);
+    }
+    if (this->numberOfEntries == this->capacity) {
+        uint32_t capacity = this->capacity ? this->capacity * 2 : ARCHIVE_FIRST_SLOTS;
+        archiveEntry* entries = (archiveEntry*)realloc(this->entries, capacity * sizeof(archiveEntry));
+        if (!entries) {
+            printf("Error: Cannot allocate memory for archive directory\n");
+            return 1;
+        }
+        this->entries = entries;
+        this->capacity = capacity;
+    }
+    this->entries[this->numberOfEntries++] = *entry;
+    *slot = this->numberOfEntries;
+    *findPayloadSlot(this, entry->checksum) = this->numberOfEntries;
+    return 0;
+}
+
+/**
+  * @brief  Reads entries of directory named by trailer at the end of archive.
+  * @param  this Pointer to archive with opened file of given length
+  * @param  length Length of archive, at least length of trailer
+  * @retval 0 if directory is valid and was read, 1 otherwise
+  */
+static uint8_t readDirectory(archive* this, uint64_t length)
+{
+    uint8_t trailer[ARCHIVE_TRAILER_LENGTH];
+    const uint8_t magic[] = ARCHIVE_MAGIC;
+    if (fseeko(this->file, (off_t)(length - ARCHIVE_TRAILER_LENGTH), SEEK_SET) ||
+        fread(trailer, 1, ARCHIVE_TRAILER_LENGTH, this->file) != ARCHIVE_TRAILER_LENGTH ||
+        memcmp(trailer, magic, sizeof(magic)) || trailer[4] != ARCHIVE_VERSION) {
+        printf("Error: File is not archive or its last append was not finished\n");
+        return 1;
+    }
+    uint64_t directoryOffset = loadLong(&trailer[8], 8);
+    uint32_t numberOfEntries = (uint32_t)loadLong(&trailer[16], 4);
+    uint32_t numberOfSlots = (uint32_t)loadLong(&trailer[20], 4);
+    uint64_t directoryLength = length - ARCHIVE_TRAILER_LENGTH - directoryOffset;
+    uint64_t namesOffset = (uint64_t)numberOfSlots * ARCHIVE_SLOT_LENGTH + (uint64_t)numberOfEntries * ARCHIVE_ENTRY_LENGTH;
+    if (directoryOffset > length - ARCHIVE_TRAILER_LENGTH || namesOffset > directoryLength ||
+        numberOfSlots < 2 * (uint64_t)numberOfEntries || (numberOfSlots & (numberOfSlots - 1))) {
+        printf("Error: Archive directory is damaged\n");
+        return 1;
+    }
+    uint8_t* directory = (uint8_t*)malloc(directoryLength ? directoryLength : 1);
+    if (!directory) {
+        printf("Error: Cannot allocate memory for archive directory\n");
+        return 1;
+    }
+    uint8_t status = fseeko(this->file, (off_t)directoryOffset, SEEK_SET) ||
+                     fread(directory, 1, directoryLength, this->file) != directoryLength ||
+                     archiveHash(directory, directoryLength) != loadLong(&trailer[24], 8);
+    if (status)
+        printf("Error: Archive directory is damaged\n");
+    status = status || growSlots(this, numberOfSlots);
+
+    for (uint32_t i = 0; i < numberOfEntries && !status; i++) {
+        const uint8_t* stored = &directory[(uint64_t)numberOfSlots * ARCHIVE_SLOT_LENGTH + (uint64_t)i * ARCHIVE_ENTRY_LENGTH];
+        archiveEntry entry;
+        entry.nameHash = loadLong(stored, 8);
+        entry.offset = loadLong(&stored[8], 8);
+        entry.length = loadLong(&stored[16], 8);
+        entry.checksum = loadLong(&stored[24], 8);
+        uint64_t nameOffset = namesOffset + loadLong(&stored[32], 4);
+        entry.nameLength = (uint16_t)loadLong(&stored[36], 2);
+        entry.channels = stored[38];
+        entry.mode = stored[39];
+        entry.width = (uint32_t)loadLong(&stored[40], 4);
+        entry.height = (uint32_t)loadLong(&stored[44], 4);
+        entry.maxGreyLevel = (uint16_t)loadLong(&stored[48], 2);
+        entry.name = nameOffset + entry.nameLength <= directoryLength ? (char*)malloc(entry.nameLength + 1) : NULL;
+        if (!entry.name) {
+            printf("Error: Archive directory is damaged\n");
+            status = 1;
+            break;
+        }
+        memcpy(entry.name, &directory[nameOffset], entry.nameLength);
+        status = addEntry(this, &entry);
+        if (status) free(entry.name);
+    }
+    free(directory);
+    return status;
+}
+
+/**
+  * @brief  Opens archive for appending, creating empty one when it does not exist, locks it
+  *         against other writers and readers and reads its directory.
+  * @param  this Pointer to zeroed archive
+  * @param  archivePath Path to archive
+  * @retval 0 if archive was opened, 1 otherwise
+  */
+static uint8_t openArchive(archive* this, const char* archivePath)
+{
+    // Append mode never truncates archive and writes at its end wherever reading left position
+    this->file = fopen(archivePath, "a+b");
+    if (!this->file) {
+        printf("Error: Could not open archive %s\n", archivePath);
+        return 1;
+    }
+#ifdef KODA_ARCHIVE_STREAMS
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if (fcntl(fileno(this->file), F_SETLKW, &lock)) {
+        printf("Error: Could not lock archive %s\n", archivePath);
+        return 1;
+    }
+#endif
+    if (fseeko(this->file, 0, SEEK_END)) return 1;
+    off_t length = ftello(this->file);
+    if (length < 0) return 1;
+    this->end = (uint64_t)length;
+    if (!this->end)
+        return growSlots(this, ARCHIVE_FIRST_SLOTS);
+    if (this->end < ARCHIVE_TRAILER_LENGTH) {
+        printf("Error: File is not archive or its last append was not finished\n");
+        return 1;
+    }
+    // Stream switching from reading to writing must be positioned first
+    return readDirectory(this, this->end) || fseeko(this->file, 0, SEEK_END);
+}
+
+/**
+  * @brief  Compresses image with coder settings into memory.
+  * @param  coder Pointer to handler, reset for next image afterwards
+  * @param  settings Pointer to settings of compression
+  * @param  inputPath Path to image
+  * @param  archivePath Path to archive, temporary file is created next to it where needed
+  * @param  data Pointer receiving allocated compressed file
+  * @param  length Pointer receiving length of compressed file
+  * @retval 0 if image was compressed, 1 otherwise
+  */
+static uint8_t compressImage(handler* coder, const batchSettings* settings, const char* inputPath, const char* archivePath,
+                             uint8_t** data, uint64_t* length)
+{
+    coder->mode = settings->mode;
+    coder->tileSide = settings->tileSide;
+    coder->records.scanOrder = settings->scanOrder;
+    coder->bitPlaneFlags = settings->bitPlaneFlags;
+#ifdef KODA_ARCHIVE_STREAMS
+    char* buffer = NULL;
+    size_t size = 0;
+    coder->compressedFile = open_memstream(&buffer, &size);
+    uint8_t status = !coder->compressedFile || initialize(coder, inputPath, NULL) || compressData(coder);
+    resetHandler(coder);
+    if (status) {
+        free(buffer);
+        return 1;
+    }
+    *data = (uint8_t*)buffer;
+    *length = size;
+    return 0;
+#else
+    size_t pathLength = strlen(archivePath) + sizeof(ARCHIVE_PART_EXTENSION);
+    char* partPath = (char*)malloc(pathLength);
+    if (!partPath) return 1;
+    snprintf(partPath, pathLength, "%s%s", archivePath, ARCHIVE_PART_EXTENSION);
+    uint8_t status = initialize(coder, inputPath, partPath) || compressData(coder);
+    resetHandler(coder);
+    FILE* part = status ? NULL : fopen(partPath, "rb");
+    status = !part || fseek(part, 0, SEEK_END);
+    long size = status ? -1 : ftell(part);
+    *data = size < 0 ? NULL : (uint8_t*)malloc(size ? (size_t)size : 1);
+    status = !*data || fseek(part, 0, SEEK_SET) || fread(*data, 1, (size_t)size, part) != (size_t)size;
+    *length = (uint64_t)size;
+    if (part) fclose(part);
+    remove(partPath);
+    free(partPath);
+    if (status) {
+        free(*data);
+        *data = NULL;
+    }
+    return status;
+#endif
+}
+
+/**
+  * @brief  Appends compressed file of image to archive and adds its entry to directory.
+  *         Compressed file equal to one already in archive is not written again, entry
+  *         refers to the stored one.
+  * @param  this Pointer to opened archive
+  * @param  inputPath Path to image, its file name names entry
+  * @param  data Compressed file
+  * @param  length Length of compressed file
+  * @retval 0 if compressed file was appended, 1 otherwise
+  */
+static uint8_t appendEntry(archive* this, const char* inputPath, const uint8_t* data, uint64_t length)
+{
+    const char* name = strrchr(inputPath, '/') ? strrchr(inputPath, '/') + 1 : inputPath;
+    size_t nameLength = strlen(name);
+    if (!nameLength || nameLength > ARCHIVE_MAX_NAME_LENGTH || length < HEADER_LENGTH) {
+        printf("Error: Can not name archive entry of %s\n", inputPath);
+        return 1;
+    }
+    archiveEntry entry;
+    entry.nameLength = (uint16_t)nameLength;
+    entry.nameHash = archiveHash((const uint8_t*)name, nameLength);
+    entry.offset = this->end;
+    entry.length = length;
+    entry.checksum = archiveHash(data, length);
+    entry.mode = data[5];
+    entry.maxGreyLevel = (uint16_t)loadLong(&data[6], 2);
+    entry.width = (uint32_t)loadLong(&data[8], 4);
+    entry.height = (uint32_t)loadLong(&data[12], 4);
+    entry.channels = data[16];
+    entry.name = (char*)malloc(nameLength + 1);
+    if (!entry.name) return 1;
+    memcpy(entry.name, name, nameLength);
+
+    if (!findPayload(this, data, length, entry.checksum, &entry.offset)) {
+        if (fwrite(data, 1, length, this->file) != length) {
+            printf("Error: Cannot write to archive\n");
+            free(entry.name);
+            return 1;
+        }
+        this->end += length;
+    }
+    if (addEntry(this, &entry)) {
+        free(entry.name);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief  Appends directory of all entries and trailer pointing to it.
+  * @param  this Pointer to opened archive
+  * @retval 0 if directory was written, 1 otherwise
+  */
+static uint8_t writeDirectory(archive* this)
+{
+    uint64_t namesOffset = (uint64_t)this->numberOfSlots * ARCHIVE_SLOT_LENGTH + (uint64_t)this->numberOfEntries * ARCHIVE_ENTRY_LENGTH;
+    uint64_t namesLength = 0;
+    for (uint32_t i = 0; i < this->numberOfEntries; i++)
+        namesLength += this->entries[i].nameLength;
+    if (namesLength > UINT32_MAX) {
+        printf("Error: Names of archive entries are too long\n");
+        return 1;
+    }
+    uint64_t directoryLength = namesOffset + namesLength;
+    uint8_t* directory = (uint8_t*)malloc(directoryLength);
+    if (!directory) {
+        printf("Error: Cannot allocate memory for archive directory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < this->numberOfSlots; i++)
+        storeLong(&directory[(uint64_t)i * ARCHIVE_SLOT_LENGTH], this->slots[i], ARCHIVE_SLOT_LENGTH);
+    uint64_t nameOffset = 0;
+    for (uint32_t i = 0; i < this->numberOfEntries; i++) {
+        const archiveEntry* entry = &this->entries[i];
+        uint8_t* stored = &directory[(uint64_t)this->numberOfSlots * ARCHIVE_SLOT_LENGTH + (uint64_t)i * ARCHIVE_ENTRY_LENGTH];
+        storeLong(stored, entry->nameHash, 8);
+        storeLong(&stored[8], entry->offset, 8);
+        storeLong(&stored[16], entry->length, 8);
+        storeLong(&stored[24], entry->checksum, 8);
+        storeLong(&stored[32], nameOffset, 4);
+        storeLong(&stored[36], entry->nameLength, 2);
+        stored[38] = entry->channels;
+        stored[39] = entry->mode;
+        storeLong(&stored[40], entry->width, 4);
+        storeLong(&stored[44], entry->height, 4);
+        storeLong(&stored[48], entry->maxGreyLevel, 2);
+        storeLong(&stored[50], 0, 2);
+        memcpy(&directory[namesOffset + nameOffset], entry->name, entry->nameLength);
+        nameOffset += entry->nameLength;
+    }
+
+    uint8_t trailer[ARCHIVE_TRAILER_LENGTH] = ARCHIVE_MAGIC;
+    trailer[4] = ARCHIVE_VERSION;
+    storeLong(&trailer[5], 0, 3);
+    storeLong(&trailer[8], this->end, 8);
+    storeLong(&trailer[16], this->numberOfEntries, 4);
+    storeLong(&trailer[20], this->numberOfSlots, 4);
+    storeLong(&trailer[24], archiveHash(directory, directoryLength), 8);
+    // Trailer goes last, readers see new directory only when it is complete
+    uint8_t status = fwrite(directory, 1, directoryLength, this->file) != directoryLength ||
+                     fwrite(trailer, 1, ARCHIVE_TRAILER_LENGTH, this->file) != ARCHIVE_TRAILER_LENGTH ||
+                     fflush(this->file);
+    if (status)
+        printf("Error: Cannot write archive directory\n");
+    free(directory);
+    return status;
+}
+
+/**
+  * @brief  Closes archive, releasing its lock, and frees its directory.
+  * @param  this Pointer to archive
+  * @retval 0 if archive file was closed, 1 otherwise
+  */
+static uint8_t closeArchive(archive* this)
+{
+    uint8_t status = this->file && fclose(this->file);
+    for (uint32_t i = 0; i < this->numberOfEntries; i++)
+        free(this->entries[i].name);
+    free(this->entries);
+    free(this->slots);
+    free(this->payloadSlots);
+    return status;
+}
+
+uint8_t appendToArchive(const char* archivePath, char** inputPaths, uint32_t numberOfInputs, const batchSettings* settings)
+{
+    // Images are compressed before archive is locked, so readers opening it wait only while
+    // new compressed files, directory and trailer are written
+    uint8_t** payloads = (uint8_t**)calloc(numberOfInputs ? numberOfInputs : 1, sizeof(uint8_t*));
+    uint64_t* lengths = (uint64_t*)calloc(numberOfInputs ? numberOfInputs : 1, sizeof(uint64_t));
+    handler* coder = payloads && lengths ? createHandler() : NULL;
+    uint8_t status = !coder;
+    for (uint32_t i = 0; i < numberOfInputs && coder; i++) {
+        if (compressImage(coder, settings, inputPaths[i], archivePath, &payloads[i], &lengths[i])) {
+            printf("Error: %s was not added to archive\n", inputPaths[i]);
+            status = 1;
+        }
+    }
+    if (coder) {
+        freeAlocatedMemory(coder);
+        free(coder);
+    }
+
+    archive this;
+    memset(&this, 0, sizeof(archive));
+    uint8_t opened = coder && !openArchive(&this, archivePath);
+    status |= coder && !opened;
+    uint64_t start = this.end;
+    uint32_t appended = 0;
+    for (uint32_t i = 0; i < numberOfInputs && opened; i++) {
+        if (!payloads[i]) continue;
+        if (appendEntry(&this, inputPaths[i], payloads[i], lengths[i])) {
+            printf("Error: %s was not added to archive\n", inputPaths[i]);
+            status = 1;
+        } else {
+            appended++;
+        }
+    }
+    // New archive gets directory even without entries, so it can be opened
+    if (opened && (appended || !start))
+        status |= writeDirectory(&this);
+    status |= closeArchive(&this);
+    for (uint32_t i = 0; payloads && i < numberOfInputs; i++)
+        free(payloads[i]);
+    free(payloads);
+    free(lengths);
+    return status;
+}
@@ -0,0 +1,42 @@
+#ifndef ARCHIVE_WRITER_H
+#define ARCHIVE_WRITER_H
+
+// Archive: compressed files one after another, then directory and trailer. Appending writes
+// new compressed files, directory and trailer after the old trailer, so bytes already in
+// archive never change and only the last trailer is valid.
+// Trailer: magic, version, three reserved bytes, offset of directory (8 bytes), number of
+// entries (4 bytes), number of slots (4 bytes) and checksum of directory (8 bytes).
+#define ARCHIVE_MAGIC { 0x8B, 'K', 'D', 'R' }
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_TRAILER_LENGTH 32
+// Directory: slots of hash table of names, each holding number of entry plus 1 or 0 when empty,
+// on 4 bytes; entries; and names. Slots are found by name hash with linear probing, there are
+// at least twice as many slots as entries and their number is power of two.
+#define ARCHIVE_SLOT_LENGTH 4
+// Entry: hash of name (8 bytes), offset (8 bytes), length (8 bytes) and checksum (8 bytes) of
+// compressed file, offset of name among names (4 bytes), length of name (2 bytes), channels,
+// mode, width (4 bytes), height (4 bytes), maximum grey level (2 bytes) and 2 reserved bytes
+#define ARCHIVE_ENTRY_LENGTH 52
+#define ARCHIVE_MAX_NAME_LENGTH UINT16_MAX
+
+#include "archiveHash.h"
+#include "batchCoder.h"
+
+/**
+  * @brief  Compresses images one by one and appends their compressed files to archive, which
+  *         is created when it does not exist. Entry is named after file name of image and
+  *         replaces earlier entry of the same name. Compressed file equal to one already in
+  *         archive is stored once, entries share it. Bytes already in archive are left intact,
+  *         so readers that opened it before keep valid view of it. Images are compressed
+  *         first and appended afterwards under file lock where POSIX locks are available,
+  *         which serializes concurrent appends and makes readers opening archive wait until
+  *         trailer matches written data.
+  * @param  archivePath Path to archive
+  * @param  inputPaths Paths to PGM or PPM images
+  * @param  numberOfInputs Number of images
+  * @param  settings Pointer to settings of compression, threads, engine and queue are unused
+  * @retval 0 if every image was appended, 1 if any of them failed
+  */
+uint8_t appendToArchive(const char* archivePath, char** inputPaths, uint32_t numberOfInputs, const batchSettings* settings);
+
+#endif // ARCHIVE_WRITER_H
@@ -0,0 +1,362 @@
+// Blocking engine needs POSIX pread() and pwrite(), io_uring is used through raw system calls
+// of Linux, so no library is needed for it
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_POSIX_IO
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define _DEFAULT_SOURCE
+#define KODA_IO_URING
+#endif
+#endif
+#endif
+#include "asyncIo.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef KODA_POSIX_IO
+#include <unistd.h>
+#endif
+#ifdef KODA_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef KODA_IO_URING
+/**
+ * @brief:  Submission and completion rings shared with kernel.
+ * @descriptor: File descriptor of ring.
+ * @submissionRing: Mapped submission ring, also holds completion ring with single mapping.
+ * @submissionLength: Length of mapped submission ring.
+ * @completionRing: Mapped completion ring.
+ * @completionLength: Length of mapped completion ring, 0 if it shares submission mapping.
+ * @entries: Mapped submission queue entries.
+ * @entriesLength: Length of mapped submission queue entries.
+ * @submissionHead, @submissionTail, @submissionMask, @submissionArray: Submission ring.
+ * @completionHead, @completionTail, @completionMask, @completions: Completion ring.
+ * @unsubmitted: Number of entries queued but not passed to kernel yet.
+ */
+typedef struct ioRing {
+    int descriptor;
+    uint8_t* submissionRing;
+    size_t submissionLength;
+    uint8_t* completionRing;
+    size_t completionLength;
+    struct io_uring_sqe* entries;
+    size_t entriesLength;
+    unsigned* submissionHead;
+    unsigned* submissionTail;
+    unsigned submissionMask;
+    unsigned* submissionArray;
+    unsigned* completionHead;
+    unsigned* completionTail;
+    unsigned completionMask;
+    struct io_uring_cqe* completions;
+    uint32_t unsubmitted;
+} ioRing;
+
+/**
+  * @brief  Queues transfer of remaining part of request, kernel gets it with next wait.
+  * @param  ring Pointer to ring
+  * @param  request Pointer to request with bytes left to transfer
+  * @retval None
+  */
+static void queueTransfer(ioRing* ring, ioRequest* request)
+{
+    uint64_t remaining = request->length - request->transferred;
+    unsigned tail = *ring->submissionTail;
+    unsigned position = tail & ring->submissionMask;
+    struct io_uring_sqe* entry = &ring->entries[position];
+
+    memset(entry, 0, sizeof(*entry));
+    entry->opcode = request->write ? IORING_OP_WRITE : IORING_OP_READ;
+    entry->fd = request->descriptor;
+    entry->addr = (uint64_t)(uintptr_t)(request->data + request->transferred);
+    entry->len = (uint32_t)(remaining < IO_MAX_TRANSFER ? remaining : IO_MAX_TRANSFER);
+    entry->off = request->offset + request->transferred;
+    entry->user_data = (uint64_t)(uintptr_t)request;
+    ring->submissionArray[position] = position;
+    __atomic_store_n(ring->submissionTail, tail + 1, __ATOMIC_RELEASE);
+    ring->unsubmitted++;
+}
+
+/**
+  * @brief  Queues request in io_uring, it is passed to kernel together with requests queued
+  *         after it when caller waits for completion.
+  * @param  my Pointer to queue with io_uring engine
+  * @param  request Pointer to request, it must stay valid until it is completed
+  * @retval 0 if request was queued, 1 if queue is full
+  */
+static uint8_t submitUring(ioQueue* my, ioRequest* request)
+{
+    if (my->pending >= my->depth) return 1;
+    request->transferred = 0;
+    request->error = 0;
+    queueTransfer(my->ring, request);
+    my->pending++;
+    return 0;
+}
+
+/**
+  * @brief  Passes queued requests to kernel and waits for next finished request. Partial
+  *         transfers are continued, so request is returned only when it is finished.
+  * @param  my Pointer to queue with io_uring engine
+  * @retval Finished request, NULL if no request is pending or waiting fails
+  */
+static ioRequest* completeUring(ioQueue* my)
+{
+    ioRing* ring = my->ring;
+    while (my->pending) {
+        unsigned head = *ring->completionHead;
+        if (head == __atomic_load_n(ring->completionTail, __ATOMIC_ACQUIRE)) {
+            long submitted = syscall(__NR_io_uring_enter, ring->descriptor, ring->unsubmitted, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+            if (submitted < 0) {
+                if (errno == EINTR) continue;
+                printf("Error: Waiting for I/O failed: %s\n", strerror(errno));
+                return NULL;
+            }
+            ring->unsubmitted -= (uint32_t)submitted;
+            continue;
+        }
+        struct io_uring_cqe* completion = &ring->completions[head & ring->completionMask];
+        ioRequest* request = (ioRequest*)(uintptr_t)completion->user_data;
+        int result = completion->res;
+        __atomic_store_n(ring->completionHead, head + 1, __ATOMIC_RELEASE);
+
+        if (result == -EINTR || result == -EAGAIN) {
+            queueTransfer(ring, request);
+            continue;
+        }
+        if (result > 0) {
+            request->transferred += (uint64_t)result;
+            if (request->transferred < request->length) {
+                queueTransfer(ring, request);
+                continue;
+            }
+        } else {
+            request->error = result ? -result : EIO;
+        }
+        my->pending--;
+        return request;
+    }
+    return NULL;
+}
+
+/**
+  * @brief  Unmaps rings and closes io_uring.
+  * @param  ring Pointer to ring, freed afterwards
+  * @retval None
+  */
+static void closeRing(ioRing* ring)
+{
+    if (ring->entries)
+        munmap(ring->entries, ring->entriesLength);
+    if (ring->completionLength)
+        munmap(ring->completionRing, ring->completionLength);
+    if (ring->submissionRing)
+        munmap(ring->submissionRing, ring->submissionLength);
+    if (ring->descriptor >= 0)
+        close(ring->descriptor);
+    free(ring);
+}
+
+/**
+  * @brief  Creates io_uring and maps its rings.
+  * @param  depth Number of entries of submission ring
+  * @retval Pointer to ring, NULL if kernel does not provide io_uring
+  */
+static ioRing* openRing(uint32_t depth)
+{
+    struct io_uring_params parameters;
+    ioRing* ring = (ioRing*)calloc(1, sizeof(ioRing));
+    if (!ring) return NULL;
+    memset(&parameters, 0, sizeof(parameters));
+    ring->descriptor = (int)syscall(__NR_io_uring_setup, depth, &parameters);
+    if (ring->descriptor < 0) {
+        free(ring);
+        return NULL;
+    }
+
+    // Kernels with single mapping hold both rings in submission ring mapping
+    ring->submissionLength = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+    size_t completionLength = parameters.cq_off.cqes + parameters.cq_entries * sizeof(struct io_uring_cqe);
+    uint8_t singleMapping = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMapping && completionLength > ring->submissionLength)
+        ring->submissionLength = completionLength;
+    void* mapping = mmap(NULL, ring->submissionLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_SQ_RING);
+    if (mapping == MAP_FAILED) {
+        closeRing(ring);
+        return NULL;
+    }
+    ring->submissionRing = (uint8_t*)mapping;
+    ring->completionRing = ring->submissionRing;
+    if (!singleMapping) {
+        mapping = mmap(NULL, completionLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_CQ_RING);
+        if (mapping == MAP_FAILED) {
+            closeRing(ring);
+            return NULL;
+        }
+        ring->completionRing = (uint8_t*)mapping;
+        ring->completionLength = completionLength;
+    }
+    ring->entriesLength = parameters.sq_entries * sizeof(struct io_uring_sqe);
+    mapping = mmap(NULL, ring->entriesLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_SQES);
+    if (mapping == MAP_FAILED) {
+        closeRing(ring);
+        return NULL;
+    }
+    ring->entries = (struct io_uring_sqe*)mapping;
+
+    ring->submissionHead = (unsigned*)(ring->submissionRing + parameters.sq_off.head);
+    ring->submissionTail = (unsigned*)(ring->submissionRing + parameters.sq_off.tail);
+    ring->submissionMask = *(unsigned*)(ring->submissionRing + parameters.sq_off.ring_mask);
+    ring->submissionArray = (unsigned*)(ring->submissionRing + parameters.sq_off.array);
+    ring->completionHead = (unsigned*)(ring->completionRing + parameters.cq_off.head);
+    ring->completionTail = (unsigned*)(ring->completionRing + parameters.cq_off.tail);
+    ring->completionMask = *(unsigned*)(ring->completionRing + parameters.cq_off.ring_mask);
+    ring->completions = (struct io_uring_cqe*)(ring->completionRing + parameters.cq_off.cqes);
+    return ring;
+}
+
+/**
+  * @brief  Checks that kernel supports reads and writes of ring, which came later than ring itself.
+  *         Kernels without probing do not support them either.
+  * @param  ring Pointer to opened ring
+  * @retval 1 if IORING_OP_READ and IORING_OP_WRITE are supported, 0 otherwise
+  */
+static uint8_t probeRing(ioRing* ring)
+{
+    const unsigned numberOfOps = IORING_OP_WRITE + 1;
+    struct io_uring_probe* probe = (struct io_uring_probe*)calloc(1, sizeof(struct io_uring_probe) + numberOfOps * sizeof(struct io_uring_probe_op));
+    if (!probe) return 0;
+    uint8_t supported = syscall(__NR_io_uring_register, ring->descriptor, IORING_REGISTER_PROBE, probe, numberOfOps) == 0 &&
+                        probe->last_op >= IORING_OP_WRITE && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+                        (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return supported;
+}
+#endif
+
+#ifdef KODA_POSIX_IO
+/**
+  * @brief  Transfers whole request with blocking I/O and keeps it for completeBlocking().
+  * @param  my Pointer to queue with blocking engine
+  * @param  request Pointer to request, it must stay valid until it is completed
+  * @retval 0 if request was finished, 1 if queue is full
+  */
+static uint8_t submitBlocking(ioQueue* my, ioRequest* request)
+{
+    if (my->pending >= my->depth) return 1;
+    request->transferred = 0;
+    request->error = 0;
+    while (request->transferred < request->length) {
+        uint64_t remaining = request->length - request->transferred;
+        size_t length = (size_t)(remaining < IO_MAX_TRANSFER ? remaining : IO_MAX_TRANSFER);
+        off_t offset = (off_t)(request->offset + request->transferred);
+        ssize_t result = request->write ? pwrite(request->descriptor, request->data + request->transferred, length, offset)
+                                        : pread(request->descriptor, request->data + request->transferred, length, offset);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            request->error = result ? errno : EIO;
+            break;
+        }
+        request->transferred += (uint64_t)result;
+    }
+    my->completed[(my->firstCompleted + my->pending) % my->depth] = request;
+    my->pending++;
+    return 0;
+}
+
+/**
+  * @brief  Returns oldest request finished by submitBlocking().
+  * @param  my Pointer to queue with blocking engine
+  * @retval Finished request, NULL if no request is pending
+  */
+static ioRequest* completeBlocking(ioQueue* my)
+{
+    if (!my->pending) return NULL;
+    ioRequest* request = my->completed[my->firstCompleted];
+    my->firstCompleted = (my->firstCompleted + 1) % my->depth;
+    my->pending--;
+    return request;
+}
+#endif
+
+ioQueue* createIoQueue(uint8_t engine, uint32_t depth)
+{
+#ifdef KODA_POSIX_IO
+    ioQueue* my = (ioQueue*)calloc(1, sizeof(ioQueue));
+    if (!my) return NULL;
+    my->depth = depth;
+#ifdef KODA_IO_URING
+    if (engine != IO_ENGINE_BLOCKING) {
+        my->ring = openRing(depth);
+        // Ring without reads and writes would fail every request with -EINVAL
+        if (my->ring && !probeRing(my->ring)) {
+            closeRing(my->ring);
+            my->ring = NULL;
+        }
+        if (my->ring) {
+            my->engine = IO_ENGINE_URING;
+            my->submit = submitUring;
+            my->complete = completeUring;
+            return my;
+        }
+    }
+#endif
+    if (engine == IO_ENGINE_URING) {
+        printf("Error: io_uring is not available\n");
+        free(my);
+        return NULL;
+    }
+    my->completed = (ioRequest**)calloc(depth, sizeof(ioRequest*));
+    if (!my->completed) {
+        free(my);
+        return NULL;
+    }
+    my->engine = IO_ENGINE_BLOCKING;
+    my->submit = submitBlocking;
+    my->complete = completeBlocking;
+    return my;
+#else
+    (void)engine;
+    (void)depth;
+    return NULL;
+#endif
+}
+
+void freeIoQueue(ioQueue** my)
+{
+    if (!*my) return;
+#ifdef KODA_IO_URING
+    if ((*my)->ring)
+        closeRing((*my)->ring);
+#endif
+    free((*my)->completed);
+    free(*my);
+    *my = NULL;
+}
+
+uint8_t parseIoEngine(const char* name, uint8_t* engine)
+{
+    if (!strcmp(name, "auto")) {
+        *engine = IO_ENGINE_AUTO;
+        return 0;
+    }
+    if (!strcmp(name, "uring")) {
+        *engine = IO_ENGINE_URING;
+        return 0;
+    }
+    if (!strcmp(name, "blocking")) {
+        *engine = IO_ENGINE_BLOCKING;
+        return 0;
+    }
+    return 1;
+}
+
+const char* ioEngineName(uint8_t engine)
+{
+    return engine == IO_ENGINE_URING ? "uring" : "blocking";
+}
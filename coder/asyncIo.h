@@ -0,0 +1,92 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+// I/O engines of batch compression, automatic engine prefers io_uring and falls back to
+// blocking I/O where it is not available
+#define IO_ENGINE_AUTO 0
+#define IO_ENGINE_URING 1
+#define IO_ENGINE_BLOCKING 2
+#define DEFAULT_QUEUE_DEPTH 32
+// Single read or write of io_uring transfers at most this many bytes, longer requests are
+// split into several transfers
+#define IO_MAX_TRANSFER (1u << 30)
+
+#include <stdint.h>
+
+/**
+ * @brief:  Read or write of whole buffer at given offset of open file.
+ * @descriptor: File descriptor.
+ * @data: Buffer read into or written from.
+ * @length: Number of bytes to transfer.
+ * @offset: Position in file of first byte.
+ * @transferred: Number of bytes transferred so far.
+ * @error: 0 on success, errno of failed transfer, or EIO if read ended at end of file.
+ * @write: 1 for write, 0 for read.
+ * @owner: Pointer of caller, e.g. to job the request belongs to.
+ */
+typedef struct ioRequest {
+    int descriptor;
+    uint8_t* data;
+    uint64_t length;
+    uint64_t offset;
+    uint64_t transferred;
+    int error;
+    uint8_t write;
+    void* owner;
+} ioRequest;
+
+/**
+ * @brief:  Queue of reads and writes in flight. Requests are completed in any order, each
+ *          one only when its whole buffer was transferred or transfer failed.
+ * @engine: IO_ENGINE_URING or IO_ENGINE_BLOCKING.
+ * @depth: Largest number of requests in flight.
+ * @pending: Number of submitted requests not returned by complete yet.
+ * @ring: State of io_uring, NULL for blocking engine.
+ * @completed: Requests finished by blocking engine, waiting to be returned by complete.
+ * @firstCompleted: Position of oldest request in completed.
+ * @submit: Function pointer for starting request, fails if depth requests are in flight.
+ * @complete: Function pointer for waiting for next finished request.
+ */
+typedef struct ioQueue {
+    uint8_t engine;
+    uint32_t depth;
+    uint32_t pending;
+    struct ioRing* ring;
+    ioRequest** completed;
+    uint32_t firstCompleted;
+    uint8_t (*submit)(struct ioQueue*, ioRequest*);
+    ioRequest* (*complete)(struct ioQueue*);
+} ioQueue;
+
+/**
+  * @brief  Creates queue with given engine. Automatic engine uses io_uring where kernel
+  *         provides it with reads and writes and blocking I/O otherwise.
+  * @param  engine IO_ENGINE_AUTO, IO_ENGINE_URING or IO_ENGINE_BLOCKING
+  * @param  depth Largest number of requests in flight, greater than 0
+  * @retval Pointer to queue, NULL if engine is not available or memory allocation fails
+  */
+ioQueue* createIoQueue(uint8_t engine, uint32_t depth);
+
+/**
+  * @brief  Frees queue, requests still in flight must be completed before.
+  * @param  my address of pointer to queue, set to NULL afterwards
+  * @retval None
+  */
+void freeIoQueue(ioQueue** my);
+
+/**
+  * @brief  Parses name of I/O engine.
+  * @param  name "auto", "uring" or "blocking"
+  * @param  engine Pointer to variable receiving engine
+  * @retval 0 if name is known, 1 otherwise
+  */
+uint8_t parseIoEngine(const char* name, uint8_t* engine);
+
+/**
+  * @brief  Returns name of I/O engine.
+  * @param  engine IO_ENGINE_URING or IO_ENGINE_BLOCKING
+  * @retval Name of engine
+  */
+const char* ioEngineName(uint8_t engine);
+
+#endif // ASYNC_IO_H
@@ -0,0 +1,348 @@
+// Batch needs POSIX files, threads and memory streams, images are compressed one by one elsewhere
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_BATCH_PIPELINE
+#endif
+#include "batchCoder.h"
+#include "fileOperations.h"
+#ifdef KODA_BATCH_PIPELINE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+  * @brief  Builds path of compressed file: output directory, name of image without extension
+  *         and BATCH_EXTENSION.
+  * @param  outputDirectory Directory of compressed files
+  * @param  inputPath Path to image
+  * @retval Allocated path, NULL if memory allocation fails
+  */
+static char* compressedPath(const char* outputDirectory, const char* inputPath)
+{
+    const char* name = strrchr(inputPath, '/') ? strrchr(inputPath, '/') + 1 : inputPath;
+    const char* extension = strrchr(name, '.');
+    size_t nameLength = extension && extension != name ? (size_t)(extension - name) : strlen(name);
+    size_t length = strlen(outputDirectory) + 1 + nameLength + sizeof(BATCH_EXTENSION);
+    char* path = (char*)malloc(length);
+    if (path)
+        snprintf(path, length, "%s/%.*s%s", outputDirectory, (int)nameLength, name, BATCH_EXTENSION);
+    return path;
+}
+
+#ifdef KODA_BATCH_PIPELINE
+/**
+ * @brief:  Single image of batch on its way from image file to compressed file.
+ * @inputPath: Path to image.
+ * @image: Contents of image file, freed when image is compressed.
+ * @compressed: Compressed file built in memory stream.
+ * @compressedLength: Length of compressed file.
+ * @request: Read of image or write of compressed file.
+ * @status: 0 while everything succeeds, 1 after error.
+ * @report: Report entry of image, NULL if report is not needed.
+ * @next: Next job of list it waits in.
+ */
+typedef struct batchJob {
+    const char* inputPath;
+    uint8_t* image;
+    char* compressed;
+    size_t compressedLength;
+    ioRequest request;
+    uint8_t status;
+    reportEntry* report;
+    struct batchJob* next;
+} batchJob;
+
+/**
+ * @brief:  State shared by calling thread and coder threads.
+ * @lock: Mutex guarding lists and stop flag.
+ * @imageRead: Signalled when job is added to read list or coder threads should stop.
+ * @imageCompressed: Signalled when job is added to compressed list.
+ * @read: Jobs with image in memory, waiting for coder thread.
+ * @compressed: Jobs compressed by coder thread, waiting for write.
+ * @stop: 1 when no more images will be read.
+ * @settings: Settings of batch.
+ */
+typedef struct batchPipeline {
+    pthread_mutex_t lock;
+    pthread_cond_t imageRead;
+    pthread_cond_t imageCompressed;
+    batchJob* read;
+    batchJob* compressed;
+    uint8_t stop;
+    const batchSettings* settings;
+} batchPipeline;
+
+/**
+  * @brief  Compresses image held in memory into memory stream with coder of thread, which is
+  *         reset for next image afterwards.
+  * @param  job Pointer to job with read image
+  * @param  settings Pointer to settings of batch
+  * @param  handler Pointer to coder of thread, NULL if it could not be created
+  * @retval 0 if image was compressed, 1 otherwise
+  */
+static uint8_t compressImage(batchJob* job, const batchSettings* settings, handler* handler)
+{
+    if (!handler) return 1;
+    handler->mode = settings->mode;
+    handler->tileSide = settings->tileSide;
+    handler->records.scanOrder = settings->scanOrder;
+    handler->bitPlaneFlags = settings->bitPlaneFlags;
+    handler->compressedFile = open_memstream(&job->compressed, &job->compressedLength);
+    uint8_t status = !handler->compressedFile || readDataFromMemory(&handler->records, job->image, job->request.length) ||
+                     initialize(handler, NULL, NULL) || compressData(handler);
+    if (job->report)
+        fillReportEntry(job->report, job->inputPath, handler, status);
+    resetHandler(handler);
+    return status;
+}
+
+/**
+  * @brief  Coder thread, compresses read images until calling thread stops batch.
+  * @param  argument Pointer to batch pipeline
+  * @retval NULL
+  */
+static void* runCoder(void* argument)
+{
+    batchPipeline* pipeline = (batchPipeline*)argument;
+    // Arena of coder is kept for every image of thread, so threads do not contend in malloc()
+    handler* handler = createHandler();
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;) {
+        while (!pipeline->read && !pipeline->stop)
+            pthread_cond_wait(&pipeline->imageRead, &pipeline->lock);
+        batchJob* job = pipeline->read;
+        if (!job) break;
+        pipeline->read = job->next;
+        pthread_mutex_unlock(&pipeline->lock);
+
+        job->status = compressImage(job, pipeline->settings, handler);
+        free(job->image);
+        job->image = NULL;
+
+        pthread_mutex_lock(&pipeline->lock);
+        job->next = pipeline->compressed;
+        pipeline->compressed = job;
+        pthread_cond_signal(&pipeline->imageCompressed);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    if (handler) {
+        freeAlocatedMemory(handler);
+        free(handler);
+    }
+    return NULL;
+}
+
+/**
+  * @brief  Opens image file and submits read of whole file.
+  * @param  queue Pointer to I/O queue with free entry
+  * @param  job Pointer to job of image
+  * @retval 0 if read was submitted, 1 otherwise
+  */
+static uint8_t submitRead(ioQueue* queue, batchJob* job)
+{
+    struct stat status;
+    job->request.descriptor = open(job->inputPath, O_RDONLY);
+    if (job->request.descriptor < 0 || fstat(job->request.descriptor, &status)) {
+        printf("Error: Could not open %s\n", job->inputPath);
+        return 1;
+    }
+    job->request.length = (uint64_t)status.st_size;
+    job->image = (uint8_t*)malloc(job->request.length ? job->request.length : 1);
+    if (!job->image) {
+        printf("Error: Cannot allocate memory for %s\n", job->inputPath);
+        return 1;
+    }
+    job->request.data = job->image;
+    job->request.offset = 0;
+    job->request.write = 0;
+    job->request.owner = job;
+    return queue->submit(queue, &job->request);
+}
+
+/**
+  * @brief  Creates compressed file of job and submits write of compressed data.
+  * @param  queue Pointer to I/O queue with free entry
+  * @param  job Pointer to compressed job
+  * @param  outputDirectory Directory of compressed files
+  * @retval 0 if write was submitted, 1 otherwise
+  */
+static uint8_t submitWrite(ioQueue* queue, batchJob* job, const char* outputDirectory)
+{
+    char* path = compressedPath(outputDirectory, job->inputPath);
+    job->request.descriptor = path ? open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    if (job->request.descriptor < 0)
+        printf("Error: Could not create compressed file for %s\n", job->inputPath);
+    free(path);
+    if (job->request.descriptor < 0) return 1;
+    job->request.data = (uint8_t*)job->compressed;
+    job->request.length = job->compressedLength;
+    job->request.offset = 0;
+    job->request.write = 1;
+    return queue->submit(queue, &job->request);
+}
+
+/**
+  * @brief  Closes file of job and frees its buffers.
+  * @param  job Pointer to job
+  * @retval 0 if job was compressed and written, 1 otherwise
+  */
+static uint8_t finishJob(batchJob* job)
+{
+    if (job->request.descriptor >= 0 && close(job->request.descriptor))
+        job->status = 1;
+    job->request.descriptor = -1;
+    // Image compressed but not written is reported as failed
+    if (job->status && job->report)
+        job->report->status = 1;
+    free(job->image);
+    free(job->compressed);
+    job->image = NULL;
+    job->compressed = NULL;
+    return job->status;
+}
+
+uint8_t compressBatch(const char* outputDirectory, char** inputPaths, uint32_t numberOfInputs, batchSettings* settings)
+{
+    ioQueue* queue = createIoQueue(settings->engine, settings->queueDepth);
+    batchJob* jobs = (batchJob*)calloc(numberOfInputs ? numberOfInputs : 1, sizeof(batchJob));
+    uint16_t threads = settings->threads;
+    if (!threads) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = processors > 0 ? (uint16_t)(processors < UINT16_MAX ? processors : UINT16_MAX) : 1;
+    }
+    pthread_t* coders = (pthread_t*)calloc(threads, sizeof(pthread_t));
+    if (!queue || !jobs || !coders) {
+        printf("Error: Cannot start batch compression\n");
+        freeIoQueue(&queue);
+        free(jobs);
+        free(coders);
+        return 1;
+    }
+    settings->engine = queue->engine;
+
+    batchPipeline pipeline = { .read = NULL, .compressed = NULL, .stop = 0, .settings = settings };
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.imageRead, NULL);
+    pthread_cond_init(&pipeline.imageCompressed, NULL);
+    uint16_t started = 0;
+    while (started < threads && !pthread_create(&coders[started], NULL, runCoder, &pipeline))
+        started++;
+
+    // Images being read, compressed or written count against queue depth, so memory holds at
+    // most queue depth images
+    uint8_t status = !started;
+    uint32_t nextInput = 0, active = 0, finished = 0, compressing = 0;
+    while (finished < numberOfInputs && started) {
+        while (nextInput < numberOfInputs && active < queue->depth) {
+            batchJob* job = &jobs[nextInput++];
+            job->inputPath = inputPaths[nextInput - 1];
+            job->report = settings->reports ? &settings->reports[nextInput - 1] : NULL;
+            job->request.descriptor = -1;
+            if (submitRead(queue, job)) {
+                status |= finishJob(job) | 1;
+                finished++;
+                continue;
+            }
+            active++;
+        }
+
+        // Compressed images are written as soon as calling thread gets to them
+        pthread_mutex_lock(&pipeline.lock);
+        while (!pipeline.compressed && !queue->pending && compressing)
+            pthread_cond_wait(&pipeline.imageCompressed, &pipeline.lock);
+        batchJob* compressed = pipeline.compressed;
+        pipeline.compressed = NULL;
+        pthread_mutex_unlock(&pipeline.lock);
+        while (compressed) {
+            batchJob* job = compressed;
+            compressed = job->next;
+            compressing--;
+            if (job->status || submitWrite(queue, job, outputDirectory)) {
+                status |= finishJob(job) | 1;
+                active--;
+                finished++;
+            }
+        }
+
+        if (!queue->pending) continue;
+        ioRequest* request = queue->complete(queue);
+        if (!request) {
+            status = 1;
+            break;
+        }
+        batchJob* job = (batchJob*)request->owner;
+        if (request->error) {
+            printf("Error: %s of %s failed: %s\n", request->write ? "Writing" : "Reading", job->inputPath, strerror(request->error));
+            job->status = 1;
+        }
+        if (request->write || job->status) {
+            status |= finishJob(job);
+            active--;
+            finished++;
+            continue;
+        }
+        // Image file is closed before its image is passed to coder thread
+        close(job->request.descriptor);
+        job->request.descriptor = -1;
+        pthread_mutex_lock(&pipeline.lock);
+        job->next = pipeline.read;
+        pipeline.read = job;
+        compressing++;
+        pthread_cond_signal(&pipeline.imageRead);
+        pthread_mutex_unlock(&pipeline.lock);
+    }
+
+    pthread_mutex_lock(&pipeline.lock);
+    pipeline.stop = 1;
+    pthread_cond_broadcast(&pipeline.imageRead);
+    pthread_mutex_unlock(&pipeline.lock);
+    for (uint16_t i = 0; i < started; i++)
+        pthread_join(coders[i], NULL);
+    // Jobs left after failed wait are released here
+    while (queue->pending && queue->complete(queue))
+        ;
+    for (uint32_t i = 0; i < numberOfInputs; i++)
+        if (jobs[i].inputPath && (jobs[i].image || jobs[i].compressed || jobs[i].request.descriptor >= 0))
+            finishJob(&jobs[i]);
+    pthread_cond_destroy(&pipeline.imageCompressed);
+    pthread_cond_destroy(&pipeline.imageRead);
+    pthread_mutex_destroy(&pipeline.lock);
+    freeIoQueue(&queue);
+    free(coders);
+    free(jobs);
+    return status;
+}
+#else
+uint8_t compressBatch(const char* outputDirectory, char** inputPaths, uint32_t numberOfInputs, batchSettings* settings)
+{
+    uint8_t status = 0;
+    settings->engine = IO_ENGINE_BLOCKING;
+    // Single coder is reset between images, so its arena is reused by all of them
+    handler* handler = createHandler();
+    for (uint32_t i = 0; i < numberOfInputs; i++) {
+        char* path = compressedPath(outputDirectory, inputPaths[i]);
+        if (handler && path) {
+            handler->mode = settings->mode;
+            handler->tileSide = settings->tileSide;
+            handler->records.scanOrder = settings->scanOrder;
+            handler->bitPlaneFlags = settings->bitPlaneFlags;
+            uint8_t imageStatus = initialize(handler, inputPaths[i], path) || compressData(handler);
+            if (settings->reports)
+                fillReportEntry(&settings->reports[i], inputPaths[i], handler, imageStatus);
+            status |= imageStatus;
+            resetHandler(handler);
+        } else {
+            status = 1;
+        }
+        free(path);
+    }
+    if (handler) {
+        freeAlocatedMemory(handler);
+        free(handler);
+    }
+    return status;
+}
+#endif
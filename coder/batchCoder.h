@@ -0,0 +1,46 @@
+#ifndef BATCH_CODER_H
+#define BATCH_CODER_H
+
+#define BATCH_EXTENSION ".bin"
+
+#include "treeOperations.h"
+#include "asyncIo.h"
+#include "compressionReport.h"
+
+/**
+ * @brief:  Settings of batch compression.
+ * @mode: Coding mode of every image, MODE_AUTO chooses it for each image.
+ * @tileSide: Side of tiles used in tiled mode.
+ * @scanOrder: Order in which samples of every block are coded.
+ * @bitPlaneFlags: Flags of blocks coded in bit-plane mode.
+ * @threads: Number of threads running coder, 0 for number of processors.
+ * @engine: I/O engine, IO_ENGINE_AUTO is replaced with engine that was used.
+ * @queueDepth: Largest number of images read, coded or written at once.
+ * @reports: Report entries filled for images in order of inputs, NULL if report is not needed.
+ */
+typedef struct batchSettings {
+    uint8_t mode;
+    uint16_t tileSide;
+    uint8_t scanOrder;
+    uint8_t bitPlaneFlags;
+    uint16_t threads;
+    uint8_t engine;
+    uint32_t queueDepth;
+    reportEntry* reports;
+} batchSettings;
+
+/**
+  * @brief  Compresses many images into given directory, every image to file named after it
+  *         with BATCH_EXTENSION instead of its extension. Calling thread keeps up to queue
+  *         depth reads and writes in flight while coder threads compress images already read
+  *         into memory, compressed files are written from memory too. Where POSIX I/O is not
+  *         available images are compressed one by one with coder file functions.
+  * @param  outputDirectory Directory of compressed files, it must exist
+  * @param  inputPaths Paths to PGM or PPM images
+  * @param  numberOfInputs Number of images
+  * @param  settings Pointer to settings, engine is replaced with engine that was used
+  * @retval 0 if every image was compressed, 1 if any of them failed
+  */
+uint8_t compressBatch(const char* outputDirectory, char** inputPaths, uint32_t numberOfInputs, batchSettings* settings);
+
+#endif // BATCH_CODER_H
@@ -0,0 +1,211 @@
+// Threads and memory streams are POSIX, planes are coded one by one into temporary files elsewhere
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_PLANE_THREADS
+#endif
+#include "bitPlanes.h"
+#include "fileOperations.h"
+#ifdef KODA_PLANE_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * @brief:  Single bit plane of block coded by its own handler.
+ * @image: Records with set window, read by every plane.
+ * @plane: Bit of samples, 0 for the least significant one.
+ * @gray: 1 to Gray-code samples before taking their bit.
+ * @numberOfBytes: Number of bytes of packed plane.
+ * @packed: Bits of plane, 8 samples per byte with first of them in the most significant bit.
+ * @coder: Handler coding packed plane with own tree and memory.
+ * @payload: Adaptive Huffman code of plane.
+ * @payloadLength: Number of bytes of payload.
+ * @status: 0 if plane was coded successfully, 1 otherwise.
+ */
+typedef struct planeWorker {
+    const records* image;
+    uint8_t plane;
+    uint8_t gray;
+    uint64_t numberOfBytes;
+    uint8_t* packed;
+    handler* coder;
+    char* payload;
+    size_t payloadLength;
+    uint8_t status;
+} planeWorker;
+
+/**
+  * @brief  Packs bit of plane of every window sample, read row by row, 8 samples per byte.
+  *         Last byte is padded with zero bits.
+  * @param  this pointer to worker with allocated packed plane
+  * @retval None
+  */
+static void packPlane(planeWorker* this)
+{
+    const records* image = this->image;
+    uint8_t* packed = this->packed;
+    uint8_t byte = 0;
+    uint8_t count = 0;
+    for (uint32_t row = image->windowOrigin[0]; row < image->windowOrigin[0] + image->windowDimension[0]; row++) {
+        for (uint32_t column = image->windowOrigin[1]; column < image->windowOrigin[1] + image->windowDimension[1]; column++) {
+            uint8_t sample = (uint8_t)readSample(image, row, column);
+            if (this->gray)
+                sample ^= sample >> 1;
+            byte = (uint8_t)(byte << 1 | ((sample >> this->plane) & 1));
+            if (++count == BITS_IN_BYTE) {
+                *packed++ = byte;
+                byte = 0;
+                count = 0;
+            }
+        }
+    }
+    if (count)
+        *packed = (uint8_t)(byte << (BITS_IN_BYTE - count));
+}
+
+/**
+  * @brief  Closes file of plane handler, leaving its contents in payload of worker.
+  * @param  this pointer to worker whose handler wrote plane
+  * @retval 0 if payload was kept, 1 on error
+  */
+static uint8_t closePayload(planeWorker* this)
+{
+    FILE* file = this->coder->compressedFile;
+    this->coder->compressedFile = NULL;
+#ifdef KODA_PLANE_THREADS
+    return fclose(file) != 0;
+#else
+    long length = ftell(file);
+    uint8_t status = length < 0 || fseek(file, 0, SEEK_SET);
+    if (!status) {
+        this->payload = (char*)malloc(length ? (size_t)length : 1);
+        this->payloadLength = (size_t)length;
+        status = !this->payload || fread(this->payload, 1, this->payloadLength, file) != this->payloadLength;
+    }
+    return (uint8_t)(fclose(file) != 0 || status);
+#endif
+}
+
+/**
+  * @brief  Packs plane of worker and codes it as single row of 8 bit samples.
+  * @param  this pointer to worker
+  * @retval 0 if plane was coded successfully, 1 otherwise
+  */
+static uint8_t codePlane(planeWorker* this)
+{
+    handler* coder = this->coder;
+    packPlane(this);
+    coder->records.matrix = &this->packed;
+    coder->records.matrixDimension[0] = 1;
+    coder->records.matrixDimension[1] = (uint32_t)this->numberOfBytes;
+    setWindow(&coder->records, 0, 0, 1, (uint32_t)this->numberOfBytes);
+#ifdef KODA_PLANE_THREADS
+    coder->compressedFile = open_memstream(&this->payload, &this->payloadLength);
+#else
+    coder->compressedFile = tmpfile();
+#endif
+    if (!coder->compressedFile) {
+        printf("Error: Cannot create buffer of bit plane\n");
+        return 1;
+    }
+    uint8_t status = resetTree(coder) || constructTree(coder);
+    return (uint8_t)(closePayload(this) || status);
+}
+
+#ifdef KODA_PLANE_THREADS
+static void* runWorker(void* argument)
+{
+    planeWorker* this = (planeWorker*)argument;
+    this->status = codePlane(this);
+    return NULL;
+}
+#endif
+
+/**
+  * @brief  Writes block header and payloads of coded planes to compressed file.
+  * @param  my A pointer to handler struct with opened compressed file
+  * @param  workers Coded planes from the most significant one
+  * @retval 0 if block was written, 1 on error
+  */
+static uint8_t writePlanes(handler* my, const planeWorker* workers)
+{
+    uint8_t header[BIT_PLANE_HEADER_LENGTH];
+    header[0] = my->bitPlaneFlags;
+    for (uint8_t i = 0; i < BIT_PLANES; i++) {
+        if (workers[i].payloadLength > UINT32_MAX) {
+            printf("Error: Bit plane is too large, use tiles\n");
+            return 1;
+        }
+        uint8_t* length = &header[1 + i * PLANE_LENGTH_BYTES];
+        for (uint8_t byte = 0; byte < PLANE_LENGTH_BYTES; byte++)
+            length[byte] = (uint8_t)(workers[i].payloadLength >> (BITS_IN_BYTE * (PLANE_LENGTH_BYTES - 1 - byte)));
+    }
+    if (fwrite(header, 1, BIT_PLANE_HEADER_LENGTH, my->compressedFile) != BIT_PLANE_HEADER_LENGTH) return 1;
+    for (uint8_t i = 0; i < BIT_PLANES; i++)
+        if (fwrite(workers[i].payload, 1, workers[i].payloadLength, my->compressedFile) != workers[i].payloadLength) return 1;
+    return 0;
+}
+
+uint8_t encodeBitPlanes(handler* my)
+{
+    const records* image = &my->records;
+    uint64_t numberOfPixels = (uint64_t)image->windowDimension[0] * image->windowDimension[1];
+    uint64_t numberOfBytes = (numberOfPixels + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    if (image->bytesPerSample > 1) {
+        printf("Error: Bit-plane mode needs 8 bit samples\n");
+        return 1;
+    }
+    if (numberOfBytes > UINT32_MAX) {
+        printf("Error: Window is too large for bit-plane mode, use tiles\n");
+        return 1;
+    }
+
+    // Every plane has own handler, so threads share neither tree nor allocator
+    planeWorker workers[BIT_PLANES];
+    uint8_t status = 0;
+    for (uint8_t i = 0; i < BIT_PLANES; i++) {
+        workers[i].image = image;
+        workers[i].plane = (uint8_t)(BIT_PLANES - 1 - i);
+        workers[i].gray = (my->bitPlaneFlags & BIT_PLANE_GRAY) != 0;
+        workers[i].numberOfBytes = numberOfBytes;
+        workers[i].packed = (uint8_t*)malloc(numberOfBytes ? (size_t)numberOfBytes : 1);
+        workers[i].coder = createHandler();
+        workers[i].payload = NULL;
+        workers[i].payloadLength = 0;
+        workers[i].status = 0;
+        status |= !workers[i].packed || !workers[i].coder;
+    }
+    if (status)
+        printf("Error: Cannot allocate memory for bit planes\n");
+
+#ifdef KODA_PLANE_THREADS
+    // First plane is coded on calling thread, the rest where thread cannot be started
+    pthread_t threads[BIT_PLANES];
+    uint8_t started[BIT_PLANES] = { 0 };
+    for (uint8_t i = 1; i < BIT_PLANES && !status; i++)
+        started[i] = !pthread_create(&threads[i], NULL, runWorker, &workers[i]);
+    for (uint8_t i = 0; i < BIT_PLANES && !status; i++)
+        if (!started[i])
+            workers[i].status = codePlane(&workers[i]);
+    for (uint8_t i = 1; i < BIT_PLANES; i++)
+        if (started[i])
+            pthread_join(threads[i], NULL);
+#else
+    for (uint8_t i = 0; i < BIT_PLANES && !status; i++)
+        workers[i].status = codePlane(&workers[i]);
+#endif
+
+    for (uint8_t i = 0; i < BIT_PLANES; i++)
+        status |= workers[i].status;
+    status = status || writePlanes(my, workers);
+    for (uint8_t i = 0; i < BIT_PLANES; i++) {
+        if (workers[i].coder) {
+            // Packed plane is not memory of plane handler
+            workers[i].coder->records.matrix = NULL;
+            freeAlocatedMemory(workers[i].coder);
+            free(workers[i].coder);
+        }
+        free(workers[i].packed);
+        free(workers[i].payload);
+    }
+    return status;
+}
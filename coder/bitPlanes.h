@@ -0,0 +1,23 @@
+#ifndef BIT_PLANES_H
+#define BIT_PLANES_H
+
+// Bit-plane block: flags, payload length of every plane from the most significant one, payloads
+#define BIT_PLANES 8
+#define BIT_PLANE_GRAY 0x01
+#define PLANE_LENGTH_BYTES 4
+#define BIT_PLANE_HEADER_LENGTH (1 + BIT_PLANES * PLANE_LENGTH_BYTES)
+
+#include "treeOperations.h"
+
+/**
+  * @brief  Compresses 8 bit records window as eight bit planes, each packed 8 samples per byte
+  *         and coded with its own adaptive Huffman model. Planes are coded on separate threads
+  *         where threads are available, each into its own memory, and written after block
+  *         header in order from the most significant one. Samples are Gray-coded first when
+  *         BIT_PLANE_GRAY is set in bitPlaneFlags of handler.
+  * @param  my A pointer to handler struct with set records window and opened compressed file.
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+uint8_t encodeBitPlanes(handler* my);
+
+#endif // BIT_PLANES_H
@@ -0,0 +1,145 @@
+#include "checkpointIndex.h"
+#include "fileOperations.h"
+
+/**
+  * @brief  Stores value on given number of bytes in big-endian order.
+  * @param  destination Pointer to first byte of value
+  * @param  value Stored value
+  * @param  bytes Number of bytes used to store value
+  * @retval None
+  */
+static void storeLong(uint8_t* destination, uint64_t value, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; i++)
+        destination[i] = (uint8_t)(value >> (BITS_IN_BYTE * (bytes - 1 - i)));
+}
+
+/**
+  * @brief  Stores varint: 7 bits per byte starting from least significant ones, highest bit
+  *         set in every byte except last.
+  * @param  destination Pointer to first byte of varint
+  * @param  value Stored value
+  * @retval Number of bytes used
+  */
+static uint32_t storeVarint(uint8_t* destination, uint64_t value)
+{
+    uint32_t length = 0;
+    while (value > 0x7F) {
+        destination[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    destination[length++] = (uint8_t)value;
+    return length;
+}
+
+uint8_t openCheckpointIndex(handler* my, const char* indexPath, uint64_t interval)
+{
+    checkpointIndex* index = (checkpointIndex*)calloc(1, sizeof(checkpointIndex));
+    if (!index) {
+        printf("Error: Failed allocating checkpoint index\n");
+        return 1;
+    }
+    index->interval = interval;
+    index->file = fopen(indexPath, "wb");
+    // Header is written again when compression finishes
+    uint8_t header[INDEX_HEADER_LENGTH] = { 0 };
+    if (!index->file || fwrite(header, 1, INDEX_HEADER_LENGTH, index->file) != INDEX_HEADER_LENGTH) {
+        printf("Error: Cannot create checkpoint index \"%s\"\n", indexPath);
+        freeCheckpointIndex(&index);
+        return 1;
+    }
+    my->index = index;
+    return 0;
+}
+
+uint64_t nextCheckpoint(const handler* my)
+{
+    uint64_t numberOfRecords = (uint64_t)my->records.windowDimension[0] * my->records.windowDimension[1];
+    uint64_t coded = numberOfRecords - my->records.remainingRecords;
+    uint64_t next = (coded / my->index->interval + 1) * my->index->interval;
+    return next < numberOfRecords ? numberOfRecords - next : 0;
+}
+
+uint8_t writeCheckpoint(handler* my)
+{
+    checkpointIndex* index = my->index;
+    uint32_t maxNumberOfNodes = 2 * my->cache.numberOfSymbols + 1;
+    if (!index->data) {
+        index->data = (uint8_t*)malloc((size_t)maxNumberOfNodes * CHECKPOINT_NODE_MAX_LENGTH);
+        index->symbols = (uint16_t*)malloc(maxNumberOfNodes * sizeof(uint16_t));
+        if (!index->data || !index->symbols) {
+            printf("Error: Failed allocating checkpoint index\n");
+            return 1;
+        }
+    }
+    // Coder tree does not hold symbols, they are found through cache
+    for (uint32_t symbol = 0; symbol < my->cache.numberOfSymbols; symbol++)
+        if (my->cache.leaves[symbol])
+            index->symbols[my->cache.leaves[symbol]->positionInTree] = (uint16_t)symbol;
+
+    uint32_t length = 0;
+    for (uint32_t i = 0; i <= my->tree.lastNode; i++) {
+        const node* _node = my->tree.nodes[i];
+        uint64_t link = _node->link0 ? 0 : CHECKPOINT_LEAF;
+        if (_node->parent) {
+            link |= (uint64_t)_node->parent->positionInTree << 2;
+            if (_node->parent->link1 == _node) link |= CHECKPOINT_LINK1;
+        }
+        length += storeVarint(&index->data[length], link);
+        length += storeVarint(&index->data[length], _node->count);
+        if (!_node->link0 && i < my->tree.lastNode) {
+            storeLong(&index->data[length], index->symbols[i], my->records.bytesPerSample);
+            length += my->records.bytesPerSample;
+        }
+    }
+
+    // Bits waiting in bit buffer follow bytes already passed to file
+    uint8_t header[CHECKPOINT_HEADER_LENGTH];
+    uint64_t numberOfRecords = (uint64_t)my->records.windowDimension[0] * my->records.windowDimension[1];
+    long writtenBytes = ftell(my->compressedFile);
+    if (writtenBytes < 0) return 1;
+    storeLong(&header[0], numberOfRecords - my->records.remainingRecords, 8);
+    storeLong(&header[8], (uint64_t)writtenBytes * BITS_IN_BYTE + BUFFER_BIT_LEN - my->bitBuffer.freeBits, 8);
+    storeLong(&header[16], my->tree.lastNode + 1, 4);
+    storeLong(&header[20], length, 4);
+    if (fwrite(header, 1, CHECKPOINT_HEADER_LENGTH, index->file) != CHECKPOINT_HEADER_LENGTH ||
+        fwrite(index->data, 1, length, index->file) != length) {
+        printf("Error: Cannot write checkpoint index\n");
+        return 1;
+    }
+    index->numberOfCheckpoints++;
+    return 0;
+}
+
+uint8_t closeCheckpointIndex(handler* my, uint64_t compressedBytes)
+{
+    const uint8_t magic[] = INDEX_MAGIC;
+    uint8_t header[INDEX_HEADER_LENGTH] = { 0 };
+    memcpy(header, magic, sizeof(magic));
+    header[4] = INDEX_VERSION;
+    header[5] = my->records.bytesPerSample;
+    storeLong(&header[8], compressedBytes, 8);
+    storeLong(&header[16], my->index->numberOfCheckpoints, 4);
+    uint8_t status = fseek(my->index->file, 0, SEEK_SET) ||
+                     fwrite(header, 1, INDEX_HEADER_LENGTH, my->index->file) != INDEX_HEADER_LENGTH;
+    status = fclose(my->index->file) || status;
+    my->index->file = NULL;
+    if (status) {
+        printf("Error: Cannot write checkpoint index\n");
+        return 1;
+    }
+    if (!my->quiet)
+        printf("Checkpoint index written: %u checkpoints\n", my->index->numberOfCheckpoints);
+    return 0;
+}
+
+void freeCheckpointIndex(checkpointIndex** my)
+{
+    if (!*my) return;
+    if ((*my)->file)
+        fclose((*my)->file);
+    free((*my)->data);
+    free((*my)->symbols);
+    free(*my);
+    *my = NULL;
+}
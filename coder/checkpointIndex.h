@@ -0,0 +1,77 @@
+#ifndef CHECKPOINT_INDEX_H
+#define CHECKPOINT_INDEX_H
+
+// Checkpoint index: magic, version, bytes per sample, two reserved bytes, length of compressed
+// file (8 bytes) and number of checkpoints (4 bytes), followed by checkpoints in order of pixels
+#define INDEX_MAGIC { 0x8B, 'K', 'D', 'X' }
+#define INDEX_VERSION 1
+#define INDEX_HEADER_LENGTH 20
+// Checkpoint: pixel (8 bytes), bit offset in compressed file (8 bytes), number of nodes
+// (4 bytes) and length of node data (4 bytes), followed by node data. Every node is varint of
+// parent position shifted by two with link1 and leaf flags, varint of count and, for leaves
+// other than NewSymbol node, symbol on bytes per sample bytes.
+#define CHECKPOINT_HEADER_LENGTH 24
+#define CHECKPOINT_NODE_MAX_LENGTH 17
+#define CHECKPOINT_LEAF 0x01
+#define CHECKPOINT_LINK1 0x02
+#define DEFAULT_CHECKPOINT_INTERVAL (1 << 20)
+
+#include "treeOperations.h"
+
+/**
+ * @brief:  Side index of adaptive stream: snapshots of tree and position in compressed file
+ *          every given number of pixels, decoder starts threads from them.
+ * @file: Index file, its header is written when compression finishes.
+ * @data: Buffer for node data of largest tree of alphabet, allocated with first checkpoint.
+ * @symbols: Symbol of leaf at every position in tree, filled for each checkpoint.
+ * @interval: Number of pixels between checkpoints.
+ * @numberOfCheckpoints: Number of written checkpoints.
+ */
+typedef struct checkpointIndex {
+    FILE* file;
+    uint8_t* data;
+    uint16_t* symbols;
+    uint64_t interval;
+    uint32_t numberOfCheckpoints;
+} checkpointIndex;
+
+/**
+  * @brief  Creates checkpoint index file written while compressing single channel adaptive
+  *         stream.
+  * @param  my A pointer to handler struct
+  * @param  indexPath Path to created index file
+  * @param  interval Number of pixels between checkpoints, greater than 0
+  * @retval 0 if index file was created, 1 otherwise
+  */
+uint8_t openCheckpointIndex(handler* my, const char* indexPath, uint64_t interval);
+
+/**
+  * @brief  Finds next checkpoint of coded block.
+  * @param  my A pointer to handler struct with open index and set records window
+  * @retval Number of remaining records at next checkpoint, 0 if no checkpoint is left
+  */
+uint64_t nextCheckpoint(const handler* my);
+
+/**
+  * @brief  Writes current tree and position in compressed file as checkpoint.
+  * @param  my A pointer to handler struct with open index
+  * @retval 0 if checkpoint was written, 1 otherwise
+  */
+uint8_t writeCheckpoint(handler* my);
+
+/**
+  * @brief  Writes index header with length of finished compressed file and closes index.
+  * @param  my A pointer to handler struct with open index
+  * @param  compressedBytes Length of compressed file
+  * @retval 0 if index was written, 1 otherwise
+  */
+uint8_t closeCheckpointIndex(handler* my, uint64_t compressedBytes);
+
+/**
+  * @brief  Frees checkpoint index, closing its file if compression did not finish.
+  * @param  my Address of pointer to index, set to NULL afterwards
+  * @retval None
+  */
+void freeCheckpointIndex(checkpointIndex** my);
+
+#endif // CHECKPOINT_INDEX_H
@@ -0,0 +1,210 @@
+#include "compressionReport.h"
+#include "fileOperations.h"
+
+/**
+ * @brief:  Measures of compression derived from sizes and time of one or more images.
+ * @samples: Number of coded samples.
+ * @originalBytes: Size of samples before compression.
+ * @compressedBytes: Size of compressed files.
+ * @entropy: First order entropy in bits per sample.
+ * @averageCodeLength: Bits of compressed files per sample.
+ * @efficiency: Entropy divided by average code length.
+ * @ratio: Size before compression divided by compressed size.
+ * @encodeSeconds: Time spent coding.
+ * @throughput: Megabytes of samples coded per second.
+ */
+typedef struct reportMetrics {
+    uint64_t samples;
+    uint64_t originalBytes;
+    uint64_t compressedBytes;
+    double entropy;
+    double averageCodeLength;
+    double efficiency;
+    double ratio;
+    double encodeSeconds;
+    double throughput;
+} reportMetrics;
+
+/**
+  * @brief  Derives metrics from summed sizes and time, every ratio with zero denominator is 0.
+  * @param  my Pointer to metrics with samples, sizes and time filled and entropy holding
+  *         total entropy in bits
+  * @retval None
+  */
+static void deriveMetrics(reportMetrics* my)
+{
+    my->entropy = my->samples ? my->entropy / my->samples : 0.0;
+    my->averageCodeLength = my->samples ? my->compressedBytes * (double)BITS_IN_BYTE / my->samples : 0.0;
+    my->efficiency = my->averageCodeLength > 0.0 ? my->entropy / my->averageCodeLength : 0.0;
+    my->ratio = my->compressedBytes ? (double)my->originalBytes / my->compressedBytes : 0.0;
+    my->throughput = my->encodeSeconds > 0.0 ? my->originalBytes / 1e6 / my->encodeSeconds : 0.0;
+}
+
+/**
+  * @brief  Computes metrics of single image.
+  * @param  my Pointer to metrics receiving values
+  * @param  entry Pointer to report entry of compressed image
+  * @retval None
+  */
+static void entryMetrics(reportMetrics* my, const reportEntry* entry)
+{
+    my->samples = entry->statistics.numberOfPixels;
+    my->originalBytes = entry->statistics.originalBytes;
+    my->compressedBytes = entry->statistics.compressedBytes;
+    my->entropy = entry->statistics.entropy * entry->statistics.numberOfPixels;
+    my->encodeSeconds = entry->statistics.encodeSeconds;
+    deriveMetrics(my);
+}
+
+/**
+  * @brief  Writes string as JSON string literal, escaping quotes, backslashes and control
+  *         characters.
+  * @param  file Report file
+  * @param  text Written string
+  * @retval None
+  */
+static void writeJsonString(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (const unsigned char* character = (const unsigned char*)text; *character; character++) {
+        if (*character == '"' || *character == '\\')
+            fprintf(file, "\\%c", *character);
+        else if (*character < 0x20)
+            fprintf(file, "\\u%04x", *character);
+        else
+            fputc(*character, file);
+    }
+    fputc('"', file);
+}
+
+/**
+  * @brief  Writes metrics as members of JSON object.
+  * @param  file Report file
+  * @param  metrics Pointer to written metrics
+  * @retval None
+  */
+static void writeJsonMetrics(FILE* file, const reportMetrics* metrics)
+{
+    fprintf(file, "\"original_bytes\": %llu, \"compressed_bytes\": %llu, \"entropy\": %.6f, "
+                  "\"average_code_length\": %.6f, \"efficiency\": %.6f, \"compression_ratio\": %.6f, "
+                  "\"encode_seconds\": %.6f, \"throughput_mb_s\": %.3f",
+            (unsigned long long)metrics->originalBytes, (unsigned long long)metrics->compressedBytes, metrics->entropy,
+            metrics->averageCodeLength, metrics->efficiency, metrics->ratio, metrics->encodeSeconds, metrics->throughput);
+}
+
+/**
+  * @brief  Writes metrics as CSV fields, each preceded by comma.
+  * @param  file Report file
+  * @param  metrics Pointer to written metrics
+  * @retval None
+  */
+static void writeCsvMetrics(FILE* file, const reportMetrics* metrics)
+{
+    fprintf(file, ",%llu,%llu,%.6f,%.6f,%.6f,%.6f,%.6f,%.3f", (unsigned long long)metrics->originalBytes,
+            (unsigned long long)metrics->compressedBytes, metrics->entropy, metrics->averageCodeLength, metrics->efficiency,
+            metrics->ratio, metrics->encodeSeconds, metrics->throughput);
+}
+
+/**
+  * @brief  Writes string as quoted CSV field, doubling quotes inside it.
+  * @param  file Report file
+  * @param  text Written string
+  * @retval None
+  */
+static void writeCsvString(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (const char* character = text; *character; character++) {
+        if (*character == '"') fputc('"', file);
+        fputc(*character, file);
+    }
+    fputc('"', file);
+}
+
+void fillReportEntry(reportEntry* my, const char* name, const handler* coder, uint8_t status)
+{
+    my->name = name;
+    my->status = status;
+    my->mode = coder->mode;
+    my->width = coder->records.matrixDimension[1];
+    my->height = coder->records.matrixDimension[0];
+    my->channels = coder->records.channels;
+    my->maxGreyLevel = coder->records.maxGreyLevel;
+    my->statistics = coder->statistics;
+}
+
+uint8_t writeReport(const char* path, const reportEntry* entries, uint32_t numberOfEntries, double wallSeconds)
+{
+    size_t length = strlen(path);
+    size_t extensionLength = strlen(REPORT_CSV_EXTENSION);
+    uint8_t csv = length >= extensionLength && !strcmp(path + length - extensionLength, REPORT_CSV_EXTENSION);
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("Error: Could not create report file %s\n", path);
+        return 1;
+    }
+
+    // Totals are summed over compressed images only, failed ones are just counted
+    reportMetrics total = { 0 };
+    uint32_t failed = 0;
+    if (csv)
+        fprintf(file, "name,status,mode,width,height,channels,max_grey_level,original_bytes,compressed_bytes,entropy,"
+                      "average_code_length,efficiency,compression_ratio,encode_seconds,throughput_mb_s,wall_seconds\n");
+    else
+        fprintf(file, "{\n  \"files\": [");
+    for (uint32_t i = 0; i < numberOfEntries; i++) {
+        const reportEntry* entry = &entries[i];
+        reportMetrics metrics = { 0 };
+        if (entry->status) {
+            failed++;
+        } else {
+            entryMetrics(&metrics, entry);
+            total.samples += metrics.samples;
+            total.originalBytes += metrics.originalBytes;
+            total.compressedBytes += metrics.compressedBytes;
+            total.entropy += entry->statistics.entropy * entry->statistics.numberOfPixels;
+            total.encodeSeconds += metrics.encodeSeconds;
+        }
+        if (csv) {
+            writeCsvString(file, entry->name ? entry->name : "");
+            if (entry->status) {
+                fprintf(file, ",failed,,,,,,,,,,,,,,\n");
+                continue;
+            }
+            fprintf(file, ",ok,%s,%u,%u,%u,%u", modeName(entry->mode), entry->width, entry->height, entry->channels,
+                    entry->maxGreyLevel);
+            writeCsvMetrics(file, &metrics);
+            fprintf(file, ",\n");
+            continue;
+        }
+        fprintf(file, "%s\n    {\"name\": ", i ? "," : "");
+        writeJsonString(file, entry->name ? entry->name : "");
+        if (entry->status) {
+            fprintf(file, ", \"status\": \"failed\"}");
+            continue;
+        }
+        fprintf(file, ", \"status\": \"ok\", \"mode\": \"%s\", \"width\": %u, \"height\": %u, \"channels\": %u, "
+                      "\"max_grey_level\": %u, ",
+                modeName(entry->mode), entry->width, entry->height, entry->channels, entry->maxGreyLevel);
+        writeJsonMetrics(file, &metrics);
+        fprintf(file, "}");
+    }
+
+    deriveMetrics(&total);
+    if (csv) {
+        fprintf(file, "\"total\",%u failed,,,,,", failed);
+        writeCsvMetrics(file, &total);
+        fprintf(file, ",%.6f\n", wallSeconds);
+    } else {
+        fprintf(file, "%s],\n  \"total\": {\"files\": %u, \"failed\": %u, ", numberOfEntries ? "\n  " : "", numberOfEntries,
+                failed);
+        writeJsonMetrics(file, &total);
+        fprintf(file, ", \"wall_seconds\": %.6f, \"wall_throughput_mb_s\": %.3f}\n}\n", wallSeconds,
+                wallSeconds > 0.0 ? total.originalBytes / 1e6 / wallSeconds : 0.0);
+    }
+    if (fclose(file)) {
+        printf("Error: Could not write report file %s\n", path);
+        return 1;
+    }
+    return 0;
+}
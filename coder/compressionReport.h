@@ -0,0 +1,54 @@
+#ifndef COMPRESSION_REPORT_H
+#define COMPRESSION_REPORT_H
+
+// Report format follows extension of report file, ".csv" gives CSV and anything else JSON
+#define REPORT_CSV_EXTENSION ".csv"
+
+#include "treeOperations.h"
+
+/**
+ * @brief:  Measurements of single compressed image, taken by coder while compressing it.
+ * @name: Path to image.
+ * @status: 0 if image was compressed, 1 otherwise.
+ * @mode: Coding mode used to compress image.
+ * @width: Number of columns of image.
+ * @height: Number of rows of image.
+ * @channels: Number of channels of image.
+ * @maxGreyLevel: Max grey level of image.
+ * @statistics: Entropy, sizes and coding time of image.
+ */
+typedef struct reportEntry {
+    const char* name;
+    uint8_t status;
+    uint8_t mode;
+    uint32_t width;
+    uint32_t height;
+    uint8_t channels;
+    uint16_t maxGreyLevel;
+    imageStatistics statistics;
+} reportEntry;
+
+/**
+  * @brief  Fills report entry with measurements of handler that compressed image.
+  * @param  my Pointer to report entry
+  * @param  name Path to image
+  * @param  coder Pointer to handler after compression
+  * @param  status 0 if image was compressed, 1 otherwise
+  * @retval None
+  */
+void fillReportEntry(reportEntry* my, const char* name, const handler* coder, uint8_t status);
+
+/**
+  * @brief  Writes JSON or CSV report with entropy, average code length, efficiency, compression
+  *         ratio, coding time and throughput of every image and of all compressed images
+  *         together. Totals are computed from sizes and times summed over images, entropy is
+  *         averaged with weight of number of samples.
+  * @param  path Path to report file, its extension chooses format
+  * @param  entries Report entries of images
+  * @param  numberOfEntries Number of entries
+  * @param  wallSeconds Wall clock time of whole compression run
+  * @retval 0 if report was written, 1 otherwise
+  */
+uint8_t writeReport(const char* path, const reportEntry* entries, uint32_t numberOfEntries, double wallSeconds);
+
+#endif // COMPRESSION_REPORT_H
@@ -0,0 +1,364 @@
+#include "dictionary.h"
+#include "fileOperations.h"
+#include <math.h>
+
+/**
+ * @brief:  Leaf of tree being trained, sorted by count before tree is built.
+ */
+typedef struct trainedLeaf {
+    uint32_t count;
+    uint16_t symbol;
+} trainedLeaf;
+
+/**
+  * @brief  Orders leaves by count, then by symbol, so trained tree does not depend on qsort.
+  */
+static int compareLeaves(const void* first, const void* second)
+{
+    const trainedLeaf* a = (const trainedLeaf*)first;
+    const trainedLeaf* b = (const trainedLeaf*)second;
+    if (a->count != b->count) return a->count < b->count ? -1 : 1;
+    return (a->symbol > b->symbol) - (a->symbol < b->symbol);
+}
+
+/**
+  * @brief  Computes identifier of serialized dictionary nodes: FNV-1a hash folded to 16 bits.
+  *         Identifier is never 0, which in compressed file header means no dictionary.
+  * @param  data Serialized nodes
+  * @param  length Length of serialized nodes in bytes
+  * @retval Dictionary identifier
+  */
+static uint16_t computeId(const uint8_t* data, uint64_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (uint64_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    uint16_t id = (uint16_t)(hash ^ (hash >> 16));
+    return id ? id : 1;
+}
+
+/**
+  * @brief  Builds Huffman tree from leaf counts with two queues: sorted leaves and internal
+  *         nodes, which are created with growing counts. Nodes are numbered from last merge
+  *         to first, larger node of each pair first, so counts do not grow with position,
+  *         siblings are neighbours and NewSymbol node of zero count is last, exactly as in
+  *         tree built by adaptive coder.
+  * @param  leaves Leaves sorted by count, NewSymbol node first
+  * @param  numberOfLeaves Number of leaves, at least 2
+  * @param  nodes Array of 2 * numberOfLeaves - 1 nodes receiving tree
+  * @retval 0 if tree was built, 1 on memory allocation failure
+  */
+static uint8_t buildTree(const trainedLeaf* leaves, uint32_t numberOfLeaves, dictionaryNode* nodes)
+{
+    uint32_t numberOfNodes = 2 * numberOfLeaves - 1;
+    uint64_t* weight = (uint64_t*)malloc(numberOfNodes * sizeof(uint64_t));
+    uint32_t* smaller = (uint32_t*)malloc(numberOfLeaves * sizeof(uint32_t));
+    uint32_t* larger = (uint32_t*)malloc(numberOfLeaves * sizeof(uint32_t));
+    uint32_t* position = (uint32_t*)malloc(numberOfNodes * sizeof(uint32_t));
+    if (!weight || !smaller || !larger || !position) {
+        printf("Error: Cannot allocate memory for dictionary tree\n");
+        free(weight);
+        free(smaller);
+        free(larger);
+        free(position);
+        return 1;
+    }
+    for (uint32_t i = 0; i < numberOfLeaves; i++)
+        weight[i] = leaves[i].count;
+
+    // Take two smallest of leaf and internal queue, leaves win ties
+    uint32_t nextLeaf = 0, nextInternal = numberOfLeaves;
+    for (uint32_t merge = 0; merge + 1 < numberOfLeaves; merge++) {
+        uint32_t pair[2];
+        for (uint8_t i = 0; i < 2; i++) {
+            if (nextLeaf < numberOfLeaves && (nextInternal == numberOfLeaves + merge || weight[nextLeaf] <= weight[nextInternal]))
+                pair[i] = nextLeaf++;
+            else
+                pair[i] = nextInternal++;
+        }
+        smaller[merge] = pair[0];
+        larger[merge] = pair[1];
+        weight[numberOfLeaves + merge] = weight[pair[0]] + weight[pair[1]];
+    }
+
+    // Root is result of last merge, children of later merges take lower positions
+    position[numberOfNodes - 1] = 0;
+    nodes[0].count = (uint32_t)weight[numberOfNodes - 1];
+    nodes[0].parent = 0;
+    nodes[0].symbol = 0;
+    nodes[0].flags = 0;
+    uint32_t nextPosition = 1;
+    for (uint32_t merge = numberOfLeaves - 1; merge-- > 0;) {
+        uint32_t parent = position[numberOfLeaves + merge];
+        uint32_t children[2] = { larger[merge], smaller[merge] };
+        for (uint8_t i = 0; i < 2; i++) {
+            dictionaryNode* node = &nodes[nextPosition];
+            position[children[i]] = nextPosition++;
+            node->count = (uint32_t)weight[children[i]];
+            node->parent = parent;
+            node->symbol = children[i] < numberOfLeaves ? leaves[children[i]].symbol : 0;
+            node->flags = (children[i] < numberOfLeaves ? DICTIONARY_LEAF : 0) | (i ? DICTIONARY_LINK1 : 0);
+        }
+    }
+    free(weight);
+    free(smaller);
+    free(larger);
+    free(position);
+    return 0;
+}
+
+uint32_t buildTreeFromCounts(const uint32_t* counts, uint32_t numberOfSymbols, dictionaryNode* nodes)
+{
+    trainedLeaf* leaves = (trainedLeaf*)malloc(((size_t)numberOfSymbols + 1) * sizeof(trainedLeaf));
+    if (!leaves) {
+        printf("Error: Cannot allocate memory for dictionary tree\n");
+        return 0;
+    }
+    leaves[0].count = 0;
+    leaves[0].symbol = 0;
+    uint32_t numberOfLeaves = 1;
+    for (uint32_t symbol = 0; symbol < numberOfSymbols; symbol++) {
+        if (!counts[symbol]) continue;
+        leaves[numberOfLeaves].count = counts[symbol];
+        leaves[numberOfLeaves].symbol = (uint16_t)symbol;
+        numberOfLeaves++;
+    }
+    // NewSymbol node has zero count, so it stays first
+    qsort(&leaves[1], numberOfLeaves - 1, sizeof(trainedLeaf), compareLeaves);
+    uint8_t status = numberOfLeaves < 2 || buildTree(leaves, numberOfLeaves, nodes);
+    free(leaves);
+    return status ? 0 : 2 * numberOfLeaves - 1;
+}
+
+/**
+  * @brief  Writes dictionary header and nodes to file in big-endian order.
+  * @param  dictionaryPath Path to created dictionary file
+  * @param  nodes Nodes of trained tree
+  * @param  numberOfNodes Number of nodes
+  * @param  bytesPerSample Sample size of training images
+  * @retval 0 if file was written, 1 otherwise
+  */
+static uint8_t writeDictionary(const char* dictionaryPath, const dictionaryNode* nodes, uint32_t numberOfNodes, uint8_t bytesPerSample)
+{
+    uint8_t header[DICTIONARY_HEADER_LENGTH] = DICTIONARY_MAGIC;
+    uint64_t length = (uint64_t)numberOfNodes * DICTIONARY_NODE_LENGTH;
+    uint8_t* data = (uint8_t*)malloc(length);
+    if (!data) {
+        printf("Error: Cannot allocate memory for dictionary\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < numberOfNodes; i++) {
+        uint8_t* node = &data[(uint64_t)i * DICTIONARY_NODE_LENGTH];
+        storeBigEndian(&node[0], nodes[i].count, 4);
+        storeBigEndian(&node[4], nodes[i].parent, 4);
+        node[8] = nodes[i].flags;
+        storeBigEndian(&node[9], nodes[i].symbol, 2);
+    }
+    uint16_t id = computeId(data, length);
+    header[4] = DICTIONARY_VERSION;
+    header[5] = bytesPerSample;
+    storeBigEndian(&header[6], id, 2);
+    storeBigEndian(&header[8], numberOfNodes, 4);
+
+    FILE* file = fopen(dictionaryPath, "wb");
+    uint8_t status = !file || fwrite(header, 1, DICTIONARY_HEADER_LENGTH, file) != DICTIONARY_HEADER_LENGTH ||
+                     fwrite(data, 1, length, file) != length;
+    if (file && fclose(file))
+        status = 1;
+    free(data);
+    if (status) {
+        printf("Error: Cannot write dictionary file\n");
+        return 1;
+    }
+    printf("Dictionary %04x with %u nodes written\n", id, numberOfNodes);
+    return 0;
+}
+
+uint8_t trainDictionary(const char* dictionaryPath, char** imagePaths, int numberOfImages)
+{
+    uint64_t* histogram = (uint64_t*)calloc(NUMBER_OF_WIDE_SYMBOLS, sizeof(uint64_t));
+    uint32_t* counts = (uint32_t*)calloc(NUMBER_OF_WIDE_SYMBOLS, sizeof(uint32_t));
+    uint8_t bytesPerSample = 0;
+    uint8_t status = !histogram || !counts;
+    if (status)
+        printf("Error: Cannot allocate memory for dictionary\n");
+
+    // Samples of all channels of all images are counted together
+    for (int i = 0; i < numberOfImages && !status; i++) {
+        handler* image = createHandler();
+        if (!image) {
+            status = 1;
+            break;
+        }
+        status = readDataFromFile(&image->records, imagePaths[i]);
+        if (!status && bytesPerSample && bytesPerSample != image->records.bytesPerSample) {
+            printf("Error: Training images must have equal sample size\n");
+            status = 1;
+        }
+        if (!status) {
+            bytesPerSample = image->records.bytesPerSample;
+            for (uint32_t symbol = 0; symbol < image->records.numberOfSymbols; symbol++)
+                histogram[symbol] += image->records.histogram[symbol];
+        }
+        freeAlocatedMemory(image);
+        free(image);
+    }
+
+    // Scale counts, so that trained tree is only a starting point for coded image
+    uint64_t total = 0;
+    uint32_t numberOfLeaves = 1;
+    for (uint32_t symbol = 0; symbol < NUMBER_OF_WIDE_SYMBOLS && !status; symbol++)
+        total += histogram[symbol];
+    if (!status && !total) {
+        printf("Error: No training images\n");
+        status = 1;
+    }
+    if (!status) {
+        for (uint32_t symbol = 0; symbol < NUMBER_OF_WIDE_SYMBOLS; symbol++) {
+            if (!histogram[symbol]) continue;
+            uint64_t count = (histogram[symbol] * DICTIONARY_TOTAL_COUNT + total / 2) / total;
+            counts[symbol] = count ? (uint32_t)count : 1;
+            numberOfLeaves++;
+        }
+        dictionaryNode* nodes = (dictionaryNode*)malloc((2 * numberOfLeaves - 1) * sizeof(dictionaryNode));
+        uint32_t numberOfNodes = nodes ? buildTreeFromCounts(counts, NUMBER_OF_WIDE_SYMBOLS, nodes) : 0;
+        status = !numberOfNodes || writeDictionary(dictionaryPath, nodes, numberOfNodes, bytesPerSample);
+        free(nodes);
+    }
+    free(histogram);
+    free(counts);
+    return status;
+}
+
+/**
+  * @brief  Checks that nodes form tree that adaptive coder can continue: parents precede
+  *         children, every internal node has two children and count equal to their sum,
+  *         counts do not grow with position, leaves hold distinct symbols of alphabet and
+  *         last node is NewSymbol node with zero count. Fills symbol counts of dictionary.
+  * @param  my Pointer to dictionary with read nodes and allocated symbol counts
+  * @retval 0 if tree is valid, 1 otherwise
+  */
+static uint8_t validateTree(dictionary* my)
+{
+    uint8_t* children = (uint8_t*)calloc(my->numberOfNodes, 1);
+    uint64_t* sums = (uint64_t*)calloc(my->numberOfNodes, sizeof(uint64_t));
+    uint32_t last = my->numberOfNodes - 1;
+    uint8_t status = !children || !sums || (my->nodes[0].flags & DICTIONARY_LEAF) ||
+                     !(my->nodes[last].flags & DICTIONARY_LEAF) || my->nodes[last].count;
+
+    for (uint32_t i = 1; i < my->numberOfNodes && !status; i++) {
+        const dictionaryNode* node = &my->nodes[i];
+        uint8_t slot = node->flags & DICTIONARY_LINK1 ? 2 : 1;
+        if (node->parent >= i || (my->nodes[node->parent].flags & DICTIONARY_LEAF) ||
+            (children[node->parent] & slot) || node->count > my->nodes[i - 1].count) {
+            status = 1;
+            break;
+        }
+        children[node->parent] |= slot;
+        sums[node->parent] += node->count;
+        if (!(node->flags & DICTIONARY_LEAF) || i == last) continue;
+        if (node->symbol >= my->numberOfSymbols || my->symbolCounts[node->symbol] || !node->count) {
+            status = 1;
+            break;
+        }
+        my->symbolCounts[node->symbol] = node->count;
+    }
+    for (uint32_t i = 0; i < my->numberOfNodes && !status; i++)
+        if (!(my->nodes[i].flags & DICTIONARY_LEAF) && (children[i] != 3 || sums[i] != my->nodes[i].count))
+            status = 1;
+    free(children);
+    free(sums);
+    return status;
+}
+
+uint8_t loadDictionary(handler* my, const char* dictionaryPath)
+{
+    const uint8_t magic[] = DICTIONARY_MAGIC;
+    uint8_t header[DICTIONARY_HEADER_LENGTH];
+    FILE* file = fopen(dictionaryPath, "rb");
+    if (!file) {
+        printf("Error: Could not open dictionary file %s\n", dictionaryPath);
+        return 1;
+    }
+    if (fread(header, 1, DICTIONARY_HEADER_LENGTH, file) != DICTIONARY_HEADER_LENGTH ||
+        memcmp(header, magic, sizeof(magic)) || header[4] != DICTIONARY_VERSION ||
+        (header[5] != 1 && header[5] != 2)) {
+        printf("Error: Unsupported dictionary file\n");
+        fclose(file);
+        return 1;
+    }
+    dictionary* loaded = (dictionary*)calloc(1, sizeof(dictionary));
+    if (!loaded) {
+        fclose(file);
+        return 1;
+    }
+    loaded->bytesPerSample = header[5];
+    loaded->numberOfSymbols = loaded->bytesPerSample == 1 ? NUMBER_OF_BYTE_SYMBOLS : NUMBER_OF_WIDE_SYMBOLS;
+    loaded->id = (header[6] << BITS_IN_BYTE) | header[7];
+    loaded->numberOfNodes = ((uint32_t)header[8] << 24) | ((uint32_t)header[9] << 16) | ((uint32_t)header[10] << 8) | header[11];
+
+    // Tree holds NewSymbol node and at least one symbol, at most every symbol of alphabet
+    uint64_t length = (uint64_t)loaded->numberOfNodes * DICTIONARY_NODE_LENGTH;
+    uint8_t* data = NULL;
+    uint8_t status = loaded->numberOfNodes < 3 || !(loaded->numberOfNodes & 1) ||
+                     loaded->numberOfNodes > 2 * loaded->numberOfSymbols + 1;
+    if (!status) {
+        data = (uint8_t*)malloc(length);
+        loaded->nodes = (dictionaryNode*)malloc(loaded->numberOfNodes * sizeof(dictionaryNode));
+        loaded->symbolCounts = (uint32_t*)calloc(loaded->numberOfSymbols, sizeof(uint32_t));
+        status = !data || !loaded->nodes || !loaded->symbolCounts || fread(data, 1, length, file) != length ||
+                 computeId(data, length) != loaded->id;
+    }
+    for (uint32_t i = 0; i < loaded->numberOfNodes && !status; i++) {
+        const uint8_t* node = &data[(uint64_t)i * DICTIONARY_NODE_LENGTH];
+        loaded->nodes[i].count = ((uint32_t)node[0] << 24) | ((uint32_t)node[1] << 16) | ((uint32_t)node[2] << 8) | node[3];
+        loaded->nodes[i].parent = ((uint32_t)node[4] << 24) | ((uint32_t)node[5] << 16) | ((uint32_t)node[6] << 8) | node[7];
+        loaded->nodes[i].flags = node[8];
+        loaded->nodes[i].symbol = (node[9] << BITS_IN_BYTE) | node[10];
+    }
+    if (!status)
+        status = validateTree(loaded);
+    free(data);
+    fclose(file);
+    if (status) {
+        printf("Error: Dictionary file is damaged\n");
+        freeDictionary(&loaded);
+        return 1;
+    }
+    my->dictionary = loaded;
+    return 0;
+}
+
+void estimateWithDictionary(const dictionary* my, const uint64_t* histogram, imageStatistics* statistics)
+{
+    uint8_t literalBits = BITS_IN_BYTE * my->bytesPerSample;
+    double total = my->nodes[0].count;
+    double newSymbolBits = 0;
+    if (!statistics->numberOfPixels) return;
+
+    // Sequential code with prior counts costs log of ratio of gamma functions, new
+    // symbols cost literal and path to NewSymbol node, then they are counted from 1
+    double nats = lgamma(total + statistics->numberOfPixels) - lgamma(total);
+    for (uint32_t symbol = 0; symbol < my->numberOfSymbols; symbol++) {
+        if (!histogram[symbol]) continue;
+        if (my->symbolCounts[symbol]) {
+            nats -= lgamma((double)my->symbolCounts[symbol] + histogram[symbol]) - lgamma(my->symbolCounts[symbol]);
+        } else {
+            nats -= lgamma((double)histogram[symbol]);
+            newSymbolBits += literalBits + log2(statistics->distinctSymbols + 1.0);
+        }
+    }
+    double bitsPerPixel = (nats / log(2.0) + newSymbolBits) / statistics->numberOfPixels;
+    statistics->adaptiveBitsPerPixel = fmin(statistics->adaptiveBitsPerPixel, fmax(bitsPerPixel, 1.0));
+}
+
+void freeDictionary(dictionary** my)
+{
+    if (!*my) return;
+    free((*my)->nodes);
+    free((*my)->symbolCounts);
+    free(*my);
+    *my = NULL;
+}
@@ -0,0 +1,101 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+// Dictionary file: magic, version, bytes per sample, id and number of nodes, followed by
+// nodes of trained tree in order of their position in tree
+#define DICTIONARY_MAGIC { 0x8B, 'K', 'D', 'D' }
+#define DICTIONARY_VERSION 1
+#define DICTIONARY_HEADER_LENGTH 12
+// Node: count (4 bytes), parent position (4 bytes), flags, symbol (2 bytes)
+#define DICTIONARY_NODE_LENGTH 11
+#define DICTIONARY_LEAF 0x01
+#define DICTIONARY_LINK1 0x02
+// Trained counts are scaled to this total, so tree still adapts to coded image quickly
+#define DICTIONARY_TOTAL_COUNT 1024
+
+#include "treeOperations.h"
+
+/**
+ * @brief:  Node of trained tree as stored in dictionary file.
+ * @count: Scaled count of node, sum of counts of children for internal nodes.
+ * @parent: Position of parent node in tree, 0 for root.
+ * @symbol: Sample value of leaf, 0 for internal nodes and NewSymbol node.
+ * @flags: DICTIONARY_LEAF for leaves, DICTIONARY_LINK1 if node is link1 of its parent.
+ */
+typedef struct dictionaryNode {
+    uint32_t count;
+    uint32_t parent;
+    uint16_t symbol;
+    uint8_t flags;
+} dictionaryNode;
+
+/**
+ * @brief:  Trained tree shared by many images, both coder and decoder start every adaptive
+ *          block from it instead of tree holding only first symbol.
+ * @nodes: Nodes in order of position in tree: root first, NewSymbol node last. Counts do
+ *         not grow with position and siblings are neighbours, as in any adaptive tree.
+ * @symbolCounts: Trained count of every symbol of alphabet, 0 for symbols not in tree.
+ * @numberOfNodes: Number of nodes of tree.
+ * @numberOfSymbols: Size of alphabet, 256 or 65536.
+ * @id: Identifier written to compressed file header, derived from dictionary content.
+ * @bytesPerSample: Size of samples of images dictionary was trained on.
+ */
+typedef struct dictionary {
+    dictionaryNode* nodes;
+    uint32_t* symbolCounts;
+    uint32_t numberOfNodes;
+    uint32_t numberOfSymbols;
+    uint16_t id;
+    uint8_t bytesPerSample;
+} dictionary;
+
+/**
+  * @brief  Trains dictionary on PGM or PPM images with equal sample size and writes it to file.
+  *         Samples of all images are counted, counts are scaled to DICTIONARY_TOTAL_COUNT and
+  *         Huffman tree with NewSymbol node of zero count is built from them.
+  * @param  dictionaryPath Path to created dictionary file
+  * @param  imagePaths Paths to training images
+  * @param  numberOfImages Number of training images
+  * @retval 0 if dictionary was written, 1 otherwise
+  */
+uint8_t trainDictionary(const char* dictionaryPath, char** imagePaths, int numberOfImages);
+
+/**
+  * @brief  Builds Huffman tree of adaptive coder from symbol counts, as trained tree is built:
+  *         leaves are ordered by count, then by symbol, so coder and decoder building tree
+  *         from the same counts get the same tree.
+  * @param  counts Count of every symbol of alphabet, 0 for symbols left out of tree
+  * @param  numberOfSymbols Size of alphabet
+  * @param  nodes Array receiving nodes, room for 2 * number of counted symbols + 1 of them
+  * @retval Number of nodes of built tree, 0 if no symbol is counted or memory allocation fails
+  */
+uint32_t buildTreeFromCounts(const uint32_t* counts, uint32_t numberOfSymbols, dictionaryNode* nodes);
+
+/**
+  * @brief  Reads dictionary file into handler, every adaptive block is then started from
+  *         trained tree and dictionary id is written to compressed file header.
+  * @param  my A pointer to handler struct
+  * @param  dictionaryPath Path to dictionary file
+  * @retval 0 if dictionary is valid, 1 otherwise
+  */
+uint8_t loadDictionary(handler* my, const char* dictionaryPath);
+
+/**
+  * @brief  Estimates size of adaptive code started from dictionary as ideal sequential code
+  *         with trained counts as prior, and lowers adaptive estimate of statistics if it is
+  *         smaller. Symbols missing in dictionary are sent as literals, as without dictionary.
+  * @param  my Pointer to loaded dictionary
+  * @param  histogram Array of sample value counts of coded block
+  * @param  statistics Pointer to statistics filled by analyzeHistogram()
+  * @retval None
+  */
+void estimateWithDictionary(const dictionary* my, const uint64_t* histogram, imageStatistics* statistics);
+
+/**
+  * @brief  Frees dictionary and its nodes.
+  * @param  my Address of pointer to dictionary, set to NULL afterwards
+  * @retval None
+  */
+void freeDictionary(dictionary** my);
+
+#endif // DICTIONARY_H
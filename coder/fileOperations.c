@@ -1,23 +1,35 @@
+// fileno() and mmap() are POSIX, input file is mapped where they are available
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_MAP_INPUT
+#define KODA_MEMORY_INPUT
+#endif
 #include "fileOperations.h"
+#include <ctype.h>
+#ifdef KODA_MAP_INPUT
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 /**
   * @brief  Opens a file for binary reading operations.
-  * @param  None
+  *         If no path is provided, user is prompted to input one.
+  * @param  filePath Path to file to compress, or NULL to ask user for it
   * @retval Pointer to the opened FILE object for read operations,
   *         or NULL if an error occurs.
   */
-FILE* openFile()
+FILE* openFile(const char* filePath)
 {
-    uint8_t filePath[512];
+    char pathFromUser[512];
 
-    printf("\nPlease enter valid path to file to compress:\n");
-
-    strcpy((char *)filePath, "C:\\Users\\Admin\\Desktop\\obrazy_testowe\\barbara.pgm");
-
-    // if (scanf("%511s", filePath) != 1) { 
-    //     printf("\nError: Invalid input. Please try again.\n");
-    //     return NULL;
-    // }
+    if (!filePath) {
+        printf("\nPlease enter valid path to file to compress:\n");
+        if (scanf("%511s", pathFromUser) != 1) { 
+            printf("\nError: Invalid input. Please try again.\n");
+            return NULL;
+        }
+        filePath = pathFromUser;
+    }
 
     // Open file with provided name on binary read mode
     FILE* fileToCompress = fopen(filePath,"rb");
@@ -30,21 +42,21 @@ FILE* openFile()
     return fileToCompress;
 }
 
-FILE* createCompressedFile()
+FILE* createCompressedFile(const char* fileName)
 {
-    uint8_t fileName[256];
-
-    printf("\nPlease enter valid file name for compressed data:\n");
+    char nameFromUser[256];
+    char fileNameWithExtension[256];
 
-    strcpy((char*)fileName, "compressed");
-
-    // if (scanf("%250s", fileName) != 1) { 
-    //     printf("\nError reading input.");
-    //     return NULL;
-    // }
-
-    // Append ".bin" extension to the provided file name
-    snprintf(fileName, sizeof(fileName), "%s.bin", fileName);
+    if (!fileName) {
+        printf("\nPlease enter valid file name for compressed data:\n");
+        if (scanf("%250s", nameFromUser) != 1) { 
+            printf("\nError reading input.");
+            return NULL;
+        }
+        // Append ".bin" extension to the provided file name
+        snprintf(fileNameWithExtension, sizeof(fileNameWithExtension), "%s.bin", nameFromUser);
+        fileName = fileNameWithExtension;
+    }
 
     // Open file with provided name on binary write mode
     // fopen allocates memory automatically
@@ -57,76 +69,393 @@ FILE* createCompressedFile()
     return compressedFile;
 }
 
-uint8_t readDataFromFile(records* my)
+/**
+  * @brief  Reads next unsigned decimal value of PNM header. Any whitespace and comments, from
+  *         '#' to the end of line, may precede value. Value of maximum grey level, the last
+  *         one in header, must be followed by single whitespace character that ends header.
+  * @param  file File positioned inside header
+  * @param  value Pointer to variable receiving value
+  * @param  limit Largest accepted value
+  * @param  last 1 if value ends header, 0 otherwise
+  * @retval 0 if value was read, 1 if header is malformed or value is above limit
+  */
+static uint8_t readHeaderValue(FILE* file, uint32_t* value, uint32_t limit, uint8_t last)
 {
-    uint8_t headerLine[64];
-    uint8_t headerLines = 0;
-    FILE* file = openFile();
-    if (!file) return 1;
+    int character = getc(file);
+    uint64_t result = 0;
 
-    // Each PGM Image File must consist of 3 header lines: signature, rows and cols, max grey level
-    while (headerLines < 3) {
-        if (!fgets(headerLine, sizeof(headerLine), file)) {
-            printf("Error: Unexpected end of file while reading header.\n");
-            return 1;
-        }
-        // Skip all comments
-        if (headerLine[0] == '#') 
-            continue; 
-        // Read and assign number of rows and columns to fields in records
-        if (headerLines == 1) {
-            uint8_t j = 0;
-            for (uint8_t i = 0; headerLine[i] != '\n'; i++) {
-                if (headerLine[i] == ' ') { 
-                    i++;
-                    j++;
-                }
-                my->matrixDimension[j] = my->matrixDimension[j] * 10 + (headerLine[i] - '0');
-            }
-        }
-        headerLines++;    
+    while (isspace(character) || character == '#') {
+        if (character == '#')
+            while (character != '\n' && character != '\r' && character != EOF)
+                character = getc(file);
+        character = getc(file);
     }
-
-    // Allocate memory for the records buffer: IMAGE_ROWS x IMAGE_COLS
-    my->matrix = (uint8_t**)malloc(my->matrixDimension[0] * sizeof(uint8_t*));
-    for (int i = 0; i < my->matrixDimension[0]; i++) {
-        my->matrix[i] = (uint8_t*)malloc(my->matrixDimension[1] * sizeof(uint8_t));
+    if (!isdigit(character)) return 1;
+    while (isdigit(character)) {
+        result = result * 10 + (character - '0');
+        if (result > limit) return 1;
+        character = getc(file);
     }
+    // Comment may follow dimensions directly, raster follows single whitespace after grey level
+    if (!last && character == '#')
+        ungetc(character, file);
+    else if (!isspace(character))
+        return 1;
+    *value = (uint32_t)result;
+    return 0;
+}
 
-    // Read pixel data row by row
-    for (int i = 0; i < my->matrixDimension[0]; i++) {
-        size_t bytesRead = fread(my->matrix[i], 1, my->matrixDimension[1], file);
+/**
+  * @brief  Points matrix rows into memory mapped input file, so pixels are paged in by
+  *         operating system on demand instead of being copied into allocated memory.
+  * @param  my Pointer to records struct with image dimensions and allocated matrix
+  * @param  file File positioned at first byte of raster
+  * @param  rowLength Length of single row in bytes
+  * @retval 0 if file was mapped, 1 if mapping is not available or file is too short
+  */
+static uint8_t mapRows(records* my, FILE* file, uint64_t rowLength)
+{
+#ifdef KODA_MAP_INPUT
+    struct stat status;
+    long rasterOffset = ftell(file);
+    uint64_t rasterLength = rowLength * my->matrixDimension[0];
 
-        if (bytesRead != my->matrixDimension[1]) {
+    if (rasterOffset < 0 || fstat(fileno(file), &status) || (uint64_t)status.st_size < (uint64_t)rasterOffset ||
+        (uint64_t)status.st_size - rasterOffset < rasterLength)
+        return 1;
+    void* mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (mapping == MAP_FAILED)
+        return 1;
+    my->mapping = (uint8_t*)mapping;
+    my->mappingLength = (uint64_t)status.st_size;
+    for (uint32_t i = 0; i < my->matrixDimension[0]; i++)
+        my->matrix[i] = my->mapping + rasterOffset + i * rowLength;
+    return 0;
+#else
+    (void)my;
+    (void)file;
+    (void)rowLength;
+    return 1;
+#endif
+}
+
+/**
+  * @brief  Reads raster into single block of memory, used when file can not be mapped.
+  * @param  my Pointer to records struct with image dimensions and allocated matrix
+  * @param  file File positioned at first byte of raster
+  * @param  rowLength Length of single row in bytes
+  * @retval 0 if all rows were read, 1 otherwise
+  */
+static uint8_t readRows(records* my, FILE* file, uint64_t rowLength)
+{
+    uint64_t rasterLength = rowLength * my->matrixDimension[0];
+    uint8_t* raster = rasterLength <= SIZE_MAX ? (uint8_t*)my->memory->allocate(my->memory, (size_t)rasterLength) : NULL;
+    if (!raster) {
+        printf("Error: Cannot allocate memory for %u rows.\n", my->matrixDimension[0]);
+        return 1;
+    }
+    // First row points to start of raster, so raster is released with it
+    for (uint32_t i = 0; i < my->matrixDimension[0]; i++)
+        my->matrix[i] = raster + i * rowLength;
+    for (uint32_t i = 0; i < my->matrixDimension[0]; i++) {
+        if (fread(my->matrix[i], 1, rowLength, file) != rowLength) {
             if (feof(file)) {
-                printf("Error: Unexpected end of file at row %d.\n", i);
+                printf("Error: Unexpected end of file at row %u.\n", i);
             } else {
-                printf("Error: Failed to read data from row %d.\n", i);
-            }
-
-            // Free allocated memory if error detected
-            for (int row = 0; row < my->matrixDimension[0]; row++) {
-                free(my->matrix[row]);
+                printf("Error: Failed to read data from row %u.\n", i);
             }
-            free(my->matrix);
             return 1;
         }
     }
+    return 0;
+}
+
+void releaseMatrix(records* my)
+{
+    if (my->sharedRows) {
+        releaseMemory(my->memory, my->matrix);
+        my->matrix = NULL;
+        my->sharedRows = 0;
+        return;
+    }
+#ifdef KODA_MAP_INPUT
+    if (my->mapping) {
+        munmap(my->mapping, (size_t)my->mappingLength);
+        my->mapping = NULL;
+        my->mappingLength = 0;
+        releaseMemory(my->memory, my->matrix);
+        my->matrix = NULL;
+        return;
+    }
+#endif
+    if (my->matrixDimension[0])
+        releaseMemory(my->memory, my->matrix[0]);
+    releaseMemory(my->memory, my->matrix);
+    my->matrix = NULL;
+}
+
+/**
+  * @brief  Allocates histogram and matrix of row pointers of image described in records, both
+  *         zeroed.
+  * @param  my Pointer to records struct with image dimensions
+  * @retval 0 on success, 1 if memory allocation fails
+  */
+static uint8_t allocateImage(records* my)
+{
+    size_t histogramLength = my->numberOfSymbols * sizeof(uint64_t);
+    size_t matrixLength = (size_t)my->matrixDimension[0] * sizeof(uint8_t*);
+    my->histogram = (uint64_t*)my->memory->allocate(my->memory, histogramLength);
+    my->matrix = (uint8_t**)my->memory->allocate(my->memory, matrixLength);
+    if (!my->histogram || !my->matrix) {
+        printf("Error: Cannot allocate memory for image.\n");
+        return 1;
+    }
+    memset(my->histogram, 0, histogramLength);
+    memset(my->matrix, 0, matrixLength);
+    return 0;
+}
+
+/**
+  * @brief  Reads PGM or PPM header, describes image in records and allocates its matrix of
+  *         row pointers and histogram.
+  * @param  my Pointer to records struct that receives image dimensions
+  * @param  file File positioned at start of image
+  * @param  rowLength Pointer to variable receiving length of single row in bytes
+  * @retval 0 if header was read, 1 if it is malformed, raster is not addressable or memory allocation fails
+  */
+static uint8_t readImageHeader(records* my, FILE* file, uint64_t* rowLength)
+{
+    uint32_t width, height, maxGreyLevel;
+
+    // Header holds signature, columns, rows and max grey level separated by any whitespace
+    if (getc(file) != 'P') {
+        printf("Error: Only binary PGM (P5) and PPM (P6) files are supported.\n");
+        return 1;
+    }
+    int signature = getc(file);
+    if (signature != '5' && signature != '6') {
+        printf("Error: Only binary PGM (P5) and PPM (P6) files are supported.\n");
+        return 1;
+    }
+    my->channels = signature == '6' ? 3 : 1;
+    if (readHeaderValue(file, &width, UINT32_MAX, 0) || readHeaderValue(file, &height, UINT32_MAX, 0)) {
+        printf("Error: Invalid image dimensions in header.\n");
+        return 1;
+    }
+    if (readHeaderValue(file, &maxGreyLevel, UINT16_MAX, 1)) {
+        printf("Error: Invalid max grey level in header.\n");
+        return 1;
+    }
+    if (!width || !height || !maxGreyLevel) {
+        printf("Error: Unsupported image size or max grey level.\n");
+        return 1;
+    }
+    my->matrixDimension[0] = height;
+    my->matrixDimension[1] = width;
+    my->maxGreyLevel = (uint16_t)maxGreyLevel;
+    my->bytesPerSample = my->maxGreyLevel > 255 ? 2 : 1;
+    my->numberOfSymbols = my->bytesPerSample == 1 ? NUMBER_OF_BYTE_SYMBOLS : NUMBER_OF_WIDE_SYMBOLS;
+    *rowLength = (uint64_t)width * my->channels * my->bytesPerSample;
+    // Raster length must not wrap, lengths of rows are multiplied by height when raster is read
+    if (*rowLength > UINT64_MAX / height || *rowLength * height > SIZE_MAX) {
+        printf("Error: Image is too large.\n");
+        return 1;
+    }
+
+    // Matrix holds only row pointers, rows point into mapped file or are read into memory
+    return allocateImage(my);
+}
+
+/**
+  * @brief  Counts samples of read image into histogram and sets window to whole image.
+  * @param  my Pointer to records struct with read matrix
+  * @param  rowLength Length of single row in bytes
+  * @retval None
+  */
+static void countSamples(records* my, uint64_t rowLength)
+{
+    // Count samples row by row, 16 bit samples are stored in big-endian order
+    for (uint32_t i = 0; i < my->matrixDimension[0]; i++) {
+        if (my->bytesPerSample == 1) {
+            accumulateHistogram(my->matrix[i], rowLength, my->histogram);
+            continue;
+        }
+        for (uint64_t sample = 0; sample < rowLength; sample += 2)
+            my->histogram[(my->matrix[i][sample] << BITS_IN_BYTE) | my->matrix[i][sample + 1]]++;
+    }
+    setWindow(my, 0, 0, my->matrixDimension[0], my->matrixDimension[1]);
+}
+
+/**
+  * @brief  Reads PGM or PPM file into records matrix: maps its rows or reads them into memory.
+  * @param  my Pointer to records struct that receives image dimensions and pixels.
+  * @param  filePath Path to PGM file, or NULL to ask user for it
+  * @param  rowLength Pointer to variable receiving length of single row in bytes
+  * @retval 0 if read was succesfull, or 1 if an error occurs.
+  */
+static uint8_t loadRows(records* my, const char* filePath, uint64_t* rowLength)
+{
+    FILE* file = openFile(filePath);
+    if (!file) return 1;
+
+    if (readImageHeader(my, file, rowLength)) {
+        fclose(file);
+        return 1;
+    }
+    if (mapRows(my, file, *rowLength) && readRows(my, file, *rowLength)) {
+        releaseMatrix(my);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+    return 0;
+}
+
+uint8_t readDataFromFile(records* my, const char* filePath)
+{
+    uint64_t rowLength;
+    if (loadRows(my, filePath, &rowLength)) return 1;
+    countSamples(my, rowLength);
+    printf("File read correctly\n");
+    return 0;
+}
+
+uint8_t mapDataFromFile(records* my, const char* filePath)
+{
+    uint64_t rowLength;
+    if (loadRows(my, filePath, &rowLength)) return 1;
+    setWindow(my, 0, 0, my->matrixDimension[0], my->matrixDimension[1]);
     printf("File read correctly\n");
+    return 0;
+}
+
+uint8_t readDataFromMemory(records* my, uint8_t* data, uint64_t length)
+{
+#ifdef KODA_MEMORY_INPUT
+    uint64_t rowLength;
+    FILE* file = fmemopen(data, (size_t)length, "rb");
+    if (!file) {
+        printf("Error: Could not open image in memory\n");
+        return 1;
+    }
+    uint8_t status = readImageHeader(my, file, &rowLength);
+    long rasterOffset = status ? -1 : ftell(file);
     fclose(file);
+    if (status) return 1;
+    if (rasterOffset < 0 || length < (uint64_t)rasterOffset || length - rasterOffset < rowLength * my->matrixDimension[0]) {
+        printf("Error: Unexpected end of file.\n");
+        releaseMemory(my->memory, my->matrix);
+        my->matrix = NULL;
+        return 1;
+    }
+    // Rows point into data, which stays owned by caller
+    my->sharedRows = 1;
+    for (uint32_t i = 0; i < my->matrixDimension[0]; i++)
+        my->matrix[i] = data + rasterOffset + i * rowLength;
+    countSamples(my, rowLength);
+    return 0;
+#else
+    (void)my;
+    (void)data;
+    (void)length;
+    printf("Error: Reading images from memory is not supported on this platform\n");
+    return 1;
+#endif
+}
+
+uint8_t readDataFromPixels(records* my, uint8_t* samples, uint32_t width, uint32_t height, uint16_t maxGreyLevel,
+                           uint8_t channels)
+{
+    if (!width || !height || !maxGreyLevel || (channels != 1 && channels != 3)) {
+        printf("Error: Unsupported image size, max grey level or number of channels.\n");
+        return 1;
+    }
+    my->matrixDimension[0] = height;
+    my->matrixDimension[1] = width;
+    my->maxGreyLevel = maxGreyLevel;
+    my->channels = channels;
+    my->bytesPerSample = maxGreyLevel > 255 ? 2 : 1;
+    my->numberOfSymbols = my->bytesPerSample == 1 ? NUMBER_OF_BYTE_SYMBOLS : NUMBER_OF_WIDE_SYMBOLS;
+    uint64_t rowLength = (uint64_t)width * channels * my->bytesPerSample;
+
+    if (allocateImage(my)) return 1;
+    // Rows point into samples, which stay owned by caller
+    my->sharedRows = 1;
+    for (uint32_t i = 0; i < height; i++)
+        my->matrix[i] = samples + i * rowLength;
+    countSamples(my, rowLength);
+    return 0;
+}
+
+void storeBigEndian(uint8_t* destination, uint32_t value, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; i++)
+        destination[i] = value >> (BITS_IN_BYTE * (bytes - 1 - i));
+}
+
+uint8_t writeHeader(FILE* compressedFile, const records* my, uint8_t mode, uint16_t dictionaryId)
+{
+    uint8_t header[HEADER_LENGTH] = HEADER_MAGIC;
+
+    header[4] = FORMAT_VERSION;
+    header[5] = mode;
+    storeBigEndian(&header[6], my->maxGreyLevel, 2);
+    storeBigEndian(&header[8], my->matrixDimension[1], 4);
+    storeBigEndian(&header[12], my->matrixDimension[0], 4);
+    header[16] = my->channels;
+    storeBigEndian(&header[17], dictionaryId, 2);
+    header[19] = my->scanOrder;
+
+    if (fwrite(header, 1, HEADER_LENGTH, compressedFile) != HEADER_LENGTH) {
+        printf("Error: Cannot write header to file\n");
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t writeStoredRecords(FILE* compressedFile, const records* my)
+{
+    size_t rowLength = (size_t)my->windowDimension[1] * my->bytesPerSample;
+    uint8_t* channelRow = NULL;
 
+    // Samples of one channel are interleaved with other channels, so they are gathered first
+    if (my->channels > 1) {
+        channelRow = (uint8_t*)my->memory->allocate(my->memory, rowLength);
+        if (!channelRow) {
+            printf("Error: Cannot allocate memory for row\n");
+            return 1;
+        }
+    }
+    for (uint32_t i = my->windowOrigin[0]; i < my->windowOrigin[0] + my->windowDimension[0]; i++) {
+        const uint8_t* row = &my->matrix[i][(size_t)my->windowOrigin[1] * my->bytesPerSample];
+        if (channelRow) {
+            for (uint32_t column = 0; column < my->windowDimension[1]; column++) {
+                uint16_t sample = readSample(my, i, my->windowOrigin[1] + column);
+                if (my->bytesPerSample == 2)
+                    channelRow[2 * column] = sample >> BITS_IN_BYTE;
+                channelRow[my->bytesPerSample * (column + 1) - 1] = (uint8_t)sample;
+            }
+            row = channelRow;
+        }
+        if (fwrite(row, 1, rowLength, compressedFile) != rowLength) {
+            printf("Error: Cannot write row %u to file\n", i);
+            releaseMemory(my->memory, channelRow);
+            return 1;
+        }
+    }
+    releaseMemory(my->memory, channelRow);
     return 0;
 }
 
 /**
-  * @brief  Function writes remaining bits in buffer to file and closes it.
+  * @brief  Function writes remaining bits in buffer to file and clears buffer.
   * @param  my Pointer to struct containing data
   * @param  compressedFile Pointer to FILE object
-  * @retval 0 if write was succesfull and file is closed, or 1 if an error occurs.
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
   */
-uint8_t writeRemainingBits(dataBuffer* my, FILE* compressedFile)
+static uint8_t writeRemainingBits(dataBuffer* my, FILE* compressedFile)
 {
-    my->buffer = _byteswap_uint64(my->buffer);
+    my->buffer = BYTESWAP_64(my->buffer);
     int8_t bufferSize = BUFFER_BIT_LEN - my->freeBits;
     uint8_t bytes = 0;
 
@@ -139,13 +468,8 @@ uint8_t writeRemainingBits(dataBuffer* my, FILE* compressedFile)
         printf("Error: Cannot write remaining bits to file\n");
         return 1;
     }
-
-    if (fclose(compressedFile)) {
-        printf("Error: Error during closing file\n");
-        return 1;
-    }
-
-    printf("File successfully written and closed\n");
+    my->buffer = 0;
+    my->freeBits = BUFFER_BIT_LEN;
     return 0;
 }
 
@@ -165,7 +489,7 @@ uint8_t writeToFile(dataBuffer* my, FILE* compressedFile, uint32_t input, uint8_
     if (shift < 0) {
         // Calculate shift for these bits that will fit in buffer by changing sign of shift
         my->buffer += data >> -shift;
-        my->buffer = _byteswap_uint64(my->buffer); // swap endiannes if necesarry
+        my->buffer = BYTESWAP_64(my->buffer); // swap endiannes if necesarry
 
         // Write data to a file from a buffer, return "0" if error occurs, clear buffer
         if (fwrite(&my->buffer, BUFFER_BYTE_LENGTH, 1, compressedFile) != 1) return 1;
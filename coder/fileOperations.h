@@ -3,32 +3,145 @@
 #define BUFFER_BYTE_LENGTH 8
 #define BUFFER_BIT_LEN 64 
 
+// Compressed file header: magic, format version, coding mode, max grey level, columns, rows,
+// channels, dictionary id (0 without dictionary) and scan order of blocks
+#define HEADER_LENGTH 20
+#define HEADER_MAGIC { 0x8B, 'K', 'D', 'A' }
+#define FORMAT_VERSION 2
+#define MODE_ADAPTIVE_HUFFMAN 0
+#define MODE_STATIC_HUFFMAN 1
+#define MODE_STORED 2
+#define MODE_RUN_LENGTH 3
+#define MODE_TILED 4
+#define MODE_RANGE 5
+// Adaptive Huffman code of pairs of neighbouring 8 bit samples, odd last sample is paired with 0
+#define MODE_PAIR_HUFFMAN 6
+// Eight bit planes of 8 bit samples, each packed 8 samples per byte with own adaptive Huffman code
+#define MODE_BIT_PLANE 7
+// Canonical Huffman code of 8 bit samples rebuilt from symbol counts every few thousand symbols
+#define MODE_PERIODIC_HUFFMAN 8
+// Tiled mode: tile side follows header, then every tile has its mode and payload length
+#define TILE_SIDE_LENGTH 2
+#define TILE_HEADER_LENGTH 5
+#define DEFAULT_TILE_SIDE 256
+// Tile mode only: tile equal to earlier tile of image, payload is number of that tile, counting
+// channels of every tile
+#define MODE_DUPLICATE_TILE 9
+#define TILE_REFERENCE_LENGTH 4
+// Scan orders in which samples of every block are coded come from scanWalk.h, shared with decoder
+// Coder setting only, replaced with mode chosen from image statistics before header is written
+#define MODE_AUTO 0xFF
+
 #include "treeOperations.h"
+#include "imageAnalysis.h"
+#include "scanWalk.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Bit buffer is flushed to file in big-endian order
+#if defined(_MSC_VER)
+#define BYTESWAP_64(value) _byteswap_uint64(value)
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BYTESWAP_64(value) (value)
+#else
+#define BYTESWAP_64(value) __builtin_bswap64(value)
+#endif
+
 /**
   * @brief  Creates and opens a file for binary writing operations
-  *         This function prompts the user to input a valid file name,
-  *         appends a ".bin" extension to it, and opens the file in binary
-  *         write mode. If the operation fails, it returns NULL.
-  * @param  my Pointer to struct containing data.
+  *         If no file name is provided, this function prompts the user to input
+  *         a valid file name, appends a ".bin" extension to it, and opens the file
+  *         in binary write mode. If the operation fails, it returns NULL.
+  * @param  fileName Path to compressed file, or NULL to ask user for it
   * @retval FILE pointer if file created succesfully, or NULL if an error occurs.
   */
-FILE* createCompressedFile();
+FILE* createCompressedFile(const char* fileName);
+
+/**
+  * @brief  Reads PGM (P5) or PPM (P6) file with 8 or 16 bit samples and counts its samples
+  *         into records histogram. Header may hold comments and any whitespace between values.
+  *         Where possible file is memory mapped and matrix rows point into mapping, so memory
+  *         used by coder does not grow with image; otherwise rows are read into memory.
+  *         This function attempts to open the file in binary read mode (prompting
+  *         the user for a path if none is given). If the operation is unsuccessful
+  *         (for example the file does not exist or cannot be accessed), it returns 1.
+  * @param  my Pointer to records struct that receives image dimensions and pixels.
+  * @param  filePath Path to PGM file, or NULL to ask user for it
+  * @retval 0 if read was succesfull, or 1 if an error occurs.
+  */
+uint8_t readDataFromFile(records* my, const char* filePath);
 
 /**
-  * @brief  Reads data from a file and stores it in a 2D array.
-  *         This function prompts the user to input a valid file path
-  *         and attempts to open the file in binary read mode. If the operation
-  *         is unsuccessful (for example the file does not exist or cannot be accessed),
-  *         it returns 1.
-  * @param  None
+  * @brief  Reads PGM or PPM file as readDataFromFile() does, without counting its samples:
+  *         histogram stays zeroed and mapped rows are not touched until they are coded.
+  * @param  my Pointer to records struct that receives image dimensions and pixels.
+  * @param  filePath Path to PGM file, or NULL to ask user for it
   * @retval 0 if read was succesfull, or 1 if an error occurs.
   */
-uint8_t readDataFromFile(records* my);
+uint8_t mapDataFromFile(records* my, const char* filePath);
+
+/**
+  * @brief  Reads PGM or PPM file already loaded into memory, as readDataFromFile() does.
+  *         Matrix rows point into data, which must outlive records and is not freed with them.
+  *         Needs POSIX fmemopen(), fails elsewhere.
+  * @param  my Pointer to records struct that receives image dimensions and pixels.
+  * @param  data Contents of image file
+  * @param  length Length of image file in bytes
+  * @retval 0 if read was succesfull, or 1 if an error occurs.
+  */
+uint8_t readDataFromMemory(records* my, uint8_t* data, uint64_t length);
+
+/**
+  * @brief  Describes raw samples held in memory as records, without any image file header.
+  *         Matrix rows point into samples, which must outlive records and are not freed with
+  *         them.
+  * @param  my Pointer to records struct that receives image dimensions and pixels.
+  * @param  samples Rows of interleaved samples, 16 bit samples in big-endian order
+  * @param  width Number of columns
+  * @param  height Number of rows
+  * @param  maxGreyLevel Max grey level, above 255 samples take 2 bytes
+  * @param  channels 1 for grey image, 3 for colour image
+  * @retval 0 if samples were described, or 1 if an error occurs.
+  */
+uint8_t readDataFromPixels(records* my, uint8_t* samples, uint32_t width, uint32_t height, uint16_t maxGreyLevel,
+                           uint8_t channels);
+
+/**
+  * @brief  Releases rows of records matrix, unmapping input file or freeing rows read into
+  *         memory, and the matrix itself.
+  * @param  my Pointer to records struct with allocated matrix
+  * @retval None
+  */
+void releaseMatrix(records* my);
+
+/**
+  * @brief  Writes compressed file header describing the image and coding mode.
+  * @param  compressedFile Pointer to FILE object.
+  * @param  my Pointer to records struct holding image dimensions and scan order.
+  * @param  mode Coding mode of data following the header.
+  * @param  dictionaryId Identifier of dictionary adaptive blocks start from, 0 if none.
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
+  */
+uint8_t writeHeader(FILE* compressedFile, const records* my, uint8_t mode, uint16_t dictionaryId);
+
+/**
+  * @brief  Stores value on given number of bytes in big-endian order.
+  * @param  destination Pointer to first byte of destination
+  * @param  value Value to store
+  * @param  bytes Number of bytes used to store value
+  * @retval None
+  */
+void storeBigEndian(uint8_t* destination, uint32_t value, uint8_t bytes);
+
+/**
+  * @brief  Writes records window to file without any coding, row by row.
+  * @param  compressedFile Pointer to FILE object.
+  * @param  my Pointer to records struct holding image and window.
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
+  */
+uint8_t writeStoredRecords(FILE* compressedFile, const records* my);
 
 /**
   * @brief  Writes data to buffer and to file if buffer is full.
@@ -36,7 +149,7 @@ uint8_t readDataFromFile(records* my);
   * @param  my Pointer to struct containing data.
   * @param  data Variable which holds data we want write to file.
   * @param  count Variable which holds number of bits we want write to file.
-  *         Set as "0" to append remaining bits in buffer
+  *         Set as "0" to append remaining bits in buffer and clear it
   * @return 0 if write was succesfull, or 1 if an error occurs.
   */
 uint8_t writeToFile(dataBuffer* my, FILE* compressedFile, uint32_t input, uint8_t count);
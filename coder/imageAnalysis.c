@@ -0,0 +1,173 @@
+#include "imageAnalysis.h"
+#include "fileOperations.h"
+#include "staticHuffman.h"
+#include "rangeCoder.h"
+
+#include <math.h>
+#include <time.h>
+
+// Counters of single table can not overflow within one block
+#define HISTOGRAM_BLOCK_LENGTH ((uint64_t)1 << 32)
+// Short inputs are not worth clearing and summing all tables
+#define HISTOGRAM_MIN_TABLE_LENGTH 256
+
+/**
+  * @brief  Counts bytes of one block into HISTOGRAM_TABLES tables, taking 8 bytes per load.
+  * @param  data Pointer to counted bytes
+  * @param  length Number of counted bytes, below HISTOGRAM_BLOCK_LENGTH
+  * @param  tables Tables of counters, each byte lane of a word has its own table
+  * @retval None
+  */
+static void countBlock(const uint8_t* data, uint64_t length, uint32_t tables[HISTOGRAM_TABLES][HISTOGRAM_BINS])
+{
+    uint64_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        uint64_t first, second;
+        memcpy(&first, data + i, sizeof(first));
+        memcpy(&second, data + i + 8, sizeof(second));
+        tables[0][first & 0xFF]++;
+        tables[1][(first >> 8) & 0xFF]++;
+        tables[2][(first >> 16) & 0xFF]++;
+        tables[3][(first >> 24) & 0xFF]++;
+        tables[0][(first >> 32) & 0xFF]++;
+        tables[1][(first >> 40) & 0xFF]++;
+        tables[2][(first >> 48) & 0xFF]++;
+        tables[3][first >> 56]++;
+        tables[0][second & 0xFF]++;
+        tables[1][(second >> 8) & 0xFF]++;
+        tables[2][(second >> 16) & 0xFF]++;
+        tables[3][(second >> 24) & 0xFF]++;
+        tables[0][(second >> 32) & 0xFF]++;
+        tables[1][(second >> 40) & 0xFF]++;
+        tables[2][(second >> 48) & 0xFF]++;
+        tables[3][second >> 56]++;
+    }
+    for (; i < length; i++)
+        tables[0][data[i]]++;
+}
+
+void accumulateHistogram(const uint8_t* data, uint64_t length, uint64_t* histogram)
+{
+    if (length < HISTOGRAM_MIN_TABLE_LENGTH) {
+        for (uint64_t i = 0; i < length; i++)
+            histogram[data[i]]++;
+        return;
+    }
+    uint32_t tables[HISTOGRAM_TABLES][HISTOGRAM_BINS];
+    while (length) {
+        uint64_t blockLength = length < HISTOGRAM_BLOCK_LENGTH ? length : HISTOGRAM_BLOCK_LENGTH - 1;
+        memset(tables, 0, sizeof(tables));
+        countBlock(data, blockLength, tables);
+        for (uint16_t bin = 0; bin < HISTOGRAM_BINS; bin++)
+            histogram[bin] += (uint64_t)tables[0][bin] + tables[1][bin] + tables[2][bin] + tables[3][bin];
+        data += blockLength;
+        length -= blockLength;
+    }
+}
+
+void analyzeHistogram(const uint64_t* histogram, uint32_t numberOfSymbols, imageStatistics* statistics)
+{
+    canonicalCode code;
+    uint64_t numberOfPixels = 0;
+    uint64_t staticBits = CODE_LENGTHS_BYTES * BITS_IN_BYTE;
+    uint8_t literalBits = numberOfSymbols > HISTOGRAM_BINS ? 2 * BITS_IN_BYTE : BITS_IN_BYTE;
+
+    statistics->distinctSymbols = 0;
+    for (uint32_t bin = 0; bin < numberOfSymbols; bin++) {
+        numberOfPixels += histogram[bin];
+        statistics->distinctSymbols += histogram[bin] > 0;
+    }
+    statistics->numberOfPixels = numberOfPixels;
+    statistics->entropy = 0;
+    statistics->storedBitsPerPixel = literalBits;
+    if (!numberOfPixels) return;
+
+    for (uint32_t bin = 0; bin < numberOfSymbols; bin++) {
+        if (!histogram[bin]) continue;
+        double probability = (double)histogram[bin] / numberOfPixels;
+        statistics->entropy -= probability * log2(probability);
+    }
+    if (numberOfSymbols == HISTOGRAM_BINS) {
+        buildCanonicalCode(histogram, &code);
+        for (uint16_t bin = 0; bin < HISTOGRAM_BINS; bin++)
+            staticBits += histogram[bin] * code.length[bin];
+        statistics->staticBitsPerPixel = (double)staticBits / numberOfPixels;
+    } else {
+        statistics->staticBitsPerPixel = HUGE_VAL;
+    }
+
+    // Every new symbol is sent as literal after path to NewSymbol node, and
+    // no symbol path is shorter than one bit
+    double newSymbolBits = statistics->distinctSymbols * (literalBits + log2(statistics->distinctSymbols + 1.0));
+    statistics->adaptiveBitsPerPixel = fmax(statistics->entropy, 1.0) + newSymbolBits / numberOfPixels;
+    // Learning each present symbol frequency costs about half of log2 of pixel count
+    double learningBits = 0.5 * statistics->distinctSymbols * log2(numberOfPixels + 1.0) + RANGE_FLUSH_BYTES * BITS_IN_BYTE;
+    statistics->rangeBitsPerPixel = numberOfSymbols == HISTOGRAM_BINS ? statistics->entropy + learningBits / numberOfPixels : HUGE_VAL;
+    // Worst case of run-length code, one value and one length byte per pixel, until exact size is counted
+    statistics->runLengthBitsPerPixel = literalBits + BITS_IN_BYTE;
+}
+
+uint8_t chooseMode(const imageStatistics* statistics)
+{
+    double bestBitsPerPixel = statistics->staticBitsPerPixel;
+    uint8_t mode = MODE_STATIC_HUFFMAN;
+
+    if (statistics->adaptiveBitsPerPixel < statistics->staticBitsPerPixel * ADAPTIVE_GAIN_THRESHOLD) {
+        bestBitsPerPixel = statistics->adaptiveBitsPerPixel;
+        mode = MODE_ADAPTIVE_HUFFMAN;
+    }
+    if (statistics->rangeBitsPerPixel < bestBitsPerPixel * ADAPTIVE_GAIN_THRESHOLD) {
+        bestBitsPerPixel = statistics->rangeBitsPerPixel;
+        mode = MODE_RANGE;
+    }
+    if (statistics->runLengthBitsPerPixel <= bestBitsPerPixel) {
+        bestBitsPerPixel = statistics->runLengthBitsPerPixel;
+        mode = MODE_RUN_LENGTH;
+    }
+    if (bestBitsPerPixel >= statistics->storedBitsPerPixel)
+        mode = MODE_STORED;
+    return mode;
+}
+
+const char* modeName(uint8_t mode)
+{
+    switch (mode) {
+    case MODE_ADAPTIVE_HUFFMAN: return "adaptive";
+    case MODE_STATIC_HUFFMAN: return "static";
+    case MODE_STORED: return "stored";
+    case MODE_RUN_LENGTH: return "run-length";
+    case MODE_TILED: return "tiled";
+    case MODE_RANGE: return "range";
+    case MODE_PAIR_HUFFMAN: return "pair";
+    case MODE_BIT_PLANE: return "bit-plane";
+    case MODE_PERIODIC_HUFFMAN: return "periodic";
+    default: return "unknown";
+    }
+}
+
+void printStatistics(const imageStatistics* statistics, uint8_t mode)
+{
+    if (!statistics->numberOfPixels) return;
+    double achievedBitsPerPixel = statistics->compressedBytes * (double)BITS_IN_BYTE / statistics->numberOfPixels;
+    // Image updated from previous compressed file is not analysed as a whole
+    if (statistics->distinctSymbols) {
+        printf("Entropy: %.3f bits/pixel (%u grey levels)\n", statistics->entropy, statistics->distinctSymbols);
+        printf("Expected: static %.3f bits/pixel, adaptive ~%.3f bits/pixel, range ~%.3f bits/pixel, run-length %.3f bits/pixel\n",
+               statistics->staticBitsPerPixel, statistics->adaptiveBitsPerPixel, statistics->rangeBitsPerPixel,
+               statistics->runLengthBitsPerPixel);
+    }
+    if (mode == MODE_TILED)
+        printf("Tiles: %u adaptive, %u static, %u range, %u stored, %u run-length, %u duplicate, %u reused\n",
+               statistics->tilesPerMode[MODE_ADAPTIVE_HUFFMAN], statistics->tilesPerMode[MODE_STATIC_HUFFMAN],
+               statistics->tilesPerMode[MODE_RANGE], statistics->tilesPerMode[MODE_STORED],
+               statistics->tilesPerMode[MODE_RUN_LENGTH], statistics->duplicateTiles, statistics->reusedTiles);
+    printf("Mode: %s, achieved %.3f bits/pixel, compression ratio %.3f\n", modeName(mode),
+           achievedBitsPerPixel, statistics->compressedBytes ? (double)statistics->originalBytes / statistics->compressedBytes : 0.0);
+}
+
+double currentSeconds(void)
+{
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
@@ -0,0 +1,105 @@
+#ifndef IMAGE_ANALYSIS_H
+#define IMAGE_ANALYSIS_H
+
+#define HISTOGRAM_BINS 256
+#define HISTOGRAM_TABLES 4
+// Adaptive mode is picked only if it is expected to be noticeably smaller than static code
+#define ADAPTIVE_GAIN_THRESHOLD 0.98
+// Tile counts are indexed with mode, every mode except tiled can be chosen for single tile
+#define TILE_MODES 6
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief:  Statistics of compressed image, gathered while reading and compressing it.
+ * @numberOfPixels: Number of samples in image, pixels times channels.
+ * @distinctSymbols: Number of sample values present in image.
+ * @entropy: First order entropy of image in bits per pixel.
+ * @storedBitsPerPixel: Size of samples stored without coding.
+ * @staticBitsPerPixel: Expected size of static canonical code, including code lengths.
+ * @adaptiveBitsPerPixel: Estimated size of adaptive code: entropy plus cost of new symbols.
+ * @runLengthBitsPerPixel: Exact size of run-length code.
+ * @rangeBitsPerPixel: Estimated size of range code: entropy plus cost of learning frequencies.
+ * @originalBytes: Size of samples before compression, pixels times bytes per sample.
+ * @compressedBytes: Size of compressed file, known after compression.
+ * @encodeSeconds: Time spent coding image, from first block to closed compressed file.
+ * @tilesPerMode: Number of tiles coded with each mode, filled in tiled mode.
+ * @duplicateTiles: Number of tiles written as reference to equal earlier tile, in tiled mode.
+ * @reusedTiles: Number of tiles copied unchanged from previous compressed file of image.
+ */
+typedef struct imageStatistics {
+    uint64_t numberOfPixels;
+    uint32_t distinctSymbols;
+    double entropy;
+    double storedBitsPerPixel;
+    double staticBitsPerPixel;
+    double adaptiveBitsPerPixel;
+    double runLengthBitsPerPixel;
+    double rangeBitsPerPixel;
+    uint64_t originalBytes;
+    uint64_t compressedBytes;
+    double encodeSeconds;
+    uint32_t tilesPerMode[TILE_MODES];
+    uint32_t duplicateTiles;
+    uint32_t reusedTiles;
+} imageStatistics;
+
+/**
+  * @brief  Adds occurrences of each byte value in data to histogram. Counting is spread over
+  *         several tables fed from 64 bit words, so consecutive equal bytes do not wait for
+  *         each other's increment, and tables are summed at the end.
+  * @param  data Pointer to counted bytes
+  * @param  length Number of counted bytes
+  * @param  histogram Array of HISTOGRAM_BINS counters that are incremented
+  * @retval None
+  */
+void accumulateHistogram(const uint8_t* data, uint64_t length, uint64_t* histogram);
+
+/**
+  * @brief  Computes entropy and expected code sizes of image described by histogram. Static
+  *         and range code handle only 8 bit samples, for larger alphabet their size is set
+  *         to infinity, so they are never chosen.
+  * @param  histogram Array of sample value counts
+  * @param  numberOfSymbols Size of histogram, HISTOGRAM_BINS or 65536 for 16 bit samples
+  * @param  statistics Pointer to struct receiving statistics
+  * @retval None
+  */
+void analyzeHistogram(const uint64_t* histogram, uint32_t numberOfSymbols, imageStatistics* statistics);
+
+/**
+  * @brief  Chooses cheapest coding mode: stored if no code saves space, adaptive Huffman if
+  *         its estimate is clearly below static code (small images, where code lengths cost
+  *         relatively much), static canonical Huffman otherwise. Range code replaces chosen
+  *         Huffman code if it is clearly smaller, which happens when Huffman code can not
+  *         go below 1 bit per pixel. Run-length code, fastest of all, wins whenever it is
+  *         not larger than chosen code.
+  * @param  statistics Pointer to statistics filled by analyzeHistogram() and with run-length size
+  * @retval Chosen coding mode
+  */
+uint8_t chooseMode(const imageStatistics* statistics);
+
+/**
+  * @brief  Prints entropy, expected and achieved bits per pixel and compression ratio.
+  * @param  statistics Pointer to statistics of compressed image
+  * @param  mode Coding mode used to compress image
+  * @retval None
+  */
+void printStatistics(const imageStatistics* statistics, uint8_t mode);
+
+/**
+  * @brief  Returns printable name of coding mode.
+  * @param  mode Coding mode
+  * @retval Name of mode, "unknown" for unknown mode
+  */
+const char* modeName(uint8_t mode);
+
+/**
+  * @brief  Returns current wall clock time, used to measure coding time.
+  * @retval Time in seconds
+  */
+double currentSeconds(void);
+
+#endif // IMAGE_ANALYSIS_H
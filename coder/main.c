@@ -1,19 +1,279 @@
 #include "fileOperations.h"
+#include "dictionary.h"
+#include "checkpointIndex.h"
+#include "batchCoder.h"
+#include "compressionReport.h"
+#include "scanOrder.h"
+#include "bitPlanes.h"
+#include "archiveWriter.h"
+#include "tileUpdate.h"
+#include "sequenceCoder.h"
 
-uint8_t run()
+/**
+  * @brief  Compresses PGM file into compressed file.
+  * @param  inputPath Path to PGM file, or NULL to ask user for it
+  * @param  outputPath Path to compressed file, or NULL to ask user for it
+  * @param  mode Coding mode used to compress file
+  * @param  tileSide Side of tiles used in tiled mode
+  * @param  scanOrder Order in which samples of every block are coded
+  * @param  bitPlaneFlags Flags of blocks coded in bit-plane mode
+  * @param  dictionaryPath Path to dictionary adaptive blocks start from, or NULL
+  * @param  indexPath Path to checkpoint index written while coding, or NULL
+  * @param  checkpointInterval Number of pixels between checkpoints of index
+  * @param  reportPath Path to JSON or CSV report of compression, or NULL
+  * @param  previousPath Path to previous tiled compressed file of image updated in place of
+  *         compressing it whole, or NULL
+  * @param  rectangles Changed rectangles of image, tiles they touch are coded again
+  * @param  numberOfRectangles Number of changed rectangles
+  * @retval 0 if file was compressed successfully, 1 otherwise
+  */
+uint8_t run(const char* inputPath, const char* outputPath, uint8_t mode, uint16_t tileSide, uint8_t scanOrder,
+            uint8_t bitPlaneFlags, const char* dictionaryPath, const char* indexPath, uint64_t checkpointInterval, const char* reportPath,
+            const char* previousPath, const dirtyRectangle* rectangles, uint32_t numberOfRectangles)
 {
+    double start = currentSeconds();
     handler* handler = createHandler();
     if (!handler) return 1;
-    if (initialize(handler)) return 1;
-    if (constructTree(handler)) return 1;
+    handler->mode = mode;
+    handler->tileSide = tileSide;
+    handler->records.scanOrder = scanOrder;
+    handler->bitPlaneFlags = bitPlaneFlags;
+    uint8_t status = (dictionaryPath && loadDictionary(handler, dictionaryPath)) ||
+                     (indexPath && openCheckpointIndex(handler, indexPath, checkpointInterval)) ||
+                     (previousPath && openTileUpdate(handler, previousPath, rectangles, numberOfRectangles)) ||
+                     initialize(handler, inputPath, outputPath) || compressData(handler);
+    if (reportPath) {
+        reportEntry report;
+        fillReportEntry(&report, inputPath, handler, status);
+        status |= writeReport(reportPath, &report, 1, currentSeconds() - start);
+    }
     freeAlocatedMemory(handler);
-    scanf("%d", NULL);
-    return 0;
+    free(handler);
+    return status;
 }
 
-int main()
+/**
+  * @brief  Compresses batch of images into directory and writes report of all of them.
+  * @param  outputDirectory Directory of compressed files
+  * @param  inputPaths Paths to PGM or PPM images
+  * @param  numberOfInputs Number of images
+  * @param  settings Pointer to settings of batch
+  * @param  reportPath Path to JSON or CSV report of compression, or NULL
+  * @retval 0 if every image was compressed, 1 otherwise
+  */
+uint8_t runBatch(const char* outputDirectory, char** inputPaths, uint32_t numberOfInputs, batchSettings* settings,
+                 const char* reportPath)
 {
-    run();
-    scanf("%d", NULL);
+    if (!reportPath)
+        return compressBatch(outputDirectory, inputPaths, numberOfInputs, settings);
+    settings->reports = (reportEntry*)calloc(numberOfInputs ? numberOfInputs : 1, sizeof(reportEntry));
+    if (!settings->reports) {
+        printf("Error: Cannot allocate memory for report\n");
+        return 1;
+    }
+    // Images that never reach coder stay reported as failed
+    for (uint32_t i = 0; i < numberOfInputs; i++) {
+        settings->reports[i].name = inputPaths[i];
+        settings->reports[i].status = 1;
+    }
+    double start = currentSeconds();
+    uint8_t status = compressBatch(outputDirectory, inputPaths, numberOfInputs, settings);
+    status |= writeReport(reportPath, settings->reports, numberOfInputs, currentSeconds() - start);
+    free(settings->reports);
+    settings->reports = NULL;
+    return status;
+}
+
+/**
+  * @brief  Parses changed rectangle given as "row,column,rows,columns".
+  * @param  text Text of rectangle
+  * @param  rectangle Pointer to rectangle receiving parsed values
+  * @retval 0 if rectangle is valid, 1 otherwise
+  */
+static uint8_t parseRectangle(const char* text, dirtyRectangle* rectangle)
+{
+    unsigned long values[4];
+    char* end = (char*)text;
+    for (uint8_t i = 0; i < 4; i++) {
+        values[i] = strtoul(end, &end, 10);
+        if (values[i] > UINT32_MAX || *end != (i < 3 ? ',' : '\0')) return 1;
+        end++;
+    }
+    rectangle->row = (uint32_t)values[0];
+    rectangle->column = (uint32_t)values[1];
+    rectangle->rows = (uint32_t)values[2];
+    rectangle->columns = (uint32_t)values[3];
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char** argv)
+{
+    uint8_t mode = MODE_AUTO;
+    uint16_t tileSide = DEFAULT_TILE_SIDE;
+    uint8_t scanOrder = SCAN_ROW;
+    uint8_t bitPlaneFlags = 0;
+    const char* dictionaryPath = NULL;
+    const char* indexPath = NULL;
+    const char* reportPath = NULL;
+    const char* previousPath = NULL;
+    uint32_t numberOfRectangles = 0;
+    uint64_t checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+    batchSettings batch = { .threads = 0, .engine = IO_ENGINE_AUTO, .queueDepth = DEFAULT_QUEUE_DEPTH, .reports = NULL };
+    sequenceSettings sequence = { .keyframeInterval = DEFAULT_KEYFRAME_INTERVAL, .ageShift = 0, .predictor = 0 };
+    int argument = 1;
+
+    while (argc - argument > 1 && !strncmp(argv[argument], "--", 2)) {
+        if (!strcmp(argv[argument], "--mode")) {
+            if (parseMode(argv[argument + 1], &mode)) {
+                printf("Error: Unknown mode \"%s\"\n", argv[argument + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--tile")) {
+            unsigned long side = strtoul(argv[argument + 1], NULL, 10);
+            if (!side || side > UINT16_MAX) {
+                printf("Error: Tile side must be between 1 and %u\n", UINT16_MAX);
+                return 1;
+            }
+            tileSide = (uint16_t)side;
+        } else if (!strcmp(argv[argument], "--scan")) {
+            if (parseScanOrder(argv[argument + 1], &scanOrder)) {
+                printf("Error: Unknown scan order \"%s\"\n", argv[argument + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--planes")) {
+            if (!strcmp(argv[argument + 1], "gray")) {
+                bitPlaneFlags = BIT_PLANE_GRAY;
+            } else if (!strcmp(argv[argument + 1], "binary")) {
+                bitPlaneFlags = 0;
+            } else {
+                printf("Error: Unknown bit-plane coding \"%s\"\n", argv[argument + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--dictionary")) {
+            dictionaryPath = argv[argument + 1];
+        } else if (!strcmp(argv[argument], "--report")) {
+            reportPath = argv[argument + 1];
+        } else if (!strcmp(argv[argument], "--index")) {
+            indexPath = argv[argument + 1];
+        } else if (!strcmp(argv[argument], "--update")) {
+            previousPath = argv[argument + 1];
+        } else if (!strcmp(argv[argument], "--dirty")) {
+            dirtyRectangle rectangle;
+            if (parseRectangle(argv[argument + 1], &rectangle)) {
+                printf("Error: Changed rectangle must be row,column,rows,columns\n");
+                return 1;
+            }
+            numberOfRectangles++;
+        } else if (!strcmp(argv[argument], "--checkpoint-interval")) {
+            checkpointInterval = strtoull(argv[argument + 1], NULL, 10);
+            if (!checkpointInterval) {
+                printf("Error: Checkpoint interval must be positive\n");
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--keyframe-interval")) {
+            unsigned long interval = strtoul(argv[argument + 1], NULL, 10);
+            if (interval > UINT32_MAX) {
+                printf("Error: Keyframe interval must be at most %u\n", UINT32_MAX);
+                return 1;
+            }
+            sequence.keyframeInterval = (uint32_t)interval;
+        } else if (!strcmp(argv[argument], "--age")) {
+            unsigned long shift = strtoul(argv[argument + 1], NULL, 10);
+            if (shift > MAX_AGE_SHIFT) {
+                printf("Error: Age shift must be at most %u\n", MAX_AGE_SHIFT);
+                return 1;
+            }
+            sequence.ageShift = (uint8_t)shift;
+        } else if (!strcmp(argv[argument], "--predict")) {
+            if (!strcmp(argv[argument + 1], "previous")) {
+                sequence.predictor = SEQUENCE_PREDICT_PREVIOUS;
+            } else if (!strcmp(argv[argument + 1], "none")) {
+                sequence.predictor = 0;
+            } else {
+                printf("Error: Unknown frame predictor \"%s\"\n", argv[argument + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--threads")) {
+            unsigned long threads = strtoul(argv[argument + 1], NULL, 10);
+            if (threads > UINT16_MAX) {
+                printf("Error: Number of threads must be at most %u\n", UINT16_MAX);
+                return 1;
+            }
+            batch.threads = (uint16_t)threads;
+        } else if (!strcmp(argv[argument], "--io")) {
+            if (parseIoEngine(argv[argument + 1], &batch.engine)) {
+                printf("Error: Unknown I/O engine \"%s\"\n", argv[argument + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--queue-depth")) {
+            unsigned long depth = strtoul(argv[argument + 1], NULL, 10);
+            if (!depth || depth > 4096) {
+                printf("Error: Queue depth must be between 1 and 4096\n");
+                return 1;
+            }
+            batch.queueDepth = (uint32_t)depth;
+        } else if (!strcmp(argv[argument], "--batch")) {
+            // Remaining arguments are images compressed into output directory
+            batch.mode = mode;
+            batch.tileSide = tileSide;
+            batch.scanOrder = scanOrder;
+            batch.bitPlaneFlags = bitPlaneFlags;
+            return runBatch(argv[argument + 1], &argv[argument + 2], argc - argument - 2, &batch, reportPath);
+        } else if (!strcmp(argv[argument], "--archive")) {
+            // Remaining arguments are images appended to archive
+            batch.mode = mode;
+            batch.tileSide = tileSide;
+            batch.scanOrder = scanOrder;
+            batch.bitPlaneFlags = bitPlaneFlags;
+            return appendToArchive(argv[argument + 1], &argv[argument + 2], argc - argument - 2, &batch);
+        } else if (!strcmp(argv[argument], "--sequence")) {
+            // Remaining arguments are frames in order
+            return compressSequence(argv[argument + 1], &argv[argument + 2], argc - argument - 2, &sequence);
+        } else if (!strcmp(argv[argument], "--train-dictionary")) {
+            // Remaining arguments are training images
+            return trainDictionary(argv[argument + 1], &argv[argument + 2], argc - argument - 2);
+        } else {
+            break;
+        }
+        argument += 2;
+    }
+    if (argc - argument == 2 && previousPath) {
+        // Rectangles were checked while reading options, every option takes one value
+        dirtyRectangle* rectangles = (dirtyRectangle*)malloc((numberOfRectangles ? numberOfRectangles : 1) * sizeof(dirtyRectangle));
+        if (!rectangles) {
+            printf("Error: Cannot allocate memory for changed rectangles\n");
+            return 1;
+        }
+        numberOfRectangles = 0;
+        for (int option = 1; option < argument; option += 2)
+            if (!strcmp(argv[option], "--dirty"))
+                parseRectangle(argv[option + 1], &rectangles[numberOfRectangles++]);
+        uint8_t status = run(argv[argument], argv[argument + 1], mode, tileSide, scanOrder, bitPlaneFlags, dictionaryPath, indexPath,
+                             checkpointInterval, reportPath, previousPath, rectangles, numberOfRectangles);
+        free(rectangles);
+        return status;
+    }
+    if (argc - argument == 2)
+        return run(argv[argument], argv[argument + 1], mode, tileSide, scanOrder, bitPlaneFlags, dictionaryPath, indexPath, checkpointInterval, reportPath,
+                   NULL, NULL, 0);
+    if (argc != argument) {
+        printf("Usage: %s [--mode auto|adaptive|pair|bitplane|static|periodic|range|stored|runlength|tiled]\n", argv[0]);
+        printf("       %*s [--tile side] [--dictionary dict.kdd] [--scan row|serpentine|hilbert|tile] [--planes binary|gray]\n", (int)strlen(argv[0]), "");
+        printf("       %*s [--report report.json|report.csv]\n", (int)strlen(argv[0]), "");
+        printf("       %*s [--index index.kdx [--checkpoint-interval pixels]] [input.pgm output.bin]\n", (int)strlen(argv[0]), "");
+        printf("       %s [--dictionary dict.kdd] --update previous.bin [--dirty row,column,rows,columns]... input.pgm output.bin\n", argv[0]);
+        printf("       %s [--mode mode] [--tile side] [--scan order] [--planes coding] [--threads n] [--io auto|uring|blocking] [--queue-depth n]\n", argv[0]);
+        printf("       %*s [--report report.json|report.csv]\n", (int)strlen(argv[0]), "");
+        printf("       %*s --batch output-directory image.pgm...\n", (int)strlen(argv[0]), "");
+        printf("       %s [--mode mode] [--tile side] [--scan order] [--planes coding] --archive archive.kda image.pgm...\n", argv[0]);
+        printf("       %s [--keyframe-interval frames] [--age shift] [--predict previous|none] --sequence sequence.kds frame.pgm...\n", argv[0]);
+        printf("       %s --train-dictionary dict.kdd image.pgm...\n", argv[0]);
+        return 1;
+    }
+    // Interactive mode: ask for paths and keep console open until user presses enter
+    uint8_t status = run(NULL, NULL, mode, tileSide, scanOrder, bitPlaneFlags, dictionaryPath, indexPath, checkpointInterval, reportPath,
+                         NULL, NULL, 0);
+    getchar();
+    getchar();
+    return status;
+}
@@ -0,0 +1,125 @@
+#include "memoryArena.h"
+#include <stdlib.h>
+
+/**
+ * @brief:  Block of memory reserved by arena.
+ * @next: Next block of arena, NULL for last one.
+ * @size: Number of bytes of block available for allocations.
+ * @used: Number of bytes of block allocated since last reset.
+ */
+typedef struct arenaBlock {
+    struct arenaBlock* next;
+    size_t size;
+    size_t used;
+} arenaBlock;
+
+// Memory of block follows its description, aligned as every allocation
+#define BLOCK_HEADER_SIZE ((sizeof(arenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+/**
+ * @brief:  Bump arena, allocator is its first member so pointers to both are the same.
+ * @base: Allocator interface.
+ * @first: First block, reused first after reset.
+ * @current: Block allocations are taken from.
+ * @blockSize: Size of blocks reserved for allocations smaller than it.
+ */
+typedef struct memoryArena {
+    allocator base;
+    arenaBlock* first;
+    arenaBlock* current;
+    size_t blockSize;
+} memoryArena;
+
+static void* allocateHeap(allocator* my, size_t size)
+{
+    (void)my;
+    return malloc(size ? size : 1);
+}
+
+static void releaseHeap(allocator* my, void* memory)
+{
+    (void)my;
+    free(memory);
+}
+
+allocator* heapAllocator(void)
+{
+    static allocator heap = { .allocate = allocateHeap, .release = releaseHeap, .reset = NULL, .killMe = NULL };
+    return &heap;
+}
+
+/**
+  * @brief  Reserves new block after current one, blocks behind it are kept for later.
+  * @param  my Pointer to arena
+  * @param  size Number of bytes block must hold
+  * @retval Pointer to block, NULL if memory allocation fails
+  */
+static arenaBlock* reserveBlock(memoryArena* my, size_t size)
+{
+    size_t blockSize = size > my->blockSize ? size : my->blockSize;
+    if (blockSize > SIZE_MAX - BLOCK_HEADER_SIZE) return NULL;
+    arenaBlock* block = (arenaBlock*)malloc(BLOCK_HEADER_SIZE + blockSize);
+    if (!block) return NULL;
+    block->size = blockSize;
+    block->used = 0;
+    if (my->current) {
+        block->next = my->current->next;
+        my->current->next = block;
+    } else {
+        block->next = NULL;
+        my->first = block;
+    }
+    return block;
+}
+
+static void* allocateArena(allocator* base, size_t size)
+{
+    memoryArena* my = (memoryArena*)base;
+    if (size > SIZE_MAX - ARENA_ALIGNMENT) return NULL;
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (!size) size = ARENA_ALIGNMENT;
+    arenaBlock* block = my->current;
+    if (!block || block->size - block->used < size) {
+        // Following block left from previous image is emptied when allocation reaches it
+        block = block && block->next && block->next->size >= size ? block->next : reserveBlock(my, size);
+        if (!block) return NULL;
+        block->used = 0;
+        my->current = block;
+    }
+    void* memory = (uint8_t*)block + BLOCK_HEADER_SIZE + block->used;
+    block->used += size;
+    return memory;
+}
+
+static void resetArena(allocator* base)
+{
+    memoryArena* my = (memoryArena*)base;
+    my->current = my->first;
+    if (my->current) my->current->used = 0;
+}
+
+static void freeArena(allocator** base)
+{
+    memoryArena* my = (memoryArena*)*base;
+    for (arenaBlock* block = my->first; block;) {
+        arenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(my);
+    *base = NULL;
+}
+
+allocator* createArena(size_t blockSize)
+{
+    memoryArena* my = (memoryArena*)malloc(sizeof(memoryArena));
+    if (!my) return NULL;
+    my->base.allocate = allocateArena;
+    my->base.release = NULL;
+    my->base.reset = resetArena;
+    my->base.killMe = freeArena;
+    my->first = NULL;
+    my->current = NULL;
+    my->blockSize = blockSize ? blockSize : DEFAULT_ARENA_BLOCK_SIZE;
+    return &my->base;
+}
@@ -0,0 +1,54 @@
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+// Arena reserves memory in blocks of at least this size, larger allocations get own block
+#define DEFAULT_ARENA_BLOCK_SIZE (1u << 20)
+#define ARENA_ALIGNMENT 16
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief:  Source of memory of coder. Memory of image and tree is taken from allocator of
+ *          handler and given back either block by block or all at once between images.
+ * @allocate: Returns uninitialised memory of given size aligned for any type, NULL on error.
+ * @release: Gives back single block, NULL if memory is only given back by reset.
+ * @reset: Gives back every block at once, NULL if blocks must be released one by one.
+ * @killMe: Frees allocator and memory it still holds, NULL for allocator that is never freed.
+ */
+typedef struct allocator {
+    void* (*allocate)(struct allocator*, size_t);
+    void (*release)(struct allocator*, void*);
+    void (*reset)(struct allocator*);
+    void (*killMe)(struct allocator**);
+} allocator;
+
+/**
+  * @brief  Returns allocator passing every call to malloc() and free(), shared by all users.
+  * @param  None
+  * @retval Pointer to allocator
+  */
+allocator* heapAllocator(void);
+
+/**
+  * @brief  Creates bump arena: memory is taken from blocks in order and given back only by
+  *         reset, which keeps blocks for next image, so image coded after first one of the
+  *         same size needs no malloc() at all.
+  * @param  blockSize Size of blocks reserved with malloc(), 0 for DEFAULT_ARENA_BLOCK_SIZE
+  * @retval Pointer to arena, NULL if memory allocation fails
+  */
+allocator* createArena(size_t blockSize);
+
+/**
+  * @brief  Gives back single block of allocator that releases blocks one by one.
+  * @param  my Pointer to allocator
+  * @param  memory Block taken from allocator, NULL is ignored
+  * @retval None
+  */
+static inline void releaseMemory(allocator* my, void* memory)
+{
+    if (memory && my->release)
+        my->release(my, memory);
+}
+
+#endif // MEMORY_ARENA_H
@@ -0,0 +1,74 @@
+#include "periodicHuffman.h"
+#include "fileOperations.h"
+
+/**
+  * @brief  Builds code of model from its counts, halving counts first when their sum is over
+  *         PERIODIC_MAX_TOTAL, and starts new drift measurement.
+  * @param  my Pointer to model
+  * @retval None
+  */
+static void rebuildCode(periodicModel* my)
+{
+    if (my->total > PERIODIC_MAX_TOTAL) {
+        my->total = 0;
+        for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++) {
+            my->counts[i] -= my->counts[i] / 2;
+            my->total += my->counts[i];
+        }
+    }
+    buildLimitedCode(my->counts, PERIODIC_MAX_CODE_LENGTH, &my->code);
+    my->expectedBits = 0;
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+        my->expectedBits += my->counts[i] * my->code.length[i];
+    my->expectedTotal = my->total;
+    my->codedBits = 0;
+    my->codedSymbols = 0;
+}
+
+/**
+  * @brief  Counts coded symbol and rebuilds code when interval ends or code drifts.
+  * @param  my Pointer to model
+  * @param  symbol Coded symbol
+  * @retval None
+  */
+static void updateModel(periodicModel* my, uint8_t symbol)
+{
+    my->codedBits += my->code.length[symbol];
+    my->counts[symbol]++;
+    my->total++;
+    if (++my->codedSymbols == my->interval) {
+        if (my->interval < PERIODIC_INTERVAL)
+            my->interval *= 2;
+        rebuildCode(my);
+    } else if (my->codedSymbols % PERIODIC_DRIFT_WINDOW == 0) {
+        // Bits per symbol compared with expected ones without division
+        if (my->codedBits * my->expectedTotal * 8 > my->expectedBits * my->codedSymbols * PERIODIC_DRIFT_EIGHTHS)
+            rebuildCode(my);
+    }
+}
+
+uint8_t encodePeriodic(handler* my)
+{
+    if (my->records.bytesPerSample > 1) {
+        printf("Error: Periodic Huffman mode supports only 8 bit samples\n");
+        return 1;
+    }
+    periodicModel model;
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+        model.counts[i] = 1;
+    model.total = NUMBER_OF_SYMBOLS;
+    model.interval = PERIODIC_FIRST_INTERVAL;
+    rebuildCode(&model);
+
+    while (my->records.remainingRecords) {
+        uint8_t symbol = (uint8_t)my->records.popRecord(&my->records);
+        if (writeToFile(&my->bitBuffer, my->compressedFile, model.code.code[symbol], model.code.length[symbol])) {
+            printf("ERROR: Cannot write to file!");
+            return 1;
+        }
+        updateModel(&model, symbol);
+    }
+    // Write remaining bits in buffer
+    if (writeToFile(&my->bitBuffer, my->compressedFile, 0, 0)) return 1;
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef PERIODIC_HUFFMAN_H
+#define PERIODIC_HUFFMAN_H
+
+// Code is rebuilt after interval of symbols, or after multiple of drift window when code
+// costs more than expected by more than PERIODIC_DRIFT_EIGHTHS / 8. Interval starts short,
+// so code learns first samples quickly, and doubles after every rebuild up to the longest one.
+#define PERIODIC_FIRST_INTERVAL 64
+#define PERIODIC_INTERVAL 8192
+#define PERIODIC_DRIFT_WINDOW 1024
+#define PERIODIC_DRIFT_EIGHTHS 9
+// Codes of symbols never seen are long, so limit of static code would cost too much
+#define PERIODIC_MAX_CODE_LENGTH 15
+// Counts are halved at rebuild when they sum to more, so code follows recent samples
+#define PERIODIC_MAX_TOTAL (1 << 16)
+
+#include "staticHuffman.h"
+
+/**
+ * @brief:  Semi-adaptive model: symbol counts and canonical code built from them.
+ * @counts: Count of each symbol, every symbol starts with 1 so it always has code.
+ * @total: Sum of counts.
+ * @expectedBits: Sum of counts times code lengths at last rebuild.
+ * @expectedTotal: Sum of counts at last rebuild.
+ * @codedBits: Number of bits of symbols coded since last rebuild.
+ * @interval: Number of symbols between last and next regular rebuild.
+ * @codedSymbols: Number of symbols coded since last rebuild.
+ * @code: Canonical code of symbols.
+ */
+typedef struct periodicModel {
+    uint64_t counts[NUMBER_OF_SYMBOLS];
+    uint64_t total;
+    uint64_t expectedBits;
+    uint64_t expectedTotal;
+    uint64_t codedBits;
+    uint32_t interval;
+    uint32_t codedSymbols;
+    canonicalCode code;
+} periodicModel;
+
+/**
+  * @brief  Compresses records window with canonical Huffman code rebuilt from symbol counts
+  *         every PERIODIC_INTERVAL symbols, or sooner when coded samples drift away from
+  *         counts the code was built from. Each symbol costs table lookup and counter
+  *         increment, decoder rebuilds the same code at the same symbols.
+  * @param  my A pointer to handler struct with loaded records and opened compressed file.
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+uint8_t encodePeriodic(handler* my);
+
+#endif // PERIODIC_HUFFMAN_H
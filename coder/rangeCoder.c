@@ -0,0 +1,142 @@
+#include "rangeCoder.h"
+#include "fileOperations.h"
+
+/**
+ * @brief:  State of range encoder. Carry is propagated through pending 0xFF bytes, which
+ *          are held back until byte that can not receive carry is known.
+ * @low: Lower end of current interval, bit 32 holds carry.
+ * @range: Width of current interval.
+ * @cache: Last byte not written yet, it may still receive carry.
+ * @pendingBytes: Number of held back bytes, cache and following 0xFF bytes.
+ */
+typedef struct rangeEncoder {
+    uint64_t low;
+    uint32_t range;
+    uint8_t cache;
+    uint64_t pendingBytes;
+} rangeEncoder;
+
+/**
+  * @brief  Sets all frequencies to 1 and builds Fenwick tree of them.
+  * @param  model Pointer to model
+  * @retval None
+  */
+static void resetModel(frequencyModel* model)
+{
+    for (uint16_t symbol = 0; symbol < RANGE_SYMBOLS; symbol++)
+        model->frequency[symbol] = 1;
+    // Entry i of Fenwick tree covers lowbit(i) symbols, all of frequency 1
+    model->fenwick[0] = 0;
+    for (uint16_t i = 1; i <= RANGE_SYMBOLS; i++)
+        model->fenwick[i] = i & -i;
+    model->total = RANGE_SYMBOLS;
+}
+
+/**
+  * @brief  Halves all frequencies, keeping them above 0, and rebuilds Fenwick tree in place.
+  * @param  model Pointer to model
+  * @retval None
+  */
+static void rescaleModel(frequencyModel* model)
+{
+    model->total = 0;
+    for (uint16_t symbol = 0; symbol < RANGE_SYMBOLS; symbol++) {
+        model->frequency[symbol] = (model->frequency[symbol] + 1) >> 1;
+        model->fenwick[symbol + 1] = model->frequency[symbol];
+        model->total += model->frequency[symbol];
+    }
+    for (uint16_t i = 1; i <= RANGE_SYMBOLS; i++) {
+        uint16_t parent = i + (i & -i);
+        if (parent <= RANGE_SYMBOLS)
+            model->fenwick[parent] += model->fenwick[i];
+    }
+}
+
+/**
+  * @brief  Returns sum of frequencies of symbols lower than given symbol.
+  * @param  model Pointer to model
+  * @param  symbol Symbol value
+  * @retval Cumulative frequency
+  */
+static uint32_t cumulativeFrequency(const frequencyModel* model, uint16_t symbol)
+{
+    uint32_t sum = 0;
+    for (uint16_t i = symbol; i; i &= i - 1)
+        sum += model->fenwick[i];
+    return sum;
+}
+
+/**
+  * @brief  Increments frequency of symbol, rescaling model when total grows too large.
+  * @param  model Pointer to model
+  * @param  symbol Symbol value
+  * @retval None
+  */
+static void updateModel(frequencyModel* model, uint16_t symbol)
+{
+    model->frequency[symbol] += RANGE_INCREMENT;
+    for (uint16_t i = symbol + 1; i <= RANGE_SYMBOLS; i += i & -i)
+        model->fenwick[i] += RANGE_INCREMENT;
+    model->total += RANGE_INCREMENT;
+    if (model->total > RANGE_MAX_TOTAL - RANGE_INCREMENT)
+        rescaleModel(model);
+}
+
+/**
+  * @brief  Moves top byte of low out of encoder. Byte is held back as cache while it can
+  *         still receive carry, 0xFF bytes after it are only counted.
+  * @param  my A pointer to handler struct with opened compressed file.
+  * @param  encoder Pointer to encoder state
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
+  */
+static uint8_t shiftLow(handler* my, rangeEncoder* encoder)
+{
+    if ((uint32_t)encoder->low < 0xFF000000u || (encoder->low >> 32)) {
+        uint8_t carry = encoder->low >> 32;
+        uint8_t byte = encoder->cache;
+        do {
+            if (writeToFile(&my->bitBuffer, my->compressedFile, (uint8_t)(byte + carry), BITS_IN_BYTE)) return 1;
+            byte = 0xFF;
+        } while (--encoder->pendingBytes);
+        encoder->cache = (encoder->low >> 24) & 0xFF;
+    }
+    encoder->pendingBytes++;
+    encoder->low = (encoder->low & 0x00FFFFFF) << BITS_IN_BYTE;
+    return 0;
+}
+
+uint8_t encodeRange(handler* my)
+{
+    frequencyModel model;
+    rangeEncoder encoder = { 0, 0xFFFFFFFFu, 0, 1 };
+
+    if (my->records.bytesPerSample > 1) {
+        printf("Error: Range mode supports only 8 bit samples\n");
+        return 1;
+    }
+    resetModel(&model);
+    while (my->records.remainingRecords) {
+        uint16_t symbol = my->records.popRecord(&my->records);
+        uint32_t step = encoder.range / model.total;
+        encoder.low += (uint64_t)step * cumulativeFrequency(&model, symbol);
+        encoder.range = step * model.frequency[symbol];
+        while (encoder.range < RANGE_TOP) {
+            encoder.range <<= BITS_IN_BYTE;
+            if (shiftLow(my, &encoder)) {
+                printf("ERROR: Cannot write to file!");
+                return 1;
+            }
+        }
+        updateModel(&model, symbol);
+    }
+    // Flush low, so decoder can read whole interval
+    for (uint8_t i = 0; i < RANGE_FLUSH_BYTES; i++) {
+        if (shiftLow(my, &encoder)) {
+            printf("ERROR: Cannot write to file!");
+            return 1;
+        }
+    }
+    // Write remaining bits in buffer
+    if (writeToFile(&my->bitBuffer, my->compressedFile, 0, 0)) return 1;
+    return 0;
+}
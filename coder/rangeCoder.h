@@ -0,0 +1,37 @@
+#ifndef RANGE_CODER_H
+#define RANGE_CODER_H
+
+#define RANGE_SYMBOLS 256
+// Frequencies are halved when their total would exceed RANGE_MAX_TOTAL, so range divided
+// by total always keeps at least 8 bits of precision
+#define RANGE_MAX_TOTAL (1 << 16)
+#define RANGE_INCREMENT 24
+#define RANGE_TOP (1u << 24)
+#define RANGE_FLUSH_BYTES 5
+
+#include "treeOperations.h"
+
+/**
+ * @brief:  Adaptive frequency model of 8 bit symbols. Cumulative frequencies are kept in
+ *          Fenwick tree, so both updating symbol and finding its cumulative frequency take
+ *          log2(RANGE_SYMBOLS) steps.
+ * @frequency: Current frequency of each symbol, never 0.
+ * @fenwick: Fenwick tree of frequencies, entry i holds sum of frequencies (i - lowbit(i), i].
+ * @total: Sum of all frequencies.
+ */
+typedef struct frequencyModel {
+    uint16_t frequency[RANGE_SYMBOLS];
+    uint32_t fenwick[RANGE_SYMBOLS + 1];
+    uint32_t total;
+} frequencyModel;
+
+/**
+  * @brief  Compresses records window with range coder driven by adaptive frequency model.
+  *         Model starts with equal frequencies and is updated after each symbol, so
+  *         symbols cost close to their entropy and, unlike Huffman code, less than 1 bit.
+  * @param  my A pointer to handler struct with loaded records and opened compressed file.
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+uint8_t encodeRange(handler* my);
+
+#endif // RANGE_CODER_H
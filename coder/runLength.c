@@ -0,0 +1,80 @@
+#include "runLength.h"
+#include "fileOperations.h"
+
+/**
+  * @brief  Returns number of LEB128 bytes needed to write run length.
+  * @param  length Run length minus one
+  * @retval Number of bytes
+  */
+static uint8_t lengthBytes(uint64_t length)
+{
+    uint8_t bytes = 1;
+    while (length >>= RUN_LENGTH_PAYLOAD_BITS)
+        bytes++;
+    return bytes;
+}
+
+/**
+  * @brief  Writes single run: sample value and LEB128 run length minus one.
+  * @param  my A pointer to handler struct with opened compressed file.
+  * @param  value Sample value of run, written on bytes of single sample
+  * @param  length Run length minus one
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
+  */
+static uint8_t writeRun(handler* my, uint16_t value, uint64_t length)
+{
+    if (writeToFile(&my->bitBuffer, my->compressedFile, value, BITS_IN_BYTE * my->records.bytesPerSample)) return 1;
+    while (length > RUN_LENGTH_PAYLOAD) {
+        if (writeToFile(&my->bitBuffer, my->compressedFile, RUN_LENGTH_CONTINUE | (length & RUN_LENGTH_PAYLOAD), BITS_IN_BYTE)) return 1;
+        length >>= RUN_LENGTH_PAYLOAD_BITS;
+    }
+    return writeToFile(&my->bitBuffer, my->compressedFile, (uint32_t)length, BITS_IN_BYTE);
+}
+
+uint64_t countRunLengthBytes(const records* my)
+{
+    uint64_t bytes = 0;
+    uint64_t length = 0;
+    uint16_t value = readSample(my, my->windowOrigin[0], my->windowOrigin[1]);
+
+    for (uint32_t row = my->windowOrigin[0]; row < (uint32_t)my->windowOrigin[0] + my->windowDimension[0]; row++) {
+        for (uint32_t column = my->windowOrigin[1]; column < (uint32_t)my->windowOrigin[1] + my->windowDimension[1]; column++) {
+            uint16_t sample = readSample(my, row, column);
+            if (sample == value) {
+                length++;
+                continue;
+            }
+            bytes += my->bytesPerSample + lengthBytes(length - 1);
+            value = sample;
+            length = 1;
+        }
+    }
+    return bytes + my->bytesPerSample + lengthBytes(length - 1);
+}
+
+uint8_t encodeRunLength(handler* my)
+{
+    uint16_t value = my->records.popRecord(&my->records);
+    uint64_t length = 0;
+
+    while (my->records.remainingRecords) {
+        uint16_t symbol = my->records.popRecord(&my->records);
+        if (symbol == value) {
+            length++;
+            continue;
+        }
+        if (writeRun(my, value, length)) {
+            printf("ERROR: Cannot write to file!");
+            return 1;
+        }
+        value = symbol;
+        length = 0;
+    }
+    if (writeRun(my, value, length)) {
+        printf("ERROR: Cannot write to file!");
+        return 1;
+    }
+    // Write remaining bits in buffer
+    if (writeToFile(&my->bitBuffer, my->compressedFile, 0, 0)) return 1;
+    return 0;
+}
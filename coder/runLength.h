@@ -0,0 +1,28 @@
+#ifndef RUN_LENGTH_H
+#define RUN_LENGTH_H
+
+// Run length is written as unsigned LEB128: 7 bits per byte, MSB set if more bytes follow
+#define RUN_LENGTH_CONTINUE 0x80
+#define RUN_LENGTH_PAYLOAD 0x7F
+#define RUN_LENGTH_PAYLOAD_BITS 7
+
+#include "treeOperations.h"
+
+/**
+  * @brief  Counts size of run-length code of records window without reading it with popRecord.
+  *         Runs continue from end of one window row to start of the next one.
+  * @param  my Pointer to records struct with set window.
+  * @retval Number of bytes of run-length code.
+  */
+uint64_t countRunLengthBytes(const records* my);
+
+/**
+  * @brief  Compresses records window as runs of equal samples. Every run is written as
+  *         sample value (1 or 2 bytes) followed by run length minus one in LEB128 bytes, so constant
+  *         areas cost a few bytes and are skipped by Huffman coders entirely.
+  * @param  my A pointer to handler struct with loaded records and opened compressed file.
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+uint8_t encodeRunLength(handler* my);
+
+#endif // RUN_LENGTH_H
@@ -0,0 +1,135 @@
+#include "scanOrder.h"
+#include "fileOperations.h"
+
+/**
+ * @brief:  Position in scan buffer that samples of window are copied to.
+ * @records: Records struct with set window.
+ * @samples: Next byte of scan buffer.
+ */
+typedef struct scanCursor {
+    const records* records;
+    uint8_t* samples;
+} scanCursor;
+
+/**
+  * @brief  Copies run of samples of current channel of records window to scan buffer.
+  * @param  context Pointer to scanCursor
+  * @param  row Row of first sample, relative to window
+  * @param  column Column of first sample, relative to window
+  * @param  count Number of samples of run
+  * @param  rowStep Row step between samples
+  * @param  columnStep Column step between samples
+  * @retval None
+  */
+static void gatherRun(void* context, uint32_t row, uint32_t column, uint32_t count, int8_t rowStep, int8_t columnStep)
+{
+    scanCursor* cursor = (scanCursor*)context;
+    const records* my = cursor->records;
+    uint8_t bytesPerSample = my->bytesPerSample;
+    uint64_t pixelLength = (uint64_t)my->channels * bytesPerSample;
+    uint64_t channelOffset = (uint64_t)my->channel * bytesPerSample;
+    row += my->windowOrigin[0];
+    column += my->windowOrigin[1];
+
+    // Forward runs of single channel rows are consecutive bytes
+    if (my->channels == 1 && !rowStep && columnStep == 1) {
+        memcpy(cursor->samples, &my->matrix[row][(uint64_t)column * bytesPerSample], (size_t)count * bytesPerSample);
+        cursor->samples += (size_t)count * bytesPerSample;
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t* sample = &my->matrix[row][column * pixelLength + channelOffset];
+        cursor->samples[0] = sample[0];
+        if (bytesPerSample == 2)
+            cursor->samples[1] = sample[1];
+        cursor->samples += bytesPerSample;
+        row += rowStep;
+        column += columnStep;
+    }
+}
+
+/**
+  * @brief  Grows scan buffer of records when it is smaller than given length.
+  * @param  my Pointer to records struct
+  * @param  scanLength Number of bytes scan buffer must hold
+  * @retval 0 if scan buffer is large enough, 1 if memory allocation fails
+  */
+static uint8_t reserveScanBuffer(records* my, uint64_t scanLength)
+{
+    if (scanLength <= my->scanCapacity) return 0;
+    releaseMemory(my->memory, my->scanBuffer);
+    my->scanCapacity = 0;
+    my->scanBuffer = scanLength <= SIZE_MAX ? (uint8_t*)my->memory->allocate(my->memory, (size_t)scanLength) : NULL;
+    if (!my->scanBuffer) {
+        printf("Error: Cannot allocate memory for scan buffer\n");
+        return 1;
+    }
+    my->scanCapacity = scanLength;
+    return 0;
+}
+
+uint8_t scanWindow(records* my)
+{
+    uint32_t rows = my->windowDimension[0];
+    uint32_t columns = my->windowDimension[1];
+    uint64_t rowLength = (uint64_t)columns * my->bytesPerSample;
+
+    if (reserveScanBuffer(my, (uint64_t)rows * sizeof(uint8_t*) + rows * rowLength)) return 1;
+    // Row pointers come first, so samples are aligned as well as pointers are
+    uint8_t** matrix = (uint8_t**)my->scanBuffer;
+    uint8_t* samples = my->scanBuffer + (size_t)rows * sizeof(uint8_t*);
+    for (uint32_t row = 0; row < rows; row++)
+        matrix[row] = samples + row * rowLength;
+
+    scanCursor cursor = { .records = my, .samples = samples };
+    walkScan(my->scanOrder, rows, columns, gatherRun, &cursor);
+    my->matrix = matrix;
+    my->channels = 1;
+    my->channel = 0;
+    setWindow(my, 0, 0, rows, columns);
+    return 0;
+}
+
+uint8_t pairWindow(records* my)
+{
+    uint64_t numberOfPairs = ((uint64_t)my->windowDimension[0] * my->windowDimension[1] + 1) / 2;
+    if (numberOfPairs > UINT32_MAX) {
+        printf("Error: Window is too large for pair mode, use tiles\n");
+        return 1;
+    }
+    if (reserveScanBuffer(my, sizeof(uint8_t*) + 2 * numberOfPairs)) return 1;
+
+    // Pairs are single row of 16 bit samples, padding of odd sample is written first
+    uint8_t** matrix = (uint8_t**)my->scanBuffer;
+    matrix[0] = my->scanBuffer + sizeof(uint8_t*);
+    matrix[0][2 * numberOfPairs - 1] = 0;
+    scanCursor cursor = { .records = my, .samples = matrix[0] };
+    walkScan(my->scanOrder, my->windowDimension[0], my->windowDimension[1], gatherRun, &cursor);
+    my->matrix = matrix;
+    my->channels = 1;
+    my->channel = 0;
+    my->bytesPerSample = 2;
+    setWindow(my, 0, 0, 1, (uint32_t)numberOfPairs);
+    return 0;
+}
+
+uint8_t parseScanOrder(const char* name, uint8_t* order)
+{
+    if (!strcmp(name, "row")) {
+        *order = SCAN_ROW;
+        return 0;
+    }
+    if (!strcmp(name, "serpentine")) {
+        *order = SCAN_SERPENTINE;
+        return 0;
+    }
+    if (!strcmp(name, "hilbert")) {
+        *order = SCAN_HILBERT;
+        return 0;
+    }
+    if (!strcmp(name, "tile")) {
+        *order = SCAN_TILE;
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,35 @@
+#ifndef SCAN_ORDER_H
+#define SCAN_ORDER_H
+
+#include "treeOperations.h"
+
+/**
+  * @brief  Copies samples of records window of current channel in scan order of records into
+  *         single channel matrix of the same dimensions, whose rows follow each other in
+  *         scan buffer of records, and makes records read it from its first sample. Block is
+  *         then coded from it by every mode as if it was read row by row. Scan buffer is
+  *         grown when window does not fit in it and kept for next windows.
+  * @param  my Pointer to records struct with set window, its matrix and window are replaced
+  * @retval 0 if samples were copied, 1 if memory allocation fails
+  */
+uint8_t scanWindow(records* my);
+
+/**
+  * @brief  Copies 8 bit samples of records window of current channel in scan order of records
+  *         into scan buffer as single row of 16 bit samples, each holding two consecutive
+  *         samples, first of them in high byte. Odd last sample is paired with 0. Records
+  *         then read pairs from the first one.
+  * @param  my Pointer to records struct with set window, its matrix and window are replaced
+  * @retval 0 if samples were copied, 1 if window has too many pairs or memory allocation fails
+  */
+uint8_t pairWindow(records* my);
+
+/**
+  * @brief  Translates scan order name ("row", "serpentine", "hilbert", "tile") to scan order.
+  * @param  name Name of scan order
+  * @param  order Pointer to variable receiving scan order
+  * @retval 0 if name is known, 1 otherwise
+  */
+uint8_t parseScanOrder(const char* name, uint8_t* order);
+
+#endif // SCAN_ORDER_H
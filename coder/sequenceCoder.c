@@ -0,0 +1,231 @@
+#include "sequenceCoder.h"
+#include "fileOperations.h"
+#include "dictionary.h"
+
+/**
+  * @brief  Ages carried tree: counts of its symbols are divided by 2 to given power, rounding
+  *         up so no symbol leaves tree, and tree is built again from them as trained tree is.
+  *         Rebuilt tree keeps order of adaptive tree, which scaling counts in place would break.
+  *         Shift grows when scaled counts would not fit in nodes of rebuilt tree.
+  * @param  my A pointer to handler struct with tree of previous frame
+  * @param  shift Power of 2 counts are divided by, 0 to keep tree unchanged
+  * @retval 0 if tree was aged, 1 if memory allocation fails
+  */
+static uint8_t ageTree(handler* my, uint8_t shift)
+{
+    if (!shift) return 0;
+    uint32_t numberOfSymbols = my->cache.numberOfSymbols;
+    uint32_t* counts = (uint32_t*)calloc(numberOfSymbols, sizeof(uint32_t));
+    dictionaryNode* nodes = (dictionaryNode*)malloc((2 * (size_t)numberOfSymbols + 1) * sizeof(dictionaryNode));
+    if (!counts || !nodes) {
+        printf("Error: Cannot allocate memory for aged tree\n");
+        free(counts);
+        free(nodes);
+        return 1;
+    }
+    uint32_t numberOfLeaves = 0;
+    for (uint32_t symbol = 0; symbol < numberOfSymbols; symbol++)
+        numberOfLeaves += my->cache.leaves[symbol] != NULL;
+    // Sum of rounded up counts is at most root count scaled plus number of leaves
+    uint64_t rootCount = my->tree.nodes[0]->count;
+    while (shift < 63 && (rootCount >> shift) + numberOfLeaves > UINT32_MAX)
+        shift++;
+    for (uint32_t symbol = 0; symbol < numberOfSymbols; symbol++)
+        if (my->cache.leaves[symbol])
+            counts[symbol] = (uint32_t)(((my->cache.leaves[symbol]->count - 1) >> shift) + 1);
+
+    memset(my->cache.leaves, 0, numberOfSymbols * sizeof(node*));
+    uint32_t numberOfNodes = buildTreeFromCounts(counts, numberOfSymbols, nodes);
+    uint8_t status = !numberOfNodes || startFromNodes(my, nodes, numberOfNodes);
+    free(counts);
+    free(nodes);
+    return status;
+}
+
+/**
+  * @brief  Appends frame to sequence: frame header and compressed file of loaded records
+  *         holding single adaptive block, whose length is filled in afterwards.
+  * @param  my A pointer to handler struct with prepared records
+  * @param  file Sequence file positioned at its end
+  * @param  flags Flags of frame, fresh tree is started for keyframe and new tree
+  * @param  ageShift Power of 2 counts of carried tree are divided by
+  * @retval 0 if frame was written, 1 otherwise
+  */
+static uint8_t compressFrame(handler* my, FILE* file, uint8_t flags, uint8_t ageShift)
+{
+    uint8_t frameHeader[SEQUENCE_FRAME_HEADER_LENGTH] = { flags };
+    long start = ftell(file);
+    if (start < 0 || fwrite(frameHeader, 1, SEQUENCE_FRAME_HEADER_LENGTH, file) != SEQUENCE_FRAME_HEADER_LENGTH) {
+        printf("Error: Cannot write to sequence file\n");
+        return 1;
+    }
+    my->compressedFile = file;
+    setWindow(&my->records, 0, 0, my->records.matrixDimension[0], my->records.matrixDimension[1]);
+    uint8_t status = writeHeader(file, &my->records, MODE_ADAPTIVE_HUFFMAN, 0) ||
+                     (flags & (SEQUENCE_KEYFRAME | SEQUENCE_NEW_TREE) ? resetTree(my) : ageTree(my, ageShift)) ||
+                     constructTree(my);
+    // Sequence file stays open for next frame
+    my->compressedFile = NULL;
+    if (status) return 1;
+
+    long end = ftell(file);
+    uint64_t length = end < 0 ? 0 : (uint64_t)(end - start) - SEQUENCE_FRAME_HEADER_LENGTH;
+    if (end < 0 || length > UINT32_MAX) {
+        printf("Error: Compressed frame is too large for sequence file\n");
+        return 1;
+    }
+    storeBigEndian(&frameHeader[1], (uint32_t)length, 4);
+    if (fseek(file, start + 1, SEEK_SET) || fwrite(&frameHeader[1], 1, 4, file) != 4 || fseek(file, 0, SEEK_END)) {
+        printf("Error: Cannot write to sequence file\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief  Copies samples of loaded frame into contiguous buffer.
+  * @param  my A pointer to records struct with loaded frame
+  * @param  samples Buffer receiving rows of frame one after another
+  * @retval None
+  */
+static void copyFrame(const records* my, uint8_t* samples)
+{
+    uint64_t rowLength = (uint64_t)my->matrixDimension[1] * my->bytesPerSample;
+    for (uint32_t row = 0; row < my->matrixDimension[0]; row++)
+        memcpy(&samples[row * rowLength], my->matrix[row], rowLength);
+}
+
+/**
+  * @brief  Computes differences of frame from previous frame modulo alphabet size, 16 bit
+  *         samples in big-endian order.
+  * @param  current Samples of frame
+  * @param  previous Samples of previous frame
+  * @param  residual Buffer receiving differences
+  * @param  numberOfSamples Number of samples of frame
+  * @param  bytesPerSample Size of samples
+  * @retval None
+  */
+static void predictFrame(const uint8_t* current, const uint8_t* previous, uint8_t* residual, uint64_t numberOfSamples,
+                         uint8_t bytesPerSample)
+{
+    if (bytesPerSample == 1) {
+        for (uint64_t i = 0; i < numberOfSamples; i++)
+            residual[i] = (uint8_t)(current[i] - previous[i]);
+        return;
+    }
+    for (uint64_t i = 0; i < 2 * numberOfSamples; i += 2) {
+        uint16_t difference = (uint16_t)(((current[i] << BITS_IN_BYTE) | current[i + 1]) - ((previous[i] << BITS_IN_BYTE) | previous[i + 1]));
+        residual[i] = (uint8_t)(difference >> BITS_IN_BYTE);
+        residual[i + 1] = (uint8_t)difference;
+    }
+}
+
+uint8_t compressSequence(const char* sequencePath, char** framePaths, uint32_t numberOfFrames, const sequenceSettings* settings)
+{
+    if (!numberOfFrames) {
+        printf("Error: Sequence needs at least one frame\n");
+        return 1;
+    }
+    // Tree and cache must outlive every frame, so they are not taken from arena reset per image
+    handler* my = createHandlerWithAllocator(heapAllocator());
+    if (!my) {
+        printf("Error: Cannot allocate memory for handler\n");
+        return 1;
+    }
+    FILE* file = createCompressedFile(sequencePath);
+    uint8_t header[SEQUENCE_HEADER_LENGTH] = SEQUENCE_MAGIC;
+    header[4] = SEQUENCE_VERSION;
+    header[5] = settings->predictor;
+    header[6] = settings->ageShift;
+    storeBigEndian(&header[8], settings->keyframeInterval, 4);
+    uint8_t status = !file || fwrite(header, 1, SEQUENCE_HEADER_LENGTH, file) != SEQUENCE_HEADER_LENGTH;
+
+    // With predictor frames are copied, previous one is kept for prediction of next one
+    uint8_t* previous = NULL;
+    uint8_t* current = NULL;
+    uint8_t* residual = NULL;
+    uint32_t width = 0, height = 0, keyframes = 0, frame = 0;
+    uint16_t maxGreyLevel = 0;
+    uint8_t previousFlags = 0;
+    uint64_t pixels = 0;
+    for (; frame < numberOfFrames && !status; frame++) {
+        resetHandler(my);
+        records* image = &my->records;
+        if (mapDataFromFile(image, framePaths[frame])) {
+            status = 1;
+            break;
+        }
+        if (image->channels != 1) {
+            printf("Error: Sequence frames must be single channel images\n");
+            status = 1;
+            break;
+        }
+        if (!frame) {
+            width = image->matrixDimension[1];
+            height = image->matrixDimension[0];
+            maxGreyLevel = image->maxGreyLevel;
+        } else if (image->matrixDimension[1] != width || image->matrixDimension[0] != height || image->maxGreyLevel != maxGreyLevel) {
+            printf("Error: Frame %s differs in size or max grey level from first frame\n", framePaths[frame]);
+            status = 1;
+            break;
+        }
+        uint8_t flags = !frame || (settings->keyframeInterval && frame % settings->keyframeInterval == 0) ? SEQUENCE_KEYFRAME : 0;
+
+        if (settings->predictor) {
+            uint8_t bytesPerSample = image->bytesPerSample;
+            uint64_t frameLength = (uint64_t)width * height * bytesPerSample;
+            if (!previous) {
+                previous = (uint8_t*)malloc(frameLength);
+                current = (uint8_t*)malloc(frameLength);
+                residual = (uint8_t*)malloc(frameLength);
+            }
+            if (!previous || !current || !residual) {
+                printf("Error: Cannot allocate memory for frames\n");
+                status = 1;
+                break;
+            }
+            copyFrame(image, current);
+            // Differences follow other statistics than samples of keyframe, so first of them starts fresh tree
+            if (!(flags & SEQUENCE_KEYFRAME)) {
+                predictFrame(current, previous, residual, (uint64_t)width * height, bytesPerSample);
+                if (previousFlags & SEQUENCE_KEYFRAME) flags = SEQUENCE_NEW_TREE;
+            }
+            uint8_t* swap = previous;
+            previous = current;
+            current = swap;
+            resetHandler(my);
+            if (readDataFromPixels(image, flags & SEQUENCE_KEYFRAME ? previous : residual, width, height, maxGreyLevel, 1)) {
+                status = 1;
+                break;
+            }
+        }
+        my->mode = MODE_ADAPTIVE_HUFFMAN;
+        if (prepareRecords(my) || compressFrame(my, file, flags, settings->ageShift)) {
+            status = 1;
+            break;
+        }
+        keyframes += flags & SEQUENCE_KEYFRAME;
+        previousFlags = flags;
+        pixels += (uint64_t)width * height;
+    }
+
+    // Frames written before error stay decodable
+    if (file) {
+        storeBigEndian(&header[12], frame, 4);
+        long length = fseek(file, 0, SEEK_END) ? -1 : ftell(file);
+        uint8_t closeStatus = length < 0 || fseek(file, 12, SEEK_SET) || fwrite(&header[12], 1, 4, file) != 4;
+        if (fclose(file) || closeStatus) {
+            printf("Error: Error during closing file\n");
+            status = 1;
+        }
+        if (!status)
+            printf("Sequence: %u frames, %u keyframes, %ld bytes, %.3f bits per pixel\n", numberOfFrames, keyframes, length,
+                   length * (double)BITS_IN_BYTE / pixels);
+    }
+    free(previous);
+    free(current);
+    free(residual);
+    freeAlocatedMemory(my);
+    free(my);
+    return status;
+}
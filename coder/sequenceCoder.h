@@ -0,0 +1,49 @@
+#ifndef SEQUENCE_CODER_H
+#define SEQUENCE_CODER_H
+
+// Sequence: header followed by frames. Header: magic, version, flags, age shift, reserved byte,
+// keyframe interval (4 bytes) and number of frames (4 bytes).
+#define SEQUENCE_MAGIC { 0x8B, 'K', 'D', 'S' }
+#define SEQUENCE_VERSION 1
+#define SEQUENCE_HEADER_LENGTH 16
+#define SEQUENCE_PREDICT_PREVIOUS 0x01
+// Frame: flags and length (4 bytes) of compressed file of frame, single adaptive block of
+// single channel image. Keyframe holds samples of frame and starts with fresh tree, so it is
+// ordinary compressed file; other frames continue tree of previous frame and with predictor
+// hold differences from previous frame modulo alphabet size.
+#define SEQUENCE_FRAME_HEADER_LENGTH 5
+#define SEQUENCE_KEYFRAME 0x01
+#define SEQUENCE_NEW_TREE 0x02
+#define DEFAULT_KEYFRAME_INTERVAL 30
+// Counts of carried tree are at most halved this many times before every frame
+#define MAX_AGE_SHIFT 31
+
+#include "treeOperations.h"
+
+/**
+ * @brief:  Settings of sequence coding.
+ * @keyframeInterval: Number of frames between keyframes, 0 for first frame only.
+ * @ageShift: Counts of carried tree are divided by 2 to this power, rounding up, before every
+ *            frame that is not keyframe, 0 to carry tree unchanged.
+ * @predictor: SEQUENCE_PREDICT_PREVIOUS to code differences from previous frame, 0 to code
+ *             samples of every frame.
+ */
+typedef struct sequenceSettings {
+    uint32_t keyframeInterval;
+    uint8_t ageShift;
+    uint8_t predictor;
+} sequenceSettings;
+
+/**
+  * @brief  Compresses frames of the same size and max grey level into sequence file. Adaptive
+  *         tree is carried from frame to frame and started again only at keyframes, so frames
+  *         are decoded in order from nearest keyframe.
+  * @param  sequencePath Path to created sequence file
+  * @param  framePaths Paths to PGM frames in order
+  * @param  numberOfFrames Number of frames
+  * @param  settings Pointer to settings of sequence
+  * @retval 0 if every frame was compressed, 1 otherwise
+  */
+uint8_t compressSequence(const char* sequencePath, char** framePaths, uint32_t numberOfFrames, const sequenceSettings* settings);
+
+#endif // SEQUENCE_CODER_H
@@ -0,0 +1,169 @@
+#include "staticHuffman.h"
+#include "fileOperations.h"
+
+// Lengths of Huffman code before limiting can reach number of symbols - 1
+#define MAX_UNLIMITED_LENGTH NUMBER_OF_SYMBOLS
+
+/**
+  * @brief  Computes Huffman code length of each symbol by repeatedly merging two least
+  *         frequent subtrees. Ties are broken by lower index, so result is deterministic.
+  * @param  histogram Array of NUMBER_OF_SYMBOLS symbol counts.
+  * @param  lengths Array receiving unlimited code length of each symbol.
+  * @retval Number of symbols present in histogram.
+  */
+static uint16_t computeCodeLengths(const uint64_t* histogram, uint16_t* lengths)
+{
+    uint64_t weight[2 * NUMBER_OF_SYMBOLS];
+    int16_t parent[2 * NUMBER_OF_SYMBOLS];
+    uint8_t active[2 * NUMBER_OF_SYMBOLS];
+    uint16_t numberOfNodes = NUMBER_OF_SYMBOLS;
+    uint16_t presentSymbols = 0;
+
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++) {
+        weight[i] = histogram[i];
+        parent[i] = -1;
+        active[i] = histogram[i] > 0;
+        presentSymbols += active[i];
+        lengths[i] = 0;
+    }
+    if (presentSymbols == 1) {
+        for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+            if (active[i]) lengths[i] = 1;
+        return presentSymbols;
+    }
+
+    for (uint16_t merges = 1; merges < presentSymbols; merges++) {
+        int16_t first = -1, second = -1;
+        for (uint16_t i = 0; i < numberOfNodes; i++) {
+            if (!active[i]) continue;
+            if (first < 0 || weight[i] < weight[first]) {
+                second = first;
+                first = i;
+            } else if (second < 0 || weight[i] < weight[second]) {
+                second = i;
+            }
+        }
+        weight[numberOfNodes] = weight[first] + weight[second];
+        parent[numberOfNodes] = -1;
+        active[numberOfNodes] = 1;
+        active[first] = active[second] = 0;
+        parent[first] = parent[second] = numberOfNodes;
+        numberOfNodes++;
+    }
+
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++) {
+        if (!histogram[i]) continue;
+        for (int16_t node = parent[i]; node >= 0; node = parent[node])
+            lengths[i]++;
+    }
+    return presentSymbols;
+}
+
+/**
+  * @brief  Limits code lengths to given length keeping prefix property (JPEG Annex K.3):
+  *         two longest codes are replaced with one shorter and shorter code is split.
+  * @param  lengthCount Number of codes of each length, modified in place.
+  * @param  maxLength Longest code length allowed
+  * @retval None
+  */
+static void limitCodeLengths(uint16_t* lengthCount, uint8_t maxLength)
+{
+    for (uint16_t length = MAX_UNLIMITED_LENGTH; length > maxLength; length--) {
+        while (lengthCount[length] > 0) {
+            uint16_t shorter = length - 2;
+            while (lengthCount[shorter] == 0)
+                shorter--;
+            lengthCount[length] -= 2;
+            lengthCount[length - 1]++;
+            lengthCount[shorter + 1] += 2;
+            lengthCount[shorter]--;
+        }
+    }
+}
+
+void buildCanonicalCode(const uint64_t* histogram, canonicalCode* code)
+{
+    buildLimitedCode(histogram, MAX_CODE_LENGTH, code);
+}
+
+void buildLimitedCode(const uint64_t* histogram, uint8_t maxLength, canonicalCode* code)
+{
+    uint16_t lengths[NUMBER_OF_SYMBOLS];
+    uint16_t lengthCount[MAX_UNLIMITED_LENGTH + 1] = { 0 };
+    uint16_t presentSymbols = computeCodeLengths(histogram, lengths);
+
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+        lengthCount[lengths[i]]++;
+    lengthCount[0] = 0;
+    limitCodeLengths(lengthCount, maxLength);
+
+    // Hand out limited lengths again: most frequent symbols get shortest codes
+    uint8_t order[NUMBER_OF_SYMBOLS];
+    uint16_t ordered = 0;
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+        if (histogram[i]) order[ordered++] = i;
+    for (uint16_t i = 1; i < presentSymbols; i++) {
+        uint8_t symbol = order[i];
+        uint16_t j = i;
+        while (j > 0 && histogram[order[j - 1]] < histogram[symbol]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = symbol;
+    }
+    memset(code->length, 0, sizeof(code->length));
+    uint16_t next = 0;
+    for (uint8_t length = 1; length <= maxLength; length++)
+        for (uint16_t i = 0; i < lengthCount[length]; i++)
+            code->length[order[next++]] = length;
+
+    // Canonical codes: consecutive values within each length, ordered by symbol value
+    uint16_t nextCode = 0;
+    for (uint8_t length = 1; length <= maxLength; length++) {
+        for (uint16_t symbol = 0; symbol < NUMBER_OF_SYMBOLS; symbol++)
+            if (code->length[symbol] == length)
+                code->code[symbol] = nextCode++;
+        nextCode <<= 1;
+    }
+}
+
+/**
+  * @brief  Writes code lengths after file header, two 4 bit lengths per byte.
+  * @param  compressedFile Pointer to FILE object.
+  * @param  code Pointer to canonical code.
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
+  */
+static uint8_t writeCodeLengths(FILE* compressedFile, const canonicalCode* code)
+{
+    uint8_t packed[CODE_LENGTHS_BYTES];
+    for (uint16_t i = 0; i < CODE_LENGTHS_BYTES; i++)
+        packed[i] = (code->length[2 * i] << 4) | code->length[2 * i + 1];
+    if (fwrite(packed, 1, CODE_LENGTHS_BYTES, compressedFile) != CODE_LENGTHS_BYTES) {
+        printf("Error: Cannot write code lengths to file\n");
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t encodeStatic(handler* my)
+{
+    canonicalCode code;
+
+    if (my->records.bytesPerSample > 1) {
+        printf("Error: Static Huffman mode supports only 8 bit samples\n");
+        return 1;
+    }
+    buildCanonicalCode(my->records.histogram, &code);
+    if (writeCodeLengths(my->compressedFile, &code)) return 1;
+
+    while (my->records.remainingRecords) {
+        uint16_t symbol = my->records.popRecord(&my->records);
+        if (writeToFile(&my->bitBuffer, my->compressedFile, code.code[symbol], code.length[symbol])) {
+            printf("ERROR: Cannot write to file!");
+            return 1;
+        }
+    }
+    // Write remaining bits in buffer
+    if (writeToFile(&my->bitBuffer, my->compressedFile, 0, 0)) return 1;
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef STATIC_HUFFMAN_H
+#define STATIC_HUFFMAN_H
+
+#define NUMBER_OF_SYMBOLS 256
+#define MAX_CODE_LENGTH 12
+#define CODE_LENGTHS_BYTES (NUMBER_OF_SYMBOLS / 2)
+
+#include "treeOperations.h"
+
+/**
+ * @brief:  Represents canonical Huffman code for 8 bit symbols.
+ * @code: Code of each symbol, aligned to LSB.
+ * @length: Number of bits of each symbol code, 0 for symbols absent in image.
+ */
+typedef struct canonicalCode {
+    uint16_t code[NUMBER_OF_SYMBOLS];
+    uint8_t length[NUMBER_OF_SYMBOLS];
+} canonicalCode;
+
+/**
+  * @brief  Builds length-limited canonical Huffman code from symbol histogram.
+  *         Code lengths never exceed MAX_CODE_LENGTH, so decoder can use single lookup table.
+  * @param  histogram Array of NUMBER_OF_SYMBOLS symbol counts.
+  * @param  code Pointer to struct receiving code lengths and codes.
+  * @retval None
+  */
+void buildCanonicalCode(const uint64_t* histogram, canonicalCode* code);
+
+/**
+  * @brief  Builds canonical Huffman code as buildCanonicalCode() does, with code lengths
+  *         limited to given length instead of MAX_CODE_LENGTH.
+  * @param  histogram Array of NUMBER_OF_SYMBOLS symbol counts.
+  * @param  maxLength Longest code length allowed, at most 15 and at least 8.
+  * @param  code Pointer to struct receiving code lengths and codes.
+  * @retval None
+  */
+void buildLimitedCode(const uint64_t* histogram, uint8_t maxLength, canonicalCode* code);
+
+/**
+  * @brief  Compresses records window with static canonical Huffman code built from records
+  *         histogram. Code lengths are written first, then code of each symbol is found
+  *         with table lookup.
+  * @param  my A pointer to handler struct with loaded records and opened compressed file.
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+uint8_t encodeStatic(handler* my);
+
+#endif // STATIC_HUFFMAN_H
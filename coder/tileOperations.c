@@ -0,0 +1,262 @@
+#include "tileOperations.h"
+#include "fileOperations.h"
+#include "runLength.h"
+#include "dictionary.h"
+#include "tileUpdate.h"
+
+// Odd constant with well mixed bits, multiplied into hash after every 8 bytes of samples
+#define TILE_HASH_MULTIPLIER 0x9E3779B97F4A7C15ull
+
+/**
+ * @brief:  Tile of single channel already written, kept so equal tiles can refer to it.
+ * @hash: Hash of dimensions and samples of tile.
+ * @row: First row of tile.
+ * @column: First column of tile.
+ * @rows: Number of rows of tile.
+ * @columns: Number of columns of tile.
+ * @channel: Channel of tile.
+ */
+typedef struct tileBlock {
+    uint64_t hash;
+    uint32_t row;
+    uint32_t column;
+    uint16_t rows;
+    uint16_t columns;
+    uint8_t channel;
+} tileBlock;
+
+/**
+ * @brief:  Hash table of written tiles, found by hash of their samples.
+ * @blocks: Written tiles in order of tile numbers.
+ * @slots: Number of tile plus 1 in each used slot, linear probing.
+ * @numberOfSlots: Number of slots, power of two at least twice number of tiles.
+ */
+typedef struct tileTable {
+    tileBlock* blocks;
+    uint32_t* slots;
+    uint64_t numberOfSlots;
+} tileTable;
+
+/**
+  * @brief  Writes tile side after file header.
+  * @param  my A pointer to handler struct with opened compressed file.
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
+  */
+static uint8_t writeTileSide(handler* my)
+{
+    uint8_t tileSide[TILE_SIDE_LENGTH];
+
+    storeBigEndian(tileSide, my->tileSide, TILE_SIDE_LENGTH);
+    if (fwrite(tileSide, 1, TILE_SIDE_LENGTH, my->compressedFile) != TILE_SIDE_LENGTH) {
+        printf("Error: Cannot write tile side to file\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief  Chooses mode of records window of current channel and compresses it. Tile header
+  *         is written with empty payload length first, which is filled when payload size
+  *         is known.
+  * @param  my A pointer to handler struct with set records window.
+  * @retval 0 if tile compressed successfully, 1 on error.
+  */
+static uint8_t encodeTile(handler* my)
+{
+    imageStatistics statistics;
+    uint8_t tileHeader[TILE_HEADER_LENGTH] = { 0 };
+
+    countWindowHistogram(&my->records);
+    analyzeHistogram(my->records.histogram, my->records.numberOfSymbols, &statistics);
+    if (my->dictionary)
+        estimateWithDictionary(my->dictionary, my->records.histogram, &statistics);
+    statistics.runLengthBitsPerPixel = countRunLengthBytes(&my->records) * (double)BITS_IN_BYTE / statistics.numberOfPixels;
+    tileHeader[0] = chooseMode(&statistics);
+    my->statistics.tilesPerMode[tileHeader[0]]++;
+
+    long tileStart = ftell(my->compressedFile);
+    if (fwrite(tileHeader, 1, TILE_HEADER_LENGTH, my->compressedFile) != TILE_HEADER_LENGTH) {
+        printf("Error: Cannot write tile header to file\n");
+        return 1;
+    }
+
+    if (encodeBlock(my, tileHeader[0])) return 1;
+
+    // Fill payload length and return to end of file
+    long tileEnd = ftell(my->compressedFile);
+    if ((uint64_t)(tileEnd - tileStart - TILE_HEADER_LENGTH) > UINT32_MAX) {
+        printf("Error: Tile payload exceeds 4 GB, use smaller tile side\n");
+        return 1;
+    }
+    storeBigEndian(&tileHeader[1], (uint32_t)(tileEnd - tileStart - TILE_HEADER_LENGTH), TILE_HEADER_LENGTH - 1);
+    if (fseek(my->compressedFile, tileStart, SEEK_SET) ||
+        fwrite(tileHeader, 1, TILE_HEADER_LENGTH, my->compressedFile) != TILE_HEADER_LENGTH ||
+        fseek(my->compressedFile, tileEnd, SEEK_SET)) {
+        printf("Error: Cannot write tile header to file\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief  Mixes bytes into hash 8 bytes at a time.
+  * @param  hash Hash of preceding data
+  * @param  data Pointer to bytes
+  * @param  length Number of bytes
+  * @retval Hash including bytes
+  */
+static uint64_t hashBytes(uint64_t hash, const uint8_t* data, uint64_t length)
+{
+    uint64_t word;
+    for (; length >= sizeof(word); data += sizeof(word), length -= sizeof(word)) {
+        memcpy(&word, data, sizeof(word));
+        hash = (hash ^ word) * TILE_HASH_MULTIPLIER;
+        hash ^= hash >> 32;
+    }
+    word = 0;
+    memcpy(&word, data, length);
+    hash = (hash ^ word ^ (length << 56)) * TILE_HASH_MULTIPLIER;
+    return hash ^ (hash >> 32);
+}
+
+/**
+  * @brief  Computes hash of dimensions and samples of records window of current channel.
+  *         Rows of single channel images are hashed whole, samples of colour images one by one.
+  * @param  my A pointer to records struct with set window
+  * @retval Hash of window
+  */
+static uint64_t hashWindow(const records* my)
+{
+    uint64_t hash = (((uint64_t)my->windowDimension[0] << 32) | my->windowDimension[1]) * TILE_HASH_MULTIPLIER;
+    for (uint32_t row = my->windowOrigin[0]; row < my->windowOrigin[0] + my->windowDimension[0]; row++) {
+        if (my->channels == 1) {
+            hash = hashBytes(hash, &my->matrix[row][(uint64_t)my->windowOrigin[1] * my->bytesPerSample],
+                             (uint64_t)my->windowDimension[1] * my->bytesPerSample);
+            continue;
+        }
+        for (uint32_t column = my->windowOrigin[1]; column < my->windowOrigin[1] + my->windowDimension[1]; column++) {
+            hash = (hash ^ readSample(my, row, column)) * TILE_HASH_MULTIPLIER;
+            hash ^= hash >> 32;
+        }
+    }
+    return hash;
+}
+
+/**
+  * @brief  Compares samples of records window of current channel with samples of written tile
+  *         of the same dimensions, which may belong to other channel.
+  * @param  my A pointer to records struct with set window
+  * @param  other Pointer to written tile
+  * @retval 1 if every sample is equal, 0 otherwise
+  */
+static uint8_t windowEquals(const records* my, const tileBlock* other)
+{
+    uint64_t pixelLength = (uint64_t)my->channels * my->bytesPerSample;
+    for (uint32_t row = 0; row < my->windowDimension[0]; row++) {
+        const uint8_t* sample = &my->matrix[my->windowOrigin[0] + row][(uint64_t)my->windowOrigin[1] * pixelLength + my->channel * my->bytesPerSample];
+        const uint8_t* otherSample = &my->matrix[other->row + row][(uint64_t)other->column * pixelLength + other->channel * my->bytesPerSample];
+        if (my->channels == 1) {
+            if (memcmp(sample, otherSample, (size_t)my->windowDimension[1] * my->bytesPerSample)) return 0;
+            continue;
+        }
+        for (uint32_t column = 0; column < my->windowDimension[1]; column++, sample += pixelLength, otherSample += pixelLength)
+            if (memcmp(sample, otherSample, my->bytesPerSample)) return 0;
+    }
+    return 1;
+}
+
+/**
+  * @brief  Looks for written tile equal to records window and adds window as written tile
+  *         when there is none.
+  * @param  table Pointer to table of written tiles
+  * @param  my A pointer to records struct with set window
+  * @param  block Number of tile of window
+  * @retval Number of equal tile plus 1, 0 if window is new
+  */
+static uint32_t findDuplicate(tileTable* table, const records* my, uint32_t block)
+{
+    uint64_t hash = hashWindow(my);
+    uint64_t mask = table->numberOfSlots - 1;
+    uint64_t slot = hash & mask;
+    for (; table->slots[slot]; slot = (slot + 1) & mask) {
+        const tileBlock* other = &table->blocks[table->slots[slot] - 1];
+        // Hash only preselects tile, samples decide
+        if (other->hash == hash && other->rows == my->windowDimension[0] && other->columns == my->windowDimension[1] &&
+            windowEquals(my, other))
+            return table->slots[slot];
+    }
+    tileBlock* written = &table->blocks[block];
+    written->hash = hash;
+    written->row = my->windowOrigin[0];
+    written->column = my->windowOrigin[1];
+    written->rows = (uint16_t)my->windowDimension[0];
+    written->columns = (uint16_t)my->windowDimension[1];
+    written->channel = my->channel;
+    table->slots[slot] = block + 1;
+    return 0;
+}
+
+/**
+  * @brief  Writes tile as reference to equal tile written before.
+  * @param  my A pointer to handler struct with opened compressed file.
+  * @param  reference Number of equal tile
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
+  */
+static uint8_t writeReference(handler* my, uint32_t reference)
+{
+    uint8_t tile[TILE_HEADER_LENGTH + TILE_REFERENCE_LENGTH];
+    tile[0] = MODE_DUPLICATE_TILE;
+    storeBigEndian(&tile[1], TILE_REFERENCE_LENGTH, TILE_HEADER_LENGTH - 1);
+    storeBigEndian(&tile[TILE_HEADER_LENGTH], reference, TILE_REFERENCE_LENGTH);
+    if (fwrite(tile, 1, sizeof(tile), my->compressedFile) != sizeof(tile)) {
+        printf("Error: Cannot write tile header to file\n");
+        return 1;
+    }
+    my->statistics.duplicateTiles++;
+    return 0;
+}
+
+uint8_t encodeTiled(handler* my)
+{
+    if (writeTileSide(my)) return 1;
+    memset(my->statistics.tilesPerMode, 0, sizeof(my->statistics.tilesPerMode));
+    my->statistics.duplicateTiles = 0;
+    my->statistics.reusedTiles = 0;
+
+    // Tiles are numbered on 4 bytes, images with more tiles are coded without references
+    uint64_t numberOfBlocks = ((my->records.matrixDimension[0] + (uint64_t)my->tileSide - 1) / my->tileSide) *
+                              ((my->records.matrixDimension[1] + (uint64_t)my->tileSide - 1) / my->tileSide) * my->records.channels;
+    tileTable table = { NULL, NULL, 2 };
+    while (table.numberOfSlots < 2 * numberOfBlocks)
+        table.numberOfSlots *= 2;
+    if (numberOfBlocks < UINT32_MAX && table.numberOfSlots <= SIZE_MAX / sizeof(uint32_t)) {
+        table.blocks = (tileBlock*)malloc((size_t)numberOfBlocks * sizeof(tileBlock));
+        table.slots = (uint32_t*)calloc((size_t)table.numberOfSlots, sizeof(uint32_t));
+    }
+    uint8_t deduplicate = table.blocks && table.slots;
+    uint32_t block = 0;
+    uint8_t status = 0;
+
+    // Positions are 64-bit, so they do not wrap past last tile of image 2^32 - 1 pixels wide
+    for (uint64_t row = 0; row < my->records.matrixDimension[0] && !status; row += my->tileSide) {
+        for (uint64_t column = 0; column < my->records.matrixDimension[1] && !status; column += my->tileSide) {
+            uint16_t rows = my->records.matrixDimension[0] - row < my->tileSide ? my->records.matrixDimension[0] - row : my->tileSide;
+            uint16_t columns = my->records.matrixDimension[1] - column < my->tileSide ? my->records.matrixDimension[1] - column : my->tileSide;
+            // Channels of tile follow each other, each with its own tile header
+            for (uint8_t channel = 0; channel < my->records.channels && !status; channel++, block++) {
+                my->records.channel = channel;
+                setWindow(&my->records, (uint32_t)row, (uint32_t)column, rows, columns);
+                // Tiles of previous compressed file outside changed rectangles are copied as
+                // they are, so only tiles coded again are looked for among written tiles
+                uint8_t copied = 0;
+                if (my->update && (status = copyUnchangedTile(my, block, &copied))) break;
+                if (copied) continue;
+                uint32_t duplicate = deduplicate ? findDuplicate(&table, &my->records, block) : 0;
+                status = duplicate ? writeReference(my, duplicate - 1) : encodeTile(my);
+            }
+        }
+    }
+    free(table.blocks);
+    free(table.slots);
+    return status;
+}
@@ -0,0 +1,19 @@
+#ifndef TILE_OPERATIONS_H
+#define TILE_OPERATIONS_H
+
+#include "treeOperations.h"
+
+/**
+  * @brief  Compresses records as square tiles in raster order. Tile side is written after
+  *         file header, then every channel of every tile is written as its mode, big-endian
+  *         payload length and payload. Mode of each tile is chosen from its own histogram, so constant
+  *         tiles become few run-length bytes and noisy tiles are stored, and only the
+  *         remaining tiles are coded with Huffman tree started again for every tile. With
+  *         tile update, tiles of previous compressed file outside changed rectangles are
+  *         copied unchanged and only the others are coded.
+  * @param  my A pointer to handler struct with loaded records and opened compressed file.
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+uint8_t encodeTiled(handler* my);
+
+#endif // TILE_OPERATIONS_H
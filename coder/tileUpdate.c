@@ -0,0 +1,144 @@
+#include "tileUpdate.h"
+#include "fileOperations.h"
+#include "dictionary.h"
+
+/**
+  * @brief  Reads value stored on given number of bytes in big-endian order.
+  * @param  source Pointer to first byte of value
+  * @param  bytes Number of bytes of value
+  * @retval Read value
+  */
+static uint32_t loadValue(const uint8_t* source, uint8_t bytes)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < bytes; i++)
+        value = (value << BITS_IN_BYTE) | source[i];
+    return value;
+}
+
+/**
+  * @brief  Checks whether records window overlaps any changed rectangle.
+  * @param  update Pointer to tile update
+  * @param  my A pointer to records struct with set window
+  * @retval 1 if window overlaps changed rectangle, 0 otherwise
+  */
+static uint8_t isChanged(const tileUpdate* update, const records* my)
+{
+    for (uint32_t i = 0; i < update->numberOfRectangles; i++) {
+        const dirtyRectangle* rectangle = &update->rectangles[i];
+        if (rectangle->row < (uint64_t)my->windowOrigin[0] + my->windowDimension[0] &&
+            my->windowOrigin[0] < (uint64_t)rectangle->row + rectangle->rows &&
+            rectangle->column < (uint64_t)my->windowOrigin[1] + my->windowDimension[1] &&
+            my->windowOrigin[1] < (uint64_t)rectangle->column + rectangle->columns)
+            return 1;
+    }
+    return 0;
+}
+
+uint8_t openTileUpdate(handler* my, const char* previousPath, const dirtyRectangle* rectangles, uint32_t numberOfRectangles)
+{
+    tileUpdate* update = (tileUpdate*)calloc(1, sizeof(tileUpdate));
+    if (update && numberOfRectangles)
+        update->rectangles = (dirtyRectangle*)malloc((size_t)numberOfRectangles * sizeof(dirtyRectangle));
+    if (!update || (numberOfRectangles && !update->rectangles)) {
+        printf("Error: Failed allocating tile update\n");
+        freeTileUpdate(&update);
+        return 1;
+    }
+    if (numberOfRectangles)
+        memcpy(update->rectangles, rectangles, (size_t)numberOfRectangles * sizeof(dirtyRectangle));
+    update->numberOfRectangles = numberOfRectangles;
+
+    FILE* file = fopen(previousPath, "rb");
+    long length = !file || fseek(file, 0, SEEK_END) ? -1 : ftell(file);
+    update->data = length > 0 ? (uint8_t*)malloc((size_t)length) : NULL;
+    uint8_t status = !update->data || fseek(file, 0, SEEK_SET) || fread(update->data, 1, (size_t)length, file) != (size_t)length;
+    if (file) fclose(file);
+    if (status) {
+        printf("Error: Cannot read previous compressed file \"%s\"\n", previousPath);
+        freeTileUpdate(&update);
+        return 1;
+    }
+    update->length = (uint64_t)length;
+    my->update = update;
+    return 0;
+}
+
+uint8_t matchTileUpdate(handler* my)
+{
+    tileUpdate* update = my->update;
+    const uint8_t magic[] = HEADER_MAGIC;
+    const uint8_t* header = update->data;
+    if (update->length < HEADER_LENGTH + TILE_SIDE_LENGTH || memcmp(header, magic, sizeof(magic)) ||
+        header[4] != FORMAT_VERSION || header[5] != MODE_TILED) {
+        printf("Error: Previous compressed file is not coded in tiled mode\n");
+        return 1;
+    }
+    if (loadValue(&header[6], 2) != my->records.maxGreyLevel || loadValue(&header[8], 4) != my->records.matrixDimension[1] ||
+        loadValue(&header[12], 4) != my->records.matrixDimension[0] || header[16] != my->records.channels) {
+        printf("Error: Previous compressed file holds image of different size\n");
+        return 1;
+    }
+    if (loadValue(&header[17], 2) != (my->dictionary ? my->dictionary->id : 0u)) {
+        printf("Error: Previous compressed file was coded with different dictionary\n");
+        return 1;
+    }
+    my->mode = MODE_TILED;
+    my->records.scanOrder = header[19];
+    my->tileSide = (uint16_t)loadValue(&header[HEADER_LENGTH], TILE_SIDE_LENGTH);
+    if (!my->tileSide) {
+        printf("Error: Previous compressed file is damaged\n");
+        return 1;
+    }
+    // Every tile of image is flagged when it is coded again, references to it follow
+    uint64_t numberOfBlocks = ((my->records.matrixDimension[0] + (uint64_t)my->tileSide - 1) / my->tileSide) *
+                              ((my->records.matrixDimension[1] + (uint64_t)my->tileSide - 1) / my->tileSide) * my->records.channels;
+    update->coded = numberOfBlocks <= SIZE_MAX ? (uint8_t*)calloc((size_t)numberOfBlocks, 1) : NULL;
+    if (!update->coded) {
+        printf("Error: Failed allocating tile update\n");
+        return 1;
+    }
+    update->position = HEADER_LENGTH + TILE_SIDE_LENGTH;
+    return 0;
+}
+
+uint8_t copyUnchangedTile(handler* my, uint64_t block, uint8_t* copied)
+{
+    tileUpdate* update = my->update;
+    const uint8_t* tile = &update->data[update->position];
+    uint64_t payloadLength = update->length - update->position >= TILE_HEADER_LENGTH ? loadValue(&tile[1], TILE_HEADER_LENGTH - 1) : UINT64_MAX;
+    if (payloadLength > update->length - update->position - TILE_HEADER_LENGTH) {
+        printf("Error: Previous compressed file is damaged\n");
+        return 1;
+    }
+    update->position += TILE_HEADER_LENGTH + payloadLength;
+
+    uint8_t changed = isChanged(update, &my->records);
+    if (tile[0] == MODE_DUPLICATE_TILE) {
+        uint64_t reference = payloadLength == TILE_REFERENCE_LENGTH ? loadValue(&tile[TILE_HEADER_LENGTH], TILE_REFERENCE_LENGTH) : UINT64_MAX;
+        if (reference >= block) {
+            printf("Error: Previous compressed file is damaged\n");
+            return 1;
+        }
+        changed |= update->coded[reference];
+    }
+    update->coded[block] = changed;
+    *copied = !changed;
+    if (changed) return 0;
+    if (fwrite(tile, 1, TILE_HEADER_LENGTH + payloadLength, my->compressedFile) != TILE_HEADER_LENGTH + payloadLength) {
+        printf("Error: Cannot write tile to file\n");
+        return 1;
+    }
+    my->statistics.reusedTiles++;
+    return 0;
+}
+
+void freeTileUpdate(tileUpdate** my)
+{
+    if (!*my) return;
+    free((*my)->data);
+    free((*my)->rectangles);
+    free((*my)->coded);
+    free(*my);
+    *my = NULL;
+}
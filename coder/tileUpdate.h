@@ -0,0 +1,77 @@
+#ifndef TILE_UPDATE_H
+#define TILE_UPDATE_H
+
+#include "treeOperations.h"
+
+/**
+ * @brief:  Rectangle of image changed since previous compressed file was written.
+ * @row: First row of rectangle.
+ * @column: First column of rectangle.
+ * @rows: Number of rows of rectangle.
+ * @columns: Number of columns of rectangle.
+ */
+typedef struct dirtyRectangle {
+    uint32_t row;
+    uint32_t column;
+    uint32_t rows;
+    uint32_t columns;
+} dirtyRectangle;
+
+/**
+ * @brief:  Previous tiled compressed file of image, whose tiles outside changed rectangles are
+ *          copied to new compressed file instead of being coded again.
+ * @data: Contents of previous compressed file.
+ * @length: Length of previous compressed file.
+ * @position: Position of header of next tile of previous file.
+ * @rectangles: Changed rectangles of image.
+ * @numberOfRectangles: Number of changed rectangles.
+ * @coded: Flag of every tile, 1 if it was coded again, allocated when image is matched.
+ */
+typedef struct tileUpdate {
+    uint8_t* data;
+    uint64_t length;
+    uint64_t position;
+    dirtyRectangle* rectangles;
+    uint32_t numberOfRectangles;
+    uint8_t* coded;
+} tileUpdate;
+
+/**
+  * @brief  Reads previous tiled compressed file of image and keeps copy of changed rectangles,
+  *         so initialize() and encodeTiled() code only tiles they touch.
+  * @param  my A pointer to handler struct
+  * @param  previousPath Path to previous compressed file, coded in tiled mode
+  * @param  rectangles Changed rectangles of image
+  * @param  numberOfRectangles Number of changed rectangles
+  * @retval 0 if previous file was read, 1 otherwise
+  */
+uint8_t openTileUpdate(handler* my, const char* previousPath, const dirtyRectangle* rectangles, uint32_t numberOfRectangles);
+
+/**
+  * @brief  Checks that previous compressed file holds image of the same size, sample size and
+  *         channels coded with the same dictionary, and takes tiled mode, tile side and scan
+  *         order from it.
+  * @param  my A pointer to handler struct with open tile update and loaded records
+  * @retval 0 if previous file matches image, 1 otherwise
+  */
+uint8_t matchTileUpdate(handler* my);
+
+/**
+  * @brief  Reads next tile of previous file and writes it unchanged to compressed file when it
+  *         lies outside every changed rectangle. Reference to tile that is coded again is
+  *         coded again as well, so every reference points to tile of the same samples.
+  * @param  my A pointer to handler struct with matched tile update and records window of tile
+  * @param  block Number of tile, counting channels of every tile
+  * @param  copied Pointer to flag receiving 1 if tile was copied, 0 if it must be coded
+  * @retval 0 on success, 1 if previous file is damaged or write fails
+  */
+uint8_t copyUnchangedTile(handler* my, uint64_t block, uint8_t* copied);
+
+/**
+  * @brief  Frees tile update.
+  * @param  my Address of pointer to tile update, set to NULL afterwards
+  * @retval None
+  */
+void freeTileUpdate(tileUpdate** my);
+
+#endif // TILE_UPDATE_H
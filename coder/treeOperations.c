@@ -1,131 +1,187 @@
 #include "treeOperations.h"
 #include "fileOperations.h"
+#include "staticHuffman.h"
+#include "periodicHuffman.h"
+#include "runLength.h"
+#include "rangeCoder.h"
+#include "tileOperations.h"
+#include "dictionary.h"
+#include "checkpointIndex.h"
+#include "tileUpdate.h"
+#include "scanOrder.h"
+#include "bitPlanes.h"
+
+#define MSB_64 0x8000000000000000ULL
 
-#define MSB_32 0x80000000
+/**
+ * @brief  Moves reading position of records to next record of the window. If the end of the
+ *         current row of the window is reached, it moves to the beginning of the next row.
+ * @param  my: Pointer to the `records` struct
+ * @return None
+ */
+static inline void advanceRecord(records* my)
+{
+    if (++my->currentDimension[1] >= my->windowOrigin[1] + my->windowDimension[1]) {
+        my->currentDimension[1] = my->windowOrigin[1];
+        my->currentDimension[0]++;
+    }
+    my->remainingRecords--;
+}
 
 /**
- * @brief  Retrieves the next record from the `records` matrix in a sequential manner.
- *         If the end of the current row is reached, it moves to the next row. If the 
- *         end of the matrix is reached, the matrix is cleared, and the function stops.
+ * @brief  Retrieves the next record from the `records` matrix in a sequential manner,
+ *         for images with single channel of 8 bit samples.
  *
  * @param  my: Pointer to the `records` struct containing the matrix, 
  *                  current row and column positions, and associated metadata.
  *
- * @return The value of the next record in the matrix as a `uint8_t`. 
- *         Returns 0 if the matrix is fully read.
+ * @return The value of the next record in the matrix. 
  */
-uint8_t popRecord(records* my)
+static uint16_t popRecord(records* my)
 {
-    uint8_t record = my->matrix[my->currentDimension[0]][my->currentDimension[1]++];
-    if (my->currentDimension[1] >= my->matrixDimension[1]) {
-        my->currentDimension[1] = 0;
-        my->currentDimension[0]++;
-    }
-    if (my->currentDimension[0] >= my->matrixDimension[0]) {
-        my->currentDimension[0] = 0;
-        for (int i = 0; i < my->matrixDimension[0]; i++){
-            free(my->matrix[i]);
-            my->matrix[i] = NULL;
-        }
-        free(my->matrix);
-        my->matrix = NULL;
-    } 
+    uint8_t record = my->matrix[my->currentDimension[0]][my->currentDimension[1]];
+    advanceRecord(my);
     return record;
 }
 
-uint8_t expandPointersArray(handler* my)
+/**
+ * @brief  Retrieves the next sample of current channel from the `records` matrix in a
+ *         sequential manner, for colour images and 16 bit samples.
+ * @param  my: Pointer to the `records` struct
+ * @return The value of the next sample in the matrix.
+ */
+static uint16_t popSample(records* my)
+{
+    uint16_t record = readSample(my, my->currentDimension[0], my->currentDimension[1]);
+    advanceRecord(my);
+    return record;
+}
+
+void setWindow(records* my, uint32_t row, uint32_t column, uint32_t rows, uint32_t columns)
+{
+    my->windowOrigin[0] = row;
+    my->windowOrigin[1] = column;
+    my->windowDimension[0] = rows;
+    my->windowDimension[1] = columns;
+    my->currentDimension[0] = row;
+    my->currentDimension[1] = column;
+    my->remainingRecords = (uint64_t)rows * columns;
+}
+
+static uint8_t expandPointersArray(handler* my)
 {
-    node** newArray = (node**)malloc((my->tree.memoryBlockMultiplier + BASE_ARRAY_ENTRIES) * sizeof(node*));
+    node** newArray =
+        (node**)my->memory->allocate(my->memory, (my->tree.memoryBlockMultiplier + BASE_ARRAY_ENTRIES) * sizeof(node*));
     if (!newArray) {
         printf("Failed expanding array pointers array");
         return 1;
     }
     if (my->tree.memoryPointers) {
         memcpy(newArray, my->tree.memoryPointers, my->tree.memoryBlockMultiplier * sizeof(node*));
-        free(my->tree.memoryPointers);
+        releaseMemory(my->memory, my->tree.memoryPointers);
     }
     my->tree.memoryPointers = newArray;
     return 0;
 }
 
 /**
- * @brief  Expands the tree by reallocating memory for the array of node pointers and adding a new block of nodes.
- *         It calculates the current tree size, allocates memory for the expanded tree, and copies the existing node 
- *         pointers to the new memory. The function ensures that the old memory is freed after the expansion.
+ * @brief  Expands the tree by adding a new block of nodes. Array of node pointers is grown to twice as many
+ *         blocks when it is full, so arena that never frees old arrays holds at most as many bytes of them as
+ *         current array takes.
  * @param  None
  * @retval 0 if successfully allocated new space, 1 if memory allocation fails
  */
-uint8_t expandTree(handler* my)
+static uint8_t expandTree(handler* my)
 {
     // Expand array of pointers if necesarry 
     if (my->tree.memoryBlockMultiplier % BASE_ARRAY_ENTRIES == 0) 
         if (expandPointersArray(my)) return 1;
 
-    uint16_t  currentNumberOfNodes = my->tree.baseNumberOfNodes * my->tree.memoryBlockMultiplier;
-    node** newNodes = (node**)malloc(my->tree.baseNumberOfNodes * (my->tree.memoryBlockMultiplier + 1) * sizeof(node*));
-    if (!newNodes) {
-        printf("Failed expanding tree");
-        return 1;
+    uint32_t currentNumberOfNodes = (uint32_t)my->tree.baseNumberOfNodes * my->tree.memoryBlockMultiplier;
+    if (my->tree.memoryBlockMultiplier == my->tree.nodesCapacity) {
+        uint16_t capacity = my->tree.nodesCapacity ? 2 * my->tree.nodesCapacity : 1;
+        node** newNodes = (node**)my->memory->allocate(my->memory, (size_t)my->tree.baseNumberOfNodes * capacity * sizeof(node*));
+        if (!newNodes) {
+            printf("Failed expanding tree");
+            return 1;
+        }
+        if (my->tree.nodes) {
+            memcpy(newNodes, my->tree.nodes, currentNumberOfNodes * sizeof(node*));
+            releaseMemory(my->memory, my->tree.nodes);
+        }
+        my->tree.nodes = newNodes;
+        my->tree.nodesCapacity = capacity;
     }
-    *(newNodes + currentNumberOfNodes) = (node*)malloc(my->tree.baseNumberOfNodes * sizeof(node));
-    if (!newNodes[currentNumberOfNodes]) {
-        free(newNodes);
+    node* block = (node*)my->memory->allocate(my->memory, my->tree.baseNumberOfNodes * sizeof(node));
+    if (!block) {
         printf("Failed expanding tree");
         return 1;
     }
 
     // Append address of new memory chunk to pointers array for memory tracking
-    my->tree.memoryPointers[my->tree.memoryBlockMultiplier] = *(newNodes + currentNumberOfNodes);
+    my->tree.memoryPointers[my->tree.memoryBlockMultiplier] = block;
 
-    for (uint16_t i = 1; i < my->tree.baseNumberOfNodes; i++)
-        *(newNodes + currentNumberOfNodes + i) = newNodes[currentNumberOfNodes] + i; // node* -> &node[0]
-    if (my->tree.nodes) {
-        memcpy(newNodes, my->tree.nodes, currentNumberOfNodes * sizeof(node*));
-        free(my->tree.nodes);
-    }
-    my->tree.nodes = newNodes;
+    for (uint16_t i = 0; i < my->tree.baseNumberOfNodes; i++)
+        my->tree.nodes[currentNumberOfNodes + i] = block + i; // node* -> &node[0]
     my->tree.memoryBlockMultiplier++;
     return 0;
 }
 
 /**
-  * @brief  Expands cache. Function calculates the current cache size, allocates memory for the expanded cache,
-  *         copies the existing cache entries to the new memory. The function ensures that the old memory
-  *         is freed after the expansion.
-  * @param  None
-  * @retval 0 if successfully allocated new space, 1 if memory allocation fails
+  * @brief  Releases image of handler: closes compressed file, frees records matrix, histogram,
+  *         checkpoint index and tile update.
+  * @param  my Pointer to handler
+  * @retval None
   */
-uint8_t expandCache(handler* my)
+static void releaseImage(handler* my)
 {
-    uint16_t oldSizeOfCache = my->cache.baseNumberOfEntries * my->cache.memoryBlockMultiplier * sizeof(cacheEntry);
-    cacheEntry* tempCache = (cacheEntry*)malloc(my->cache.baseNumberOfEntries * ++my->cache.memoryBlockMultiplier * sizeof(cacheEntry));
-    if(!tempCache) {
-        printf("Failed expanding cache");
-        return 1;
+    // Close compressed file if compression did not finish
+    if (my->compressedFile) {
+        fclose(my->compressedFile);
+        my->compressedFile = NULL;
     }
-    if (my->cache.symbolCache) {
-        memcpy(tempCache, my->cache.symbolCache, oldSizeOfCache);
-        free(my->cache.symbolCache);
-    }
-    my->cache.symbolCache = tempCache;
-    return 0;
+    // Free records matrix if it was not fully read
+    if (my->records.matrix)
+        releaseMatrix(&my->records);
+    releaseMemory(my->memory, my->records.histogram);
+    my->records.histogram = NULL;
+    releaseMemory(my->memory, my->records.scanBuffer);
+    my->records.scanBuffer = NULL;
+    my->records.scanCapacity = 0;
+    freeCheckpointIndex(&my->index);
+    freeTileUpdate(&my->update);
 }
 
-void freeAlocatedMemory(handler* my)
+/**
+  * @brief  Frees nodes of tree and cache of leaves, next block allocates them again.
+  * @param  my Pointer to handler
+  * @retval None
+  */
+static void releaseTree(handler* my)
 {
-    // Free memory used for symbolCache array
-    if (my->cache.symbolCache) {
-        free(my->cache.symbolCache);
-        my->cache.symbolCache = NULL;
-    }
-    // Free memory used for nodes array
-    if (my->tree.nodes) {
+    releaseMemory(my->memory, my->cache.leaves);
+    my->cache.leaves = NULL;
+    // Blocks of nodes are given back one by one only to allocator without reset
+    if (my->tree.nodes && my->memory->release)
         for (uint16_t i = 0; i < my->tree.memoryBlockMultiplier; i++)
-            free(my->tree.memoryPointers[i]);
-        // Free memory for node struct pointers
-        free(my->tree.nodes);
-        my->tree.nodes = NULL;
-    }
+            releaseMemory(my->memory, my->tree.memoryPointers[i]);
+    releaseMemory(my->memory, my->tree.nodes);
+    releaseMemory(my->memory, my->tree.memoryPointers);
+    my->tree.nodes = NULL;
+    my->tree.memoryPointers = NULL;
+    my->tree.memoryBlockMultiplier = 0;
+    my->tree.nodesCapacity = 0;
+    my->tree.lastNode = 0;
+}
+
+void freeAlocatedMemory(handler* my)
+{
+    releaseImage(my);
+    freeDictionary(&my->dictionary);
+    releaseTree(my);
+    if (my->ownsMemory && my->memory) my->memory->killMe(&my->memory);
+    my->memory = NULL;
+    my->records.memory = NULL;
 }
 
 /**
@@ -133,34 +189,76 @@ void freeAlocatedMemory(handler* my)
   *         The path is stored in bits, where each bit represents whether the node is a
   *         left (0) or right (1) child in the tree. The path is represented from node to
   *         root. Function register each nodes connection by incrementing mask, so leading
-  *         zeros are not omtied. Then modifies the path if the node is the last node in
-  *         the tree by adding constant symbol value registered from records, and writes
-  *         the final bit sequence to the file.
+  *         zeros are not omtied, and writes the final bit sequence to the file. Path of
+  *         adaptive tree stays below 64 bits, deeper tree would need Fibonacci-like counts
+  *         above 10^13 pixels in one block.
   * @param  node Pointer to the node for which the bit sequence is appended to the file.
-  * @retval None
+  * @retval 0 if write was succesfull, or 1 if an error occurs.
   */
-void appendPathToFile(handler* my, node* _node)
+static uint8_t appendPathToFile(handler* my, node* _node)
 {
-    uint32_t bits = 0;
+    uint64_t bits = 0;
     uint8_t mask = 0;
 
-    // If new symbol append its value to MSB of bits
-    if (_node->positionInTree == my->tree.lastNode) {
-        bits = (my->cache.symbolCache[my->cache.lastCacheEntry].symbolValue) << (32 - BITS_IN_BYTE);
-        mask = BITS_IN_BYTE;
-    }
-
     while (_node->parent) {
         mask++;
         bits >>= 1;
         if (_node == (_node->parent)->link1)
-            bits += MSB_32;
+            bits += MSB_64;
         _node = _node->parent;
     }
+    if (!mask) return 0;
+    bits >>= (64 - mask); // 64 -> bits in "bits" variable (uint64_t)
 
-    bits >>= (32-mask); // 32 -> bits in "bits" variable (uint32_t)
+    // Buffer accepts at most 32 bits at once
+    if (mask > 32 && writeToFile(&my->bitBuffer, my->compressedFile, (uint32_t)(bits >> 32), mask - 32)) return 1;
+    return writeToFile(&my->bitBuffer, my->compressedFile, (uint32_t)bits, mask > 32 ? 32 : mask);
+}
 
-    if (writeToFile(&my->bitBuffer, my->compressedFile, bits, mask)) printf("ERROR: Cannot write to file!");
+/**
+  * @brief  Sets image, bit buffer, statistics and settings of handler to state of new handler.
+  *         Memory of previous image must be released before.
+  * @param  my Pointer to handler
+  * @retval None
+  */
+static void clearImage(handler* my)
+{
+    my->bitBuffer.buffer = 0;
+    my->bitBuffer.freeBits = sizeof(my->bitBuffer.buffer) * 8;
+
+    my->compressedFile = NULL;
+
+    my->records.matrix = NULL;
+    my->records.mapping = NULL;
+    my->records.mappingLength = 0;
+    my->records.sharedRows = 0;
+    my->records.currentDimension[0] = 0; // rows
+    my->records.currentDimension[1] = 0; // columns
+    my->records.matrixDimension[0] = 0;
+    my->records.matrixDimension[1] = 0;
+    my->records.windowOrigin[0] = 0;
+    my->records.windowOrigin[1] = 0;
+    my->records.windowDimension[0] = 0;
+    my->records.windowDimension[1] = 0;
+    my->records.remainingRecords = 0;
+    my->records.maxGreyLevel = 0;
+    my->records.channels = 1;
+    my->records.bytesPerSample = 1;
+    my->records.channel = 0;
+    my->records.numberOfSymbols = NUMBER_OF_BYTE_SYMBOLS;
+    my->records.histogram = NULL;
+    my->records.memory = my->memory;
+    my->records.scanOrder = SCAN_ROW;
+    my->records.scanBuffer = NULL;
+    my->records.scanCapacity = 0;
+    my->records.popRecord = popRecord;
+    my->index = NULL;
+    my->update = NULL;
+
+    memset(&my->statistics, 0, sizeof(my->statistics));
+    my->mode = MODE_AUTO;
+    my->bitPlaneFlags = 0;
+    my->tileSide = DEFAULT_TILE_SIDE;
 }
 
 /**
@@ -172,69 +270,193 @@ void appendPathToFile(handler* my, node* _node)
  *
  **/
 handler* createHandler() {
+    return createHandlerWithAllocator(NULL);
+}
+
+handler* createHandlerWithAllocator(allocator* memory)
+{
     // Dynamically allocate memory for the handler
     handler* _handler = malloc(sizeof(handler));
     if (!_handler) {
         return NULL; // Handle allocation failure
     }
+#if defined(__SANITIZE_ADDRESS__)
+    // AddressSanitizer sees overflow of single block only when blocks come from heap
+    if (!memory) memory = heapAllocator();
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+    if (!memory) memory = heapAllocator();
+#endif
+#endif
+    _handler->ownsMemory = !memory;
+    _handler->memory = memory ? memory : createArena(0);
+    if (!_handler->memory) {
+        free(_handler);
+        return NULL;
+    }
 
     // Initialize internal structs
-    _handler->bitBuffer.buffer = 0;
-    _handler->bitBuffer.freeBits = sizeof(_handler->bitBuffer.buffer) * 8;
-
-    _handler->compressedFile = NULL;
+    clearImage(_handler);
 
-    _handler->records.matrix = NULL;
-    _handler->records.currentDimension[0] = 0; // rows
-    _handler->records.currentDimension[1] = 0; // columns
-    _handler->records.matrixDimension[0] = 0;
-    _handler->records.matrixDimension[1] = 0;
-    _handler->records.popRecord = popRecord;
-
-    _handler->cache.symbolCache = NULL;
-    _handler->cache.baseNumberOfEntries = BASE_CACHE_ENTRIES;
-    _handler->cache.memoryBlockMultiplier = 0;
-    _handler->cache.lastCacheEntry = 0;
+    _handler->cache.leaves = NULL;
+    _handler->cache.numberOfSymbols = NUMBER_OF_BYTE_SYMBOLS;
 
     _handler->tree.nodes = NULL;
     _handler->tree.memoryPointers = NULL;
     _handler->tree.baseNumberOfNodes = BASE_NODES_ENTRIES;
     _handler->tree.memoryBlockMultiplier = 0;
+    _handler->tree.nodesCapacity = 0;
     _handler->tree.lastNode = 0;
+    _handler->dictionary = NULL;
+    _handler->quiet = 0;
 
     return _handler;
 }
 
+void resetHandler(handler* my)
+{
+    releaseImage(my);
+    // Arena gives back image and tree at once, without walking their blocks
+    if (my->memory->reset) {
+        releaseTree(my);
+        my->memory->reset(my->memory);
+    }
+    clearImage(my);
+}
+
+uint8_t prepareRecords(handler* my)
+{
+    if (my->records.channels > 1 || my->records.bytesPerSample > 1)
+        my->records.popRecord = popSample;
+    if (my->mode == MODE_PAIR_HUFFMAN && (my->records.bytesPerSample > 1 || my->dictionary)) {
+        printf("Error: Pair mode needs 8 bit samples and can not use dictionary\n");
+        return 1;
+    }
+    if (my->mode == MODE_BIT_PLANE && (my->records.bytesPerSample > 1 || my->dictionary)) {
+        printf("Error: Bit-plane mode needs 8 bit samples and can not use dictionary\n");
+        return 1;
+    }
+    // Alphabet of 16 bit samples and of pairs needs much larger tree and cache, tree and cache
+    // kept from previous image of handler are reused only for alphabet of the same size
+    uint32_t numberOfSymbols = my->mode == MODE_PAIR_HUFFMAN ? NUMBER_OF_WIDE_SYMBOLS : my->records.numberOfSymbols;
+    uint16_t baseNumberOfNodes = numberOfSymbols > NUMBER_OF_BYTE_SYMBOLS ? WIDE_NODES_ENTRIES : BASE_NODES_ENTRIES;
+    if (my->cache.numberOfSymbols != numberOfSymbols || my->tree.baseNumberOfNodes != baseNumberOfNodes)
+        releaseTree(my);
+    my->cache.numberOfSymbols = numberOfSymbols;
+    my->tree.baseNumberOfNodes = baseNumberOfNodes;
+
+    if (my->dictionary && my->dictionary->bytesPerSample != my->records.bytesPerSample) {
+        printf("Error: Dictionary was trained on images with different sample size\n");
+        return 1;
+    }
+    return 0;
+}
+
 /**
-  * @brief  Initialize tree by loading records to records buffer, allocating memory for tree and cache
-  *         and creating base tree consistiong of root, first symbol from stream and NewSymbol node
-  * @param  None
-  * @retval 0 if successfully created tree and buffer, 1 otherwise
+  * @brief  Initialize handler by loading records to records buffer, choosing coding mode and
+  *         writing header. Tree is created with resetTree() for each coded block.
+  * @param  my A pointer to handler struct, its mode selects coding mode
+  * @param  inputPath Path to PGM file to compress, or NULL to ask user for it
+  * @param  outputPath Path to compressed file, or NULL to ask user for it
+  * @retval 0 if successfully loaded records and created file, 1 otherwise
   */
-uint8_t initialize(handler* my)
+uint8_t initialize(handler* my, const char* inputPath, const char* outputPath)
 {
-    // Create file for compressed data
-    my->compressedFile = createCompressedFile();
+    // Allocate memory for records matrix and populate it with data, update of previous
+    // compressed file touches only rows of tiles it codes again
+    if (!my->records.matrix && (my->update ? mapDataFromFile(&my->records, inputPath) : readDataFromFile(&my->records, inputPath)))
+        return 1;
+    if (!my->records.matrix) return 1;
+    if (my->update && matchTileUpdate(my)) return 1;
+    if (prepareRecords(my)) return 1;
+
+    // Choose mode from histogram counted while reading the image, images larger
+    // than one tile are split into tiles and mode is chosen for each of them
+    if (my->update) {
+        my->statistics.numberOfPixels = (uint64_t)my->records.matrixDimension[0] * my->records.matrixDimension[1] * my->records.channels;
+    } else {
+        analyzeHistogram(my->records.histogram, my->records.numberOfSymbols, &my->statistics);
+        if (my->dictionary)
+            estimateWithDictionary(my->dictionary, my->records.histogram, &my->statistics);
+        uint64_t runLengthBytes = 0;
+        for (uint8_t channel = 0; channel < my->records.channels; channel++) {
+            my->records.channel = channel;
+            runLengthBytes += countRunLengthBytes(&my->records);
+        }
+        my->records.channel = 0;
+        my->statistics.runLengthBitsPerPixel = runLengthBytes * (double)BITS_IN_BYTE / my->statistics.numberOfPixels;
+    }
+    my->statistics.originalBytes = my->statistics.numberOfPixels * my->records.bytesPerSample;
+    if (my->mode == MODE_AUTO) {
+        if (my->records.matrixDimension[0] > my->tileSide || my->records.matrixDimension[1] > my->tileSide)
+            my->mode = MODE_TILED;
+        else
+            my->mode = chooseMode(&my->statistics);
+    }
+    if (my->index && (my->mode != MODE_ADAPTIVE_HUFFMAN || my->records.channels > 1)) {
+        printf("Error: Checkpoint index needs single channel image coded in adaptive mode\n");
+        return 1;
+    }
+    if (my->index && my->records.scanOrder != SCAN_ROW) {
+        printf("Error: Checkpoint index needs row scan order\n");
+        return 1;
+    }
 
-    // Allocate memory for struct fields
-    if (expandTree(my)) return 1;
-    if (expandCache(my)) return 1;
-    if (expandPointersArray(my)) return 1;
+    // Create file for compressed data and describe image in its header
+    if (!my->compressedFile)
+        my->compressedFile = createCompressedFile(outputPath);
+    if (!my->compressedFile) return 1;
+    return writeHeader(my->compressedFile, &my->records, my->mode, my->dictionary ? my->dictionary->id : 0);
+}
 
-    // Allocate memory for records matrix and populate it with data
-    if (readDataFromFile(&my->records)) return 1;
-    if (!my->records.matrix) return 1;
+uint8_t startFromNodes(handler* my, const dictionaryNode* nodes, uint32_t numberOfNodes)
+{
+    while ((uint32_t)my->tree.baseNumberOfNodes * my->tree.memoryBlockMultiplier <= numberOfNodes + 2)
+        if (expandTree(my)) return 1;
+
+    for (uint32_t i = 0; i < numberOfNodes; i++) {
+        node* _node = my->tree.nodes[i];
+        _node->count = nodes[i].count;
+        _node->positionInTree = i;
+        _node->link0 = NULL;
+        _node->link1 = NULL;
+        _node->parent = i ? my->tree.nodes[nodes[i].parent] : NULL;
+        if (!i) continue;
+        if (nodes[i].flags & DICTIONARY_LINK1)
+            _node->parent->link1 = _node;
+        else
+            _node->parent->link0 = _node;
+        if (nodes[i].flags & DICTIONARY_LEAF && i + 1 < numberOfNodes)
+            my->cache.leaves[nodes[i].symbol] = _node;
+    }
+    my->tree.lastNode = numberOfNodes - 1;
+    return 0;
+}
 
-    // Declare first entries for cache and first nodes in tree
-    // and populate cache and nodes entries fields
+uint8_t resetTree(handler* my)
+{
+    // Allocate memory for struct fields, memory of previous tree is reused
+    if (!my->tree.nodes && expandTree(my)) return 1;
+    if (!my->cache.leaves) {
+        my->cache.leaves = (node**)my->memory->allocate(my->memory, my->cache.numberOfSymbols * sizeof(node*));
+        if (!my->cache.leaves) {
+            printf("Failed allocating cache");
+            return 1;
+        }
+    }
+    memset(my->cache.leaves, 0, my->cache.numberOfSymbols * sizeof(node*));
+    if (my->dictionary)
+        return startFromNodes(my, my->dictionary->nodes, my->dictionary->numberOfNodes);
+    my->tree.lastNode = 0;
+
+    // Declare first nodes in tree and populate their fields
     
     node* root =  my->tree.nodes[my->tree.lastNode];       // Root -> position in tree = "0"
     node* symbol0 = my->tree.nodes[++my->tree.lastNode];
     node* newSymbol = my->tree.nodes[++my->tree.lastNode];
 
-    cacheEntry* cachedSymbol0 = &my->cache.symbolCache[my->cache.lastCacheEntry];
-    cachedSymbol0->symbolValue = my->records.popRecord(&my->records);
-    cachedSymbol0->treeAddress = symbol0;
+    uint16_t firstSymbol = my->records.popRecord(&my->records);
+    my->cache.leaves[firstSymbol] = symbol0;
 
     root->count = 1;
     root->parent = NULL;      // Root -> No parent
@@ -254,23 +476,12 @@ uint8_t initialize(handler* my)
     newSymbol->link1 = NULL;
     newSymbol->positionInTree = my->tree.lastNode;   // NewSymbol -> position in tree = tree.lastNode
 
-    if (writeToFile(&my->bitBuffer, my->compressedFile, cachedSymbol0->symbolValue, 9)) printf("ERROR: Cannot write to file!");
-
-    return 0;
-}
+    // Path to first symbol ("0") followed by its value
+    if (writeToFile(&my->bitBuffer, my->compressedFile, firstSymbol, 1 + BITS_IN_BYTE * my->records.bytesPerSample)) {
+        printf("ERROR: Cannot write to file!");
+        return 1;
+    }
 
-/**
-  * @brief  Function checks if it is necesarry to reallocate memory and if so, calls expandTree() and 
-  *         expandCache().
-  * @param None
-  * @retval 1 if failed to reallocate memory, 0 otherwise
-  */
-uint8_t memoryCheck(handler* my)
-{
-    if ((my->cache.lastCacheEntry + 1) >= my->cache.baseNumberOfEntries * my->cache.memoryBlockMultiplier)
-        if(expandCache(my)) return 1;
-    if ((my->tree.lastNode + 2) >= my->tree.baseNumberOfNodes * my->tree.memoryBlockMultiplier) 
-        if (expandTree(my)) return 1;
     return 0;
 }
 
@@ -281,16 +492,24 @@ uint8_t memoryCheck(handler* my)
   * @param  Node Address of node that we will increment
   * @retval address of "parent" node of newly created node after swap, to further tree reorganization
   */
-node* rearrangeTree(handler* my, node* _node)
+static node* rearrangeTree(handler* my, node* _node)
 {
 
     // Search for a node highest in the tree hierarchy on the same "level" -> with the same "count"
     // value that could be swapped with the node that we will increment in this function call
-    uint16_t tempAddress = _node->positionInTree;
+    // Counts never grow with position in tree, so first node of the same count is found with
+    // binary search, which keeps large alphabets with many equal counts fast
+    uint32_t tempAddress = _node->positionInTree;
     node* incrementedNode = my->tree.nodes[tempAddress];
-
-    while (incrementedNode->count == my->tree.nodes[tempAddress - 1]->count) 
-        tempAddress--;
+    uint32_t lowestAddress = 0;
+
+    while (lowestAddress < tempAddress) {
+        uint32_t middle = lowestAddress + (tempAddress - lowestAddress) / 2;
+        if (my->tree.nodes[middle]->count == incrementedNode->count)
+            tempAddress = middle;
+        else
+            lowestAddress = middle + 1;
+    }
     
     incrementedNode->count++;
     node* nodeToSwap = my->tree.nodes[tempAddress];
@@ -330,10 +549,10 @@ node* rearrangeTree(handler* my, node* _node)
   *         registered in data stream and one parent node that will chain together two
   *         symbols: one newly added and one existing symbol that parent node overwrite
   *         in tree array.
-  * @param  newValue new symbol registered in data stream (records) not present in SymbolCache
+  * @param  newValue new symbol registered in data stream (records) not present in cache
   * @retval address of "parent" node of newly created parent node, to further tree reorganization
   */
-node* addNewSymbol(handler* my, uint8_t newValue)
+static node* addNewSymbol(handler* my, uint16_t newValue)
 {
 // Create new parent node in place of newSymbolNode
 node* newParentNode = my->tree.nodes[my->tree.lastNode];
@@ -364,48 +583,240 @@ newParentNode->count = 1;
 newParentNode->link0 = symbolFromStream;
 newParentNode->link1 = newSymbolNode;
 
-// Add newly registered symbol address to SymbolCache
-my->cache.symbolCache[my->cache.lastCacheEntry].treeAddress = symbolFromStream;
+// Add newly registered symbol address to cache
+my->cache.leaves[newValue] = symbolFromStream;
 
 // Return parent of newParentNode for further tree reorganization
 return newParentNode->parent;
 }
 
 /**
-  * @brief   Function searches cache for symbol, if match is found, path of this
-  *          symbol is appended to file and address of this symbol is returned.
-  *          Otherwise new node for newly registered symbol is created and tree
-  *          is reorganized, node returned from addNewSymbol() is returned. Before
-  *          adding nodes to tree, function checks if there is available memory to
-  *          complete this operation, tries to reallocate memory if necesarry.
-  * @param   symbol value of symbol from data stream
-  * @retval  symbol address to further tree reorganization. NULL if error
+  * @brief  Adaptive Huffman coding loop, specialised by kernels below for every sample size
+  *         and number of channels. Both are constants of kernel, so sample is read from
+  *         records matrix without function pointer, tree memory block size is resolved at
+  *         compile time and reading position stays in registers.
+  * @param  my A pointer to handler struct with started tree
+  * @param  lastRecord number of remaining records coding stops at
+  * @param  bytesPerSample size of samples, constant of kernel
+  * @param  singleChannel 1 if image has single channel, constant of kernel
+  * @retval 0 if records were coded, 1 on error
   */
-node* searchCache(handler* my, uint8_t symbol)
+KODA_INLINE uint8_t adaptiveKernel(handler* my, uint64_t lastRecord, const uint8_t bytesPerSample, const uint8_t singleChannel)
 {
-    if (memoryCheck(my)) return NULL;
-    for(uint16_t i = 0; i <= my->cache.lastCacheEntry; i++)
-        if (my->cache.symbolCache[i].symbolValue == symbol) {
-            appendPathToFile(my, my->cache.symbolCache[i].treeAddress);
-            return my->cache.symbolCache[i].treeAddress;
+    const uint32_t nodesEntries = bytesPerSample == 1 ? BASE_NODES_ENTRIES : WIDE_NODES_ENTRIES;
+    records* records = &my->records;
+    uint8_t** matrix = records->matrix;
+    const uint32_t firstColumn = records->windowOrigin[1];
+    const uint32_t endColumn = firstColumn + records->windowDimension[1];
+    const uint64_t stride = singleChannel ? bytesPerSample : (uint64_t)records->channels * bytesPerSample;
+    const uint64_t channelOffset = singleChannel ? 0 : (uint64_t)records->channel * bytesPerSample;
+    uint32_t row = records->currentDimension[0];
+    uint32_t column = records->currentDimension[1];
+    uint64_t remainingRecords = records->remainingRecords;
+    uint8_t status = 0;
+
+    while (remainingRecords > lastRecord) {
+        const uint8_t* sample = &matrix[row][column * stride + channelOffset];
+        uint16_t symbol = bytesPerSample == 1 ? sample[0] : (uint16_t)((sample[0] << BITS_IN_BYTE) | sample[1]);
+        if (++column >= endColumn) {
+            column = firstColumn;
+            row++;
         }
-    // If no match found, expand cache by new value and append NewSymbol to file
-    my->cache.symbolCache[++my->cache.lastCacheEntry].symbolValue = symbol;
-    appendPathToFile(my, my->tree.nodes[my->tree.lastNode]);
-    return addNewSymbol(my, symbol);
+        remainingRecords--;
+
+        if (my->tree.lastNode + 2 >= nodesEntries * my->tree.memoryBlockMultiplier && expandTree(my)) {
+            status = 1;
+            break;
+        }
+        node* leaf = my->cache.leaves[symbol];
+        if (leaf) {
+            if (appendPathToFile(my, leaf)) {
+                status = 1;
+                break;
+            }
+        } else {
+            // If symbol is not in tree, append NewSymbol path and symbol value to file
+            if (appendPathToFile(my, my->tree.nodes[my->tree.lastNode]) ||
+                writeToFile(&my->bitBuffer, my->compressedFile, symbol, BITS_IN_BYTE * bytesPerSample)) {
+                printf("ERROR: Cannot write to file!");
+                status = 1;
+                break;
+            }
+            leaf = addNewSymbol(my, symbol);
+        }
+        my->tree.nodes[0]->count++;
+        while (leaf->parent != NULL)
+            leaf = rearrangeTree(my, leaf);
+    }
+    records->currentDimension[0] = row;
+    records->currentDimension[1] = column;
+    records->remainingRecords = remainingRecords;
+    return status;
 }
 
+#define ADAPTIVE_KERNEL(name, bytesPerSample, singleChannel) \
+    static uint8_t name(handler* my, uint64_t lastRecord) { return adaptiveKernel(my, lastRecord, bytesPerSample, singleChannel); }
+ADAPTIVE_KERNEL(encodeByteSamples, 1, 1)
+ADAPTIVE_KERNEL(encodeWideSamples, 2, 1)
+ADAPTIVE_KERNEL(encodeByteChannel, 1, 0)
+ADAPTIVE_KERNEL(encodeWideChannel, 2, 0)
+
 uint8_t constructTree(handler* my)
 {
-    node* symbol;
-    while (my->records.matrix) {
-        symbol = searchCache(my, my->records.popRecord(&my->records));
-        if (!symbol) return 1;
-        my->tree.nodes[0]->count++;
-        while (symbol->parent != NULL)
-            symbol = rearrangeTree(my, symbol);
+    // Kernel is chosen once per block
+    uint8_t (*kernel)(handler*, uint64_t);
+    if (my->records.channels == 1)
+        kernel = my->records.bytesPerSample == 1 ? encodeByteSamples : encodeWideSamples;
+    else
+        kernel = my->records.bytesPerSample == 1 ? encodeByteChannel : encodeWideChannel;
+
+    while (my->records.remainingRecords) {
+        // Records are coded up to next checkpoint, or to the end without index
+        uint64_t checkpoint = my->index ? nextCheckpoint(my) : 0;
+        if (kernel(my, checkpoint)) return 1;
+        if (checkpoint && writeCheckpoint(my)) return 1;
     }
     // Write remaining bits in buffer
     if (writeToFile(&my->bitBuffer, my->compressedFile, 0, 0)) return 1;
     return 0;
+}
+
+void countWindowHistogram(records* my)
+{
+    memset(my->histogram, 0, my->numberOfSymbols * sizeof(uint64_t));
+    for (uint32_t row = my->windowOrigin[0]; row < (uint32_t)my->windowOrigin[0] + my->windowDimension[0]; row++) {
+        // Samples of single channel 8 bit image are consecutive bytes
+        if (my->channels == 1 && my->bytesPerSample == 1) {
+            accumulateHistogram(&my->matrix[row][my->windowOrigin[1]], my->windowDimension[1], my->histogram);
+            continue;
+        }
+        for (uint32_t column = my->windowOrigin[1]; column < (uint32_t)my->windowOrigin[1] + my->windowDimension[1]; column++)
+            my->histogram[readSample(my, row, column)]++;
+    }
+}
+
+/**
+  * @brief  Compresses records window of current channel with single coding mode, reading it
+  *         row by row.
+  * @param  my A pointer to handler struct with set records window.
+  * @param  mode Coding mode of block
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+static uint8_t encodeWindow(handler* my, uint8_t mode)
+{
+    switch (mode) {
+    case MODE_ADAPTIVE_HUFFMAN:
+    case MODE_PAIR_HUFFMAN:
+        return resetTree(my) || constructTree(my);
+    case MODE_STATIC_HUFFMAN:
+        return encodeStatic(my);
+    case MODE_PERIODIC_HUFFMAN:
+        return encodePeriodic(my);
+    case MODE_STORED:
+        return writeStoredRecords(my->compressedFile, &my->records);
+    case MODE_RUN_LENGTH:
+        return encodeRunLength(my);
+    case MODE_RANGE:
+        return encodeRange(my);
+    case MODE_BIT_PLANE:
+        return encodeBitPlanes(my);
+    default:
+        printf("Error: Unknown coding mode %u\n", mode);
+        return 1;
+    }
+}
+
+uint8_t encodeBlock(handler* my, uint8_t mode)
+{
+    if (my->records.scanOrder == SCAN_ROW && mode != MODE_PAIR_HUFFMAN)
+        return encodeWindow(my, mode);
+
+    // Block is coded from copy of window in scan order, then records read image again
+    records image = my->records;
+    uint8_t status = mode == MODE_PAIR_HUFFMAN ? pairWindow(&my->records) : scanWindow(&my->records);
+    // Pairs are read as 16 bit samples
+    if (mode == MODE_PAIR_HUFFMAN)
+        my->records.popRecord = popSample;
+    status = status || encodeWindow(my, mode);
+    image.scanBuffer = my->records.scanBuffer;
+    image.scanCapacity = my->records.scanCapacity;
+    image.remainingRecords = 0;
+    my->records = image;
+    return status;
+}
+
+uint8_t compressData(handler* my)
+{
+    double start = currentSeconds();
+    if (my->mode == MODE_TILED) {
+        if (encodeTiled(my)) return 1;
+    } else {
+        // Every channel is coded as separate block with its own model
+        for (uint8_t channel = 0; channel < my->records.channels; channel++) {
+            my->records.channel = channel;
+            setWindow(&my->records, 0, 0, my->records.matrixDimension[0], my->records.matrixDimension[1]);
+            if (my->records.channels > 1)
+                countWindowHistogram(&my->records);
+            if (encodeBlock(my, my->mode)) return 1;
+        }
+    }
+
+    my->statistics.compressedBytes = ftell(my->compressedFile);
+    if (fclose(my->compressedFile)) {
+        my->compressedFile = NULL;
+        printf("Error: Error during closing file\n");
+        return 1;
+    }
+    my->compressedFile = NULL;
+    my->statistics.encodeSeconds = currentSeconds() - start;
+    if (my->index && closeCheckpointIndex(my, my->statistics.compressedBytes)) return 1;
+    if (my->quiet) return 0;
+    printf("File successfully written and closed\n");
+    printStatistics(&my->statistics, my->mode);
+    return 0;
+}
+
+uint8_t parseMode(const char* name, uint8_t* mode)
+{
+    if (!strcmp(name, "auto")) {
+        *mode = MODE_AUTO;
+        return 0;
+    }
+    if (!strcmp(name, "stored")) {
+        *mode = MODE_STORED;
+        return 0;
+    }
+    if (!strcmp(name, "runlength")) {
+        *mode = MODE_RUN_LENGTH;
+        return 0;
+    }
+    if (!strcmp(name, "range")) {
+        *mode = MODE_RANGE;
+        return 0;
+    }
+    if (!strcmp(name, "tiled")) {
+        *mode = MODE_TILED;
+        return 0;
+    }
+    if (!strcmp(name, "adaptive")) {
+        *mode = MODE_ADAPTIVE_HUFFMAN;
+        return 0;
+    }
+    if (!strcmp(name, "static")) {
+        *mode = MODE_STATIC_HUFFMAN;
+        return 0;
+    }
+    if (!strcmp(name, "pair")) {
+        *mode = MODE_PAIR_HUFFMAN;
+        return 0;
+    }
+    if (!strcmp(name, "bitplane")) {
+        *mode = MODE_BIT_PLANE;
+        return 0;
+    }
+    if (!strcmp(name, "periodic")) {
+        *mode = MODE_PERIODIC_HUFFMAN;
+        return 0;
+    }
+    return 1;
 }
\ No newline at end of file
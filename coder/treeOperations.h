@@ -2,15 +2,30 @@
 #define TREE_OPERATIONS_H
 
 #define BASE_NODES_ENTRIES 32
-#define BASE_CACHE_ENTRIES 16
+// Tree of 16 bit alphabet holds up to 131071 nodes, so it grows in larger blocks
+#define WIDE_NODES_ENTRIES 1024
 #define BASE_ARRAY_ENTRIES 8
 #define BITS_IN_BYTE 8
+#define NUMBER_OF_BYTE_SYMBOLS 256
+#define NUMBER_OF_WIDE_SYMBOLS 65536
+
+// Kernels are specialised by inlining their body with constant parameters
+#if defined(_MSC_VER)
+#define KODA_INLINE static __forceinline
+#else
+#define KODA_INLINE static inline __attribute__((always_inline))
+#endif
 
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "imageAnalysis.h"
+#include "memoryArena.h"
+
+struct dictionaryNode;
+
 /**
  * @brief:  Represents buffer to store data before writing it to file.
  * @buffer: Variable that stores appended bit paths and symbol values
@@ -34,8 +49,8 @@ typedef struct node {
     struct node* parent;
     struct node* link0;
     struct node* link1;
-    uint16_t positionInTree;
-    uint32_t count;
+    uint32_t positionInTree;
+    uint64_t count;
 } node;
 
 /**
@@ -43,55 +58,93 @@ typedef struct node {
  * @nodes: Array of pointers to node structs, used to create the tree.
  * @baseNumberOfNodes: Base size of memory chunk for nodes.
  * @memoryBlockMultiplier: Number of memory blocks allocated for nodes.
+ * @nodesCapacity: Number of memory blocks array of node pointers has room for.
  * @lastNode: Position of the last node in the array, used for tracking new symbols.
  */
 typedef struct tree {
     struct node** nodes;
     struct node** memoryPointers;
-    uint8_t baseNumberOfNodes;
+    uint16_t baseNumberOfNodes;
     uint8_t memoryBlockMultiplier;
-    uint16_t lastNode;
+    uint16_t nodesCapacity;
+    uint32_t lastNode;
 } tree;
 
 /**
- * @brief:  Represents a single entry in the symbol cache.
- * @treeAddress: Pointer to a node in the tree structure representing the symbol.
- * @symbolValue: Value of the symbol associated with this cache entry.
- */
-typedef struct cacheEntry {
-    struct node* treeAddress;
-    uint8_t symbolValue;
-} cacheEntry;
-
-/**
- * @brief:  Represents a cache for storing symbol recorded in data stream.
- * @symbolCache: Array of cacheEntry structs for symbol lookup.
- * @lastSymbolPath: Last processed symbol's path in the tree.
- * @baseNumberOfEntries: Base size for the memory chunk of the cache.
- * @memoryBlockMultiplier: Number of memory blocks allocated for the cache.
- * @lastCacheEntry: Position of the last cache entry in the symbolCache array.
+ * @brief:  Represents a cache mapping symbols recorded in data stream to their leaves, so
+ *          symbol is found with single access whatever the size of alphabet.
+ * @leaves: Array of numberOfSymbols leaves, NULL for symbols not present in tree yet.
+ * @numberOfSymbols: Size of alphabet, 256 or 65536 for 16 bit samples.
  */
 typedef struct cache {
-    struct cacheEntry* symbolCache;
-    uint8_t baseNumberOfEntries;
-    uint8_t memoryBlockMultiplier;
-    uint16_t lastCacheEntry;
+    struct node** leaves;
+    uint32_t numberOfSymbols;
 } cache;
 
 /**
- * @brief:  Manages a 2D matrix of int8_t records with sequential access capabilities.
- * @matrix: Dynamically allocated 2D array of uint8_t values.
- * @currentRow: Current row index being accessed in the matrix.
- * @currentColumn: Current column index being accessed in the current row.
+ * @brief:  Manages a 2D matrix of samples with sequential access capabilities.
+ * @matrix: Array of pointers to rows as stored in file: channels interleaved, 16 bit samples
+ *          in big-endian order.
+ * @mapping: Memory mapped input file that matrix rows point into, NULL if rows were read
+ *           into allocated memory.
+ * @mappingLength: Length of mapped input file in bytes.
+ * @sharedRows: 1 if rows point into image file loaded by caller, which frees it.
+ * @currentDimension: Current row and column index being accessed in the matrix.
+ * @matrixDimension: Number of rows and columns of the matrix.
+ * @windowOrigin: First row and column of window that is read by popRecord.
+ * @windowDimension: Number of rows and columns of window that is read by popRecord.
+ * @remainingRecords: Number of records of window not read yet.
+ * @maxGreyLevel: Maximum grey level declared in the image header.
+ * @channels: Number of channels, 1 for PGM and 3 for PPM images.
+ * @bytesPerSample: 1 for max grey level up to 255, 2 otherwise.
+ * @channel: Channel read by popRecord, every channel is coded with its own model.
+ * @numberOfSymbols: Size of sample alphabet, 256 or 65536.
+ * @histogram: Number of occurrences of each sample value in current window, counted for
+ *             all channels of the whole image while reading it.
+ * @memory: Allocator of matrix, rows read into memory, histogram and scan buffer.
+ * @scanOrder: Order in which samples of every coded block are read, written to compressed
+ *             file header.
+ * @scanBuffer: Samples of current window in scan order with their row pointers, NULL until
+ *              window is read in order other than SCAN_ROW.
+ * @scanCapacity: Number of bytes of scan buffer.
  * @popRecord: Function pointer for retrieving the next record in sequence.
  */
 typedef struct records {
     uint8_t** matrix;
-    uint16_t currentDimension[2];
-    uint16_t matrixDimension[2];
-    uint8_t (*popRecord)(struct records*);
+    uint8_t* mapping;
+    uint64_t mappingLength;
+    uint8_t sharedRows;
+    uint32_t currentDimension[2];
+    uint32_t matrixDimension[2];
+    uint32_t windowOrigin[2];
+    uint32_t windowDimension[2];
+    uint64_t remainingRecords;
+    uint16_t maxGreyLevel;
+    uint8_t channels;
+    uint8_t bytesPerSample;
+    uint8_t channel;
+    uint32_t numberOfSymbols;
+    uint64_t* histogram;
+    struct allocator* memory;
+    uint8_t scanOrder;
+    uint8_t* scanBuffer;
+    uint64_t scanCapacity;
+    uint16_t (*popRecord)(struct records*);
 } records;
 
+/**
+ * @brief  Reads sample of current channel of records.
+ * @param  my Pointer to records struct with loaded matrix
+ * @param  row Row of sample
+ * @param  column Column of sample
+ * @retval Sample value
+ */
+static inline uint16_t readSample(const records* my, uint32_t row, uint32_t column)
+{
+    const uint8_t* sample = &my->matrix[row][((uint64_t)column * my->channels + my->channel) * my->bytesPerSample];
+    return my->bytesPerSample == 1 ? sample[0] : (uint16_t)((sample[0] << BITS_IN_BYTE) | sample[1]);
+}
+
 /**
  * @brief:  Represents the main structure for managing the Huffman codec, 
  *          including input records, symbol cache, and the Huffman tree.
@@ -100,6 +153,17 @@ typedef struct records {
  * @records: A `records` structure for managing the 2D matrix of input data.
  * @cache: A `cache` structure for storing symbol information and lookup paths.
  * @tree: A `tree` structure representing the Huffman tree for encoding and decoding.
+ * @statistics: Entropy and expected and achieved sizes of compressed image.
+ * @dictionary: Trained tree every adaptive block starts from, NULL to start from first symbol.
+ * @index: Checkpoint index written while coding adaptive stream, NULL if not requested.
+ * @update: Previous tiled compressed file and changed rectangles of image, only tiles they
+ *          touch are coded, NULL to code whole image.
+ * @mode: Coding mode used to compress records, written to compressed file header.
+ * @bitPlaneFlags: Flags of blocks coded in bit-plane mode, BIT_PLANE_GRAY to Gray-code samples.
+ * @tileSide: Side of square tiles used in tiled mode.
+ * @quiet: 1 to skip success message and statistics of compressed image, errors are printed always.
+ * @memory: Allocator of image, tree and cache, reset between images when it can be.
+ * @ownsMemory: 1 if allocator is arena created with handler and freed with it.
  */
 typedef struct handler {
     FILE* compressedFile;
@@ -107,6 +171,16 @@ typedef struct handler {
     records records;
     cache  cache;
     tree tree;
+    struct dictionary* dictionary;
+    struct checkpointIndex* index;
+    struct tileUpdate* update;
+    imageStatistics statistics;
+    uint8_t mode;
+    uint8_t bitPlaneFlags;
+    uint16_t tileSide;
+    uint8_t quiet;
+    struct allocator* memory;
+    uint8_t ownsMemory;
 } handler;
 
 /**
@@ -118,27 +192,130 @@ typedef struct handler {
 handler* createHandler();
 
 /**
-  * @brief: Initialize tree by loading records to records buffer, allocating memory for tree and cache
-  *         and creating base tree consistiong of root, first symbol from stream and NewSymbol node
+  * @brief: Creates handler as createHandler() does, taking memory of every image from given
+  *         allocator. Allocator with reset is reset by resetHandler(), so it must not be
+  *         shared with other handler.
+  * @param  memory Allocator outliving handler, NULL for arena of handler
+  * @retval Pointer to handler, NULL if memory allocation fails
+  */
+handler* createHandlerWithAllocator(struct allocator* memory);
+
+/**
+  * @brief: Initialize handler by loading records to records buffer, choosing coding mode
+  *         and writing header of compressed file.
+  *         Automatic mode is resolved here from image statistics, images larger than one tile
+  *         are tiled. Tree is created later, for each coded block. Records read before and
+  *         compressed file opened before are used instead of paths. With tile update, image
+  *         is neither counted nor analysed as a whole and mode is taken from previous file.
   * @param  my A pointer to handler struct containing information about tree, cache and records
+  * @param  inputPath Path to PGM file to compress, or NULL to ask user for it
+  * @param  outputPath Path to compressed file, or NULL to ask user for it
   * @retval 0 if successfully created tree and buffer, 1 otherwise
   */
-uint8_t initialize(handler* my);
+uint8_t initialize(handler* my, const char* inputPath, const char* outputPath);
+
+/**
+  * @brief: Checks loaded records against coding mode and dictionary of handler, selects how
+  *         popRecord reads them and sizes tree and cache for their alphabet. Called by
+  *         initialize(), and by callers coding records without compressed file header.
+  * @param  my A pointer to handler struct with loaded records
+  * @retval 0 if records can be coded, 1 otherwise
+  */
+uint8_t prepareRecords(handler* my);
+
+/**
+  * @brief: Replaces tree with given nodes, links of nodes are rebuilt from their parents and
+  *         leaves of their symbols are put in cache, which must hold no other leaves.
+  * @param  my A pointer to handler struct with allocated cache
+  * @param  nodes Valid adaptive tree in order of position in tree, NewSymbol node last
+  * @param  numberOfNodes Number of nodes
+  * @retval 0 if tree was created, 1 if memory allocation fails
+  */
+uint8_t startFromNodes(handler* my, const struct dictionaryNode* nodes, uint32_t numberOfNodes);
+
+/**
+  * @brief: Creates base tree consisting of root, first symbol of records window and NewSymbol
+  *         node, and writes first symbol to file. With dictionary, tree is copied from trained
+  *         tree instead and nothing is written. Memory of previous tree is reused, so tree
+  *         can be started again for every tile.
+  * @param  my A pointer to handler struct with opened compressed file and set records window
+  * @retval 0 if successfully created tree, 1 otherwise
+  */
+uint8_t resetTree(handler* my);
+
+/**
+  * @brief: Sets rectangular window of records matrix that is read by popRecord, row by row,
+  *         and moves reading position to its first record.
+  * @param  my A pointer to records struct with loaded matrix
+  * @param  row First row of window
+  * @param  column First column of window
+  * @param  rows Number of rows of window
+  * @param  columns Number of columns of window
+  * @retval None
+  */
+void setWindow(records* my, uint32_t row, uint32_t column, uint32_t rows, uint32_t columns);
+
+/**
+  * @brief: Counts samples of records window and current channel into records histogram.
+  * @param  my A pointer to records struct with set window
+  * @retval None
+  */
+void countWindowHistogram(records* my);
+
+/**
+  * @brief: Compresses records window of current channel with single coding mode. Every
+  *         block starts with fresh model and ends byte aligned. Samples are read in scan
+  *         order of records, in pair mode two of them form single symbol.
+  * @param  my A pointer to handler struct with set records window.
+  * @param  mode Coding mode of block, any mode except tiled.
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+uint8_t encodeBlock(handler* my, uint8_t mode);
 
 /**
   * @brief: Constructs the Huffman tree and compresses input data dynamically.
   *         Iterates through input records, updates the tree structure, and encodes data.
+  *         With checkpoint index, tree is written to it every index interval of pixels.
   * @param  my A pointer to the handler struct containing the Huffman tree, cache, and data records.
   * @retval 0 if the tree is successfully constructed and data compressed, 1 on error.
   */
 uint8_t constructTree(handler* my);
 
 /**
-  * @brief  Frees memory used by structs
-  * @param  my pointer to handler struct containing instances of: dataBuffer, records, cache, tree
-  *         and compressedFile pointer
+  * @brief: Compresses loaded records with coding mode selected in handler, each channel
+  *         separately, then closes compressed file and records its size in handler statistics.
+  * @param  my A pointer to initialized handler struct.
+  * @retval 0 if data compressed successfully, 1 on error.
+  */
+uint8_t compressData(handler* my);
+
+/**
+  * @brief: Translates coding mode name ("auto", "adaptive", "pair", "bitplane", "static",
+  *         "periodic", "stored", "runlength", "range", "tiled") to coder mode.
+  * @param  name Name of coding mode
+  * @param  mode Pointer to variable receiving mode
+  * @retval 0 if name is known, 1 otherwise
+  */
+uint8_t parseMode(const char* name, uint8_t* mode);
+
+/**
+  * @brief  Frees memory used by structs. Handler itself is left for the caller to free.
+  * @param  my pointer to handler struct containing instances of: dataBuffer, records, cache, tree,
+  *         dictionary, checkpoint index, tile update and compressedFile pointer
   * @retval None
   */
 void freeAlocatedMemory(handler* my);
 
+/**
+  * @brief  Prepares handler used for previous image for next one: closes compressed file,
+  *         releases image, checkpoint index and tile update and restores default mode, scan order and
+  *         statistics.
+  *         Allocator with reset gives back all memory at once and keeps it for next image,
+  *         otherwise tree nodes and cache stay allocated and are reused when next image has
+  *         samples of the same size. Dictionary and quiet flag are kept.
+  * @param  my pointer to handler struct
+  * @retval None
+  */
+void resetHandler(handler* my);
+
 #endif // TREE_OPERATIONS_H
\ No newline at end of file
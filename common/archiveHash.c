@@ -0,0 +1,11 @@
+#include "archiveHash.h"
+
+uint64_t archiveHash(const uint8_t* data, uint64_t length)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (uint64_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,15 @@
+#ifndef ARCHIVE_HASH_H
+#define ARCHIVE_HASH_H
+
+#include <stdint.h>
+
+/**
+  * @brief  Computes 64-bit FNV-1a hash of data, used for names and checksums of archive by
+  *         coder and decoder alike.
+  * @param  data Hashed bytes
+  * @param  length Number of bytes
+  * @retval Hash of data
+  */
+uint64_t archiveHash(const uint8_t* data, uint64_t length);
+
+#endif // ARCHIVE_HASH_H
@@ -0,0 +1,116 @@
+#include "scanWalk.h"
+
+/**
+ * @brief:  Receiver of runs of scan, passed down recursion of Hilbert curve.
+ * @run: Function receiving runs of positions.
+ * @context: Pointer passed to run.
+ */
+typedef struct scanWalk {
+    scanRun run;
+    void* context;
+} scanWalk;
+
+static int64_t sign(int64_t value)
+{
+    return (value > 0) - (value < 0);
+}
+
+// Halves are rounded down as in the reference algorithm, also for negative vectors
+static int64_t floorHalf(int64_t value)
+{
+    return value >= 0 ? value / 2 : -((1 - value) / 2);
+}
+
+static int64_t length(int64_t x, int64_t y)
+{
+    return x + y >= 0 ? x + y : -(x + y);
+}
+
+/**
+  * @brief  Walks generalized Hilbert curve (gilbert2d) of rectangle given by origin and two
+  *         vectors, major one along which curve proceeds and orthogonal one. Rectangle
+  *         is split in halves along its longer side, or in three parts turning the curve,
+  *         until it is single row or column, which is passed as single run.
+  * @param  walk Pointer to receiver of runs
+  * @param  x Column of origin
+  * @param  y Row of origin
+  * @param  ax Column part of major vector
+  * @param  ay Row part of major vector
+  * @param  bx Column part of orthogonal vector
+  * @param  by Row part of orthogonal vector
+  * @retval None
+  */
+static void walkHilbert(const scanWalk* walk, int64_t x, int64_t y, int64_t ax, int64_t ay, int64_t bx, int64_t by)
+{
+    int64_t width = length(ax, ay);
+    int64_t height = length(bx, by);
+    int64_t dax = sign(ax), day = sign(ay);
+    int64_t dbx = sign(bx), dby = sign(by);
+
+    if (height == 1) {
+        walk->run(walk->context, (uint32_t)y, (uint32_t)x, (uint32_t)width, (int8_t)day, (int8_t)dax);
+        return;
+    }
+    if (width == 1) {
+        walk->run(walk->context, (uint32_t)y, (uint32_t)x, (uint32_t)height, (int8_t)dby, (int8_t)dbx);
+        return;
+    }
+
+    int64_t ax2 = floorHalf(ax), ay2 = floorHalf(ay);
+    int64_t bx2 = floorHalf(bx), by2 = floorHalf(by);
+    if (2 * width > 3 * height) {
+        // Long rectangle is split in two along major vector, halves of even length if possible
+        if ((length(ax2, ay2) & 1) && width > 2) {
+            ax2 += dax;
+            ay2 += day;
+        }
+        walkHilbert(walk, x, y, ax2, ay2, bx, by);
+        walkHilbert(walk, x + ax2, y + ay2, ax - ax2, ay - ay2, bx, by);
+        return;
+    }
+    // Otherwise curve goes up the orthogonal half, along the rest and back down
+    if ((length(bx2, by2) & 1) && height > 2) {
+        bx2 += dbx;
+        by2 += dby;
+    }
+    walkHilbert(walk, x, y, bx2, by2, ax2, ay2);
+    walkHilbert(walk, x + bx2, y + by2, ax, ay, bx - bx2, by - by2);
+    walkHilbert(walk, x + (ax - dax) + (bx2 - dbx), y + (ay - day) + (by2 - dby), -bx2, -by2, -(ax - ax2), -(ay - ay2));
+}
+
+void walkScan(uint8_t order, uint32_t rows, uint32_t columns, scanRun run, void* context)
+{
+    if (!rows || !columns) return;
+    switch (order) {
+    case SCAN_SERPENTINE:
+        for (uint32_t row = 0; row < rows; row++) {
+            if (row & 1)
+                run(context, row, columns - 1, columns, 0, -1);
+            else
+                run(context, row, 0, columns, 0, 1);
+        }
+        break;
+    case SCAN_HILBERT: {
+        scanWalk walk = { .run = run, .context = context };
+        if (columns >= rows)
+            walkHilbert(&walk, 0, 0, columns, 0, 0, rows);
+        else
+            walkHilbert(&walk, 0, 0, 0, rows, columns, 0);
+        break;
+    }
+    case SCAN_TILE:
+        for (uint32_t tileRow = 0; tileRow < rows; tileRow += SCAN_TILE_SIDE) {
+            uint32_t tileRows = rows - tileRow < SCAN_TILE_SIDE ? rows - tileRow : SCAN_TILE_SIDE;
+            for (uint32_t tileColumn = 0; tileColumn < columns; tileColumn += SCAN_TILE_SIDE) {
+                uint32_t tileColumns = columns - tileColumn < SCAN_TILE_SIDE ? columns - tileColumn : SCAN_TILE_SIDE;
+                for (uint32_t row = tileRow; row < tileRow + tileRows; row++)
+                    run(context, row, tileColumn, tileColumns, 0, 1);
+            }
+        }
+        break;
+    default:
+        for (uint32_t row = 0; row < rows; row++)
+            run(context, row, 0, columns, 0, 1);
+        break;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef SCAN_WALK_H
+#define SCAN_WALK_H
+
+// Scan orders in which samples of every block are coded, stored in header of compressed file
+#define SCAN_ROW 0
+#define SCAN_SERPENTINE 1
+#define SCAN_HILBERT 2
+#define SCAN_TILE 3
+// Tile-major scan visits rectangle in squares of this side, row by row inside each square
+#define SCAN_TILE_SIDE 16
+
+#include <stdint.h>
+
+/**
+  * @brief  Receives run of positions visited by scan: length positions starting at given row
+  *         and column, each next one moved by row and column step.
+  * @param  context Pointer passed to walkScan
+  * @param  row Row of first position, relative to walked rectangle
+  * @param  column Column of first position, relative to walked rectangle
+  * @param  length Number of positions of run
+  * @param  rowStep Row step between positions, -1, 0 or 1
+  * @param  columnStep Column step between positions, -1, 0 or 1
+  * @retval None
+  */
+typedef void (*scanRun)(void* context, uint32_t row, uint32_t column, uint32_t length, int8_t rowStep, int8_t columnStep);
+
+/**
+  * @brief  Visits every position of rectangle exactly once in given scan order: row by row,
+  *         serpentine (odd rows right to left), generalized Hilbert curve, which keeps
+  *         neighbouring positions close for any rectangle, or tile-major in squares of
+  *         SCAN_TILE_SIDE. Positions are passed in runs of the same direction. Coder reads
+  *         samples and decoder places them along the same walk.
+  * @param  order Scan order, SCAN_ROW, SCAN_SERPENTINE, SCAN_HILBERT or SCAN_TILE
+  * @param  rows Number of rows of rectangle
+  * @param  columns Number of columns of rectangle
+  * @param  run Function receiving runs of positions in scan order
+  * @param  context Pointer passed to run
+  * @retval None
+  */
+void walkScan(uint8_t order, uint32_t rows, uint32_t columns, scanRun run, void* context);
+
+#endif // SCAN_WALK_H
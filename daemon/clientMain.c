@@ -0,0 +1,278 @@
+// Client of compression daemon: sends image or compressed file and writes reply to file
+#define _GNU_SOURCE
+#include "daemonProtocol.h"
+#include "codecContext.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// Daemon started together with client gets this long to create its socket
+#define CLIENT_CONNECT_ATTEMPTS 500
+#define CLIENT_CONNECT_DELAY_US 10000
+
+/**
+  * @brief  Returns monotonic time in seconds.
+  * @param  None
+  * @retval Time in seconds
+  */
+static double currentSeconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+  * @brief  Connects to daemon, retrying while its socket does not accept connections yet.
+  * @param  path Path of socket
+  * @retval Connected socket, -1 on error
+  */
+static int connectDaemon(const char* path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("Error: Socket path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    for (uint32_t attempt = 0; attempt < CLIENT_CONNECT_ATTEMPTS; attempt++) {
+        int connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connection < 0) break;
+        if (!connect(connection, (struct sockaddr*)&address, sizeof(address))) return connection;
+        close(connection);
+        if (errno != ENOENT && errno != ECONNREFUSED) break;
+        usleep(CLIENT_CONNECT_DELAY_US);
+    }
+    printf("Error: Cannot connect to daemon at %s\n", path);
+    return -1;
+}
+
+/**
+  * @brief  Reads whole file into memory, or into shared memory passed to daemon.
+  * @param  path Path to file
+  * @param  length Pointer receiving length of file
+  * @param  shared Pointer receiving shared memory with file, NULL to read file into memory
+  * @retval Contents of file, NULL on error
+  */
+static uint8_t* loadFile(const char* path, uint64_t* length, int* shared)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Error: Cannot open %s\n", path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = NULL;
+    if (size >= 0) {
+        *length = (uint64_t)size;
+        if (shared) {
+            *shared = createSharedMemory(*length);
+            data = *shared >= 0 ? mapSharedMemory(*shared, *length, 1) : NULL;
+        } else {
+            data = (uint8_t*)malloc(size ? (size_t)size : 1);
+        }
+    }
+    if (!data || (size && fread(data, 1, (size_t)size, file) != (size_t)size)) {
+        printf("Error: Cannot read %s\n", path);
+        if (shared && data) unmapSharedMemory(data, *length);
+        else free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+/**
+  * @brief  Sends request and receives reply, payload of reply is left for caller.
+  * @param  connection Connected socket
+  * @param  request Pointer to request header
+  * @param  payload Inline payload, NULL if it is held by shared memory
+  * @param  shared Shared memory with payload, -1 for inline payload
+  * @param  reply Pointer to header receiving reply
+  * @param  replyShared Pointer receiving shared memory with reply payload, -1 if it is inline
+  * @retval 0 if reply was received, 1 otherwise
+  */
+static uint8_t exchange(int connection, const daemonRequest* request, const uint8_t* payload, int shared,
+                        daemonReply* reply, int* replyShared)
+{
+    const uint8_t magic[4] = DAEMON_REPLY_MAGIC;
+    if (sendHeader(connection, request, sizeof(*request), shared) ||
+        (shared < 0 && sendAll(connection, payload, request->payloadLength)) ||
+        receiveHeader(connection, reply, sizeof(*reply), replyShared) || memcmp(reply->magic, magic, sizeof(magic))) {
+        printf("Error: Connection to daemon failed\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief  Reads payload of reply and writes it to file.
+  * @param  connection Connected socket
+  * @param  reply Pointer to reply header
+  * @param  replyShared Shared memory with payload, -1 if it is inline; closed here
+  * @param  outputPath Path to written file
+  * @retval 0 if file was written, 1 otherwise
+  */
+static uint8_t saveReply(int connection, const daemonReply* reply, int replyShared, const char* outputPath)
+{
+    uint8_t* data = NULL;
+    if (reply->flags & DAEMON_SHARED_MEMORY) {
+        data = replyShared >= 0 ? mapSharedMemory(replyShared, reply->payloadLength, 0) : NULL;
+    } else if ((data = (uint8_t*)malloc(reply->payloadLength ? (size_t)reply->payloadLength : 1)) &&
+               receiveAll(connection, data, reply->payloadLength)) {
+        free(data);
+        data = NULL;
+    }
+    if (replyShared >= 0) close(replyShared);
+    if (!data) {
+        printf("Error: Cannot read reply of daemon\n");
+        return 1;
+    }
+    FILE* file = fopen(outputPath, "wb");
+    uint8_t status = !file || fwrite(data, 1, (size_t)reply->payloadLength, file) != reply->payloadLength;
+    if (file && fclose(file)) status = 1;
+    if (status) printf("Error: Cannot write %s\n", outputPath);
+    if (reply->flags & DAEMON_SHARED_MEMORY) unmapSharedMemory(data, reply->payloadLength);
+    else free(data);
+    return status;
+}
+
+/**
+  * @brief  Sends file to daemon given number of times and writes last reply to file.
+  * @param  connection Connected socket
+  * @param  request Pointer to request header with operation, mode and flags set
+  * @param  inputPath Path to image or compressed file
+  * @param  outputPath Path to written file
+  * @param  repeat Number of requests
+  * @retval 0 if every request succeeded, 1 otherwise
+  */
+static uint8_t runRequests(int connection, daemonRequest* request, const char* inputPath, const char* outputPath,
+                           uint32_t repeat)
+{
+    uint8_t sharedMemory = request->flags & DAEMON_SHARED_MEMORY;
+    int shared = -1;
+    uint64_t length;
+    uint8_t* payload = loadFile(inputPath, &length, sharedMemory ? &shared : NULL);
+    if (!payload) {
+        if (shared >= 0) close(shared);
+        return 1;
+    }
+    request->payloadLength = length;
+
+    uint8_t status = 0;
+    double start = currentSeconds();
+    for (uint32_t i = 0; i < repeat && !status; i++) {
+        daemonReply reply;
+        int replyShared;
+        if (exchange(connection, request, payload, shared, &reply, &replyShared)) {
+            status = 1;
+            break;
+        }
+        if (reply.status) {
+            printf("Error: Daemon could not %s %s\n", request->operation == DAEMON_ENCODE ? "compress" : "decompress",
+                   inputPath);
+            if (replyShared >= 0) close(replyShared);
+            status = 1;
+        } else if (i + 1 == repeat) {
+            status = saveReply(connection, &reply, replyShared, outputPath);
+        } else if (reply.flags & DAEMON_SHARED_MEMORY) {
+            if (replyShared >= 0) close(replyShared);
+        } else {
+            // Inline payload of repeated request is drained without saving
+            uint8_t drain[65536];
+            for (uint64_t left = reply.payloadLength; left && !status;) {
+                uint64_t part = left < sizeof(drain) ? left : sizeof(drain);
+                status = receiveAll(connection, drain, part);
+                left -= part;
+            }
+        }
+    }
+    double seconds = currentSeconds() - start;
+    if (!status && repeat > 1)
+        printf("Requests: %u, average time: %.1f us\n", repeat, seconds / repeat * 1e6);
+
+    if (sharedMemory) {
+        unmapSharedMemory(payload, length);
+        close(shared);
+    } else {
+        free(payload);
+    }
+    return status;
+}
+
+int main(int argc, char** argv)
+{
+    daemonRequest request = { .magic = DAEMON_REQUEST_MAGIC, .flags = 0, .tileSide = 0, .payloadLength = 0 };
+    uint32_t repeat = 1;
+    parseEncoderMode("auto", &request.mode);
+    int argument = 1;
+    while (argc - argument > 1 && !strncmp(argv[argument], "--", 2)) {
+        if (!strcmp(argv[argument], "--shared")) {
+            request.flags |= DAEMON_SHARED_MEMORY;
+            argument++;
+            continue;
+        }
+        if (!strcmp(argv[argument], "--mode")) {
+            if (parseEncoderMode(argv[argument + 1], &request.mode)) {
+                printf("Error: Unknown mode \"%s\"\n", argv[argument + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--tile")) {
+            unsigned long side = strtoul(argv[argument + 1], NULL, 10);
+            if (side < 1 || side > UINT16_MAX) {
+                printf("Error: Tile side must be between 1 and %u\n", UINT16_MAX);
+                return 1;
+            }
+            request.tileSide = (uint16_t)side;
+        } else if (!strcmp(argv[argument], "--repeat")) {
+            unsigned long count = strtoul(argv[argument + 1], NULL, 10);
+            if (count < 1 || count > UINT32_MAX) {
+                printf("Error: Number of requests must be at least 1\n");
+                return 1;
+            }
+            repeat = (uint32_t)count;
+        } else {
+            break;
+        }
+        argument += 2;
+    }
+
+    uint8_t shutdownDaemon = argc - argument == 2 && !strcmp(argv[argument + 1], "shutdown");
+    uint8_t transfer = argc - argument == 4 && (!strcmp(argv[argument + 1], "encode") || !strcmp(argv[argument + 1], "decode"));
+    if (!shutdownDaemon && !transfer) {
+        printf("Usage: %s [--shared] [--repeat n] [--mode auto|adaptive|pair|bitplane|static|periodic|range|stored|runlength|tiled]\n", argv[0]);
+        printf("       %*s [--tile side] socket-path encode|decode input output\n", (int)strlen(argv[0]), "");
+        printf("       %s socket-path shutdown\n", argv[0]);
+        return 1;
+    }
+    if (request.flags & DAEMON_SHARED_MEMORY) {
+        int probe = createSharedMemory(0);
+        if (probe < 0) {
+            printf("Error: Shared memory is not supported on this platform\n");
+            return 1;
+        }
+        close(probe);
+    }
+
+    int connection = connectDaemon(argv[argument]);
+    if (connection < 0) return 1;
+    uint8_t status;
+    if (shutdownDaemon) {
+        daemonReply reply;
+        int replyShared;
+        request.operation = DAEMON_SHUTDOWN;
+        request.flags = 0;
+        status = exchange(connection, &request, NULL, -1, &reply, &replyShared) || reply.status;
+    } else {
+        request.operation = !strcmp(argv[argument + 1], "encode") ? DAEMON_ENCODE : DAEMON_DECODE;
+        status = runRequests(connection, &request, argv[argument + 2], argv[argument + 3], repeat);
+    }
+    close(connection);
+    return status;
+}
@@ -0,0 +1,81 @@
+#ifndef CODEC_CONTEXT_H
+#define CODEC_CONTEXT_H
+
+// Contexts wrap coder and decoder libraries in separate translation units, because coder and
+// decoder2c headers declare types with the same names
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct encoderContext encoderContext;
+typedef struct decoderContext decoderContext;
+
+/**
+  * @brief  Creates encoder context, whose coder is reused by every image it compresses.
+  * @param  None
+  * @retval Pointer to context, NULL if memory allocation fails
+  */
+encoderContext* createEncoderContext(void);
+
+/**
+  * @brief  Compresses PGM or PPM file held in memory without printing anything on success.
+  *         Rows of image are read in place and released before return.
+  * @param  my Pointer to encoder context
+  * @param  image Contents of image file
+  * @param  length Length of image file
+  * @param  mode Coding mode, MODE_AUTO of coder to choose it from image
+  * @param  tileSide Side of tiles used in tiled mode, 0 for coder default
+  * @param  compressed Compressed file, closed by encoder whether compression succeeds or not
+  * @param  compressedLength Pointer receiving length of compressed file
+  * @retval 0 if image was compressed, 1 otherwise
+  */
+uint8_t encodeImage(encoderContext* my, uint8_t* image, uint64_t length, uint8_t mode, uint16_t tileSide,
+                    FILE* compressed, uint64_t* compressedLength);
+
+/**
+  * @brief  Frees encoder context.
+  * @param  my Pointer to pointer to context, set to NULL
+  * @retval None
+  */
+void freeEncoderContext(encoderContext** my);
+
+/**
+  * @brief  Parses name of coding mode accepted by coder.
+  * @param  name Name of mode, e.g. "auto" or "adaptive"
+  * @param  mode Pointer receiving mode
+  * @retval 0 if name is known, 1 otherwise
+  */
+uint8_t parseEncoderMode(const char* name, uint8_t* mode);
+
+/**
+  * @brief  Creates decoder context, whose tree and buffers are reused by every file it decodes.
+  * @param  None
+  * @retval Pointer to context, NULL if memory allocation fails
+  */
+decoderContext* createDecoderContext(void);
+
+/**
+  * @brief  Loads compressed file and reads its header; finishDecoding() decodes it.
+  * @param  my Pointer to decoder context
+  * @param  data Compressed file, copied into context
+  * @param  length Length of compressed file
+  * @param  imageLength Pointer receiving length of decompressed PGM or PPM file
+  * @retval 0 if header is valid, 1 otherwise
+  */
+uint8_t startDecoding(decoderContext* my, const uint8_t* data, uint64_t length, uint64_t* imageLength);
+
+/**
+  * @brief  Decodes file loaded by startDecoding() straight into PGM or PPM file in memory.
+  * @param  my Pointer to decoder context
+  * @param  image Buffer of length given by startDecoding(), receiving image file
+  * @retval 0 if file was decoded, 1 otherwise
+  */
+uint8_t finishDecoding(decoderContext* my, uint8_t* image);
+
+/**
+  * @brief  Frees decoder context.
+  * @param  my Pointer to pointer to context, set to NULL
+  * @retval None
+  */
+void freeDecoderContext(decoderContext** my);
+
+#endif // CODEC_CONTEXT_H
@@ -0,0 +1,379 @@
+// Compression daemon: worker threads serve encode and decode requests sent over Unix socket,
+// each with encoder and decoder context kept warm between requests
+#define _GNU_SOURCE
+#include "daemonProtocol.h"
+#include "codecContext.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define DAEMON_MAX_THREADS 256
+#define DAEMON_BACKLOG 64
+
+/**
+ * @brief:  Worker thread with its own codec contexts and buffer of inline payloads.
+ * @thread: Thread serving connections.
+ * @encoder: Encoder context reused by every encode request.
+ * @decoder: Decoder context reused by every decode request.
+ * @payload: Buffer receiving inline request payload.
+ * @payloadCapacity: Size of payload buffer.
+ * @reply: Buffer of inline decode reply.
+ * @replyCapacity: Size of reply buffer.
+ * @connection: Socket of served connection, -1 while waiting for one.
+ */
+typedef struct worker {
+    pthread_t thread;
+    encoderContext* encoder;
+    decoderContext* decoder;
+    uint8_t* payload;
+    uint64_t payloadCapacity;
+    uint8_t* reply;
+    uint64_t replyCapacity;
+    int connection;
+} worker;
+
+/**
+ * @brief:  State shared by workers.
+ * @listening: Listening socket, accepted by every worker.
+ * @mainThread: Thread waiting for shutdown signal.
+ * @lock: Guards connection of every worker and stopping flag.
+ * @stopping: 1 once shutdown started.
+ */
+typedef struct daemonState {
+    int listening;
+    pthread_t mainThread;
+    pthread_mutex_t lock;
+    uint8_t stopping;
+} daemonState;
+
+static daemonState state = { .listening = -1, .lock = PTHREAD_MUTEX_INITIALIZER, .stopping = 0 };
+
+/**
+  * @brief  Makes sure buffer holds given number of bytes, contents are not kept.
+  * @param  buffer Pointer to buffer
+  * @param  capacity Pointer to size of buffer
+  * @param  length Required size
+  * @retval 0 on success, 1 if memory allocation fails
+  */
+static uint8_t reserveBuffer(uint8_t** buffer, uint64_t* capacity, uint64_t length)
+{
+    if (length <= *capacity) return 0;
+    free(*buffer);
+    *buffer = (uint8_t*)malloc(length ? (size_t)length : 1);
+    *capacity = *buffer ? length : 0;
+    if (!*buffer) {
+        printf("Error: Cannot allocate %llu bytes for request\n", (unsigned long long)length);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief  Sends reply header and inline payload, or shared memory holding payload.
+  * @param  connection Connected socket
+  * @param  status 0 if request succeeded, 1 otherwise
+  * @param  payload Inline payload, NULL if it is held by shared memory
+  * @param  length Length of payload
+  * @param  shared Shared memory with payload, -1 for inline payload; closed here
+  * @retval 0 if reply was sent, 1 otherwise
+  */
+static uint8_t sendReply(int connection, uint8_t status, const uint8_t* payload, uint64_t length, int shared)
+{
+    daemonReply reply = { .magic = DAEMON_REPLY_MAGIC, .status = status, .flags = 0, .reserved = 0, .payloadLength = 0 };
+    if (!status) {
+        reply.payloadLength = length;
+        reply.flags = shared >= 0 ? DAEMON_SHARED_MEMORY : 0;
+    }
+    uint8_t failed = sendHeader(connection, &reply, sizeof(reply), status ? -1 : shared) ||
+                     (!status && shared < 0 && sendAll(connection, payload, length));
+    if (shared >= 0) close(shared);
+    return failed;
+}
+
+/**
+  * @brief  Compresses image and replies with compressed file, inline or in shared memory.
+  * @param  my Pointer to worker
+  * @param  request Pointer to request header
+  * @param  image Image file
+  * @retval 0 if reply was sent, 1 if connection failed
+  */
+static uint8_t serveEncode(worker* my, const daemonRequest* request, uint8_t* image)
+{
+    uint64_t compressedLength = 0;
+    uint8_t status;
+    if (request->flags & DAEMON_SHARED_MEMORY) {
+        // Coder writes compressed file straight into shared memory file passed to client
+        int shared = createSharedMemory(0);
+        int duplicate = shared >= 0 ? dup(shared) : -1;
+        FILE* compressed = duplicate >= 0 ? fdopen(duplicate, "wb") : NULL;
+        if (!compressed) {
+            if (duplicate >= 0) close(duplicate);
+            printf("Error: Cannot create shared memory for reply\n");
+            return sendReply(my->connection, 1, NULL, 0, shared);
+        }
+        status = encodeImage(my->encoder, image, request->payloadLength, request->mode, request->tileSide, compressed,
+                             &compressedLength);
+        return sendReply(my->connection, status, NULL, compressedLength, shared);
+    }
+    char* compressedData = NULL;
+    size_t compressedSize = 0;
+    FILE* compressed = open_memstream(&compressedData, &compressedSize);
+    status = !compressed || encodeImage(my->encoder, image, request->payloadLength, request->mode, request->tileSide,
+                                        compressed, &compressedLength);
+    uint8_t failed = sendReply(my->connection, status, (const uint8_t*)compressedData, compressedLength, -1);
+    free(compressedData);
+    return failed;
+}
+
+/**
+  * @brief  Decompresses file and replies with PGM or PPM file, inline or in shared memory.
+  * @param  my Pointer to worker
+  * @param  request Pointer to request header
+  * @param  data Compressed file
+  * @retval 0 if reply was sent, 1 if connection failed
+  */
+static uint8_t serveDecode(worker* my, const daemonRequest* request, const uint8_t* data)
+{
+    uint64_t imageLength;
+    if (startDecoding(my->decoder, data, request->payloadLength, &imageLength))
+        return sendReply(my->connection, 1, NULL, 0, -1);
+    if (request->flags & DAEMON_SHARED_MEMORY) {
+        // Decoder writes pixels straight into shared memory file passed to client
+        int shared = createSharedMemory(imageLength);
+        uint8_t* image = shared >= 0 ? mapSharedMemory(shared, imageLength, 1) : NULL;
+        uint8_t status = !image || finishDecoding(my->decoder, image);
+        unmapSharedMemory(image, imageLength);
+        return sendReply(my->connection, status, NULL, imageLength, shared);
+    }
+    uint8_t status = reserveBuffer(&my->reply, &my->replyCapacity, imageLength) || finishDecoding(my->decoder, my->reply);
+    return sendReply(my->connection, status, my->reply, imageLength, -1);
+}
+
+/**
+  * @brief  Serves requests of connection until client closes it or breaks protocol.
+  * @param  my Pointer to worker with connection set
+  * @retval None
+  */
+static void serveConnection(worker* my)
+{
+    const uint8_t magic[4] = DAEMON_REQUEST_MAGIC;
+    daemonRequest request;
+    int shared;
+    while (!receiveHeader(my->connection, &request, sizeof(request), &shared)) {
+        if (memcmp(request.magic, magic, sizeof(magic)) || ((request.flags & DAEMON_SHARED_MEMORY) && shared < 0)) {
+            printf("Error: Invalid request, connection closed\n");
+            if (shared >= 0) close(shared);
+            return;
+        }
+        if (request.operation == DAEMON_SHUTDOWN) {
+            if (shared >= 0) close(shared);
+            sendReply(my->connection, 0, NULL, 0, -1);
+            pthread_kill(state.mainThread, SIGTERM);
+            return;
+        }
+
+        // Shared payload is read in place, inline payload is received into buffer of worker
+        uint8_t* payload;
+        if (request.flags & DAEMON_SHARED_MEMORY) {
+            payload = mapSharedMemory(shared, request.payloadLength, 0);
+            close(shared);
+            if (!payload) {
+                printf("Error: Cannot map shared memory of request\n");
+                if (sendReply(my->connection, 1, NULL, 0, -1)) return;
+                continue;
+            }
+        } else {
+            if (shared >= 0) close(shared);
+            if (request.payloadLength > DAEMON_MAX_INLINE_PAYLOAD ||
+                reserveBuffer(&my->payload, &my->payloadCapacity, request.payloadLength) ||
+                receiveAll(my->connection, my->payload, request.payloadLength))
+                return;
+            payload = my->payload;
+        }
+
+        uint8_t failed;
+        if (request.operation == DAEMON_ENCODE) {
+            failed = serveEncode(my, &request, payload);
+        } else if (request.operation == DAEMON_DECODE) {
+            failed = serveDecode(my, &request, payload);
+        } else {
+            printf("Error: Unknown operation %u\n", request.operation);
+            failed = sendReply(my->connection, 1, NULL, 0, -1);
+        }
+        if (request.flags & DAEMON_SHARED_MEMORY) unmapSharedMemory(payload, request.payloadLength);
+        if (failed) return;
+    }
+}
+
+/**
+  * @brief  Accepts connections on listening socket and serves them one after another.
+  * @param  argument Pointer to worker
+  * @retval NULL
+  */
+static void* runWorker(void* argument)
+{
+    worker* my = (worker*)argument;
+    while (1) {
+        int connection = accept(state.listening, NULL, NULL);
+        pthread_mutex_lock(&state.lock);
+        if (state.stopping) {
+            pthread_mutex_unlock(&state.lock);
+            if (connection >= 0) close(connection);
+            return NULL;
+        }
+        my->connection = connection;
+        pthread_mutex_unlock(&state.lock);
+        if (connection < 0) {
+            if (errno != EINTR && errno != ECONNABORTED) usleep(1000);
+            continue;
+        }
+        serveConnection(my);
+        pthread_mutex_lock(&state.lock);
+        my->connection = -1;
+        pthread_mutex_unlock(&state.lock);
+        close(connection);
+    }
+}
+
+/**
+  * @brief  Creates listening socket at path, replacing stale socket left by daemon that died.
+  * @param  path Path of socket
+  * @retval Listening socket, -1 on error
+  */
+static int openListeningSocket(const char* path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("Error: Socket path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    int listening = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listening < 0) {
+        printf("Error: Cannot create socket\n");
+        return -1;
+    }
+    int bound = bind(listening, (struct sockaddr*)&address, sizeof(address));
+    if (bound && errno == EADDRINUSE) {
+        // Socket file nobody listens on is left by daemon that did not stop cleanly
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        uint8_t alive = probe >= 0 && !connect(probe, (struct sockaddr*)&address, sizeof(address));
+        if (probe >= 0) close(probe);
+        if (alive) {
+            printf("Error: Daemon is already listening on %s\n", path);
+            close(listening);
+            return -1;
+        }
+        unlink(path);
+        bound = bind(listening, (struct sockaddr*)&address, sizeof(address));
+    }
+    if (bound || chmod(path, S_IRUSR | S_IWUSR) || listen(listening, DAEMON_BACKLOG)) {
+        printf("Error: Cannot listen on %s\n", path);
+        close(listening);
+        return -1;
+    }
+    return listening;
+}
+
+/**
+  * @brief  Runs daemon until shutdown request or SIGINT or SIGTERM.
+  * @param  path Path of socket
+  * @param  numberOfThreads Number of workers
+  * @retval 0 if daemon stopped cleanly, 1 otherwise
+  */
+static uint8_t runDaemon(const char* path, uint32_t numberOfThreads)
+{
+    uint32_t started = 0;
+    worker* workers = (worker*)calloc(numberOfThreads, sizeof(worker));
+    if (!workers) {
+        printf("Error: Cannot allocate workers\n");
+        return 1;
+    }
+    // Contexts are created before first request, so it does not pay for them
+    for (uint32_t i = 0; i < numberOfThreads; i++) {
+        workers[i].connection = -1;
+        workers[i].encoder = createEncoderContext();
+        workers[i].decoder = createDecoderContext();
+        if (!workers[i].encoder || !workers[i].decoder) {
+            printf("Error: Cannot allocate codec contexts\n");
+            numberOfThreads = i + 1;
+            goto release;
+        }
+    }
+
+    // Signals are taken only by main thread, which waits for them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    // Standard output closed by its reader must not stop daemon, sockets are written with MSG_NOSIGNAL
+    signal(SIGPIPE, SIG_IGN);
+    state.mainThread = pthread_self();
+    state.listening = openListeningSocket(path);
+    if (state.listening < 0) goto release;
+
+    for (; started < numberOfThreads; started++)
+        if (pthread_create(&workers[started].thread, NULL, runWorker, &workers[started])) break;
+    if (started) {
+        printf("Listening on %s with %u threads\n", path, started);
+        fflush(stdout);
+        int received;
+        sigwait(&signals, &received);
+    } else {
+        printf("Error: Cannot start worker threads\n");
+    }
+
+    // Waiting workers are woken by shut down listening socket, serving ones by shut down connection
+    pthread_mutex_lock(&state.lock);
+    state.stopping = 1;
+    shutdown(state.listening, SHUT_RDWR);
+    for (uint32_t i = 0; i < started; i++)
+        if (workers[i].connection >= 0) shutdown(workers[i].connection, SHUT_RDWR);
+    pthread_mutex_unlock(&state.lock);
+    for (uint32_t i = 0; i < started; i++)
+        pthread_join(workers[i].thread, NULL);
+    close(state.listening);
+    unlink(path);
+    printf("Daemon stopped\n");
+
+release:
+    for (uint32_t i = 0; i < numberOfThreads; i++) {
+        freeEncoderContext(&workers[i].encoder);
+        freeDecoderContext(&workers[i].decoder);
+        free(workers[i].payload);
+        free(workers[i].reply);
+    }
+    free(workers);
+    return state.listening < 0 || !started;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numberOfThreads = DAEMON_DEFAULT_THREADS;
+    int argument = 1;
+    while (argc - argument > 1 && !strncmp(argv[argument], "--", 2)) {
+        if (!strcmp(argv[argument], "--threads")) {
+            unsigned long threads = strtoul(argv[argument + 1], NULL, 10);
+            if (threads < 1 || threads > DAEMON_MAX_THREADS) {
+                printf("Error: Number of threads must be between 1 and %u\n", DAEMON_MAX_THREADS);
+                return 1;
+            }
+            numberOfThreads = (uint32_t)threads;
+        } else {
+            break;
+        }
+        argument += 2;
+    }
+    if (argc - argument != 1) {
+        printf("Usage: %s [--threads n] socket-path\n", argv[0]);
+        return 1;
+    }
+    return runDaemon(argv[argument], numberOfThreads);
+}
@@ -0,0 +1,126 @@
+// Unix sockets, descriptor passing and shared memory files are POSIX, memfd_create() is Linux
+#define _GNU_SOURCE
+#include "daemonProtocol.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+uint8_t sendHeader(int socket, const void* header, size_t headerLength, int descriptor)
+{
+    struct iovec vector = { .iov_base = (void*)header, .iov_len = headerLength };
+    struct msghdr message = { .msg_iov = &vector, .msg_iovlen = 1 };
+    union {
+        struct cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+
+    if (descriptor >= 0) {
+        memset(&control, 0, sizeof(control));
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+        struct cmsghdr* attached = CMSG_FIRSTHDR(&message);
+        attached->cmsg_level = SOL_SOCKET;
+        attached->cmsg_type = SCM_RIGHTS;
+        attached->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(attached), &descriptor, sizeof(int));
+    }
+    ssize_t sent;
+    do {
+        sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    // Header is small, so it is sent at once or connection failed; descriptor goes with first byte
+    if (sent < 0) return 1;
+    return sent < (ssize_t)headerLength && sendAll(socket, (const uint8_t*)header + sent, headerLength - (size_t)sent);
+}
+
+uint8_t receiveHeader(int socket, void* header, size_t headerLength, int* descriptor)
+{
+    struct iovec vector = { .iov_base = header, .iov_len = headerLength };
+    struct msghdr message = { .msg_iov = &vector, .msg_iovlen = 1 };
+    union {
+        struct cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    *descriptor = -1;
+    ssize_t received;
+    do {
+        received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) return 1;
+    for (struct cmsghdr* attached = CMSG_FIRSTHDR(&message); attached; attached = CMSG_NXTHDR(&message, attached))
+        if (attached->cmsg_level == SOL_SOCKET && attached->cmsg_type == SCM_RIGHTS)
+            memcpy(descriptor, CMSG_DATA(attached), sizeof(int));
+    if (received < (ssize_t)headerLength &&
+        receiveAll(socket, (uint8_t*)header + received, headerLength - (size_t)received)) {
+        if (*descriptor >= 0) close(*descriptor);
+        *descriptor = -1;
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t sendAll(int socket, const uint8_t* data, uint64_t length)
+{
+    while (length) {
+        ssize_t sent = send(socket, data, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return 1;
+        data += sent;
+        length -= (uint64_t)sent;
+    }
+    return 0;
+}
+
+uint8_t receiveAll(int socket, uint8_t* data, uint64_t length)
+{
+    while (length) {
+        ssize_t received = recv(socket, data, length, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return 1;
+        data += received;
+        length -= (uint64_t)received;
+    }
+    return 0;
+}
+
+int createSharedMemory(uint64_t length)
+{
+#ifdef __linux__
+    int descriptor = memfd_create("koda", MFD_CLOEXEC);
+    if (descriptor < 0) return -1;
+    if (ftruncate(descriptor, (off_t)length)) {
+        close(descriptor);
+        return -1;
+    }
+    return descriptor;
+#else
+    (void)length;
+    return -1;
+#endif
+}
+
+uint8_t* mapSharedMemory(int descriptor, uint64_t length, uint8_t writable)
+{
+    // Empty payload needs no mapping, any non-NULL pointer describes it
+    static uint8_t empty;
+    if (!length) return &empty;
+    // Pages past end of file would raise SIGBUS when touched
+    struct stat status;
+    if (fstat(descriptor, &status) || (uint64_t)status.st_size < length) return NULL;
+    void* mapping = mmap(NULL, (size_t)length, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, descriptor, 0);
+    return mapping == MAP_FAILED ? NULL : (uint8_t*)mapping;
+}
+
+void unmapSharedMemory(uint8_t* mapping, uint64_t length)
+{
+    if (mapping && length)
+        munmap(mapping, (size_t)length);
+}
@@ -0,0 +1,121 @@
+#ifndef DAEMON_PROTOCOL_H
+#define DAEMON_PROTOCOL_H
+
+// Requests and replies of compression daemon travel over Unix stream socket of one machine,
+// so their headers are sent in native byte order. Every message is header followed by payload
+// of payloadLength bytes, unless DAEMON_SHARED_MEMORY is set: then payload is not sent over
+// socket but held by memory file descriptor passed with header.
+#define DAEMON_REQUEST_MAGIC { 'K', 'D', 'R', 'Q' }
+#define DAEMON_REPLY_MAGIC { 'K', 'D', 'R', 'S' }
+#define DAEMON_ENCODE 1
+#define DAEMON_DECODE 2
+#define DAEMON_SHUTDOWN 3
+#define DAEMON_SHARED_MEMORY 0x01
+#define DAEMON_DEFAULT_THREADS 4
+// Largest payload accepted over socket, larger images are passed in shared memory
+#define DAEMON_MAX_INLINE_PAYLOAD (1ull << 30)
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief:  Header of request sent by client.
+ * @magic: DAEMON_REQUEST_MAGIC.
+ * @operation: DAEMON_ENCODE, DAEMON_DECODE or DAEMON_SHUTDOWN.
+ * @mode: Coding mode of encoded image, MODE_AUTO of coder to choose it from image.
+ * @flags: DAEMON_SHARED_MEMORY if payload is passed in shared memory, reply is then passed
+ *         the same way.
+ * @tileSide: Side of tiles used in tiled mode, 0 for coder default.
+ * @payloadLength: Length of PGM or PPM file to encode or of compressed file to decode.
+ */
+typedef struct daemonRequest {
+    uint8_t magic[4];
+    uint8_t operation;
+    uint8_t mode;
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t tileSide;
+    uint16_t reserved2;
+    uint32_t reserved3;
+    uint64_t payloadLength;
+} daemonRequest;
+
+/**
+ * @brief:  Header of reply sent by daemon.
+ * @magic: DAEMON_REPLY_MAGIC.
+ * @status: 0 if request succeeded, 1 otherwise; failed request has no payload.
+ * @flags: DAEMON_SHARED_MEMORY if payload is passed in shared memory.
+ * @payloadLength: Length of compressed file or of decompressed PGM or PPM file.
+ */
+typedef struct daemonReply {
+    uint8_t magic[4];
+    uint8_t status;
+    uint8_t flags;
+    uint16_t reserved;
+    uint64_t payloadLength;
+} daemonReply;
+
+/**
+  * @brief  Sends message header, with file descriptor attached if one is given.
+  * @param  socket Connected socket
+  * @param  header Header of message
+  * @param  headerLength Length of header
+  * @param  descriptor File descriptor passed to receiver, -1 for none
+  * @retval 0 if header was sent, 1 otherwise
+  */
+uint8_t sendHeader(int socket, const void* header, size_t headerLength, int descriptor);
+
+/**
+  * @brief  Receives message header and file descriptor attached to it.
+  * @param  socket Connected socket
+  * @param  header Buffer receiving header
+  * @param  headerLength Length of header
+  * @param  descriptor Pointer receiving passed file descriptor, -1 if none was passed
+  * @retval 0 if header was received, 1 if connection was closed or failed
+  */
+uint8_t receiveHeader(int socket, void* header, size_t headerLength, int* descriptor);
+
+/**
+  * @brief  Sends whole buffer, retrying partial and interrupted writes.
+  * @param  socket Connected socket
+  * @param  data Sent data
+  * @param  length Length of data
+  * @retval 0 if all data was sent, 1 otherwise
+  */
+uint8_t sendAll(int socket, const uint8_t* data, uint64_t length);
+
+/**
+  * @brief  Receives exactly given number of bytes, retrying partial and interrupted reads.
+  * @param  socket Connected socket
+  * @param  data Buffer receiving data
+  * @param  length Number of bytes to receive
+  * @retval 0 if all data was received, 1 otherwise
+  */
+uint8_t receiveAll(int socket, uint8_t* data, uint64_t length);
+
+/**
+  * @brief  Creates anonymous shared memory file of given length.
+  * @param  length Length of file
+  * @retval File descriptor, -1 if shared memory is not available or creation fails
+  */
+int createSharedMemory(uint64_t length);
+
+/**
+  * @brief  Maps shared memory file received from other process.
+  * @param  descriptor File descriptor of shared memory
+  * @param  length Number of bytes to map, file must be at least that long
+  * @param  writable 1 to map for writing seen by other process, 0 for private copy-on-write
+  *         view, whose changes stay in this process
+  * @retval Pointer to mapping, NULL on error
+  */
+uint8_t* mapSharedMemory(int descriptor, uint64_t length, uint8_t writable);
+
+/**
+  * @brief  Unmaps memory mapped with mapSharedMemory().
+  * @param  mapping Pointer to mapping, NULL is ignored
+  * @param  length Length of mapping
+  * @retval None
+  */
+void unmapSharedMemory(uint8_t* mapping, uint64_t length);
+
+#endif // DAEMON_PROTOCOL_H
@@ -0,0 +1,55 @@
+#include "codecContext.h"
+#include "decoderOperations.h"
+#include "outputSink.h"
+
+/**
+ * @brief:  Decoder of daemon worker.
+ * @decoder: Tree restarted for every file, created with first one.
+ * @headerText: PGM or PPM header of decompressed image.
+ * @headerLength: Length of header text.
+ * @pixelsLength: Length of decompressed samples.
+ */
+struct decoderContext {
+    tree* decoder;
+    char headerText[IMAGE_HEADER_MAX_LENGTH];
+    uint32_t headerLength;
+    uint64_t pixelsLength;
+};
+
+decoderContext* createDecoderContext(void)
+{
+    decoderContext* my = (decoderContext*)calloc(1, sizeof(decoderContext));
+    return my;
+}
+
+uint8_t startDecoding(decoderContext* my, const uint8_t* data, uint64_t length, uint64_t* imageLength)
+{
+    *imageLength = 0;
+    if (my->decoder ? restartTree(my->decoder, data, length) : !(my->decoder = createTreeFromMemory(data, length)))
+        return 1;
+    const imageHeader* header = &my->decoder->header;
+    // Daemon loads no dictionaries
+    if (header->dictionaryId) {
+        printf("Error: Files compressed with dictionary are not supported\n");
+        return 1;
+    }
+    my->headerLength = formatImageHeader(my->headerText, sizeof(my->headerText), header);
+    my->pixelsLength = (uint64_t)header->width * header->height * header->channels * header->bytesPerSample;
+    *imageLength = my->headerLength + my->pixelsLength;
+    return 0;
+}
+
+uint8_t finishDecoding(decoderContext* my, uint8_t* image)
+{
+    memcpy(image, my->headerText, my->headerLength);
+    return useCallerBuffer(my->decoder->output, image + my->headerLength, my->pixelsLength) ||
+           decodeData(my->decoder);
+}
+
+void freeDecoderContext(decoderContext** my)
+{
+    if (!*my) return;
+    if ((*my)->decoder) freeTree(&(*my)->decoder);
+    free(*my);
+    *my = NULL;
+}
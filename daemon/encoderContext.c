@@ -0,0 +1,52 @@
+#include "codecContext.h"
+#include "fileOperations.h"
+
+/**
+ * @brief:  Encoder of daemon worker.
+ * @coder: Handler reset between images, so its tree and cache stay allocated.
+ */
+struct encoderContext {
+    handler* coder;
+};
+
+encoderContext* createEncoderContext(void)
+{
+    encoderContext* my = (encoderContext*)malloc(sizeof(encoderContext));
+    if (!my) return NULL;
+    my->coder = createHandler();
+    if (!my->coder) {
+        free(my);
+        return NULL;
+    }
+    my->coder->quiet = 1;
+    return my;
+}
+
+uint8_t encodeImage(encoderContext* my, uint8_t* image, uint64_t length, uint8_t mode, uint16_t tileSide,
+                    FILE* compressed, uint64_t* compressedLength)
+{
+    handler* coder = my->coder;
+    coder->mode = mode;
+    if (tileSide) coder->tileSide = tileSide;
+    coder->compressedFile = compressed;
+    uint8_t status = readDataFromMemory(&coder->records, image, length) || initialize(coder, NULL, NULL) ||
+                     compressData(coder);
+    *compressedLength = status ? 0 : coder->statistics.compressedBytes;
+    // Rows point into image of caller, they must not outlive this call
+    resetHandler(coder);
+    return status;
+}
+
+void freeEncoderContext(encoderContext** my)
+{
+    if (!*my) return;
+    freeAlocatedMemory((*my)->coder);
+    free((*my)->coder);
+    free(*my);
+    *my = NULL;
+}
+
+uint8_t parseEncoderMode(const char* name, uint8_t* mode)
+{
+    return parseMode(name, mode);
+}
@@ -1,76 +1,138 @@
-from treeClasses import *
-from math import sqrt
-
-def load_data_from_file(fileName):
-    data = []
-    if fileName[-4:] != '.bin':
-        raise Exception("This is not a binary file.")
-    with open(fileName, mode='rb') as file:
-        fileContent = file.read()
-        for byte_value in fileContent:
-            byte_bin_value_str = bin(byte_value)[2:]
-            zeros = ''
-            if len(byte_bin_value_str) != 8:
-                for _ in range(8 - len(byte_bin_value_str)):
-                    zeros = zeros + '0'
-            byte_bin_value_str = zeros + byte_bin_value_str
-            for bit in byte_bin_value_str:
-                if bit == '0':
-                    data.append(False)
-                elif bit == '1':
-                    data.append(True)
-                else:
-                    raise TypeError("Error reading .bin file")
-    return data
-
-def bin_data_to_int(bin):
-    number = 0
-    power = len(bin) - 1
-    for bit_bool in bin:
-        if bit_bool:
-            bit = 1
-        else:
-            bit = 0
-        number = number + (bit * (2 ** power))
-        power = power - 1
-    return number
-
-def decode(data):
-    out = []
-    i = 0
-    symbol_tree = Tree()
-    p = ''
-    while i < len(data) and len(out) < 512 ** 2:
-        current_node = symbol_tree.nodes[-1]
-        while(type(current_node) is not ExternalNode and current_node is not None):
-            bit = data[i]
-            i += 1
-            if not bit:
-                current_node = current_node.link0
-            else:
-                current_node = current_node.link1
-        if (type(current_node) is RootNode and current_node.link0 is None and current_node.link1 is None) or (type(current_node) is ExternalNode and current_node.value is None) or current_node is None: # jeśli NYT
-            p = bin_data_to_int(data[i : i + e])
-            i += e
-        else:
-            p = current_node.value
-        symbol_tree.update_tree(p)
-        out.append(p)
-    return out
-            
-def write_to_pgm_file(data, fileName):
-    side_length = sqrt(len(data))
-    pgmHeader = 'P5' + '\n' + str(int(side_length)) + ' ' + str(int(side_length)) + '\n' + str(255) +  '\n'
-    fout=open((fileName + '.pgm'), 'wb')
-    file_header_byte = bytearray(pgmHeader,'utf-8')
-    fout.write(file_header_byte)
-    fout.write(bytearray(data))
-    fout.close()
-
-print('Please enter a valid path to file ending with .bin with data to decompress')
-fileNameIN = input()
-raw_data = load_data_from_file(fileNameIN)
-print('Please enter a valid file name (without extention) to write the decompressed data to')
-fileNameOUT = input()
-decoded_data = decode(raw_data)
-write_to_pgm_file(decoded_data, fileNameOUT)
+import array
+import os
+import sys
+from treeClasses import *
+
+# Moduł natywny koda (katalog python w drzewie projektu) dekoduje wszystkie tryby wielokrotnie
+# szybciej; KODA_PURE_PYTHON=1 wymusza dekoder w pythonie
+try:
+    import koda
+except ImportError:
+    koda = None
+if os.environ.get('KODA_PURE_PYTHON'):
+    koda = None
+
+HEADER_MAGIC = bytes([0x8B]) + b'KDA'
+HEADER_LENGTH = 20
+HEADER_V1_LENGTH = 16
+FORMAT_VERSION = 2
+LEGACY_IMAGE_SIDE = 512
+
+def read_header(fileContent):
+    # Pliki bez nagłówka to starsze strumienie obrazów 512x512
+    if fileContent[:4] != HEADER_MAGIC:
+        return (LEGACY_IMAGE_SIDE, LEGACY_IMAGE_SIDE, 255), fileContent
+    # Dekoder w pythonie obsługuje tylko jednokanałowe obrazy kodowane adaptacyjnie
+    header_length = HEADER_V1_LENGTH if len(fileContent) > 4 and fileContent[4] == 1 else HEADER_LENGTH
+    if len(fileContent) < header_length or fileContent[4] not in (1, FORMAT_VERSION) or fileContent[5] != 0:
+        raise Exception("Unsupported compressed file header.")
+    if header_length == HEADER_LENGTH and fileContent[16] != 1:
+        raise Exception("Only single channel images are supported.")
+    if header_length == HEADER_LENGTH and fileContent[17:19] != bytes(2):
+        raise Exception("Files compressed with dictionary are not supported.")
+    if header_length == HEADER_LENGTH and fileContent[19] != 0:
+        raise Exception("Only row scan order is supported.")
+    max_grey_level = int.from_bytes(fileContent[6:8], 'big')
+    width = int.from_bytes(fileContent[8:12], 'big')
+    height = int.from_bytes(fileContent[12:16], 'big')
+    return (width, height, max_grey_level), fileContent[header_length:]
+
+def load_data_from_file(fileName):
+    data = []
+    if fileName[-4:] != '.bin':
+        raise Exception("This is not a binary file.")
+    with open(fileName, mode='rb') as file:
+        header, fileContent = read_header(file.read())
+        for byte_value in fileContent:
+            byte_bin_value_str = bin(byte_value)[2:]
+            zeros = ''
+            if len(byte_bin_value_str) != 8:
+                for _ in range(8 - len(byte_bin_value_str)):
+                    zeros = zeros + '0'
+            byte_bin_value_str = zeros + byte_bin_value_str
+            for bit in byte_bin_value_str:
+                if bit == '0':
+                    data.append(False)
+                elif bit == '1':
+                    data.append(True)
+                else:
+                    raise TypeError("Error reading .bin file")
+    return header, data
+
+def bin_data_to_int(bin):
+    number = 0
+    power = len(bin) - 1
+    for bit_bool in bin:
+        if bit_bool:
+            bit = 1
+        else:
+            bit = 0
+        number = number + (bit * (2 ** power))
+        power = power - 1
+    return number
+
+def decode(data, number_of_pixels, literal_bits=e):
+    out = []
+    i = 0
+    symbol_tree = Tree()
+    p = ''
+    while i < len(data) and len(out) < number_of_pixels:
+        current_node = symbol_tree.nodes[-1]
+        while(type(current_node) is not ExternalNode and current_node is not None):
+            bit = data[i]
+            i += 1
+            if not bit:
+                current_node = current_node.link0
+            else:
+                current_node = current_node.link1
+        if (type(current_node) is RootNode and current_node.link0 is None and current_node.link1 is None) or (type(current_node) is ExternalNode and current_node.value is None) or current_node is None: # jeśli NYT
+            p = bin_data_to_int(data[i : i + literal_bits])
+            i += literal_bits
+        else:
+            p = current_node.value
+        symbol_tree.update_tree(p)
+        out.append(p)
+    return out
+            
+def write_to_pgm_file(data, header, fileName):
+    width, height, max_grey_level = header
+    pgmHeader = 'P5' + '\n' + str(width) + ' ' + str(height) + '\n' + str(max_grey_level) +  '\n'
+    fout=open((fileName + '.pgm'), 'wb')
+    file_header_byte = bytearray(pgmHeader,'utf-8')
+    fout.write(file_header_byte)
+    if max_grey_level > 255:
+        fout.write(b''.join(value.to_bytes(2, 'big') for value in data))
+    else:
+        fout.write(bytearray(data))
+    fout.close()
+
+def decode_native(fileName, fileNameOUT):
+    if fileName[-4:] != '.bin':
+        raise Exception("This is not a binary file.")
+    with open(fileName, mode='rb') as file:
+        content = file.read()
+    header = koda.info(content)
+    pixels = koda.decode(content)
+    # Próbki 16-bitowe zapisywane są w pliku PGM w kolejności big-endian
+    if pixels.format == 'H' and sys.byteorder == 'little':
+        samples = array.array('H')
+        samples.frombytes(pixels.cast('B'))
+        samples.byteswap()
+        pixels = samples
+    pgmHeader = ('P6' if header['channels'] == 3 else 'P5') + '\n' + str(header['width']) + ' ' + \
+        str(header['height']) + '\n' + str(header['max_grey_level']) + '\n'
+    with open(fileNameOUT + '.pgm', 'wb') as fout:
+        fout.write(bytearray(pgmHeader, 'utf-8'))
+        fout.write(pixels)
+
+print('Please enter a valid path to file ending with .bin with data to decompress')
+fileNameIN = input()
+if koda is not None:
+    print('Please enter a valid file name (without extention) to write the decompressed data to')
+    decode_native(fileNameIN, input())
+else:
+    header, raw_data = load_data_from_file(fileNameIN)
+    print('Please enter a valid file name (without extention) to write the decompressed data to')
+    fileNameOUT = input()
+    decoded_data = decode(raw_data, header[0] * header[1], 2 * e if header[2] > 255 else e)
+    write_to_pgm_file(decoded_data, header, fileNameOUT)
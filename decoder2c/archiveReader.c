@@ -0,0 +1,191 @@
+// open(), fstat(), mmap() and file locks are POSIX, archive is read into memory where they are missing
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_MAP_ARCHIVE
+#endif
+#include "archiveReader.h"
+#include "archiveHash.h"
+#ifdef KODA_MAP_ARCHIVE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+  * @brief  Reads value stored on 8 bytes in big-endian order.
+  * @param  source pointer to first byte of value
+  * @retval Read value
+  */
+static uint64_t loadLong(const uint8_t* source)
+{
+    return ((uint64_t)loadBigEndian(source, 4) << 32) | loadBigEndian(&source[4], 4);
+}
+
+/**
+  * @brief  Loads whole archive into memory: maps it where possible, reads it otherwise. Where
+  *         file locks are available archive is loaded under shared lock, so append in progress
+  *         is finished first and its trailer matches data; mapped bytes never change later.
+  * @param  this pointer to archive receiving data
+  * @param  path to archive
+  * @retval 0 if archive was loaded, 1 otherwise
+  */
+static uint8_t loadArchive(archive* this, const char* path)
+{
+#ifdef KODA_MAP_ARCHIVE
+    int descriptor = open(path, O_RDONLY);
+    struct stat fileStatus;
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_RDLCK;
+    lock.l_whence = SEEK_SET;
+    if (descriptor >= 0 && fcntl(descriptor, F_SETLKW, &lock)) {
+        printf("Nie udało się zablokować archiwum %s!\n", path);
+        close(descriptor);
+        return 1;
+    }
+    if (descriptor >= 0 && !fstat(descriptor, &fileStatus) && fileStatus.st_size > 0 && (uint64_t)fileStatus.st_size <= SIZE_MAX) {
+        void* mapping = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+        if (mapping != MAP_FAILED) {
+            // Closing descriptor releases lock
+            close(descriptor);
+            this->data = (const uint8_t*)mapping;
+            this->length = (uint64_t)fileStatus.st_size;
+            this->mapped = 1;
+            return 0;
+        }
+    }
+#endif
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Nie udało się otworzyć archiwum %s!\n", path);
+        return 1;
+    }
+    long length = fseek(file, 0, SEEK_END) ? -1 : ftell(file);
+    uint8_t* data = length > 0 ? (uint8_t*)malloc((size_t)length) : NULL;
+    uint8_t status = !data || fseek(file, 0, SEEK_SET) || fread(data, 1, (size_t)length, file) != (size_t)length;
+    fclose(file);
+#ifdef KODA_MAP_ARCHIVE
+    if (descriptor >= 0) close(descriptor);
+#endif
+    if (status) {
+        printf("Nie udało się wczytać archiwum %s!\n", path);
+        free(data);
+        return 1;
+    }
+    this->data = data;
+    this->length = (uint64_t)length;
+    return 0;
+}
+
+/**
+  * @brief  Finds directory named by trailer and checks its checksum.
+  * @param  this pointer to loaded archive
+  * @retval 0 if directory is valid, 1 otherwise
+  */
+static uint8_t readDirectory(archive* this)
+{
+    const uint8_t magic[] = ARCHIVE_MAGIC;
+    const uint8_t* trailer = this->length >= ARCHIVE_TRAILER_LENGTH ? &this->data[this->length - ARCHIVE_TRAILER_LENGTH] : NULL;
+    if (!trailer || memcmp(trailer, magic, sizeof(magic)) || trailer[4] != ARCHIVE_VERSION) {
+        printf("Plik nie jest archiwum albo ostatnie dopisywanie nie zostało ukończone!\n");
+        return 1;
+    }
+    uint64_t directoryOffset = loadLong(&trailer[8]);
+    this->numberOfEntries = loadBigEndian(&trailer[16], 4);
+    this->numberOfSlots = loadBigEndian(&trailer[20], 4);
+    uint64_t namesOffset = (uint64_t)this->numberOfSlots * ARCHIVE_SLOT_LENGTH + (uint64_t)this->numberOfEntries * ARCHIVE_ENTRY_LENGTH;
+    uint64_t directoryLength = this->length - ARCHIVE_TRAILER_LENGTH - directoryOffset;
+    if (directoryOffset > this->length - ARCHIVE_TRAILER_LENGTH || namesOffset > directoryLength || !this->numberOfSlots ||
+        this->numberOfSlots < 2 * (uint64_t)this->numberOfEntries || (this->numberOfSlots & (this->numberOfSlots - 1)) ||
+        archiveHash(&this->data[directoryOffset], directoryLength) != loadLong(&trailer[24])) {
+        printf("Katalog archiwum jest uszkodzony!\n");
+        return 1;
+    }
+    this->slots = &this->data[directoryOffset];
+    this->entries = &this->slots[(uint64_t)this->numberOfSlots * ARCHIVE_SLOT_LENGTH];
+    this->names = (const char*)&this->slots[namesOffset];
+    this->namesLength = directoryLength - namesOffset;
+    return 0;
+}
+
+archive* openArchive(const char* path)
+{
+    archive* this = (archive*)calloc(1, sizeof(archive));
+    if (!this) {
+        printf("Błąd podczas alokowania pamięci na archiwum!\n");
+        return NULL;
+    }
+    if (loadArchive(this, path) || readDirectory(this))
+        closeArchive(&this);
+    return this;
+}
+
+uint8_t readArchiveEntry(const archive* this, uint32_t index, archiveEntry* entry)
+{
+    if (index >= this->numberOfEntries) return 1;
+    const uint8_t* stored = &this->entries[(uint64_t)index * ARCHIVE_ENTRY_LENGTH];
+    uint64_t offset = loadLong(&stored[8]);
+    uint64_t nameOffset = loadBigEndian(&stored[32], 4);
+    entry->length = loadLong(&stored[16]);
+    entry->checksum = loadLong(&stored[24]);
+    entry->nameLength = (uint16_t)loadBigEndian(&stored[36], 2);
+    entry->channels = stored[38];
+    entry->mode = stored[39];
+    entry->width = loadBigEndian(&stored[40], 4);
+    entry->height = loadBigEndian(&stored[44], 4);
+    entry->maxGreyLevel = (uint16_t)loadBigEndian(&stored[48], 2);
+    // Compressed file and name must lie inside archive, directory was checked only as a whole
+    if (offset > this->length || entry->length > this->length - offset || nameOffset + entry->nameLength > this->namesLength) {
+        printf("Wpis archiwum jest uszkodzony!\n");
+        return 1;
+    }
+    entry->data = &this->data[offset];
+    entry->name = &this->names[nameOffset];
+    return 0;
+}
+
+uint8_t findArchiveEntry(const archive* this, const char* name, archiveEntry* entry)
+{
+    size_t nameLength = strlen(name);
+    uint64_t hash = archiveHash((const uint8_t*)name, nameLength);
+    uint32_t mask = this->numberOfSlots - 1;
+    uint32_t slot = (uint32_t)hash & mask;
+    // Coder leaves at least half of slots empty, damaged table is probed at most once around
+    for (uint32_t probe = 0; probe < this->numberOfSlots; probe++, slot = (slot + 1) & mask) {
+        uint32_t index = loadBigEndian(&this->slots[(uint64_t)slot * ARCHIVE_SLOT_LENGTH], ARCHIVE_SLOT_LENGTH);
+        if (!index) break;
+        if (index > this->numberOfEntries) {
+            printf("Katalog archiwum jest uszkodzony!\n");
+            return 1;
+        }
+        const uint8_t* stored = &this->entries[(uint64_t)(index - 1) * ARCHIVE_ENTRY_LENGTH];
+        if (loadLong(stored) != hash || loadBigEndian(&stored[36], 2) != nameLength) continue;
+        if (readArchiveEntry(this, index - 1, entry)) return 1;
+        if (!memcmp(entry->name, name, nameLength)) return 0;
+    }
+    printf("Archiwum nie zawiera pliku %s!\n", name);
+    return 1;
+}
+
+tree* createTreeFromArchive(const archiveEntry* entry)
+{
+    if (archiveHash(entry->data, entry->length) != entry->checksum) {
+        printf("Suma kontrolna pliku %.*s w archiwum się nie zgadza!\n", (int)entry->nameLength, entry->name);
+        return NULL;
+    }
+    return createTreeFromMemory(entry->data, entry->length);
+}
+
+void closeArchive(archive** this)
+{
+    if (!*this) return;
+#ifdef KODA_MAP_ARCHIVE
+    if ((*this)->mapped)
+        munmap((void*)(*this)->data, (size_t)(*this)->length);
+    else
+#endif
+        free((void*)(*this)->data);
+    free(*this);
+    *this = NULL;
+}
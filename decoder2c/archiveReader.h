@@ -0,0 +1,116 @@
+#ifndef ARCHIVE_READER_H
+#define ARCHIVE_READER_H
+
+// Archive: compressed files one after another, then directory and trailer; only the last
+// trailer is valid. Trailer: magic, version, three reserved bytes, offset of directory
+// (8 bytes), number of entries (4 bytes), number of slots (4 bytes) and checksum of directory
+// (8 bytes). Hashes of names and checksums are 64-bit FNV-1a hashes.
+#define ARCHIVE_MAGIC { 0x8B, 'K', 'D', 'R' }
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_TRAILER_LENGTH 32
+// Directory: slots of hash table of names (4 bytes each, number of entry plus 1 or 0 when
+// empty, linear probing), entries and names
+#define ARCHIVE_SLOT_LENGTH 4
+// Entry: hash of name (8 bytes), offset (8 bytes), length (8 bytes) and checksum (8 bytes) of
+// compressed file, offset of name among names (4 bytes), length of name (2 bytes), channels,
+// mode, width (4 bytes), height (4 bytes), maximum grey level (2 bytes) and 2 reserved bytes
+#define ARCHIVE_ENTRY_LENGTH 52
+
+#include "decoderOperations.h"
+
+/**
+ * @brief:  Archive of compressed files, mapped into memory or read into it. It is never
+ *          changed after opening, so any number of threads may look up and decode its
+ *          entries at once.
+ * @data: Contents of archive.
+ * @length: Length of archive.
+ * @mapped: 1 if data is mapped file, 0 if it was read into allocated memory.
+ * @slots: Hash table of names in directory.
+ * @entries: Entries in directory.
+ * @names: Names of entries in directory.
+ * @namesLength: Length of names.
+ * @numberOfEntries: Number of entries.
+ * @numberOfSlots: Number of slots of hash table, power of two.
+ */
+typedef struct archive {
+    const uint8_t* data;
+    uint64_t length;
+    uint8_t mapped;
+    const uint8_t* slots;
+    const uint8_t* entries;
+    const char* names;
+    uint64_t namesLength;
+    uint32_t numberOfEntries;
+    uint32_t numberOfSlots;
+} archive;
+
+/**
+ * @brief:  Entry of archive directory.
+ * @data: Compressed file inside archive.
+ * @length: Length of compressed file.
+ * @checksum: FNV-1a hash of compressed file.
+ * @name: Name of entry, not terminated.
+ * @nameLength: Length of name.
+ * @channels: Number of channels of image.
+ * @mode: Coding mode of compressed file.
+ * @width: Width of image.
+ * @height: Height of image.
+ * @maxGreyLevel: Maximum grey level of image.
+ */
+typedef struct archiveEntry {
+    const uint8_t* data;
+    uint64_t length;
+    uint64_t checksum;
+    const char* name;
+    uint16_t nameLength;
+    uint8_t channels;
+    uint8_t mode;
+    uint32_t width;
+    uint32_t height;
+    uint16_t maxGreyLevel;
+} archiveEntry;
+
+/**
+  * @brief: Opens archive: maps it into memory where mmap() is available, reads it otherwise,
+  *         and checks its trailer and checksum of directory.
+  * @param  path to archive
+  * @retval pointer to opened archive, NULL otherwise
+  */
+archive* openArchive(const char* path);
+
+/**
+  * @brief: Reads entry of directory by its position.
+  * @param  pointer to the archive struct
+  * @param  index position of entry, below number of entries
+  * @param  pointer to entry receiving description
+  * @retval 0 if entry is valid, 1 otherwise
+  */
+uint8_t readArchiveEntry(const archive*, uint32_t index, archiveEntry* entry);
+
+/**
+  * @brief: Finds entry by name with single lookup in hash table of directory, not counting
+  *         collisions.
+  * @param  pointer to the archive struct
+  * @param  name of entry
+  * @param  pointer to entry receiving description
+  * @retval 0 if entry was found, 1 otherwise
+  */
+uint8_t findArchiveEntry(const archive*, const char* name, archiveEntry* entry);
+
+/**
+  * @brief: Checks checksum of compressed file of entry and creates tree decoding it, as
+  *         createTreeFromMemory() does.
+  * @param  pointer to entry of opened archive
+  * @retval pointer to created tree, NULL otherwise
+  */
+tree* createTreeFromArchive(const archiveEntry* entry);
+
+/**
+  * @brief: Unmaps or frees archive and sets pointer to NULL. Entries read from it are invalid
+  *         afterwards.
+  * @param  pointer to the pointer of archive struct
+  * @retval None
+  */
+void closeArchive(archive**);
+
+#endif
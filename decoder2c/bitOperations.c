@@ -1,11 +1,12 @@
 #include "bitOperations.h"
+#include "outputSink.h"
 
 /** 
  * @brief:  Frees memory allocated for input data buffer
  * @param:  this - address of pointer to buffer structure
  * @retval: None
  */
-void freeBaseBuffer(baseBuffer** this)
+static void freeBaseBuffer(baseBuffer** this)
 {
     (*this)->killMe = NULL;
     (*this)->baseBufferSize = 0;
@@ -18,6 +19,7 @@ void freeBaseBuffer(baseBuffer** this)
 
 void freeByteBuffer(byteBuffer** this)
 {
+    releaseSink(*this);
     (*this)->killMe = NULL;
     (*this)->appendByte = NULL;
     (*this)->currentByte = 0;
@@ -42,49 +44,64 @@ void freeBitBuffer(bitBuffer** this)
 }
 
 /**
- * @brief:  Function responsible of reallocating memory for array storing bits from
- *          compressed file.
+ * @brief:  Function responsible of reallocating memory for array storing data,
+ *          grows buffer to given number of base chunks.
  * @param:  this - pointer to buffer structure.
+ * @param:  multiplier - number of base chunks of new buffer, greater than current one.
  * @retval: 0 if succesfully reallocates memory, 1 in case of memory allocation failure
  */
-uint8_t reallocateBuffer(baseBuffer* this)
+static uint8_t resizeBuffer(baseBuffer* this, uint32_t multiplier)
 {
     // Allocate larger memory pool
-    uint8_t* newBuffer = (uint8_t*)malloc((this->multiplier + 1) * this->baseBufferSize);
+    uint8_t* newBuffer = (uint8_t*)malloc((size_t)multiplier * this->baseBufferSize);
     if (!newBuffer) {
         printf("Błąd podczas alokacji nowej pamięci bufora danych!\n");
         return 1;
     } 
     // Copy old data to new buffer and clear old buffer memory
     if (this->dataBuffer) {
-        memcpy(newBuffer, this->dataBuffer, this->multiplier * this->baseBufferSize);
+        memcpy(newBuffer, this->dataBuffer, (size_t)this->multiplier * this->baseBufferSize);
         free(this->dataBuffer);
     }
     // Assign new dataBuffer memory to buffer struct
     this->dataBuffer = newBuffer;
-    this->multiplier++;
+    this->multiplier = multiplier;
     return 0;
 }
 
 /**
- * @brief Extracts the most significant bit (MSB) from the current byte in the bit buffer,
- *        shifts the byte to prepare for the next bit, and updates the position.
+ * @brief:  Function responsible of reallocating memory for array storing bits from
+ *          compressed file. Buffer is doubled, so filling it byte by byte copies every
+ *          byte only a few times on average.
+ * @param:  this - pointer to buffer structure.
+ * @retval: 0 if succesfully reallocates memory, 1 in case of memory allocation failure
+ */
+static uint8_t reallocateBuffer(baseBuffer* this)
+{
+    if (this->multiplier > UINT32_MAX / 2) {
+        printf("Przekroczono maksymalny rozmiar bufora danych!\n");
+        return 1;
+    }
+    return resizeBuffer(this, this->multiplier ? 2 * this->multiplier : 1);
+}
+
+/**
+ * @brief Extracts the bit at current position of the current byte in the bit buffer,
+ *        starting from the most significant one, and updates the position.
  * @param this Pointer to the bitBuffer instance.
  * @return
  *         - 0: If the extracted bit is 0.
  *         - 1: If the extracted bit is 1.
  *         - 2: If the end of the buffer is reached (no more bits to read).
  */
-uint8_t popBit(bitBuffer* this)
+static uint8_t popBit(bitBuffer* this)
 {
-    if (this->currentByte > this->lastByte) return 2;
+    if (this->currentByte >= this->lastByte) return 2;
     uint8_t bit = 0;
-    if ((this->baseBuffer->dataBuffer[this->currentByte] & MSB) == MSB) bit = 1;
+    if (((this->baseBuffer->dataBuffer[this->currentByte] << this->currentShift) & MSB) == MSB) bit = 1;
     this->currentShift++;
-    if (this->currentShift < BITS_IN_BYTE) {
-        this->baseBuffer->dataBuffer[this->currentByte] <<= 1;
+    if (this->currentShift < BITS_IN_BYTE) 
         return bit;
-    }
     this->currentShift = 0;
     this->currentByte++;
     return bit;
@@ -95,7 +112,7 @@ uint8_t popBit(bitBuffer* this)
  * @param this Pointer to the bitBuffer instance.
  * @return symbol value
  */
-uint8_t popSymbol(bitBuffer* this)
+static uint8_t popSymbol(bitBuffer* this)
 {
     uint8_t symbol = 0;
     for (uint8_t i = 0; i < 8; i++) {
@@ -114,49 +131,96 @@ uint8_t popSymbol(bitBuffer* this)
  *         - 0: On successful append.
  *         - 1: If memory reallocation fails.
  */
-uint8_t appendByte(byteBuffer* this, uint8_t byte)
+static uint8_t appendByte(byteBuffer* this, uint8_t byte)
 {
     this->baseBuffer->dataBuffer[this->currentByte] = byte;
     this->currentByte++;
     // Realocate memory if next appendByte() would exceed current buffer size
-    if (this->currentByte % this->baseBuffer->baseBufferSize == 0) 
+    if (this->currentByte == (uint64_t)this->baseBuffer->multiplier * this->baseBuffer->baseBufferSize) 
         if (reallocateBuffer(this->baseBuffer)) return 1;   
     return 0;
 }
 
+uint8_t reserveBytes(byteBuffer* this, uint64_t numberOfBytes)
+{
+    if (this->sink.type == OUTPUT_STREAM) {
+        printf("Wyjście strumieniowe wymaga dekodowania sekwencyjnego!\n");
+        return 1;
+    }
+    if (this->sink.type != OUTPUT_MEMORY) {
+        if (numberOfBytes <= this->sink.capacity) return 0;
+        printf("Bufor wyjściowy jest zbyt mały dla obrazu!\n");
+        return 1;
+    }
+    // One spare byte, appendByte() always needs room for next byte
+    uint64_t multiplier = (numberOfBytes + this->baseBuffer->baseBufferSize) / this->baseBuffer->baseBufferSize;
+    if (multiplier <= this->baseBuffer->multiplier) return 0;
+    if (multiplier > UINT32_MAX) {
+        printf("Obraz jest zbyt duży dla bufora pikseli!\n");
+        return 1;
+    }
+    return resizeBuffer(this->baseBuffer, (uint32_t)multiplier);
+}
+
 /** 
- * @brief:  Ask user for path to compressed file and loads data from it to buffer
- * @param:  my - pointer to buffer structure
+ * @brief:  Loads data from compressed file to buffer, asks user for path if none is given
+ * @param:  this - pointer to buffer structure
+ * @param:  filePath - path to compressed file, or NULL to ask user for it
  * @retval: 0 if succesfully loads data to program memory, 1 in case of memory
- *          allocation failure 2 in case of FILE creation error
+ *          allocation failure or FILE opening error
  */
-uint8_t loadDataFromFile(bitBuffer* this)
+static uint8_t loadDataFromFile(bitBuffer* this, const char* filePath)
 {
     // Open file storing compressed data
-    char filePath[256];
-    printf("Podaj ścieżkę do skompresowanego pliku:\n");
-    if (scanf("%250s", filePath) != 1) { 
-        printf("Błąd podczas odczytu ścieżki!\n");
-        return 1;
+    char pathFromUser[256];
+    if (!filePath) {
+        printf("Podaj ścieżkę do skompresowanego pliku:\n");
+        if (scanf("%250s", pathFromUser) != 1) { 
+            printf("Błąd podczas odczytu ścieżki!\n");
+            return 1;
+        }
+        filePath = pathFromUser;
     }
     FILE* compressed = fopen(filePath, "rb");
     if (!compressed) {
         printf("Błąd podczas otwierania skompresowanego pliku!\n");
         return 1;
     }
+    // Buffer is sized to the whole file up front when its size is known, and doubled if file grows
+    long fileLength = -1;
+    if (!fseek(compressed, 0, SEEK_END)) {
+        fileLength = ftell(compressed);
+        rewind(compressed);
+    }
+    if (fileLength >= 0 && (uint64_t)fileLength >= MAX_BYTE_NUM) {
+        printf("Przekroczono maksymalny rozmiar pliku wejściowego!\n");
+        fclose(compressed);
+        return 1;
+    }
+    if (fileLength > 0) {
+        uint32_t multiplier = (uint32_t)(((uint64_t)fileLength + CHUNK_SIZE) / this->baseBuffer->baseBufferSize + 1);
+        if (resizeBuffer(this->baseBuffer, multiplier)) {
+            fclose(compressed);
+            return 1;
+        }
+    }
     // Read data chunk by chunk up to the end of file
-    uint16_t readBytes;
+    size_t readBytes;
     while (1) {
+        uint64_t bufferLength = (uint64_t)this->baseBuffer->multiplier * this->baseBuffer->baseBufferSize;
+        // Realocate memory if next fread() would exceed current buffer size
+        if (bufferLength - this->lastByte < CHUNK_SIZE && reallocateBuffer(this->baseBuffer)) {
+            fclose(compressed);
+            return 1;
+        }
         readBytes = fread(&this->baseBuffer->dataBuffer[this->lastByte], 1, CHUNK_SIZE, compressed);
         this->lastByte += readBytes;
         if (readBytes != CHUNK_SIZE) break;
         if (this->lastByte >= MAX_BYTE_NUM) {
             printf("Przekroczono maksymalny rozmiar pliku wejściowego!\n");
+            fclose(compressed);
             return 1;
         }
-        // Realocate memory if next fread() would exceed current buffer size
-        if (this->lastByte % this->baseBuffer->baseBufferSize == 0) 
-            if (reallocateBuffer(this->baseBuffer)) return 1;      
     }
     // Close file with compressed data
     if (fclose(compressed)) {
@@ -171,7 +235,7 @@ uint8_t loadDataFromFile(bitBuffer* this)
  * @param:  None
  * @retval: Pointer to newly created buffer, or NULL on error
  */
-baseBuffer* createDataBuffer(uint16_t baseBufferSize)
+static baseBuffer* createDataBuffer(uint16_t baseBufferSize)
 {
     // Create instance of buffer
     baseBuffer* newBuffer = (baseBuffer*)malloc(sizeof(baseBuffer));
@@ -199,6 +263,8 @@ byteBuffer* createByteBuffer(uint16_t baseBufferSize)
         return NULL;
     }
     newByteBuffer->currentByte = 0;
+    memset(&newByteBuffer->sink, 0, sizeof(outputSink));
+    newByteBuffer->sink.type = OUTPUT_MEMORY;
     newByteBuffer->appendByte = appendByte;
     newByteBuffer->killMe = freeByteBuffer;
     newByteBuffer->baseBuffer = createDataBuffer(baseBufferSize);
@@ -209,7 +275,36 @@ byteBuffer* createByteBuffer(uint16_t baseBufferSize)
     return newByteBuffer;
 }
 
-bitBuffer* createBitBuffer(uint16_t baseBufferSize)
+/** 
+ * @brief:  Copies compressed data from memory to buffer
+ * @param:  this - pointer to buffer structure
+ * @param:  data - compressed data
+ * @param:  length - length of compressed data
+ * @retval: 0 if succesfully loads data, 1 if data is too long or memory allocation fails
+ */
+static uint8_t loadDataFromMemory(bitBuffer* this, const uint8_t* data, uint64_t length)
+{
+    if (length >= MAX_BYTE_NUM) {
+        printf("Przekroczono maksymalny rozmiar pliku wejściowego!\n");
+        return 1;
+    }
+    // Buffer keeps the same spare chunk as buffer loaded from file, buffer reloaded with
+    // shorter data is not reallocated
+    uint32_t multiplier = (uint32_t)((length + CHUNK_SIZE) / this->baseBuffer->baseBufferSize + 1);
+    if (multiplier > this->baseBuffer->multiplier && resizeBuffer(this->baseBuffer, multiplier))
+        return 1;
+    if (length)
+        memcpy(this->baseBuffer->dataBuffer, data, (size_t)length);
+    this->lastByte = length;
+    return 0;
+}
+
+/** 
+ * @brief:  Creates empty bit buffer instance
+ * @param:  baseBufferSize - base size of chunk of data buffer
+ * @retval: Pointer to newly created buffer, or NULL on error
+ */
+static bitBuffer* allocateBitBuffer(uint16_t baseBufferSize)
 {
     bitBuffer* newBitBuffer = (bitBuffer*)malloc(sizeof(bitBuffer));
     if (!newBitBuffer) {
@@ -227,39 +322,153 @@ bitBuffer* createBitBuffer(uint16_t baseBufferSize)
         newBitBuffer->killMe(&newBitBuffer);
         return NULL;
     }
+    return newBitBuffer;
+}
+
+bitBuffer* createBitBuffer(uint16_t baseBufferSize, const char* filePath)
+{
+    bitBuffer* newBitBuffer = allocateBitBuffer(baseBufferSize);
     // Load created buffer with data
-    if (loadDataFromFile(newBitBuffer)) {
+    if (newBitBuffer && loadDataFromFile(newBitBuffer, filePath)) {
+        newBitBuffer->killMe(&newBitBuffer);
+        return NULL;
+    }
+    return newBitBuffer;
+}
+
+bitBuffer* createBitBufferFromMemory(uint16_t baseBufferSize, const uint8_t* data, uint64_t length)
+{
+    bitBuffer* newBitBuffer = allocateBitBuffer(baseBufferSize);
+    if (newBitBuffer && loadDataFromMemory(newBitBuffer, data, length)) {
         newBitBuffer->killMe(&newBitBuffer);
         return NULL;
     }
-    
     return newBitBuffer;
 }
 
-uint8_t writeToFile(byteBuffer* this)
+uint8_t reloadBitBuffer(bitBuffer* this, const uint8_t* data, uint64_t length)
 {
-    uint8_t fileName[256];
-    printf("Wprowadź nazwę dla zdekompresowanego pliku:\n");
-    if (scanf("%250s", fileName) != 1) { 
-        printf("Error reading input\n");
+    this->lastByte = 0;
+    this->currentByte = 0;
+    this->currentShift = 0;
+    return loadDataFromMemory(this, data, length);
+}
+
+uint8_t resetByteBuffer(byteBuffer* this)
+{
+    releaseSink(this);
+    memset(&this->sink, 0, sizeof(outputSink));
+    this->sink.type = OUTPUT_MEMORY;
+    this->currentByte = 0;
+    this->appendByte = appendByte;
+    // Caller buffer detached from buffer leaves it without memory of its own
+    if (!this->baseBuffer->dataBuffer) {
+        this->baseBuffer->multiplier = 0;
+        return resizeBuffer(this->baseBuffer, 1);
+    }
+    return 0;
+}
+
+uint32_t loadBigEndian(const uint8_t* source, uint8_t bytes)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < bytes; i++)
+        value = (value << BITS_IN_BYTE) | source[i];
+    return value;
+}
+
+uint8_t readHeader(bitBuffer* this, imageHeader* header)
+{
+    const uint8_t magic[] = HEADER_MAGIC;
+    const uint8_t* data = this->baseBuffer->dataBuffer;
+
+    // Legacy stream starts directly with path to first symbol, which is always "0" bit
+    if (this->lastByte < sizeof(magic) || memcmp(data, magic, sizeof(magic))) {
+        header->width = LEGACY_IMAGE_SIDE;
+        header->height = LEGACY_IMAGE_SIDE;
+        header->maxGreyLevel = 255;
+        header->mode = MODE_ADAPTIVE_HUFFMAN;
+        header->channels = 1;
+        header->bytesPerSample = 1;
+        header->dictionaryId = 0;
+        header->scanOrder = SCAN_ROW;
+        return 0;
+    }
+    if (this->lastByte < HEADER_V1_LENGTH || !data[4] || data[4] > FORMAT_VERSION) {
+        printf("Nieobsługiwana wersja formatu pliku lub niekompletny nagłówek!\n");
+        return 1;
+    }
+    uint8_t headerLength = data[4] == 1 ? HEADER_V1_LENGTH : HEADER_LENGTH;
+    if (this->lastByte < headerLength) {
+        printf("Niekompletny nagłówek skompresowanego pliku!\n");
+        return 1;
+    }
+    header->mode = data[5];
+    header->maxGreyLevel = loadBigEndian(&data[6], 2);
+    header->width = loadBigEndian(&data[8], 4);
+    header->height = loadBigEndian(&data[12], 4);
+    header->channels = data[4] == 1 ? 1 : data[16];
+    header->dictionaryId = data[4] == 1 ? 0 : loadBigEndian(&data[17], 2);
+    header->scanOrder = data[4] == 1 ? SCAN_ROW : data[19];
+    header->bytesPerSample = header->maxGreyLevel > 255 ? 2 : 1;
+    if (!header->width || !header->height || !header->maxGreyLevel) {
+        printf("Nieprawidłowe wymiary obrazu w nagłówku!\n");
+        return 1;
+    }
+    if (header->channels != 1 && header->channels != 3) {
+        printf("Nieobsługiwana liczba kanałów: %u!\n", header->channels);
+        return 1;
+    }
+    // Decoded image with its text header must be addressable, callers compute its length
+    // from 32 bit sides without checking it again
+    uint64_t sampleBytes = (uint64_t)header->channels * header->bytesPerSample;
+    uint64_t numberOfPixels = (uint64_t)header->width * header->height;
+    if (numberOfPixels > UINT64_MAX / sampleBytes || numberOfPixels * sampleBytes > SIZE_MAX - IMAGE_HEADER_MAX_LENGTH) {
+        printf("Nieprawidłowe wymiary obrazu w nagłówku!\n");
         return 1;
     }
-    // Append ".pgm" extension to the provided file name
-    snprintf(fileName, sizeof(fileName), "%s.pgm", fileName);
-    FILE* newFile = fopen(fileName,"wb");
+    if (header->scanOrder > SCAN_TILE) {
+        printf("Nieobsługiwana kolejność skanowania: %u!\n", header->scanOrder);
+        return 1;
+    }
+    this->currentByte = headerLength;
+    return 0;
+}
+
+uint32_t formatImageHeader(char* text, size_t size, const imageHeader* header)
+{
+    int length = snprintf(text, size, "P%c\n%u %u\n%u\n", header->channels == 3 ? '6' : '5',
+                          header->width, header->height, header->maxGreyLevel);
+    return length > 0 ? (uint32_t)length : 0;
+}
+
+uint8_t writeDecompressedFile(byteBuffer* this, const imageHeader* header, const char* filePath)
+{
+    char nameFromUser[256];
+    char fileName[256];
+    if (!filePath) {
+        printf("Wprowadź nazwę dla zdekompresowanego pliku:\n");
+        if (scanf("%250s", nameFromUser) != 1) { 
+            printf("Error reading input\n");
+            return 1;
+        }
+        // Append ".pgm" extension to the provided file name
+        snprintf(fileName, sizeof(fileName), "%s.pgm", nameFromUser);
+        filePath = fileName;
+    }
+    FILE* newFile = fopen(filePath,"wb");
 
     if (newFile == NULL) {
         printf("Błąd podczas tworzenia pliku!\n");
         return 1;
     }
 
-    fprintf(newFile, "P5\n");
-    fprintf(newFile, "# Created by IrfanView\n");
-    fprintf(newFile, "512 512\n");
-    fprintf(newFile, "255\n");
-
-    if (fwrite(this->baseBuffer->dataBuffer, 1, this->currentByte, newFile) != this->currentByte) {
+    char headerText[IMAGE_HEADER_MAX_LENGTH];
+    uint32_t headerLength = formatImageHeader(headerText, sizeof(headerText), header);
+    if (fwrite(headerText, 1, headerLength, newFile) != headerLength ||
+        fwrite(this->baseBuffer->dataBuffer, 1, this->currentByte, newFile) != this->currentByte) {
         printf("Błąd podczas zapisywania danych do pliku!\n");
+        fclose(newFile);
         return 1;
     }
     if (fclose(newFile)) {
@@ -268,4 +477,4 @@ uint8_t writeToFile(byteBuffer* this)
     }
     printf("Zdekompresowany plik zapisany poprawnie\n");
     return 0;
-}
\ No newline at end of file
+}
@@ -1,12 +1,60 @@
 #ifndef BIT_OPERATIONS_H
 #define BIT_OPERATIONS_H
 
-#define MAX_BYTE_NUM 393216
 #define BASE_BUFFER_SIZE 1024
-#define CHUNK_SIZE 128
+// Largest input that buffer of BASE_BUFFER_SIZE chunks can address, run-length and stored
+// data can be larger than image itself
+#define MAX_BYTE_NUM ((uint64_t)BASE_BUFFER_SIZE * UINT32_MAX)
+// Compressed file is read in chunks of 1 MB
+#define CHUNK_SIZE (1 << 20)
 #define BITS_IN_BYTE 8
 #define MSB 128
 
+// Compressed file header: magic, format version, coding mode, max grey level, columns, rows,
+// channels, dictionary id (0 without dictionary) and scan order of blocks. Version 1 header
+// ends after rows.
+#define HEADER_LENGTH 20
+#define HEADER_V1_LENGTH 16
+#define HEADER_MAGIC { 0x8B, 'K', 'D', 'A' }
+#define FORMAT_VERSION 2
+#define MODE_ADAPTIVE_HUFFMAN 0
+#define MODE_STATIC_HUFFMAN 1
+#define MODE_STORED 2
+#define MODE_RUN_LENGTH 3
+#define MODE_TILED 4
+#define MODE_RANGE 5
+// Adaptive Huffman code of pairs of neighbouring 8 bit samples, odd last sample is paired with 0
+#define MODE_PAIR_HUFFMAN 6
+// Eight bit planes of 8 bit samples, each packed 8 samples per byte with own adaptive Huffman code
+#define MODE_BIT_PLANE 7
+// Canonical Huffman code of 8 bit samples rebuilt from symbol counts every few thousand symbols
+#define MODE_PERIODIC_HUFFMAN 8
+// Scan orders in which samples of every block were coded come from scanWalk.h, shared with coder
+// Tiled mode: tile side follows header, then every tile has its mode and payload length
+#define TILE_SIDE_LENGTH 2
+#define TILE_HEADER_LENGTH 5
+// Tile mode only: tile equal to earlier tile of image, payload is number of that tile, counting
+// channels of every tile
+#define MODE_DUPLICATE_TILE 9
+#define TILE_REFERENCE_LENGTH 4
+// Files written before header was introduced always hold 512x512 images
+#define LEGACY_IMAGE_SIDE 512
+// Destinations of decompressed pixels, streamed pixels are written in windows of 4 MB
+#define OUTPUT_MEMORY 0
+#define OUTPUT_CALLER 1
+#define OUTPUT_MAPPED 2
+#define OUTPUT_STREAM 3
+#define OUTPUT_WINDOW_SIZE (1 << 22)
+#define IMAGE_HEADER_MAX_LENGTH 40
+
+// Kernels are specialised by inlining their body with constant parameters
+#if defined(_MSC_VER)
+#define KODA_INLINE static __forceinline
+#else
+#define KODA_INLINE static inline __attribute__((always_inline))
+#endif
+
+#include "scanWalk.h"
 #include "stdlib.h"
 #include "stdint.h"
 #include "string.h"
@@ -15,27 +63,47 @@
 /**
  * @brief: Represents base instance of buffer
  * @dataBuffer: Array storing bits in 8bit variables
- * @multiplier: Tells us how many times buffer was expanded
+ * @multiplier: Size of buffer in base chunks, doubled whenever buffer is full
  * @baseBufferSize: Base size of chunk of data buffer
  * @killMe: destructor
  */
 typedef struct baseBuffer {
     uint8_t* dataBuffer;
-    uint16_t  multiplier;
+    uint32_t multiplier;
     uint16_t baseBufferSize;
     void (*killMe)(struct baseBuffer**);
 } baseBuffer;
 
+/**
+ * @brief: Describes where decompressed pixels go
+ * @file: Decompressed file, NULL if pixels stay in memory
+ * @mapping: Start of mapped decompressed file, pixels follow PGM header in it
+ * @mappingLength: Length of mapped decompressed file
+ * @capacity: Size of caller buffer or mapped pixels, size of window of streamed pixels
+ * @flushedBytes: Number of pixel bytes already written to streamed file
+ * @type: OUTPUT_MEMORY, OUTPUT_CALLER, OUTPUT_MAPPED or OUTPUT_STREAM
+ */
+typedef struct outputSink {
+    FILE* file;
+    uint8_t* mapping;
+    uint64_t mappingLength;
+    uint64_t capacity;
+    uint64_t flushedBytes;
+    uint8_t type;
+} outputSink;
+
 /**
  * @brief: Represents instance of buffer storing byte data
  * @baseBuffer: Pointer to buffer struct storing data
  * @currentByte: Tells us possition of last added byte
+ * @sink: Destination of data, growing buffer in memory by default
  * @appendByte: Add byte to baseBuffer
  * @killMe: destructor
  */
 typedef struct byteBuffer {
     baseBuffer* baseBuffer;
     uint64_t currentByte;
+    outputSink sink;
     uint8_t (*appendByte)(struct byteBuffer*, uint8_t);
     void (*killMe)(struct byteBuffer**);
 } byteBuffer;
@@ -61,6 +129,28 @@ typedef struct bitBuffer {
     void (*killMe)(struct bitBuffer**);
 } bitBuffer;
 
+/**
+ * @brief: Describes image stored in compressed file
+ * @width: Number of columns of image
+ * @height: Number of rows of image
+ * @maxGreyLevel: Maximum grey level written to decompressed file
+ * @mode: Coding mode of data following the header
+ * @channels: Number of channels, 1 for PGM and 3 for PPM images
+ * @bytesPerSample: 1 for max grey level up to 255, 2 otherwise, derived from maxGreyLevel
+ * @dictionaryId: Identifier of dictionary adaptive blocks start from, 0 if none
+ * @scanOrder: Order in which samples of every block were coded, SCAN_ROW for older files
+ */
+typedef struct imageHeader {
+    uint32_t width;
+    uint32_t height;
+    uint16_t maxGreyLevel;
+    uint8_t mode;
+    uint8_t channels;
+    uint8_t bytesPerSample;
+    uint16_t dictionaryId;
+    uint8_t scanOrder;
+} imageHeader;
+
 /** 
  * @brief:  Creates byte buffer instance
  * @param:  None
@@ -69,18 +159,86 @@ typedef struct bitBuffer {
 byteBuffer* createByteBuffer(uint16_t baseBufferSize);
 
 /** 
- * @brief:  Creates bit buffer instance
- * @param:  None
+ * @brief:  Creates bit buffer instance and loads it with content of compressed file
+ * @param:  baseBufferSize - base size of chunk of data buffer
+ * @param:  filePath - path to compressed file, or NULL to ask user for it
  * @retval: Pointer to newly created buffer, or NULL on error
  */
-bitBuffer* createBitBuffer(uint16_t baseBufferSize);
+bitBuffer* createBitBuffer(uint16_t baseBufferSize, const char* filePath);
+
+/** 
+ * @brief:  Creates bit buffer instance holding copy of compressed data from memory
+ * @param:  baseBufferSize - base size of chunk of data buffer
+ * @param:  data - compressed data, as stored in compressed file
+ * @param:  length - length of compressed data
+ * @retval: Pointer to newly created buffer, or NULL on error
+ */
+bitBuffer* createBitBufferFromMemory(uint16_t baseBufferSize, const uint8_t* data, uint64_t length);
+
+/** 
+ * @brief:  Replaces content of bit buffer with copy of other compressed data, reusing its
+ *          memory, and moves reading position to first bit.
+ * @param:  this - pointer to buffer structure
+ * @param:  data - compressed data, as stored in compressed file
+ * @param:  length - length of compressed data
+ * @retval: 0 if data was loaded, 1 if it is too long or memory allocation fails
+ */
+uint8_t reloadBitBuffer(bitBuffer* this, const uint8_t* data, uint64_t length);
+
+/** 
+ * @brief:  Empties byte buffer for next image: releases its output sink and makes it grow
+ *          in memory again, memory it owns is reused.
+ * @param:  this - pointer to buffer structure
+ * @retval: 0 on success, 1 in case of memory allocation failure
+ */
+uint8_t resetByteBuffer(byteBuffer* this);
+
+/** 
+ * @brief:  Makes sure byte buffer can hold given number of bytes without reallocation.
+ *          Caller buffer and mapped file are never reallocated, streamed output is
+ *          written sequentially and can not be reserved.
+ * @param:  this - pointer to buffer structure
+ * @param:  numberOfBytes - number of bytes buffer has to hold
+ * @retval: 0 if buffer is large enough, 1 in case of memory allocation failure or if
+ *          output can not hold given number of bytes
+ */
+uint8_t reserveBytes(byteBuffer* this, uint64_t numberOfBytes);
+
+/** 
+ * @brief:  Reads value stored on given number of bytes in big-endian order.
+ * @param:  source - pointer to first byte of value
+ * @param:  bytes - number of bytes used to store value
+ * @retval: Read value
+ */
+uint32_t loadBigEndian(const uint8_t* source, uint8_t bytes);
+
+/** 
+ * @brief:  Reads compressed file header and moves buffer position past it. Files without
+ *          header are treated as legacy 512x512 adaptive Huffman streams.
+ * @param:  this - pointer to buffer structure
+ * @param:  header - pointer to structure receiving image description
+ * @retval: 0 if header is valid and decoded image is addressable, 1 otherwise
+ */
+uint8_t readHeader(bitBuffer* this, imageHeader* header);
+
+/** 
+ * @brief:  Formats PGM or PPM header of decompressed image.
+ * @param:  text - buffer receiving header
+ * @param:  size - size of buffer
+ * @param:  header - pointer to structure describing decompressed image
+ * @retval: Length of header
+ */
+uint32_t formatImageHeader(char* text, size_t size, const imageHeader* header);
 
 /** 
- * @brief:  Ask user for name for decopressed file and loads it with decompressed data
+ * @brief:  Writes decompressed data to PGM or PPM file. If no name is given, user is asked
+ *          for name for decompressed file and ".pgm" extension is appended to it.
  * @param:  this - pointer to buffer structure
+ * @param:  header - pointer to structure describing decompressed image
+ * @param:  filePath - path to decompressed file, or NULL to ask user for it
  * @retval: 0 if succesfully loads data to file, 1 otherwise
  */
-uint8_t writeToFile(byteBuffer* this);
+uint8_t writeDecompressedFile(byteBuffer* this, const imageHeader* header, const char* filePath);
 
 /** 
  * @brief:  Frees memory allocated for input data buffer
@@ -0,0 +1,233 @@
+// Threads are POSIX, planes are decoded one by one where they are missing
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_THREADS
+#endif
+#include "bitPlaneDecoder.h"
+#ifdef KODA_THREADS
+#include <pthread.h>
+#endif
+
+struct planeBlock;
+
+/**
+ * @brief:  Thread of bit-plane block: decodes one plane, then puts together one part of block.
+ * @tree: Tree of plane, its input limited to payload of plane.
+ * @block: Block worker belongs to.
+ * @plane: Position of plane in block, 0 for the most significant one.
+ * @task: Work of current phase.
+ * @status: 0 if work was done successfully, 1 otherwise.
+ */
+typedef struct planeWorker {
+    tree* tree;
+    struct planeBlock* block;
+    uint8_t plane;
+    uint8_t (*task)(struct planeWorker*);
+    uint8_t status;
+} planeWorker;
+
+/**
+ * @brief:  Bit-plane block decoded by workers.
+ * @workers: Worker of every plane, from the most significant one.
+ * @pixels: Output of first sample of block.
+ * @numberOfPixels: Number of samples of block.
+ * @numberOfBytes: Number of bytes of every packed plane.
+ * @gray: 1 if samples were Gray-coded.
+ */
+typedef struct planeBlock {
+    planeWorker workers[BIT_PLANES];
+    uint8_t* pixels;
+    uint64_t numberOfPixels;
+    uint64_t numberOfBytes;
+    uint8_t gray;
+} planeBlock;
+
+/**
+  * @brief  Creates tree decoding single plane: its input shares buffer of decoded tree and is
+  *         limited to payload of plane, its output is its own.
+  * @param  parent pointer to decoded tree
+  * @param  firstByte position of payload in input
+  * @param  length number of bytes of payload
+  * @retval Pointer to created tree, NULL on memory allocation error
+  */
+static tree* createPlaneTree(const tree* parent, uint64_t firstByte, uint64_t length)
+{
+    tree* this = (tree*)calloc(1, sizeof(tree));
+    bitBuffer* input = (bitBuffer*)malloc(sizeof(bitBuffer));
+    byteBuffer* output = createByteBuffer(BASE_BUFFER_SIZE);
+    if (!this || !input || !output) {
+        printf("Błąd podczas alokowania pamięci na strukturę drzewa!");
+        free(this);
+        free(input);
+        if (output) output->killMe(&output);
+        return NULL;
+    }
+    *input = *parent->input;
+    input->currentByte = firstByte;
+    input->lastByte = firstByte + length;
+    input->currentShift = 0;
+    this->input = input;
+    this->output = output;
+    // Packed plane is coded as 8 bit samples of single channel
+    this->header = parent->header;
+    this->header.mode = MODE_ADAPTIVE_HUFFMAN;
+    this->header.channels = 1;
+    this->header.bytesPerSample = 1;
+    this->baseNumberOfNodes = BASE_NODES_ENTRIES;
+    return this;
+}
+
+/**
+  * @brief  Frees tree of plane, leaving input buffer to decoded tree.
+  * @param  this address of pointer to tree of plane
+  * @retval None
+  */
+static void freePlaneTree(tree** this)
+{
+    if (!*this) return;
+    (*this)->input->baseBuffer = NULL;
+    freeTree(this);
+}
+
+/**
+  * @brief  Decodes packed plane of worker into output of its tree.
+  * @param  this pointer to worker
+  * @retval 0 if plane was decoded successfully, 1 otherwise
+  */
+static uint8_t decodePlane(planeWorker* this)
+{
+    return startAdaptive(this->tree) || resumeAdaptive(this->tree, this->block->numberOfBytes);
+}
+
+/**
+  * @brief  Puts together samples of part of block from bits of all planes, one packed byte of
+  *         every plane at a time, and reverses their Gray code.
+  * @param  this pointer to worker, its position selects part of block
+  * @retval 0
+  */
+static uint8_t mergePlanes(planeWorker* this)
+{
+    const planeBlock* block = this->block;
+    uint64_t firstByte = block->numberOfBytes * this->plane / BIT_PLANES;
+    uint64_t lastByte = block->numberOfBytes * (this->plane + 1) / BIT_PLANES;
+    for (uint64_t byte = firstByte; byte < lastByte; byte++) {
+        uint8_t samples[BITS_IN_BYTE] = { 0 };
+        for (uint8_t plane = 0; plane < BIT_PLANES; plane++) {
+            uint8_t bits = block->workers[plane].tree->output->baseBuffer->dataBuffer[byte];
+            uint8_t weight = (uint8_t)(1 << (BIT_PLANES - 1 - plane));
+            for (uint8_t i = 0; i < BITS_IN_BYTE; i++)
+                if ((bits >> (BITS_IN_BYTE - 1 - i)) & 1)
+                    samples[i] |= weight;
+        }
+        // Last byte of planes may be padded
+        uint64_t first = byte * BITS_IN_BYTE;
+        uint8_t count = block->numberOfPixels - first < BITS_IN_BYTE ? (uint8_t)(block->numberOfPixels - first) : BITS_IN_BYTE;
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t sample = samples[i];
+            if (block->gray) {
+                sample ^= sample >> 1;
+                sample ^= sample >> 2;
+                sample ^= sample >> 4;
+            }
+            block->pixels[first + i] = sample;
+        }
+    }
+    return 0;
+}
+
+#ifdef KODA_THREADS
+/**
+  * @brief  Thread entry point, does work of current phase of worker.
+  * @param  argument pointer to worker
+  * @retval NULL
+  */
+static void* runWorker(void* argument)
+{
+    planeWorker* this = (planeWorker*)argument;
+    this->status = this->task(this);
+    return NULL;
+}
+#endif
+
+/**
+  * @brief  Runs given work on every worker of block, first worker on calling thread. Work of
+  *         thread that can not be started is done on calling thread too.
+  * @param  block pointer to block
+  * @param  task work of every worker
+  * @retval 0 if every worker succeeded, 1 otherwise
+  */
+static uint8_t runWorkers(planeBlock* block, uint8_t (*task)(planeWorker*))
+{
+    planeWorker* workers = block->workers;
+    for (uint8_t i = 0; i < BIT_PLANES; i++) {
+        workers[i].task = task;
+        workers[i].status = 0;
+    }
+#ifdef KODA_THREADS
+    pthread_t threads[BIT_PLANES];
+    uint8_t started[BIT_PLANES] = { 0 };
+    for (uint8_t i = 1; i < BIT_PLANES; i++)
+        started[i] = !pthread_create(&threads[i], NULL, runWorker, &workers[i]);
+    for (uint8_t i = 0; i < BIT_PLANES; i++)
+        if (!started[i])
+            workers[i].status = task(&workers[i]);
+    for (uint8_t i = 1; i < BIT_PLANES; i++)
+        if (started[i])
+            pthread_join(threads[i], NULL);
+#else
+    for (uint8_t i = 0; i < BIT_PLANES; i++)
+        workers[i].status = task(&workers[i]);
+#endif
+    uint8_t status = 0;
+    for (uint8_t i = 0; i < BIT_PLANES; i++)
+        status |= workers[i].status;
+    return status;
+}
+
+uint8_t decodeBitPlanes(tree* this, uint64_t numberOfPixels)
+{
+    bitBuffer* input = this->input;
+    if (this->header.bytesPerSample > 1 || input->currentShift ||
+        input->lastByte - input->currentByte < BIT_PLANE_HEADER_LENGTH) {
+        printf("Skompresowany plik jest niekompletny lub uszkodzony!\n");
+        return 1;
+    }
+    const uint8_t* blockHeader = &input->baseBuffer->dataBuffer[input->currentByte];
+    uint64_t payloadStart[BIT_PLANES];
+    uint64_t payloadLength[BIT_PLANES];
+    uint64_t position = input->currentByte + BIT_PLANE_HEADER_LENGTH;
+    uint8_t status = (blockHeader[0] & ~BIT_PLANE_GRAY) != 0;
+    for (uint8_t i = 0; i < BIT_PLANES && !status; i++) {
+        payloadStart[i] = position;
+        payloadLength[i] = loadBigEndian(&blockHeader[1 + i * PLANE_LENGTH_BYTES], PLANE_LENGTH_BYTES);
+        status = input->lastByte - position < payloadLength[i];
+        position += payloadLength[i];
+    }
+    if (status) {
+        printf("Skompresowany plik jest niekompletny lub uszkodzony!\n");
+        return 1;
+    }
+    if (reserveBytes(this->output, this->output->currentByte + numberOfPixels)) return 1;
+
+    planeBlock block = {
+        .pixels = &this->output->baseBuffer->dataBuffer[this->output->currentByte],
+        .numberOfPixels = numberOfPixels,
+        .numberOfBytes = (numberOfPixels + BITS_IN_BYTE - 1) / BITS_IN_BYTE,
+        .gray = (blockHeader[0] & BIT_PLANE_GRAY) != 0,
+    };
+    for (uint8_t i = 0; i < BIT_PLANES; i++) {
+        block.workers[i].block = &block;
+        block.workers[i].plane = i;
+        block.workers[i].tree = status ? NULL : createPlaneTree(this, payloadStart[i], payloadLength[i]);
+        status = !block.workers[i].tree;
+    }
+    // Planes are decoded first, samples of every part of block need all of them
+    if (!status && block.numberOfBytes)
+        status = runWorkers(&block, decodePlane) || runWorkers(&block, mergePlanes);
+    for (uint8_t i = 0; i < BIT_PLANES; i++)
+        freePlaneTree(&block.workers[i].tree);
+    if (status) return 1;
+    input->currentByte = position;
+    this->output->currentByte += numberOfPixels;
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef BIT_PLANE_DECODER_H
+#define BIT_PLANE_DECODER_H
+
+// Bit-plane block: flags, payload length of every plane from the most significant one, payloads
+#define BIT_PLANES 8
+#define BIT_PLANE_GRAY 0x01
+#define PLANE_LENGTH_BYTES 4
+#define BIT_PLANE_HEADER_LENGTH (1 + BIT_PLANES * PLANE_LENGTH_BYTES)
+
+#include "decoderOperations.h"
+
+/**
+  * @brief: Decodes 8 bit samples coded as eight bit planes, each packed 8 samples per byte with
+  *         its own adaptive Huffman code. Planes are decoded on separate threads where threads
+  *         are available, then samples are put together from them by the same threads, each
+  *         of them for its part of block. Gray code of samples is reversed when block has
+  *         BIT_PLANE_GRAY flag.
+  * @param  pointer to the tree struct holding input and output buffers.
+  * @param  numberOfPixels number of pixels appended to output
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t decodeBitPlanes(tree* this, uint64_t numberOfPixels);
+
+#endif
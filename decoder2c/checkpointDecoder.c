@@ -0,0 +1,473 @@
+// Threads and sysconf() are POSIX, stream is decoded sequentially where they are missing
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_THREADS
+#endif
+#include "checkpointDecoder.h"
+#ifdef KODA_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief:  Part of stream decoded by single thread: consecutive segments between checkpoints.
+ * @tree: Tree of thread, sharing input and output buffers of decoded tree.
+ * @index: Checkpoints of stream.
+ * @firstSegment: First decoded segment, segment k ends at checkpoint k.
+ * @lastSegment: Segment after last decoded segment.
+ * @numberOfPixels: Number of pixels of whole stream.
+ * @status: 0 if segments were decoded successfully, 1 otherwise.
+ */
+typedef struct segmentWorker {
+    tree* tree;
+    const checkpointIndex* index;
+    uint32_t firstSegment;
+    uint32_t lastSegment;
+    uint64_t numberOfPixels;
+    uint8_t status;
+} segmentWorker;
+
+/**
+  * @brief  Reads value stored on 8 bytes in big-endian order.
+  * @param  source pointer to first byte of value
+  * @retval Read value
+  */
+static uint64_t loadLong(const uint8_t* source)
+{
+    return ((uint64_t)loadBigEndian(source, 4) << 32) | loadBigEndian(&source[4], 4);
+}
+
+/**
+  * @brief  Stores value on given number of bytes in big-endian order.
+  * @param  destination pointer to first byte of value
+  * @param  value stored value
+  * @param  bytes number of bytes used to store value
+  * @retval None
+  */
+static void storeLong(uint8_t* destination, uint64_t value, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; i++)
+        destination[i] = (uint8_t)(value >> (BITS_IN_BYTE * (bytes - 1 - i)));
+}
+
+/**
+  * @brief  Reads varint: 7 bits per byte starting from least significant ones, highest bit
+  *         set in every byte except last.
+  * @param  data node data of checkpoint
+  * @param  length length of node data
+  * @param  position pointer to position of varint, moved past it
+  * @param  value pointer to variable receiving value
+  * @retval 0 if varint was read, 1 if it exceeds node data or 64 bits
+  */
+static uint8_t loadVarint(const uint8_t* data, uint32_t length, uint32_t* position, uint64_t* value)
+{
+    *value = 0;
+    for (uint8_t shift = 0; shift < 64 && *position < length; shift += 7) {
+        uint8_t byte = data[(*position)++];
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return 0;
+    }
+    return 1;
+}
+
+/**
+  * @brief  Stores varint, see loadVarint().
+  * @param  destination pointer to first byte of varint
+  * @param  value stored value
+  * @retval Number of bytes used
+  */
+static uint32_t storeVarint(uint8_t* destination, uint64_t value)
+{
+    uint32_t length = 0;
+    while (value > 0x7F) {
+        destination[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    destination[length++] = (uint8_t)value;
+    return length;
+}
+
+/**
+  * @brief  Reads nodes of checkpoint from node data.
+  * @param  this pointer to checkpoint with allocated nodes
+  * @param  data node data
+  * @param  length length of node data
+  * @param  bytesPerSample size of symbols of leaves
+  * @retval 0 if nodes form valid adaptive tree, 1 otherwise
+  */
+static uint8_t parseNodes(checkpoint* this, const uint8_t* data, uint32_t length, uint8_t bytesPerSample)
+{
+    uint32_t position = 0;
+    for (uint32_t i = 0; i < this->numberOfNodes; i++) {
+        uint64_t link, count;
+        if (loadVarint(data, length, &position, &link) || loadVarint(data, length, &position, &count) ||
+            (link >> 2) > UINT32_MAX)
+            return 1;
+        this->nodes[i].parent = (uint32_t)(link >> 2);
+        this->nodes[i].flags = link & (DICTIONARY_LEAF | DICTIONARY_LINK1);
+        this->nodes[i].count = count;
+        this->nodes[i].symbol = 0;
+        if ((link & DICTIONARY_LEAF) && i + 1 < this->numberOfNodes) {
+            if (length - position < bytesPerSample) return 1;
+            this->nodes[i].symbol = (uint16_t)loadBigEndian(&data[position], bytesPerSample);
+            position += bytesPerSample;
+        }
+    }
+    return position != length || validateNodes(this->nodes, this->numberOfNodes, bytesPerSample);
+}
+
+/**
+  * @brief  Reads checkpoints of index file and checks them against compressed file.
+  * @param  this pointer to index with allocated checkpoints
+  * @param  file index file positioned after its header
+  * @param  tree pointer to the tree struct with read header
+  * @retval 0 if every checkpoint is valid, 1 otherwise
+  */
+static uint8_t readCheckpoints(checkpointIndex* this, FILE* file, const tree* tree)
+{
+    uint64_t numberOfPixels = (uint64_t)tree->header.width * tree->header.height;
+    uint32_t maxNumberOfNodes = 2 * (tree->header.bytesPerSample == 1 ? 256 : 65536) + 1;
+    uint64_t bitOffset = tree->input->currentByte * BITS_IN_BYTE;
+    uint64_t pixel = 0;
+    uint8_t* data = (uint8_t*)malloc((size_t)maxNumberOfNodes * CHECKPOINT_NODE_MAX_LENGTH);
+    uint8_t status = !data;
+
+    for (uint32_t i = 0; i < this->numberOfCheckpoints && !status; i++) {
+        checkpoint* current = &this->checkpoints[i];
+        uint8_t header[CHECKPOINT_HEADER_LENGTH];
+        if (fread(header, 1, CHECKPOINT_HEADER_LENGTH, file) != CHECKPOINT_HEADER_LENGTH) {
+            status = 1;
+            break;
+        }
+        current->pixel = loadLong(&header[0]);
+        current->bitOffset = loadLong(&header[8]);
+        current->numberOfNodes = loadBigEndian(&header[16], 4);
+        uint32_t length = loadBigEndian(&header[20], 4);
+        // Checkpoints follow each other inside stream, tree holds at least one symbol
+        status = current->pixel <= pixel || current->pixel >= numberOfPixels || current->bitOffset < bitOffset ||
+                 current->bitOffset >= tree->input->lastByte * BITS_IN_BYTE || current->numberOfNodes < 3 ||
+                 !(current->numberOfNodes & 1) || current->numberOfNodes > maxNumberOfNodes ||
+                 length > current->numberOfNodes * CHECKPOINT_NODE_MAX_LENGTH;
+        if (status) break;
+        current->nodes = (dictionaryNode*)malloc(current->numberOfNodes * sizeof(dictionaryNode));
+        status = !current->nodes || fread(data, 1, length, file) != length ||
+                 parseNodes(current, data, length, tree->header.bytesPerSample);
+        pixel = current->pixel;
+        bitOffset = current->bitOffset;
+    }
+    free(data);
+    return status;
+}
+
+uint8_t attachIndex(tree* this, const char* indexPath, uint16_t threads)
+{
+    const uint8_t magic[] = INDEX_MAGIC;
+    uint8_t header[INDEX_HEADER_LENGTH];
+    if (this->header.mode != MODE_ADAPTIVE_HUFFMAN || this->header.channels > 1) {
+        printf("Indeks punktów kontrolnych obsługuje tylko jednokanałowe pliki adaptacyjne!\n");
+        return 1;
+    }
+    if (this->header.scanOrder != SCAN_ROW) {
+        printf("Indeks punktów kontrolnych wymaga skanowania wierszami!\n");
+        return 1;
+    }
+    FILE* file = fopen(indexPath, "rb");
+    if (!file) {
+        printf("Błąd podczas otwierania pliku indeksu!\n");
+        return 1;
+    }
+    if (fread(header, 1, INDEX_HEADER_LENGTH, file) != INDEX_HEADER_LENGTH ||
+        memcmp(header, magic, sizeof(magic)) || header[4] != INDEX_VERSION) {
+        printf("Nieobsługiwany plik indeksu!\n");
+        fclose(file);
+        return 1;
+    }
+    if (header[5] != this->header.bytesPerSample || loadLong(&header[8]) != this->input->lastByte) {
+        printf("Indeks nie pasuje do skompresowanego pliku!\n");
+        fclose(file);
+        return 1;
+    }
+    // Every checkpoint takes at least its header, so count from file is bounded by its length
+    // before checkpoints are allocated
+    uint32_t numberOfCheckpoints = loadBigEndian(&header[16], 4);
+    long fileLength = fseek(file, 0, SEEK_END) ? -1 : ftell(file);
+    if (fileLength < INDEX_HEADER_LENGTH || fseek(file, INDEX_HEADER_LENGTH, SEEK_SET) ||
+        numberOfCheckpoints > (uint64_t)(fileLength - INDEX_HEADER_LENGTH) / CHECKPOINT_HEADER_LENGTH) {
+        printf("Plik indeksu jest uszkodzony!\n");
+        fclose(file);
+        return 1;
+    }
+    checkpointIndex* loaded = (checkpointIndex*)calloc(1, sizeof(checkpointIndex));
+    if (loaded) {
+        loaded->numberOfCheckpoints = numberOfCheckpoints;
+        loaded->checkpoints = (checkpoint*)calloc(loaded->numberOfCheckpoints ? loaded->numberOfCheckpoints : 1, sizeof(checkpoint));
+    }
+    if (!loaded || !loaded->checkpoints) {
+        printf("Błąd podczas alokacji pamięci indeksu!\n");
+        releaseIndex(&loaded);
+        fclose(file);
+        return 1;
+    }
+    uint8_t status = readCheckpoints(loaded, file, this);
+    fclose(file);
+    if (status) {
+        printf("Plik indeksu jest uszkodzony!\n");
+        releaseIndex(&loaded);
+        return 1;
+    }
+#ifdef KODA_THREADS
+    if (!threads) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = processors > 0 ? (uint16_t)(processors < UINT16_MAX ? processors : UINT16_MAX) : 1;
+    }
+#else
+    threads = 1;
+#endif
+    loaded->threads = threads ? threads : 1;
+    this->index = loaded;
+    return 0;
+}
+
+/**
+  * @brief  Creates tree of thread, sharing buffers, header and dictionary of decoded tree.
+  *         Output buffer is reserved for whole image, so threads never reallocate it.
+  * @param  parent pointer to decoded tree
+  * @retval Pointer to created tree, NULL on memory allocation error
+  */
+static tree* createSegmentTree(const tree* parent)
+{
+    tree* this = (tree*)calloc(1, sizeof(tree));
+    bitBuffer* input = (bitBuffer*)malloc(sizeof(bitBuffer));
+    byteBuffer* output = (byteBuffer*)malloc(sizeof(byteBuffer));
+    if (!this || !input || !output) {
+        printf("Błąd podczas alokowania pamięci na strukturę drzewa!");
+        free(this);
+        free(input);
+        free(output);
+        return NULL;
+    }
+    *input = *parent->input;
+    *output = *parent->output;
+    this->input = input;
+    this->output = output;
+    this->header = parent->header;
+    this->dictionary = parent->dictionary;
+    this->baseNumberOfNodes = parent->baseNumberOfNodes;
+    return this;
+}
+
+/**
+  * @brief  Frees tree of thread, leaving buffers, output file and dictionary to decoded tree.
+  * @param  this address of pointer to tree of thread
+  * @retval None
+  */
+static void freeSegmentTree(tree** this)
+{
+    if (!*this) return;
+    (*this)->input->baseBuffer = NULL;
+    (*this)->output->baseBuffer = NULL;
+    memset(&(*this)->output->sink, 0, sizeof(outputSink));
+    (*this)->dictionary = NULL;
+    freeTree(this);
+}
+
+/**
+  * @brief  Decodes segments of worker, starting from its first checkpoint or from start of
+  *         stream, and checks that every segment ends at bit offset of next checkpoint.
+  * @param  this pointer to worker
+  * @retval 0 if segments were decoded successfully, 1 otherwise
+  */
+static uint8_t decodeSegments(segmentWorker* this)
+{
+    tree* tree = this->tree;
+    const checkpointIndex* index = this->index;
+    uint8_t bytesPerSample = tree->header.bytesPerSample;
+
+    if (!this->firstSegment) {
+        if (startAdaptive(tree)) return 1;
+    } else {
+        const checkpoint* start = &index->checkpoints[this->firstSegment - 1];
+        tree->input->currentByte = start->bitOffset / BITS_IN_BYTE;
+        tree->input->currentShift = start->bitOffset % BITS_IN_BYTE;
+        tree->output->currentByte = start->pixel * bytesPerSample;
+        if (restoreTree(tree, start->nodes, start->numberOfNodes)) return 1;
+    }
+    for (uint32_t segment = this->firstSegment; segment < this->lastSegment; segment++) {
+        uint8_t last = segment == index->numberOfCheckpoints;
+        const checkpoint* end = &index->checkpoints[segment];
+        if (resumeAdaptive(tree, (last ? this->numberOfPixels : end->pixel) * bytesPerSample)) return 1;
+        if (!last && tree->input->currentByte * BITS_IN_BYTE + tree->input->currentShift != end->bitOffset) {
+            printf("Punkt kontrolny %u nie pasuje do skompresowanego pliku!\n", segment);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#ifdef KODA_THREADS
+/**
+  * @brief  Thread entry point, decodes segments of worker.
+  * @param  argument pointer to worker
+  * @retval NULL
+  */
+static void* runWorker(void* argument)
+{
+    segmentWorker* this = (segmentWorker*)argument;
+    this->status = decodeSegments(this);
+    return NULL;
+}
+#endif
+
+uint8_t decodeFromCheckpoints(tree* this)
+{
+    const checkpointIndex* index = this->index;
+    uint32_t numberOfSegments = index->numberOfCheckpoints + 1;
+    uint32_t numberOfWorkers = index->threads < numberOfSegments ? index->threads : numberOfSegments;
+    segmentWorker* workers = (segmentWorker*)calloc(numberOfWorkers, sizeof(segmentWorker));
+    if (!workers) {
+        printf("Błąd podczas alokowania pamięci na wątki!\n");
+        return 1;
+    }
+
+    // Every worker decodes consecutive segments, so it restores tree only once
+    uint8_t status = 0;
+    for (uint32_t i = 0; i < numberOfWorkers && !status; i++) {
+        workers[i].index = index;
+        workers[i].firstSegment = (uint32_t)((uint64_t)numberOfSegments * i / numberOfWorkers);
+        workers[i].lastSegment = (uint32_t)((uint64_t)numberOfSegments * (i + 1) / numberOfWorkers);
+        workers[i].numberOfPixels = (uint64_t)this->header.width * this->header.height;
+        workers[i].tree = createSegmentTree(this);
+        status = !workers[i].tree;
+    }
+#ifdef KODA_THREADS
+    // First worker runs on calling thread
+    pthread_t* threads = (pthread_t*)calloc(numberOfWorkers, sizeof(pthread_t));
+    uint32_t started = 1;
+    if (!status && !threads) {
+        printf("Błąd podczas alokowania pamięci na wątki!\n");
+        status = 1;
+    }
+    for (; started < numberOfWorkers && !status; started++) {
+        if (pthread_create(&threads[started], NULL, runWorker, &workers[started])) {
+            printf("Błąd podczas uruchamiania wątku!\n");
+            status = 1;
+            break;
+        }
+    }
+    if (!status)
+        workers[0].status = decodeSegments(&workers[0]);
+    for (uint32_t i = 1; i < started; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+#else
+    for (uint32_t i = 0; i < numberOfWorkers && !status; i++)
+        workers[i].status = decodeSegments(&workers[i]);
+#endif
+
+    for (uint32_t i = 0; i < numberOfWorkers; i++) {
+        status |= workers[i].status;
+        freeSegmentTree(&workers[i].tree);
+    }
+    free(workers);
+    if (status) return 1;
+    // Segments were written in place, output holds whole image now
+    this->output->currentByte = (uint64_t)this->header.width * this->header.height * this->header.bytesPerSample;
+    return 0;
+}
+
+/**
+  * @brief  Writes checkpoint with current tree and input position to index.
+  * @param  this pointer to the tree struct
+  * @param  file index file
+  * @param  pixel number of decoded pixels
+  * @param  data buffer for node data of largest tree of alphabet
+  * @retval 0 if checkpoint was written, 1 otherwise
+  */
+static uint8_t writeCheckpoint(tree* this, FILE* file, uint64_t pixel, uint8_t* data)
+{
+    uint8_t header[CHECKPOINT_HEADER_LENGTH];
+    uint32_t length = 0;
+    for (uint32_t i = 0; i <= this->lastNode; i++) {
+        const node* _node = this->nodes[i];
+        uint64_t link = _node->link0 ? 0 : DICTIONARY_LEAF;
+        if (_node->parent) {
+            link |= (uint64_t)_node->parent->positionInTree << 2;
+            if (_node->parent->link1 == _node) link |= DICTIONARY_LINK1;
+        }
+        length += storeVarint(&data[length], link);
+        length += storeVarint(&data[length], _node->count);
+        if (!_node->link0 && i < this->lastNode) {
+            storeLong(&data[length], _node->value, this->header.bytesPerSample);
+            length += this->header.bytesPerSample;
+        }
+    }
+    storeLong(&header[0], pixel, 8);
+    storeLong(&header[8], this->input->currentByte * BITS_IN_BYTE + this->input->currentShift, 8);
+    storeLong(&header[16], this->lastNode + 1, 4);
+    storeLong(&header[20], length, 4);
+    return fwrite(header, 1, CHECKPOINT_HEADER_LENGTH, file) != CHECKPOINT_HEADER_LENGTH ||
+           fwrite(data, 1, length, file) != length;
+}
+
+uint8_t buildIndex(tree* this, const char* indexPath, uint64_t interval)
+{
+    const uint8_t magic[] = INDEX_MAGIC;
+    uint8_t header[INDEX_HEADER_LENGTH] = { 0 };
+    uint64_t numberOfPixels = (uint64_t)this->header.width * this->header.height;
+    uint8_t bytesPerSample = this->header.bytesPerSample;
+    uint32_t numberOfCheckpoints = 0;
+
+    if (this->header.mode != MODE_ADAPTIVE_HUFFMAN || this->header.channels > 1) {
+        printf("Indeks punktów kontrolnych obsługuje tylko jednokanałowe pliki adaptacyjne!\n");
+        return 1;
+    }
+    if (this->header.scanOrder != SCAN_ROW) {
+        printf("Indeks punktów kontrolnych wymaga skanowania wierszami!\n");
+        return 1;
+    }
+    if (this->header.dictionaryId && !this->dictionary) {
+        printf("Plik skompresowano ze słownikiem %04x, podaj go opcją --dictionary!\n", this->header.dictionaryId);
+        return 1;
+    }
+    if (this->output->sink.type != OUTPUT_STREAM && reserveBytes(this->output, numberOfPixels * bytesPerSample)) return 1;
+    uint8_t* data = (uint8_t*)malloc((size_t)(2 * (bytesPerSample == 1 ? 256 : 65536) + 1) * CHECKPOINT_NODE_MAX_LENGTH);
+    FILE* file = fopen(indexPath, "wb");
+    if (!data || !file) {
+        printf("Błąd podczas tworzenia pliku indeksu!\n");
+        free(data);
+        if (file) fclose(file);
+        return 1;
+    }
+
+    // Header is written again when number of checkpoints is known
+    uint8_t status = fwrite(header, 1, INDEX_HEADER_LENGTH, file) != INDEX_HEADER_LENGTH || startAdaptive(this);
+    for (uint64_t pixel = interval; pixel < numberOfPixels && !status; pixel += interval) {
+        status = resumeAdaptive(this, pixel * bytesPerSample) || writeCheckpoint(this, file, pixel, data);
+        numberOfCheckpoints++;
+    }
+    status = status || resumeAdaptive(this, numberOfPixels * bytesPerSample);
+    memcpy(header, magic, sizeof(magic));
+    header[4] = INDEX_VERSION;
+    header[5] = bytesPerSample;
+    storeLong(&header[8], this->input->lastByte, 8);
+    storeLong(&header[16], numberOfCheckpoints, 4);
+    status = status || fseek(file, 0, SEEK_SET) || fwrite(header, 1, INDEX_HEADER_LENGTH, file) != INDEX_HEADER_LENGTH;
+    status = fclose(file) || status;
+    free(data);
+    if (status) {
+        printf("Błąd podczas zapisu pliku indeksu!\n");
+        return 1;
+    }
+    return 0;
+}
+
+void releaseIndex(checkpointIndex** this)
+{
+    if (!*this) return;
+    if ((*this)->checkpoints)
+        for (uint32_t i = 0; i < (*this)->numberOfCheckpoints; i++)
+            free((*this)->checkpoints[i].nodes);
+    free((*this)->checkpoints);
+    free(*this);
+    *this = NULL;
+}
@@ -0,0 +1,84 @@
+#ifndef CHECKPOINT_DECODER_H
+#define CHECKPOINT_DECODER_H
+
+// Checkpoint index: magic, version, bytes per sample, two reserved bytes, length of compressed
+// file (8 bytes) and number of checkpoints (4 bytes), followed by checkpoints in order of pixels
+#define INDEX_MAGIC { 0x8B, 'K', 'D', 'X' }
+#define INDEX_VERSION 1
+#define INDEX_HEADER_LENGTH 20
+// Checkpoint: pixel (8 bytes), bit offset in compressed file (8 bytes), number of nodes
+// (4 bytes) and length of node data (4 bytes), followed by node data. Every node is varint of
+// parent position shifted by two with DICTIONARY_LINK1 and DICTIONARY_LEAF flags, varint of
+// count and, for leaves other than NewSymbol node, symbol on bytes per sample bytes.
+#define CHECKPOINT_HEADER_LENGTH 24
+#define CHECKPOINT_NODE_MAX_LENGTH 17
+#define DEFAULT_CHECKPOINT_INTERVAL (1 << 20)
+
+#include "decoderOperations.h"
+#include "dictionaryDecoder.h"
+
+/**
+ * @brief:  State of adaptive stream after given number of pixels.
+ * @pixel: Number of pixels decoded before checkpoint.
+ * @bitOffset: Position of next symbol in compressed file, in bits from start of file.
+ * @nodes: Tree after last decoded pixel, in order of position in tree.
+ * @numberOfNodes: Number of nodes of tree.
+ */
+typedef struct checkpoint {
+    uint64_t pixel;
+    uint64_t bitOffset;
+    dictionaryNode* nodes;
+    uint32_t numberOfNodes;
+} checkpoint;
+
+/**
+ * @brief:  Checkpoints of single adaptive stream, stream between neighbouring checkpoints is
+ *          decoded independently of the rest of it.
+ * @checkpoints: Checkpoints in order of pixels.
+ * @numberOfCheckpoints: Number of checkpoints.
+ * @threads: Number of threads stream is decoded with.
+ */
+typedef struct checkpointIndex {
+    checkpoint* checkpoints;
+    uint32_t numberOfCheckpoints;
+    uint16_t threads;
+} checkpointIndex;
+
+/**
+  * @brief  Reads checkpoint index of compressed file, decodeData() then decodes stream
+  *         between checkpoints in parallel. Index must describe compressed file of the same
+  *         length with single channel adaptive stream.
+  * @param  this pointer to the tree struct with read header
+  * @param  indexPath path to checkpoint index
+  * @param  threads number of threads, 0 for number of processors
+  * @retval 0 if index was loaded, 1 otherwise
+  */
+uint8_t attachIndex(tree* this, const char* indexPath, uint16_t threads);
+
+/**
+  * @brief  Decodes adaptive stream with threads started at checkpoints, every thread writes
+  *         its pixels directly to their place in output. Each thread checks that it ends
+  *         exactly at bit offset of next checkpoint.
+  * @param  this pointer to the tree struct with attached index and reserved output
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t decodeFromCheckpoints(tree* this);
+
+/**
+  * @brief  Decodes single channel adaptive stream sequentially and writes checkpoint every
+  *         given number of pixels, so file compressed before can be decoded in parallel.
+  * @param  this pointer to the tree struct with read header
+  * @param  indexPath path to created checkpoint index
+  * @param  interval number of pixels between checkpoints
+  * @retval 0 if data was decompressed and index written, 1 otherwise
+  */
+uint8_t buildIndex(tree* this, const char* indexPath, uint64_t interval);
+
+/**
+  * @brief  Frees checkpoint index and its trees.
+  * @param  this address of pointer to index, set to NULL afterwards
+  * @retval None
+  */
+void releaseIndex(checkpointIndex** this);
+
+#endif // CHECKPOINT_DECODER_H
@@ -1,4 +1,24 @@
 #include "decoderOperations.h"
+#include "staticDecoder.h"
+#include "periodicDecoder.h"
+#include "runLengthDecoder.h"
+#include "rangeDecoder.h"
+#include "tileDecoder.h"
+#include "bitPlaneDecoder.h"
+#include "dictionaryDecoder.h"
+#include "checkpointDecoder.h"
+#include "outputSink.h"
+
+/**
+ * @brief  Returns size of symbols of adaptive code: 2 bytes for 16 bit samples and for pairs
+ *         of 8 bit samples, 1 byte otherwise.
+ * @param  this pointer to tree with read header
+ * @retval Number of bytes of symbol
+ */
+static inline uint8_t symbolBytes(const tree* this)
+{
+    return this->header.bytesPerSample > 1 || this->header.mode == MODE_PAIR_HUFFMAN ? 2 : 1;
+}
 
 /**
  * @brief  Expands the memory pointers by reallocating memory for the array of node pointers.
@@ -8,7 +28,7 @@
  * @param  None
  * @retval 0 if successfully allocated new space, 1 if memory allocation fails
  */
-uint8_t expandPointersArray(tree* this)
+static uint8_t expandPointersArray(tree* this)
 {
     node** newArray = (node**)malloc((this->memoryBlockMultiplier + BASE_ARRAY_ENTRIES) * sizeof(node*));
     if (!newArray) {
@@ -30,14 +50,14 @@ uint8_t expandPointersArray(tree* this)
  * @param  None
  * @retval 0 if successfully allocated new space, 1 if memory allocation fails
  */
-uint8_t expandNodes(tree* this)
+static uint8_t expandNodes(tree* this)
 {
     // Expand array of pointers if necesarry 
     if (this->memoryBlockMultiplier % BASE_ARRAY_ENTRIES == 0) 
         if (expandPointersArray(this)) return 1;
 
-    uint16_t currentNumberOfNodes = this->baseNumberOfNodes * this->memoryBlockMultiplier;
-    node** newNodes = (node**)malloc(this->baseNumberOfNodes * (this->memoryBlockMultiplier + 1) * sizeof(node*));
+    uint32_t currentNumberOfNodes = (uint32_t)this->baseNumberOfNodes * this->memoryBlockMultiplier;
+    node** newNodes = (node**)malloc((size_t)this->baseNumberOfNodes * (this->memoryBlockMultiplier + 1) * sizeof(node*));
     if (!newNodes) {
         printf("Błąd podczas alokowania pamięci na nową tablicę wskaźników do węzłów");
         return 1;
@@ -64,11 +84,11 @@ uint8_t expandNodes(tree* this)
     return 0;
 }
 
-void freeAlocatedMemory(tree** this)
+void freeTree(tree** this)
 {
     // Free memory used for nodes array
     if ((*this)->nodes) {
-        for (uint16_t i = 0; i < (*this)->memoryBlockMultiplier; i++)
+        for (uint32_t i = 0; i < (*this)->memoryBlockMultiplier; i++)
             free((*this)->memoryPointers[i]);
         // Free memory for node struct pointers
         free((*this)->nodes);
@@ -76,30 +96,156 @@ void freeAlocatedMemory(tree** this)
     }
     free((*this)->memoryPointers);
     (*this)->memoryPointers = NULL;
-    (*this)->input->killMe(&(*this)->input);
-    (*this)->output->killMe(&(*this)->output);
+    if ((*this)->input)
+        (*this)->input->killMe(&(*this)->input);
+    if ((*this)->output)
+        (*this)->output->killMe(&(*this)->output);
+    releaseDictionary(&(*this)->dictionary);
+    releaseIndex(&(*this)->index);
     (*this)->baseNumberOfNodes = 0;
     (*this)->lastNode = 0;
     (*this)->memoryBlockMultiplier = 0;
+    free(*this);
     (*this) = NULL;
 }
 
-tree* createTree()
+/**
+  * @brief  Allocates first nodes for alphabet of image described by header and checks its
+  *         coding mode. Nodes left from image with other sample size are freed first.
+  * @param  this pointer to tree with read header
+  * @retval 0 on success, 1 if memory allocation fails or mode is not supported
+  */
+static uint8_t prepareNodes(tree* this)
+{
+    // Alphabet of 16 bit samples and of pairs needs much larger tree
+    uint16_t baseNumberOfNodes = symbolBytes(this) > 1 ? WIDE_NODES_ENTRIES : BASE_NODES_ENTRIES;
+    if (this->nodes && this->baseNumberOfNodes != baseNumberOfNodes) {
+        for (uint32_t i = 0; i < this->memoryBlockMultiplier; i++)
+            free(this->memoryPointers[i]);
+        free(this->nodes);
+        free(this->memoryPointers);
+        this->nodes = NULL;
+        this->memoryPointers = NULL;
+        this->memoryBlockMultiplier = 0;
+    }
+    this->baseNumberOfNodes = baseNumberOfNodes;
+    if (!this->nodes && expandNodes(this)) return 1;
+    uint8_t byteSamplesOnly = this->header.mode == MODE_PAIR_HUFFMAN || this->header.mode == MODE_BIT_PLANE;
+    if (this->header.mode > MODE_PERIODIC_HUFFMAN || (byteSamplesOnly && this->header.bytesPerSample > 1)) {
+        printf("Nieobsługiwany tryb kodowania: %u!\n", this->header.mode);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+  * @brief  Creates tree decoding given input: reads header and allocates first nodes.
+  * @param  input pointer to loaded compressed data, owned by tree afterwards
+  * @retval Pointer to tree, NULL on error
+  */
+static tree* startTree(bitBuffer* input)
 {
     tree* this = malloc(sizeof(tree));
     if (!this) {
         printf("Błąd podczas alokowania pamięci na strukturę drzewa!");
+        if (input) input->killMe(&input);
         return NULL;
     }
     this->memoryPointers = NULL;
     this->nodes = NULL;
-    this->input = createBitBuffer(BASE_BUFFER_SIZE);
+    this->dictionary = NULL;
+    this->index = NULL;
+    this->input = input;
     this->output = createByteBuffer(BASE_BUFFER_SIZE);
     this->baseNumberOfNodes = BASE_NODES_ENTRIES;
     this->memoryBlockMultiplier = 0;
     this->lastNode = 0;
-    expandNodes(this);
+    if (!this->input || !this->output || readHeader(this->input, &this->header) || prepareNodes(this)) {
+        freeTree(&this);
+        return NULL;
+    }
+    return this;
+}
+
+tree* createTree(const char* inputPath)
+{
+    return startTree(createBitBuffer(BASE_BUFFER_SIZE, inputPath));
+}
+
+tree* createTreeFromMemory(const uint8_t* data, uint64_t length)
+{
+    return startTree(createBitBufferFromMemory(BASE_BUFFER_SIZE, data, length));
+}
+
+uint8_t restartTree(tree* this, const uint8_t* data, uint64_t length)
+{
+    releaseDictionary(&this->dictionary);
+    releaseIndex(&this->index);
+    this->lastNode = 0;
+    return resetByteBuffer(this->output) || reloadBitBuffer(this->input, data, length) ||
+           readHeader(this->input, &this->header) || prepareNodes(this);
+}
+
+/**
+  * @brief  Reads value of symbol sent for the first time, 8 or 16 bits depending on symbol size.
+  * @param  pointer to the tree struct
+  * @retval Symbol value
+  */
+static uint16_t popLiteral(tree* this)
+{
+    uint16_t value = this->input->popSymbol(this->input);
+    if (symbolBytes(this) > 1)
+        value = (value << BITS_IN_BYTE) | this->input->popSymbol(this->input);
+    return value;
+}
+
+/**
+  * @brief  Appends symbol to output, 16 bit samples and pairs in big-endian order.
+  * @param  pointer to the tree struct
+  * @param  value Symbol value
+  * @retval 0 on success, 1 if output could not grow or streamed window could not be written
+  */
+static uint8_t appendSample(tree* this, uint16_t value)
+{
+    if (symbolBytes(this) > 1 && this->output->appendByte(this->output, value >> BITS_IN_BYTE)) return 1;
+    return this->output->appendByte(this->output, (uint8_t)value);
+}
+
+uint8_t restoreTree(tree* this, const dictionaryNode* nodes, uint32_t numberOfNodes)
+{
+    while ((uint32_t)this->baseNumberOfNodes * this->memoryBlockMultiplier <= numberOfNodes + 2)
+        if (expandNodes(this)) return 1;
 
+    for (uint32_t i = 0; i < numberOfNodes; i++) {
+        node* _node = this->nodes[i];
+        _node->count = nodes[i].count;
+        _node->value = nodes[i].symbol;
+        _node->positionInTree = i;
+        _node->link0 = NULL;
+        _node->link1 = NULL;
+        _node->parent = i ? this->nodes[nodes[i].parent] : NULL;
+        if (!i) continue;
+        if (nodes[i].flags & DICTIONARY_LINK1)
+            _node->parent->link1 = _node;
+        else
+            _node->parent->link0 = _node;
+    }
+    this->lastNode = numberOfNodes - 1;
+    return 0;
+}
+
+/**
+  * @brief  Creates base tree consisting of root, first symbol from stream and NewSymbol node,
+  *         and appends first symbol to output. With dictionary tree is copied from trained
+  *         tree instead and nothing is read. Memory of previous tree is reused.
+  * @param  pointer to the tree struct with allocated nodes
+  * @retval 0 if tree was created, 1 if memory allocation fails
+  */
+static uint8_t resetTree(tree* this)
+{
+    if (this->dictionary)
+        return restoreTree(this, this->dictionary->nodes, this->dictionary->numberOfNodes);
+    this->lastNode = 0;
     node* root =  this->nodes[this->lastNode];
     node* symbol0 = this->nodes[++this->lastNode];
     node* newSymbol = this->nodes[++this->lastNode];
@@ -125,21 +271,11 @@ tree* createTree()
     symbol0->positionInTree = 1;
 
     this->input->popBit(this->input); // Path to first symbol (0)...
-    symbol0->value = this->input->popSymbol(this->input); // Followed by bit representation
-    this->output->appendByte(this->output, symbol0->value);
-
-    return this;
-}
-
-/**
-  * @brief  Function checks if it is necesarry to reallocate memory and if so, calls expandTree()
-  * @param None
-  * @retval 1 if failed to reallocate memory, 0 otherwise
-  */
-uint8_t memoryCheck(tree* this)
-{
-    if ((this->lastNode + 2) >= this->baseNumberOfNodes * this->memoryBlockMultiplier) 
-        if (expandNodes(this)) return 1;
+    symbol0->value = popLiteral(this); // Followed by bit representation
+    if (appendSample(this, symbol0->value)) {
+        printf("Błąd podczas zapisywania danych do pliku!\n");
+        return 1;
+    }
     return 0;
 }
 
@@ -150,13 +286,21 @@ uint8_t memoryCheck(tree* this)
   * @param  Node Address of node that we will increment
   * @retval address of "parent" node of newly created node after swap, to further tree reorganization
   */
-node* rearrangeTree(tree* this, node* _node)
+static node* rearrangeTree(tree* this, node* _node)
 {
-    uint16_t tempAddress = _node->positionInTree;
+    // Counts never grow with position in tree, so first node of the same count is found with
+    // binary search, which keeps large alphabets with many equal counts fast
+    uint32_t tempAddress = _node->positionInTree;
     node* incrementedNode = this->nodes[tempAddress];
-
-    while (incrementedNode->count == this->nodes[tempAddress - 1]->count) 
-        tempAddress--;
+    uint32_t lowestAddress = 0;
+
+    while (lowestAddress < tempAddress) {
+        uint32_t middle = lowestAddress + (tempAddress - lowestAddress) / 2;
+        if (this->nodes[middle]->count == incrementedNode->count)
+            tempAddress = middle;
+        else
+            lowestAddress = middle + 1;
+    }
     
     incrementedNode->count++;
     node* nodeToSwap = this->nodes[tempAddress];
@@ -194,7 +338,7 @@ node* rearrangeTree(tree* this, node* _node)
   * @param  newValue new symbol registered in data stream (records) not present in SymbolCache
   * @retval address of "parent" node of newly created parent node, to further tree reorganization
   */
-node* addNewSymbol(tree* this, uint8_t newValue)
+static node* addNewSymbol(tree* this, uint16_t newValue)
 {
 
 node* newParentNode = this->nodes[this->lastNode];
@@ -223,36 +367,270 @@ newParentNode->link1 = newSymbolNode;
 return newParentNode->parent;
 }
 
-node* retrieveSymbol(tree* this)
+uint8_t startAdaptive(tree* this)
 {
-    // Start from root -> nodes[0]
-    node* node = this->nodes[0];
-    // While node == internal node
-    while (node->link0 != NULL) {
-        uint8_t bit = this->input->popBit(this->input);
-        if (bit)
-            node = node->link1;
-        else 
-            node = node->link0;
+    if (this->input->currentByte >= this->input->lastByte) {
+        printf("Skompresowany plik jest niekompletny!\n");
+        return 1;
     }
-    if (node == this->nodes[this->lastNode]) {
-        uint8_t newSymbolValue = this->input->popSymbol(this->input);
-        this->output->appendByte(this->output, newSymbolValue);
-        return addNewSymbol(this, newSymbolValue);
+    if (!this->nodes && expandNodes(this)) return 1;
+    return resetTree(this);
+}
+
+/**
+  * @brief  Reads next bit of compressed stream, starting from the most significant bit of
+  *         byte. Bits past the end of stream are read as 0 and position stays at the end.
+  * @param  data compressed stream
+  * @param  lastByte length of compressed stream
+  * @param  currentByte pointer to position of currently read byte
+  * @param  currentShift pointer to position of currently read bit in byte
+  * @retval Read bit
+  */
+KODA_INLINE uint8_t nextBit(const uint8_t* data, uint64_t lastByte, uint64_t* currentByte, uint8_t* currentShift)
+{
+    if (*currentByte >= lastByte) return 0;
+    uint8_t bit = (data[*currentByte] >> (BITS_IN_BYTE - 1 - *currentShift)) & 1;
+    if (++*currentShift == BITS_IN_BYTE) {
+        *currentShift = 0;
+        (*currentByte)++;
+    }
+    return bit;
+}
+
+/**
+  * @brief  Stores byte of decoded sample in output, window of streamed output is written to
+  *         file when full.
+  * @param  output pointer to output buffer
+  * @param  pixels data of output buffer
+  * @param  outputByte pointer to position of stored byte in output
+  * @param  byte stored byte
+  * @param  streamed 1 if output is streamed, constant of kernel
+  * @retval 0 on success, 1 if full window could not be written
+  */
+KODA_INLINE uint8_t storeByte(byteBuffer* output, uint8_t* pixels, uint64_t* outputByte, uint8_t byte, const uint8_t streamed)
+{
+    if (!streamed) {
+        pixels[(*outputByte)++] = byte;
+        return 0;
     }
-    this->output->appendByte(this->output, node->value);   
-    return node;
+    pixels[(*outputByte)++ - output->sink.flushedBytes] = byte;
+    if (*outputByte - output->sink.flushedBytes < output->sink.capacity) return 0;
+    output->currentByte = *outputByte;
+    return flushOutputWindow(output);
 }
 
-uint8_t constructTree(tree* this)
+/**
+  * @brief  Adaptive Huffman decoding loop, specialised by kernels below for every sample size
+  *         and kind of output. Both are constants of kernel, so their branches, tree memory
+  *         block size and buffer functions are resolved at compile time and stream position
+  *         stays in registers.
+  * @param  this pointer to the tree struct with started tree and reserved output
+  * @param  lastPixel position in output buffer decoding stops at
+  * @param  bytesPerSample size of samples, constant of kernel
+  * @param  streamed 1 if output is streamed, constant of kernel
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+KODA_INLINE uint8_t adaptiveKernel(tree* this, uint64_t lastPixel, const uint8_t bytesPerSample, const uint8_t streamed)
 {
-    node* node;
-    while (this->input->lastByte > this->input->currentByte) {
-        if (memoryCheck(this)) return 1;
-        node = retrieveSymbol(this);
+    const uint32_t nodesEntries = bytesPerSample == 1 ? BASE_NODES_ENTRIES : WIDE_NODES_ENTRIES;
+    const uint8_t* data = this->input->baseBuffer->dataBuffer;
+    const uint64_t lastByte = this->input->lastByte;
+    uint64_t currentByte = this->input->currentByte;
+    uint8_t currentShift = this->input->currentShift;
+    uint8_t* pixels = this->output->baseBuffer->dataBuffer;
+    uint64_t outputByte = this->output->currentByte;
+    uint8_t status = 0;
+
+    // Padding bits of last byte must not be decoded as symbols, so stop after last pixel
+    while (outputByte < lastPixel) {
+        if (currentByte >= lastByte) {
+            printf("Skompresowany plik jest niekompletny!\n");
+            status = 1;
+            break;
+        }
+        if (this->lastNode + 2 >= nodesEntries * this->memoryBlockMultiplier && expandNodes(this)) {
+            status = 1;
+            break;
+        }
+        node* node = this->nodes[0];
+        while (node->link0)
+            node = nextBit(data, lastByte, &currentByte, &currentShift) ? node->link1 : node->link0;
+
+        // NewSymbol node is followed by value of symbol sent for the first time
+        uint16_t value = node->value;
+        uint8_t newSymbol = node == this->nodes[this->lastNode];
+        if (newSymbol) {
+            // Tree of full alphabet has 2 * alphabet + 1 nodes, so stream sending symbols again
+            // as new ones is damaged and must not grow tree without bound
+            if (this->lastNode + 2 > 2u << (BITS_IN_BYTE * bytesPerSample)) {
+                printf("Skompresowany plik jest uszkodzony!\n");
+                status = 1;
+                break;
+            }
+            value = 0;
+            for (uint8_t i = 0; i < BITS_IN_BYTE * bytesPerSample; i++)
+                value = (uint16_t)((value << 1) | nextBit(data, lastByte, &currentByte, &currentShift));
+        }
+        // Decoding stops at first window that could not be written
+        if ((bytesPerSample > 1 && storeByte(this->output, pixels, &outputByte, (uint8_t)(value >> BITS_IN_BYTE), streamed)) ||
+            storeByte(this->output, pixels, &outputByte, (uint8_t)value, streamed)) {
+            printf("Błąd podczas zapisywania danych do pliku!\n");
+            status = 1;
+            break;
+        }
+
+        if (newSymbol)
+            node = addNewSymbol(this, value);
         this->nodes[0]->count++;
         while (node->parent != NULL)
             node = rearrangeTree(this, node);
     }
+    this->input->currentByte = currentByte;
+    this->input->currentShift = currentShift;
+    this->output->currentByte = outputByte;
+    return status;
+}
+
+#define ADAPTIVE_KERNEL(name, bytesPerSample, streamed) \
+    static uint8_t name(tree* this, uint64_t lastPixel) { return adaptiveKernel(this, lastPixel, bytesPerSample, streamed); }
+ADAPTIVE_KERNEL(decodeByteSamples, 1, 0)
+ADAPTIVE_KERNEL(decodeWideSamples, 2, 0)
+ADAPTIVE_KERNEL(streamByteSamples, 1, 1)
+ADAPTIVE_KERNEL(streamWideSamples, 2, 1)
+
+uint8_t resumeAdaptive(tree* this, uint64_t lastPixel)
+{
+    // Kernel is chosen once per block, it writes to output without growing it
+    if (this->output->sink.type == OUTPUT_STREAM)
+        return symbolBytes(this) == 1 ? streamByteSamples(this, lastPixel) : streamWideSamples(this, lastPixel);
+    if (reserveBytes(this->output, lastPixel)) return 1;
+    return symbolBytes(this) == 1 ? decodeByteSamples(this, lastPixel) : decodeWideSamples(this, lastPixel);
+}
+
+/**
+  * @brief: Decodes data compressed with adaptive Huffman code, starting from base tree and
+  *         updating tree after each symbol exactly as coder did.
+  * @param  pointer to the tree struct containing the Huffman tree.
+  * @param  numberOfSymbols number of symbols appended to output, samples or pairs of them
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+static uint8_t decodeAdaptive(tree* this, uint64_t numberOfSymbols)
+{
+    uint64_t lastPixel = this->output->currentByte + numberOfSymbols * symbolBytes(this);
+    return startAdaptive(this) || resumeAdaptive(this, lastPixel);
+}
+
+/**
+  * @brief: Decodes pairs of 8 bit samples coded as single symbols with adaptive Huffman code.
+  *         Odd number of samples ends with pair padded with 0, which does not fit in output
+  *         of exact image size, so such block is decoded into spare buffer and copied.
+  * @param  pointer to the tree struct containing the Huffman tree.
+  * @param  numberOfPixels number of pixels appended to output
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+static uint8_t decodePairs(tree* this, uint64_t numberOfPixels)
+{
+    if (this->header.mode != MODE_PAIR_HUFFMAN) {
+        printf("Skompresowany plik jest uszkodzony!\n");
+        return 1;
+    }
+    if (!(numberOfPixels & 1))
+        return decodeAdaptive(this, numberOfPixels / 2);
+
+    byteBuffer* output = this->output;
+    byteBuffer* pairs = createByteBuffer(BASE_BUFFER_SIZE);
+    if (!pairs) return 1;
+    this->output = pairs;
+    uint8_t status = decodeAdaptive(this, numberOfPixels / 2 + 1);
+    this->output = output;
+    status = status || reserveBytes(output, output->currentByte + numberOfPixels);
+    if (!status) {
+        memcpy(&output->baseBuffer->dataBuffer[output->currentByte], pairs->baseBuffer->dataBuffer, numberOfPixels);
+        output->currentByte += numberOfPixels;
+    }
+    pairs->killMe(&pairs);
+    return status;
+}
+
+/**
+  * @brief: Copies pixels stored without coding to output buffer.
+  * @param  pointer to the tree struct holding input and output buffers.
+  * @param  numberOfPixels number of pixels appended to output
+  * @retval 0 if all pixels were copied, 1 if file is incomplete or on memory allocation error
+  */
+static uint8_t decodeStored(tree* this, uint64_t numberOfPixels)
+{
+    numberOfPixels *= this->header.bytesPerSample;
+    if (this->input->lastByte - this->input->currentByte < numberOfPixels) {
+        printf("Skompresowany plik jest niekompletny!\n");
+        return 1;
+    }
+    if (reserveBytes(this->output, this->output->currentByte + numberOfPixels)) return 1;
+    memcpy(&this->output->baseBuffer->dataBuffer[this->output->currentByte],
+           &this->input->baseBuffer->dataBuffer[this->input->currentByte], numberOfPixels);
+    this->output->currentByte += numberOfPixels;
+    this->input->currentByte += numberOfPixels;
     return 0;
+}
+
+uint8_t decodeBlock(tree* this, uint8_t mode, uint64_t numberOfPixels)
+{
+    switch (mode) {
+    case MODE_ADAPTIVE_HUFFMAN:
+    case MODE_PAIR_HUFFMAN:
+        if (mode == MODE_PAIR_HUFFMAN ? decodePairs(this, numberOfPixels) : decodeAdaptive(this, numberOfPixels)) return 1;
+        // Next block starts at byte boundary
+        if (this->input->currentShift) {
+            this->input->currentByte++;
+            this->input->currentShift = 0;
+        }
+        return 0;
+    case MODE_STATIC_HUFFMAN:
+        return decodeStatic(this, numberOfPixels);
+    case MODE_PERIODIC_HUFFMAN:
+        return decodePeriodic(this, numberOfPixels);
+    case MODE_STORED:
+        return decodeStored(this, numberOfPixels);
+    case MODE_RANGE:
+        return decodeRange(this, numberOfPixels);
+    case MODE_RUN_LENGTH:
+        return decodeRunLength(this, numberOfPixels);
+    case MODE_BIT_PLANE:
+        return decodeBitPlanes(this, numberOfPixels);
+    default:
+        printf("Nieobsługiwany tryb kodowania: %u!\n", mode);
+        return 1;
+    }
+}
+
+uint8_t decodeData(tree* this)
+{
+    uint64_t numberOfPixels = (uint64_t)this->header.width * this->header.height;
+
+    if (this->header.dictionaryId && !this->dictionary) {
+        printf("Plik skompresowano ze słownikiem %04x, podaj go opcją --dictionary!\n", this->header.dictionaryId);
+        return 1;
+    }
+
+    // Output is reserved once, so it is not copied while it grows. Streamed output is written
+    // while single adaptive block is decoded and needs no reservation.
+    if (this->output->sink.type == OUTPUT_STREAM) {
+        if (preferredOutput(&this->header, this->index != NULL) != OUTPUT_STREAM) {
+            printf("Wyjście strumieniowe wymaga dekodowania sekwencyjnego!\n");
+            return 1;
+        }
+    } else if (reserveBytes(this->output, numberOfPixels * this->header.channels * this->header.bytesPerSample)) {
+        return 1;
+    }
+    if (this->header.mode == MODE_TILED)
+        return decodeTiled(this);
+    if (this->index && this->header.scanOrder != SCAN_ROW) {
+        printf("Indeks punktów kontrolnych wymaga skanowania wierszami!\n");
+        return 1;
+    }
+    if (this->header.channels > 1 || this->header.scanOrder != SCAN_ROW)
+        return decodePlanes(this);
+    if (this->index)
+        return decodeFromCheckpoints(this);
+    return decodeBlock(this, this->header.mode, numberOfPixels);
 }
\ No newline at end of file
@@ -2,12 +2,16 @@
 #define DECODER_OPERATIONS_H
 
 #define BASE_NODES_ENTRIES 32
+// Tree of 16 bit alphabet holds up to 131071 nodes, so it grows in larger blocks
+#define WIDE_NODES_ENTRIES 1024
 #define BASE_CACHE_ENTRIES 16
 #define BASE_ARRAY_ENTRIES 8
 #define BITS_IN_BYTE 8
 
 #include "bitOperations.h"
 
+struct dictionaryNode;
+
 /**
  * @brief:  Represents a node in the Huffman tree.
  * @parent: Pointer to the parent node.
@@ -22,9 +26,9 @@ typedef struct node {
     struct node* parent;
     struct node* link0;
     struct node* link1;
-    uint8_t value;
-    uint16_t positionInTree;
-    uint32_t count;
+    uint16_t value;
+    uint32_t positionInTree;
+    uint64_t count;
 } node;
 
 /**
@@ -33,6 +37,9 @@ typedef struct node {
  * @memoryPointers: Array of pointers to node structs that stores information about memory.
  * @input: Struct containing bit value read from compressed file
  * @output: Struct containing byte value of pixels, used for creating output file
+ * @header: Description of image stored in compressed file
+ * @dictionary: Trained tree adaptive blocks start from, NULL to start from first symbol
+ * @index: Checkpoints of adaptive stream decoded in parallel, NULL to decode it sequentially
  * @baseNumberOfNodes: Base size of memory chunk for nodes.
  * @memoryBlockMultiplier: Number of memory blocks allocated for nodes.
  * @lastNode: Position of the last node in the array, used for tracking new symbols.
@@ -42,33 +49,94 @@ typedef struct tree {
     struct node** memoryPointers;
     struct bitBuffer* input;
     struct byteBuffer* output;
-    uint8_t baseNumberOfNodes;
-    uint8_t memoryBlockMultiplier;
-    uint16_t lastNode;
+    imageHeader header;
+    struct dictionary* dictionary;
+    struct checkpointIndex* index;
+    uint16_t baseNumberOfNodes;
+    uint32_t memoryBlockMultiplier;
+    uint32_t lastNode;
 } tree;
 
 /**
-  * @brief: Initialize tree by allocating memory for tree and creating base tree
-  *         consisting of root, first symbol from stream and NewSymbol node.
-  * @param  pointer to tree struct
-  * @retval 0 if successfully created tree, 1 otherwise
+  * @brief: Initialize tree by loading compressed file, reading its header and allocating memory
+  *         for tree. Base tree is created when adaptive data is decoded.
+  * @param  path to compressed file, or NULL to ask user for it
+  * @retval pointer to created tree, NULL otherwise
+  */
+tree* createTree(const char* inputPath);
+
+/**
+  * @brief: Initialize tree as createTree() does, with compressed file already loaded to memory.
+  *         Data is copied, so caller may free it afterwards.
+  * @param  data contents of compressed file
+  * @param  length length of compressed file in bytes
+  * @retval pointer to created tree, NULL otherwise
+  */
+tree* createTreeFromMemory(const uint8_t* data, uint64_t length);
+
+/**
+  * @brief: Prepares tree used for previous file to decode other compressed data from memory.
+  *         Nodes and buffers are reused, nodes only for samples of the same size; output
+  *         grows in memory again, dictionary and checkpoint index are released.
+  * @param  pointer to the tree struct
+  * @param  compressed data, copied into tree
+  * @param  length of compressed data
+  * @retval 0 if header of data is valid, 1 otherwise
   */
-tree* createTree();
+uint8_t restartTree(tree*, const uint8_t* data, uint64_t length);
 
 /**
-  * @brief: Constructs the Huffman tree and stores decompressed data in buffer.
-  *         Iterates through input bits, updates the tree structure, and decodes data.
+  * @brief: Decodes data with coding mode given in header and stores decompressed data in buffer.
+  *         Dictionary named in header must be loaded with attachDictionary() first.
+  *         In adaptive mode iterates through input bits, updates the tree structure, and decodes
+  *         data until every pixel described in header is decoded.
   * @param  pointer to the tree struct containing the Huffman tree.
   * @retval 0 if the tree is successfully constructed and data decompressed, 1 on error
   */
-uint8_t constructTree(tree*);
+uint8_t decodeData(tree*);
+
+/**
+  * @brief: Decodes block of data coded with single mode and appends its samples to output
+  *         buffer, 16 bit samples in big-endian order. Adaptive tree is started again for
+  *         every block.
+  * @param  pointer to the tree struct with input positioned at start of block.
+  * @param  mode coding mode of block
+  * @param  numberOfPixels number of samples in block
+  * @retval 0 if block decompressed successfully, 1 on error
+  */
+uint8_t decodeBlock(tree*, uint8_t mode, uint64_t numberOfPixels);
+
+/**
+  * @brief: Starts adaptive block: creates base tree, or copies dictionary tree, and decodes
+  *         first symbol if tree holds no symbols yet.
+  * @param  pointer to the tree struct with input positioned at start of block.
+  * @retval 0 if tree was created, 1 if file is incomplete or on memory allocation error
+  */
+uint8_t startAdaptive(tree*);
+
+/**
+  * @brief: Continues decoding adaptive Huffman code with current tree, updating tree after
+  *         each symbol exactly as coder did.
+  * @param  pointer to the tree struct with started tree.
+  * @param  lastPixel position in output buffer decoding stops at
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t resumeAdaptive(tree*, uint64_t lastPixel);
+
+/**
+  * @brief: Replaces tree with given nodes, links of nodes are rebuilt from their parents.
+  * @param  pointer to the tree struct
+  * @param  nodes valid adaptive tree in order of position in tree, NewSymbol node last
+  * @param  numberOfNodes number of nodes
+  * @retval 0 if tree was created, 1 if memory allocation fails
+  */
+uint8_t restoreTree(tree*, const struct dictionaryNode* nodes, uint32_t numberOfNodes);
 
 /**
-  * @brief  Frees memory used by structs
-  * @param  pointer to handler struct containing instances of: dataBuffer, records, cache, tree
-  *         and compressedFile pointer
+  * @brief  Frees memory used by tree, its nodes and input and output buffers
+  * @param  address of pointer to tree struct, set to NULL afterwards
   * @retval None
   */
-void freeAlocatedMemory(tree**);
+void freeTree(tree**);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "dictionaryDecoder.h"
+
+/**
+  * @brief  Computes identifier of serialized dictionary nodes: FNV-1a hash folded to 16 bits,
+  *         never 0, exactly as coder does.
+  * @param  data serialized nodes
+  * @param  length length of serialized nodes in bytes
+  * @retval Dictionary identifier
+  */
+static uint16_t computeId(const uint8_t* data, uint64_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (uint64_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    uint16_t id = (uint16_t)(hash ^ (hash >> 16));
+    return id ? id : 1;
+}
+
+uint8_t validateNodes(const dictionaryNode* nodes, uint32_t numberOfNodes, uint8_t bytesPerSample)
+{
+    uint32_t numberOfSymbols = bytesPerSample == 1 ? 256 : 65536;
+    uint8_t* children = (uint8_t*)calloc(numberOfNodes, 1);
+    uint64_t* sums = (uint64_t*)calloc(numberOfNodes, sizeof(uint64_t));
+    uint8_t* present = (uint8_t*)calloc(numberOfSymbols, 1);
+    uint32_t last = numberOfNodes - 1;
+    uint8_t status = !children || !sums || !present || (nodes[0].flags & DICTIONARY_LEAF) ||
+                     !(nodes[last].flags & DICTIONARY_LEAF) || nodes[last].count;
+
+    for (uint32_t i = 1; i < numberOfNodes && !status; i++) {
+        const dictionaryNode* node = &nodes[i];
+        uint8_t slot = node->flags & DICTIONARY_LINK1 ? 2 : 1;
+        if (node->parent >= i || (nodes[node->parent].flags & DICTIONARY_LEAF) ||
+            (children[node->parent] & slot) || node->count > nodes[i - 1].count) {
+            status = 1;
+            break;
+        }
+        children[node->parent] |= slot;
+        sums[node->parent] += node->count;
+        if (!(node->flags & DICTIONARY_LEAF) || i == last) continue;
+        if (node->symbol >= numberOfSymbols || present[node->symbol] || !node->count) {
+            status = 1;
+            break;
+        }
+        present[node->symbol] = 1;
+    }
+    for (uint32_t i = 0; i < numberOfNodes && !status; i++)
+        if (!(nodes[i].flags & DICTIONARY_LEAF) && (children[i] != 3 || sums[i] != nodes[i].count))
+            status = 1;
+    free(children);
+    free(sums);
+    free(present);
+    return status;
+}
+
+uint8_t attachDictionary(tree* this, const char* dictionaryPath)
+{
+    const uint8_t magic[] = DICTIONARY_MAGIC;
+    uint8_t header[DICTIONARY_HEADER_LENGTH];
+    FILE* file = fopen(dictionaryPath, "rb");
+    if (!file) {
+        printf("Błąd podczas otwierania pliku słownika!\n");
+        return 1;
+    }
+    if (fread(header, 1, DICTIONARY_HEADER_LENGTH, file) != DICTIONARY_HEADER_LENGTH ||
+        memcmp(header, magic, sizeof(magic)) || header[4] != DICTIONARY_VERSION) {
+        printf("Nieobsługiwany plik słownika!\n");
+        fclose(file);
+        return 1;
+    }
+    dictionary* loaded = (dictionary*)calloc(1, sizeof(dictionary));
+    if (!loaded) {
+        printf("Błąd podczas alokacji pamięci słownika!\n");
+        fclose(file);
+        return 1;
+    }
+    loaded->bytesPerSample = header[5];
+    loaded->id = loadBigEndian(&header[6], 2);
+    loaded->numberOfNodes = loadBigEndian(&header[8], 4);
+    if (loaded->id != this->header.dictionaryId || loaded->bytesPerSample != this->header.bytesPerSample) {
+        printf("Słownik %04x nie pasuje do skompresowanego pliku!\n", loaded->id);
+        releaseDictionary(&loaded);
+        fclose(file);
+        return 1;
+    }
+
+    // Tree holds NewSymbol node and at least one symbol, at most every symbol of alphabet
+    uint32_t numberOfSymbols = loaded->bytesPerSample == 1 ? 256 : 65536;
+    uint64_t length = (uint64_t)loaded->numberOfNodes * DICTIONARY_NODE_LENGTH;
+    uint8_t* data = NULL;
+    uint8_t status = loaded->numberOfNodes < 3 || !(loaded->numberOfNodes & 1) ||
+                     loaded->numberOfNodes > 2 * numberOfSymbols + 1;
+    if (!status) {
+        data = (uint8_t*)malloc(length);
+        loaded->nodes = (dictionaryNode*)malloc(loaded->numberOfNodes * sizeof(dictionaryNode));
+        status = !data || !loaded->nodes || fread(data, 1, length, file) != length || computeId(data, length) != loaded->id;
+    }
+    for (uint32_t i = 0; i < loaded->numberOfNodes && !status; i++) {
+        const uint8_t* node = &data[(uint64_t)i * DICTIONARY_NODE_LENGTH];
+        loaded->nodes[i].count = loadBigEndian(&node[0], 4);
+        loaded->nodes[i].parent = loadBigEndian(&node[4], 4);
+        loaded->nodes[i].flags = node[8];
+        loaded->nodes[i].symbol = loadBigEndian(&node[9], 2);
+    }
+    if (!status)
+        status = validateNodes(loaded->nodes, loaded->numberOfNodes, loaded->bytesPerSample);
+    free(data);
+    fclose(file);
+    if (status) {
+        printf("Plik słownika jest uszkodzony!\n");
+        releaseDictionary(&loaded);
+        return 1;
+    }
+    this->dictionary = loaded;
+    return 0;
+}
+
+void releaseDictionary(dictionary** this)
+{
+    if (!*this) return;
+    free((*this)->nodes);
+    free(*this);
+    *this = NULL;
+}
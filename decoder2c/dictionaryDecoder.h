@@ -0,0 +1,73 @@
+#ifndef DICTIONARY_DECODER_H
+#define DICTIONARY_DECODER_H
+
+// Dictionary file: magic, version, bytes per sample, id and number of nodes, followed by
+// nodes of trained tree in order of their position in tree
+#define DICTIONARY_MAGIC { 0x8B, 'K', 'D', 'D' }
+#define DICTIONARY_VERSION 1
+#define DICTIONARY_HEADER_LENGTH 12
+// Node: count (4 bytes), parent position (4 bytes), flags, symbol (2 bytes)
+#define DICTIONARY_NODE_LENGTH 11
+#define DICTIONARY_LEAF 0x01
+#define DICTIONARY_LINK1 0x02
+
+#include "decoderOperations.h"
+
+/**
+ * @brief:  Node of trained tree as stored in dictionary file, also used for tree snapshots
+ *          of checkpoint index.
+ * @count: Count of node, sum of counts of children for internal nodes.
+ * @parent: Position of parent node in tree, 0 for root.
+ * @symbol: Sample value of leaf, 0 for internal nodes and NewSymbol node.
+ * @flags: DICTIONARY_LEAF for leaves, DICTIONARY_LINK1 if node is link1 of its parent.
+ */
+typedef struct dictionaryNode {
+    uint64_t count;
+    uint32_t parent;
+    uint16_t symbol;
+    uint8_t flags;
+} dictionaryNode;
+
+/**
+ * @brief:  Trained tree every adaptive block of compressed file starts from.
+ * @nodes: Nodes in order of position in tree: root first, NewSymbol node last.
+ * @numberOfNodes: Number of nodes of tree.
+ * @id: Identifier of dictionary, equal to the one in compressed file header.
+ * @bytesPerSample: Size of samples of images dictionary was trained on.
+ */
+typedef struct dictionary {
+    dictionaryNode* nodes;
+    uint32_t numberOfNodes;
+    uint16_t id;
+    uint8_t bytesPerSample;
+} dictionary;
+
+/**
+  * @brief  Checks that nodes form adaptive tree: parents precede children, every internal
+  *         node has two children and count equal to their sum, counts do not grow with
+  *         position, leaves hold distinct symbols of alphabet and last node is NewSymbol
+  *         node with zero count.
+  * @param  nodes nodes in order of position in tree
+  * @param  numberOfNodes number of nodes, at least 1
+  * @param  bytesPerSample size of samples, selects alphabet of leaves
+  * @retval 0 if tree is valid, 1 otherwise
+  */
+uint8_t validateNodes(const dictionaryNode* nodes, uint32_t numberOfNodes, uint8_t bytesPerSample);
+
+/**
+  * @brief  Reads dictionary file for compressed file whose header names it. Dictionary must
+  *         have identifier and sample size of compressed file and hold valid adaptive tree.
+  * @param  this pointer to the tree struct with read header
+  * @param  dictionaryPath path to dictionary file
+  * @retval 0 if dictionary was loaded, 1 otherwise
+  */
+uint8_t attachDictionary(tree* this, const char* dictionaryPath);
+
+/**
+  * @brief  Frees dictionary and its nodes.
+  * @param  this address of pointer to dictionary, set to NULL afterwards
+  * @retval None
+  */
+void releaseDictionary(dictionary** this);
+
+#endif // DICTIONARY_DECODER_H
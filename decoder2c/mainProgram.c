@@ -1,18 +1,178 @@
 #include "decoderOperations.h"
+#include "dictionaryDecoder.h"
+#include "checkpointDecoder.h"
+#include "outputSink.h"
+#include "archiveReader.h"
+#include "sequenceDecoder.h"
 
-uint8_t run()
+/**
+ * @brief:  Options of decompression given on command line.
+ * @dictionaryPath: Path to dictionary named in compressed file header, or NULL.
+ * @indexPath: Path to checkpoint index stream is decoded in parallel with, or NULL.
+ * @buildIndexPath: Path to checkpoint index written while decoding, or NULL.
+ * @checkpointInterval: Number of pixels between written checkpoints.
+ * @threads: Number of threads decoding stream with index, 0 for number of processors.
+ * @output: OUTPUT_MEMORY, OUTPUT_MAPPED or OUTPUT_STREAM, OUTPUT_AUTO to choose from header.
+ * @archivePath: Path to archive compressed file is taken from by its name, or NULL.
+ */
+typedef struct options {
+    const char* dictionaryPath;
+    const char* indexPath;
+    const char* buildIndexPath;
+    uint64_t checkpointInterval;
+    uint16_t threads;
+    uint8_t output;
+    const char* archivePath;
+} options;
+
+// Output is chosen from compressed file header
+#define OUTPUT_AUTO 0xFF
+
+/**
+  * @brief  Decompresses compressed file loaded into tree into PGM file and frees tree.
+  * @param  this Tree with loaded compressed file, or NULL if it could not be created
+  * @param  outputPath Path to PGM file, or NULL to ask user for it
+  * @param  options Pointer to options of decompression
+  * @retval 0 if file was decompressed successfully, 1 otherwise
+  */
+uint8_t decompress(tree* this, const char* outputPath, const options* options)
 {
-    tree* this = createTree();
     if (!this) return 1;
-    if (constructTree(this)) return 1;
-    if (writeToFile(this->output)) return 1;
-    freeAlocatedMemory(&this);
-    return 0;
+    uint8_t output = options->output;
+    if (output == OUTPUT_AUTO)
+        output = preferredOutput(&this->header, options->indexPath != NULL);
+    // Without path, name of decompressed file is asked for after decoding
+    uint8_t status = (options->dictionaryPath && attachDictionary(this, options->dictionaryPath)) ||
+                     (options->indexPath && attachIndex(this, options->indexPath, options->threads)) ||
+                     (outputPath && openOutputFile(this->output, &this->header, outputPath, output)) ||
+                     (options->buildIndexPath ? buildIndex(this, options->buildIndexPath, options->checkpointInterval) : decodeData(this)) ||
+                     (outputPath ? finishOutput(this->output) : writeDecompressedFile(this->output, &this->header, outputPath));
+    freeTree(&this);
+    return status;
 }
 
-int main()
+/**
+  * @brief  Decompresses compressed file into PGM file.
+  * @param  inputPath Path to compressed file, or NULL to ask user for it
+  * @param  outputPath Path to PGM file, or NULL to ask user for it
+  * @param  options Pointer to options of decompression
+  * @retval 0 if file was decompressed successfully, 1 otherwise
+  */
+uint8_t run(const char* inputPath, const char* outputPath, const options* options)
 {
-    run();
-    scanf("%d", NULL);
-    return 0;
-}
\ No newline at end of file
+    return decompress(createTree(inputPath), outputPath, options);
+}
+
+/**
+  * @brief  Decompresses compressed file stored in archive into PGM file.
+  * @param  name Name of compressed file in archive
+  * @param  outputPath Path to PGM file
+  * @param  options Pointer to options of decompression with path to archive
+  * @retval 0 if file was decompressed successfully, 1 otherwise
+  */
+uint8_t runArchive(const char* name, const char* outputPath, const options* options)
+{
+    archive* archive = openArchive(options->archivePath);
+    if (!archive) return 1;
+    archiveEntry entry;
+    uint8_t status = findArchiveEntry(archive, name, &entry) || decompress(createTreeFromArchive(&entry), outputPath, options);
+    closeArchive(&archive);
+    return status;
+}
+
+/**
+  * @brief  Prints every entry of archive: name, width, height, channels, maximum grey level,
+  *         coding mode and length of compressed file, separated by tabs.
+  * @param  archivePath Path to archive
+  * @retval 0 if every entry was valid, 1 otherwise
+  */
+uint8_t listArchive(const char* archivePath)
+{
+    archive* archive = openArchive(archivePath);
+    if (!archive) return 1;
+    uint8_t status = 0;
+    for (uint32_t i = 0; i < archive->numberOfEntries && !status; i++) {
+        archiveEntry entry;
+        status = readArchiveEntry(archive, i, &entry);
+        if (!status)
+            printf("%.*s\t%u\t%u\t%u\t%u\t%u\t%llu\n", (int)entry.nameLength, entry.name, entry.width, entry.height,
+                   entry.channels, entry.maxGreyLevel, entry.mode, (unsigned long long)entry.length);
+    }
+    closeArchive(&archive);
+    return status;
+}
+
+int main(int argc, char** argv)
+{
+    options options = { NULL, NULL, NULL, DEFAULT_CHECKPOINT_INTERVAL, 0, OUTPUT_AUTO, NULL };
+    int argument = 1;
+
+    while (argc - argument > 1 && !strncmp(argv[argument], "--", 2)) {
+        if (!strcmp(argv[argument], "--dictionary")) {
+            options.dictionaryPath = argv[argument + 1];
+        } else if (!strcmp(argv[argument], "--index")) {
+            options.indexPath = argv[argument + 1];
+        } else if (!strcmp(argv[argument], "--archive")) {
+            options.archivePath = argv[argument + 1];
+        } else if (!strcmp(argv[argument], "--list")) {
+            return listArchive(argv[argument + 1]);
+        } else if (!strcmp(argv[argument], "--sequence")) {
+            // Sequence is followed by first frame, number of frames and prefix of decoded files
+            if (argc - argument != 5) break;
+            unsigned long firstFrame = strtoul(argv[argument + 2], NULL, 10);
+            unsigned long numberOfFrames = strtoul(argv[argument + 3], NULL, 10);
+            if (firstFrame > UINT32_MAX || numberOfFrames > UINT32_MAX) {
+                printf("Numer i liczba klatek muszą mieścić się w 32 bitach!\n");
+                return 1;
+            }
+            return decodeSequence(argv[argument + 1], (uint32_t)firstFrame, (uint32_t)numberOfFrames, argv[argument + 4]);
+        } else if (!strcmp(argv[argument], "--build-index")) {
+            options.buildIndexPath = argv[argument + 1];
+        } else if (!strcmp(argv[argument], "--checkpoint-interval")) {
+            options.checkpointInterval = strtoull(argv[argument + 1], NULL, 10);
+            if (!options.checkpointInterval) {
+                printf("Odstęp punktów kontrolnych musi być dodatni!\n");
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--output")) {
+            if (!strcmp(argv[argument + 1], "memory")) {
+                options.output = OUTPUT_MEMORY;
+            } else if (!strcmp(argv[argument + 1], "mapped")) {
+                options.output = OUTPUT_MAPPED;
+            } else if (!strcmp(argv[argument + 1], "stream")) {
+                options.output = OUTPUT_STREAM;
+            } else {
+                printf("Nieznane wyjście \"%s\"!\n", argv[argument + 1]);
+                return 1;
+            }
+        } else if (!strcmp(argv[argument], "--threads")) {
+            unsigned long threads = strtoul(argv[argument + 1], NULL, 10);
+            if (!threads || threads > UINT16_MAX) {
+                printf("Liczba wątków musi mieścić się między 1 a %u!\n", UINT16_MAX);
+                return 1;
+            }
+            options.threads = (uint16_t)threads;
+        } else {
+            break;
+        }
+        argument += 2;
+    }
+    if (argc - argument == 2 && options.archivePath)
+        return runArchive(argv[argument], argv[argument + 1], &options);
+    if (argc - argument == 2)
+        return run(argv[argument], argv[argument + 1], &options);
+    if (argc != argument || options.archivePath) {
+        printf("Użycie: %s [--dictionary słownik.kdd] [--index indeks.kdx] [--threads n]\n", argv[0]);
+        printf("        %*s [--output memory|mapped|stream] [plik.bin plik.pgm]\n", (int)strlen(argv[0]), "");
+        printf("        %s [--dictionary słownik.kdd] [--output memory|mapped|stream] --archive archiwum.kda nazwa plik.pgm\n", argv[0]);
+        printf("        %s --list archiwum.kda\n", argv[0]);
+        printf("        %s --sequence sekwencja.kds pierwsza-klatka liczba-klatek prefiks\n", argv[0]);
+        printf("        %s [--dictionary słownik.kdd] --build-index indeks.kdx [--checkpoint-interval piksele] plik.bin plik.pgm\n", argv[0]);
+        return 1;
+    }
+    // Tryb interaktywny: pytamy o ścieżki i czekamy na enter przed zamknięciem konsoli
+    uint8_t status = run(NULL, NULL, &options);
+    getchar();
+    getchar();
+    return status;
+}
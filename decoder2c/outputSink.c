@@ -0,0 +1,177 @@
+// fileno(), ftruncate() and mmap() are POSIX, decompressed file is mapped where they are available
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_MAP_OUTPUT
+#endif
+#include "outputSink.h"
+#ifdef KODA_MAP_OUTPUT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Appends a byte to buffer that holds whole image, caller buffer or mapped file.
+ *        Output is reserved for whole image before decoding, so buffer never grows.
+ * @param this Pointer to the byteBuffer instance.
+ * @param byte The byte to append to the data buffer.
+ * @return 0
+ */
+static uint8_t appendFixed(byteBuffer* this, uint8_t byte)
+{
+    this->baseBuffer->dataBuffer[this->currentByte++] = byte;
+    return 0;
+}
+
+uint8_t flushOutputWindow(byteBuffer* this)
+{
+    size_t length = (size_t)(this->currentByte - this->sink.flushedBytes);
+    this->sink.flushedBytes = this->currentByte;
+    return fwrite(this->baseBuffer->dataBuffer, 1, length, this->sink.file) != length;
+}
+
+/**
+ * @brief Appends a byte to window of streamed pixels, window is written to file when full.
+ * @param this Pointer to the byteBuffer instance.
+ * @param byte The byte to append to the data buffer.
+ * @return 0 on success, 1 if write fails
+ */
+static uint8_t appendStreamed(byteBuffer* this, uint8_t byte)
+{
+    this->baseBuffer->dataBuffer[this->currentByte++ - this->sink.flushedBytes] = byte;
+    if (this->currentByte - this->sink.flushedBytes == this->sink.capacity)
+        return flushOutputWindow(this);
+    return 0;
+}
+
+/**
+ * @brief Replaces memory owned by buffer with external memory.
+ * @param this Pointer to the byteBuffer instance.
+ * @param data External memory
+ * @param capacity Size of external memory
+ * @param type OUTPUT_CALLER or OUTPUT_MAPPED
+ * @return None
+ */
+static void useFixedMemory(byteBuffer* this, uint8_t* data, uint64_t capacity, uint8_t type)
+{
+    free(this->baseBuffer->dataBuffer);
+    this->baseBuffer->dataBuffer = data;
+    this->baseBuffer->multiplier = 0;
+    this->sink.capacity = capacity;
+    this->sink.type = type;
+    this->appendByte = appendFixed;
+}
+
+uint8_t useCallerBuffer(byteBuffer* this, uint8_t* buffer, uint64_t capacity)
+{
+    if (!buffer || this->currentByte || this->sink.type != OUTPUT_MEMORY) {
+        printf("Nie można użyć bufora wyjściowego!\n");
+        return 1;
+    }
+    useFixedMemory(this, buffer, capacity, OUTPUT_CALLER);
+    return 0;
+}
+
+uint8_t openOutputFile(byteBuffer* this, const imageHeader* header, const char* filePath, uint8_t type)
+{
+    char text[IMAGE_HEADER_MAX_LENGTH];
+    uint32_t headerLength = formatImageHeader(text, sizeof(text), header);
+    uint64_t imageLength = (uint64_t)header->width * header->height * header->channels * header->bytesPerSample;
+
+    if (this->currentByte || this->sink.type != OUTPUT_MEMORY || this->sink.file) {
+        printf("Nie można zmienić wyjścia dekodera!\n");
+        return 1;
+    }
+    this->sink.file = fopen(filePath, type == OUTPUT_MAPPED ? "w+b" : "wb");
+    if (!this->sink.file) {
+        printf("Błąd podczas tworzenia pliku!\n");
+        return 1;
+    }
+    if (fwrite(text, 1, headerLength, this->sink.file) != headerLength || fflush(this->sink.file)) {
+        printf("Błąd podczas zapisywania danych do pliku!\n");
+        return 1;
+    }
+
+    if (type == OUTPUT_STREAM) {
+        uint8_t* window = (uint8_t*)malloc(OUTPUT_WINDOW_SIZE);
+        if (!window) {
+            printf("Błąd podczas alokacji pamięci bufora pixeli!\n");
+            return 1;
+        }
+        // Windows are written whole, stdio buffer would only copy them once more
+        setvbuf(this->sink.file, NULL, _IONBF, 0);
+        free(this->baseBuffer->dataBuffer);
+        this->baseBuffer->dataBuffer = window;
+        this->baseBuffer->multiplier = 0;
+        this->sink.capacity = OUTPUT_WINDOW_SIZE;
+        this->sink.type = OUTPUT_STREAM;
+        this->appendByte = appendStreamed;
+        return 0;
+    }
+#ifdef KODA_MAP_OUTPUT
+    // File is sized for whole image, so pixels are written straight into page cache
+    uint64_t fileLength = headerLength + imageLength;
+    if (type == OUTPUT_MAPPED && fileLength <= (uint64_t)SIZE_MAX && (off_t)fileLength > 0 &&
+        !ftruncate(fileno(this->sink.file), (off_t)fileLength)) {
+        void* mapping = mmap(NULL, (size_t)fileLength, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(this->sink.file), 0);
+        if (mapping != MAP_FAILED) {
+            this->sink.mapping = (uint8_t*)mapping;
+            this->sink.mappingLength = fileLength;
+            useFixedMemory(this, this->sink.mapping + headerLength, imageLength, OUTPUT_MAPPED);
+            return 0;
+        }
+    }
+#else
+    (void)imageLength;
+#endif
+    // Pixels stay in memory and are written by finishOutput()
+    return 0;
+}
+
+uint8_t preferredOutput(const imageHeader* header, uint8_t parallel)
+{
+    if (header->mode == MODE_ADAPTIVE_HUFFMAN && header->channels == 1 && header->scanOrder == SCAN_ROW && !parallel)
+        return OUTPUT_STREAM;
+    return OUTPUT_MAPPED;
+}
+
+uint8_t finishOutput(byteBuffer* this)
+{
+    uint8_t status = !this->sink.file;
+    if (!status && this->sink.type == OUTPUT_MEMORY)
+        status = fwrite(this->baseBuffer->dataBuffer, 1, this->currentByte, this->sink.file) != this->currentByte;
+    if (!status && this->sink.type == OUTPUT_STREAM)
+        status = flushOutputWindow(this) || ferror(this->sink.file);
+#ifdef KODA_MAP_OUTPUT
+    if (this->sink.mapping) {
+        status = munmap(this->sink.mapping, (size_t)this->sink.mappingLength) || status;
+        this->sink.mapping = NULL;
+        this->baseBuffer->dataBuffer = NULL;
+    }
+#endif
+    if (this->sink.file) {
+        status = fclose(this->sink.file) || status;
+        this->sink.file = NULL;
+    }
+    if (status) {
+        printf("Błąd podczas zapisywania danych do pliku!\n");
+        return 1;
+    }
+    printf("Zdekompresowany plik zapisany poprawnie\n");
+    return 0;
+}
+
+void releaseSink(byteBuffer* this)
+{
+#ifdef KODA_MAP_OUTPUT
+    if (this->sink.mapping)
+        munmap(this->sink.mapping, (size_t)this->sink.mappingLength);
+#endif
+    this->sink.mapping = NULL;
+    if (this->sink.file)
+        fclose(this->sink.file);
+    this->sink.file = NULL;
+    // Caller buffer and mapped file do not belong to buffer
+    if ((this->sink.type == OUTPUT_CALLER || this->sink.type == OUTPUT_MAPPED) && this->baseBuffer)
+        this->baseBuffer->dataBuffer = NULL;
+    this->sink.type = OUTPUT_MEMORY;
+}
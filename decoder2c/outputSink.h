@@ -0,0 +1,61 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include "bitOperations.h"
+
+/** 
+ * @brief:  Makes decoder write pixels straight into caller buffer, which is never reallocated
+ *          nor freed. Buffer must hold whole image, 16 bit samples in big-endian order.
+ * @param:  this - pointer to output buffer structure, empty
+ * @param:  buffer - caller buffer
+ * @param:  capacity - size of caller buffer in bytes
+ * @retval: 0 if buffer is used, 1 otherwise
+ */
+uint8_t useCallerBuffer(byteBuffer* this, uint8_t* buffer, uint64_t capacity);
+
+/** 
+ * @brief:  Creates decompressed file and makes decoder write pixels straight into it. Mapped
+ *          file is sized for whole image and pixels are written in place, where mapping is
+ *          not available pixels stay in memory until finishOutput(). Streamed file receives
+ *          pixels in large writes, only for sequentially decoded single adaptive block.
+ * @param:  this - pointer to output buffer structure, empty
+ * @param:  header - pointer to structure describing decompressed image
+ * @param:  filePath - path to decompressed file
+ * @param:  type - OUTPUT_MAPPED, OUTPUT_STREAM or OUTPUT_MEMORY
+ * @retval: 0 if file was created, 1 otherwise
+ */
+uint8_t openOutputFile(byteBuffer* this, const imageHeader* header, const char* filePath, uint8_t type);
+
+/** 
+ * @brief:  Writes window of streamed pixels to decompressed file and empties window.
+ * @param:  this - pointer to output buffer structure with streamed output
+ * @retval: 0 on success, 1 if write fails
+ */
+uint8_t flushOutputWindow(byteBuffer* this);
+
+/** 
+ * @brief:  Chooses output of decompressed file: streamed file for single adaptive block
+ *          read row by row, which is decoded sequentially, mapped file otherwise.
+ * @param:  header - pointer to structure describing decompressed image
+ * @param:  parallel - 1 if stream is decoded in parallel from checkpoints
+ * @retval: OUTPUT_STREAM or OUTPUT_MAPPED
+ */
+uint8_t preferredOutput(const imageHeader* header, uint8_t parallel);
+
+/** 
+ * @brief:  Completes decompressed file opened with openOutputFile(): writes pixels left in
+ *          memory and closes file.
+ * @param:  this - pointer to output buffer structure holding whole image
+ * @retval: 0 if file was written, 1 otherwise
+ */
+uint8_t finishOutput(byteBuffer* this);
+
+/** 
+ * @brief:  Unmaps and closes decompressed file and detaches caller buffer, so only memory
+ *          owned by buffer is freed with it.
+ * @param:  this - pointer to output buffer structure
+ * @retval: None
+ */
+void releaseSink(byteBuffer* this);
+
+#endif // OUTPUT_SINK_H
@@ -0,0 +1,234 @@
+#include "periodicDecoder.h"
+
+// Lengths of Huffman code before limiting can reach number of symbols - 1
+#define MAX_UNLIMITED_LENGTH NUMBER_OF_SYMBOLS
+
+/**
+ * @brief:  Semi-adaptive model: symbol counts and lookup table of code built from them.
+ * @counts: Count of each symbol, every symbol starts with 1 so it always has code.
+ * @total: Sum of counts.
+ * @expectedBits: Sum of counts times code lengths at last rebuild.
+ * @expectedTotal: Sum of counts at last rebuild.
+ * @codedBits: Number of bits of symbols decoded since last rebuild.
+ * @interval: Number of symbols between last and next regular rebuild.
+ * @codedSymbols: Number of symbols decoded since last rebuild.
+ * @lengths: Code length of each symbol.
+ * @table: Lookup table of code.
+ */
+typedef struct periodicModel {
+    uint64_t counts[NUMBER_OF_SYMBOLS];
+    uint64_t total;
+    uint64_t expectedBits;
+    uint64_t expectedTotal;
+    uint64_t codedBits;
+    uint32_t interval;
+    uint32_t codedSymbols;
+    uint8_t lengths[NUMBER_OF_SYMBOLS];
+    uint16_t table[PERIODIC_TABLE_SIZE];
+} periodicModel;
+
+/**
+  * @brief  Computes Huffman code length of each symbol by repeatedly merging two least
+  *         frequent subtrees, exactly as coder does. Ties are broken by lower index.
+  * @param  histogram Array of NUMBER_OF_SYMBOLS symbol counts.
+  * @param  lengths Array receiving unlimited code length of each symbol.
+  * @retval Number of symbols present in histogram.
+  */
+static uint16_t computeCodeLengths(const uint64_t* histogram, uint16_t* lengths)
+{
+    uint64_t weight[2 * NUMBER_OF_SYMBOLS];
+    int16_t parent[2 * NUMBER_OF_SYMBOLS];
+    uint8_t active[2 * NUMBER_OF_SYMBOLS];
+    uint16_t numberOfNodes = NUMBER_OF_SYMBOLS;
+    uint16_t presentSymbols = 0;
+
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++) {
+        weight[i] = histogram[i];
+        parent[i] = -1;
+        active[i] = histogram[i] > 0;
+        presentSymbols += active[i];
+        lengths[i] = 0;
+    }
+    if (presentSymbols == 1) {
+        for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+            if (active[i]) lengths[i] = 1;
+        return presentSymbols;
+    }
+
+    for (uint16_t merges = 1; merges < presentSymbols; merges++) {
+        int16_t first = -1, second = -1;
+        for (uint16_t i = 0; i < numberOfNodes; i++) {
+            if (!active[i]) continue;
+            if (first < 0 || weight[i] < weight[first]) {
+                second = first;
+                first = i;
+            } else if (second < 0 || weight[i] < weight[second]) {
+                second = i;
+            }
+        }
+        weight[numberOfNodes] = weight[first] + weight[second];
+        parent[numberOfNodes] = -1;
+        active[numberOfNodes] = 1;
+        active[first] = active[second] = 0;
+        parent[first] = parent[second] = numberOfNodes;
+        numberOfNodes++;
+    }
+
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++) {
+        if (!histogram[i]) continue;
+        for (int16_t node = parent[i]; node >= 0; node = parent[node])
+            lengths[i]++;
+    }
+    return presentSymbols;
+}
+
+/**
+  * @brief  Limits code lengths to PERIODIC_MAX_CODE_LENGTH keeping prefix property (JPEG
+  *         Annex K.3): two longest codes are replaced with one shorter and shorter code is split.
+  * @param  lengthCount Number of codes of each length, modified in place.
+  * @retval None
+  */
+static void limitCodeLengths(uint16_t* lengthCount)
+{
+    for (uint16_t length = MAX_UNLIMITED_LENGTH; length > PERIODIC_MAX_CODE_LENGTH; length--) {
+        while (lengthCount[length] > 0) {
+            uint16_t shorter = length - 2;
+            while (lengthCount[shorter] == 0)
+                shorter--;
+            lengthCount[length] -= 2;
+            lengthCount[length - 1]++;
+            lengthCount[shorter + 1] += 2;
+            lengthCount[shorter]--;
+        }
+    }
+}
+
+/**
+  * @brief  Builds length-limited code lengths from symbol counts, the same as coder builds.
+  * @param  histogram Array of NUMBER_OF_SYMBOLS symbol counts.
+  * @param  lengths Array receiving code length of each symbol.
+  * @retval None
+  */
+static void buildCodeLengths(const uint64_t* histogram, uint8_t* lengths)
+{
+    uint16_t unlimited[NUMBER_OF_SYMBOLS];
+    uint16_t lengthCount[MAX_UNLIMITED_LENGTH + 1] = { 0 };
+    uint16_t presentSymbols = computeCodeLengths(histogram, unlimited);
+
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+        lengthCount[unlimited[i]]++;
+    lengthCount[0] = 0;
+    limitCodeLengths(lengthCount);
+
+    // Hand out limited lengths again: most frequent symbols get shortest codes
+    uint8_t order[NUMBER_OF_SYMBOLS];
+    uint16_t ordered = 0;
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+        if (histogram[i]) order[ordered++] = i;
+    for (uint16_t i = 1; i < presentSymbols; i++) {
+        uint8_t symbol = order[i];
+        uint16_t j = i;
+        while (j > 0 && histogram[order[j - 1]] < histogram[symbol]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = symbol;
+    }
+    memset(lengths, 0, NUMBER_OF_SYMBOLS);
+    uint16_t next = 0;
+    for (uint8_t length = 1; length <= PERIODIC_MAX_CODE_LENGTH; length++)
+        for (uint16_t i = 0; i < lengthCount[length]; i++)
+            lengths[order[next++]] = length;
+}
+
+/**
+  * @brief  Builds lookup table of model from its counts, halving counts first when their sum
+  *         is over PERIODIC_MAX_TOTAL, and starts new drift measurement.
+  * @param  this pointer to model
+  * @retval 0 on success, 1 if code is not valid
+  */
+static uint8_t rebuildCode(periodicModel* this)
+{
+    if (this->total > PERIODIC_MAX_TOTAL) {
+        this->total = 0;
+        for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++) {
+            this->counts[i] -= this->counts[i] / 2;
+            this->total += this->counts[i];
+        }
+    }
+    buildCodeLengths(this->counts, this->lengths);
+    this->expectedBits = 0;
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+        this->expectedBits += this->counts[i] * this->lengths[i];
+    this->expectedTotal = this->total;
+    this->codedBits = 0;
+    this->codedSymbols = 0;
+    return buildLookupTable(this->lengths, PERIODIC_MAX_CODE_LENGTH, this->table);
+}
+
+uint8_t decodePeriodic(tree* this, uint64_t numberOfPixels)
+{
+    const uint8_t* data = this->input->baseBuffer->dataBuffer;
+    uint64_t position = this->input->currentByte;
+    uint64_t end = this->input->lastByte;
+
+    if (this->header.bytesPerSample > 1) {
+        printf("Kod okresowo przebudowywany obsługuje tylko próbki 8-bitowe!\n");
+        return 1;
+    }
+    periodicModel* model = (periodicModel*)malloc(sizeof(periodicModel));
+    if (!model) {
+        printf("Błąd podczas alokowania pamięci na model!\n");
+        return 1;
+    }
+    for (uint16_t i = 0; i < NUMBER_OF_SYMBOLS; i++)
+        model->counts[i] = 1;
+    model->total = NUMBER_OF_SYMBOLS;
+    model->interval = PERIODIC_FIRST_INTERVAL;
+    if (rebuildCode(model) || reserveBytes(this->output, this->output->currentByte + numberOfPixels)) {
+        free(model);
+        return 1;
+    }
+
+    // Bits are consumed from MSB of window, which is refilled byte by byte
+    uint8_t* pixels = &this->output->baseBuffer->dataBuffer[this->output->currentByte];
+    uint64_t window = 0;
+    uint8_t bitsInWindow = 0;
+    uint8_t status = 0;
+    for (uint64_t pixel = 0; pixel < numberOfPixels && !status; pixel++) {
+        while (bitsInWindow <= 56 && position < end) {
+            window |= (uint64_t)data[position++] << (56 - bitsInWindow);
+            bitsInWindow += BITS_IN_BYTE;
+        }
+        uint16_t entry = model->table[window >> (64 - PERIODIC_MAX_CODE_LENGTH)];
+        uint8_t length = entry & LENGTH_MASK;
+        if (!length || length > bitsInWindow) {
+            printf("Skompresowany plik jest niekompletny lub uszkodzony!\n");
+            status = 1;
+            break;
+        }
+        uint8_t symbol = (uint8_t)(entry >> LENGTH_BITS);
+        pixels[pixel] = symbol;
+        window <<= length;
+        bitsInWindow -= length;
+
+        // Model follows coder: count symbol, rebuild when interval ends or code drifts
+        model->codedBits += length;
+        model->counts[symbol]++;
+        model->total++;
+        if (++model->codedSymbols == model->interval) {
+            if (model->interval < PERIODIC_INTERVAL)
+                model->interval *= 2;
+            status = rebuildCode(model);
+        } else if (model->codedSymbols % PERIODIC_DRIFT_WINDOW == 0) {
+            if (model->codedBits * model->expectedTotal * 8 > model->expectedBits * model->codedSymbols * PERIODIC_DRIFT_EIGHTHS)
+                status = rebuildCode(model);
+        }
+    }
+    free(model);
+    if (status) return 1;
+    this->output->currentByte += numberOfPixels;
+    // Whole bytes left in window belong to next block
+    this->input->currentByte = position - bitsInWindow / BITS_IN_BYTE;
+    return 0;
+}
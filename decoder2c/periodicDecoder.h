@@ -0,0 +1,29 @@
+#ifndef PERIODIC_DECODER_H
+#define PERIODIC_DECODER_H
+
+// Code is rebuilt after interval of symbols, or after multiple of drift window when code
+// costs more than expected by more than PERIODIC_DRIFT_EIGHTHS / 8. Interval starts short,
+// so code learns first samples quickly, and doubles after every rebuild up to the longest one.
+#define PERIODIC_FIRST_INTERVAL 64
+#define PERIODIC_INTERVAL 8192
+#define PERIODIC_DRIFT_WINDOW 1024
+#define PERIODIC_DRIFT_EIGHTHS 9
+// Codes of symbols never seen are long, so limit of static code would cost too much
+#define PERIODIC_MAX_CODE_LENGTH 15
+#define PERIODIC_TABLE_SIZE (1 << PERIODIC_MAX_CODE_LENGTH)
+// Counts are halved at rebuild when they sum to more, so code follows recent samples
+#define PERIODIC_MAX_TOTAL (1 << 16)
+
+#include "staticDecoder.h"
+
+/**
+  * @brief: Decodes data compressed with canonical Huffman code rebuilt from counts of decoded
+  *         symbols at the same symbols as coder rebuilt it. Between rebuilds every symbol is
+  *         decoded with single lookup table access, as in static mode.
+  * @param  pointer to the tree struct holding input and output buffers.
+  * @param  numberOfPixels number of pixels appended to output
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t decodePeriodic(tree* this, uint64_t numberOfPixels);
+
+#endif
@@ -0,0 +1,125 @@
+#include "rangeDecoder.h"
+
+/**
+  * @brief  Sets all frequencies to 1 and builds Fenwick tree of them.
+  * @param  model Pointer to model
+  * @retval None
+  */
+static void resetModel(frequencyModel* model)
+{
+    for (uint16_t symbol = 0; symbol < RANGE_SYMBOLS; symbol++)
+        model->frequency[symbol] = 1;
+    model->fenwick[0] = 0;
+    for (uint16_t i = 1; i <= RANGE_SYMBOLS; i++)
+        model->fenwick[i] = i & -i;
+    model->total = RANGE_SYMBOLS;
+}
+
+/**
+  * @brief  Halves all frequencies, keeping them above 0, and rebuilds Fenwick tree in place.
+  * @param  model Pointer to model
+  * @retval None
+  */
+static void rescaleModel(frequencyModel* model)
+{
+    model->total = 0;
+    for (uint16_t symbol = 0; symbol < RANGE_SYMBOLS; symbol++) {
+        model->frequency[symbol] = (model->frequency[symbol] + 1) >> 1;
+        model->fenwick[symbol + 1] = model->frequency[symbol];
+        model->total += model->frequency[symbol];
+    }
+    for (uint16_t i = 1; i <= RANGE_SYMBOLS; i++) {
+        uint16_t parent = i + (i & -i);
+        if (parent <= RANGE_SYMBOLS)
+            model->fenwick[parent] += model->fenwick[i];
+    }
+}
+
+/**
+  * @brief  Increments frequency of symbol, rescaling model when total grows too large.
+  * @param  model Pointer to model
+  * @param  symbol Symbol value
+  * @retval None
+  */
+static void updateModel(frequencyModel* model, uint8_t symbol)
+{
+    model->frequency[symbol] += RANGE_INCREMENT;
+    for (uint16_t i = symbol + 1; i <= RANGE_SYMBOLS; i += i & -i)
+        model->fenwick[i] += RANGE_INCREMENT;
+    model->total += RANGE_INCREMENT;
+    if (model->total > RANGE_MAX_TOTAL - RANGE_INCREMENT)
+        rescaleModel(model);
+}
+
+/**
+  * @brief  Finds symbol whose cumulative frequency interval contains value, descending
+  *         Fenwick tree from its largest power of two.
+  * @param  model Pointer to model
+  * @param  value Value below model total, replaced with cumulative frequency of found symbol
+  * @retval Found symbol
+  */
+static uint8_t findSymbol(const frequencyModel* model, uint32_t* value)
+{
+    uint32_t remainder = *value;
+    uint16_t position = 0;
+    for (uint16_t step = RANGE_SYMBOLS; step; step >>= 1) {
+        if (position + step <= RANGE_SYMBOLS && model->fenwick[position + step] <= remainder) {
+            position += step;
+            remainder -= model->fenwick[position];
+        }
+    }
+    *value -= remainder;
+    return (uint8_t)position;
+}
+
+uint8_t decodeRange(tree* this, uint64_t numberOfPixels)
+{
+    frequencyModel model;
+    const uint8_t* data = this->input->baseBuffer->dataBuffer;
+    uint64_t position = this->input->currentByte;
+    uint64_t end = this->input->lastByte;
+    uint32_t range = 0xFFFFFFFFu;
+    uint32_t code = 0;
+
+    if (this->header.bytesPerSample > 1) {
+        printf("Koder zakresowy obsługuje tylko próbki 8-bitowe!\n");
+        return 1;
+    }
+    if (end - position < RANGE_FLUSH_BYTES) {
+        printf("Skompresowany plik jest niekompletny!\n");
+        return 1;
+    }
+    // First byte is always 0, coder holds it back for carry
+    for (uint8_t i = 0; i < RANGE_FLUSH_BYTES; i++)
+        code = (code << BITS_IN_BYTE) | data[position++];
+    if (reserveBytes(this->output, this->output->currentByte + numberOfPixels)) return 1;
+    uint8_t* pixels = &this->output->baseBuffer->dataBuffer[this->output->currentByte];
+
+    resetModel(&model);
+    for (uint64_t pixel = 0; pixel < numberOfPixels; pixel++) {
+        uint32_t step = range / model.total;
+        uint32_t value = code / step;
+        if (value >= model.total) {
+            printf("Skompresowany plik jest uszkodzony!\n");
+            return 1;
+        }
+        uint8_t symbol = findSymbol(&model, &value);
+        code -= step * value;
+        range = step * model.frequency[symbol];
+        // Bytes past end of data were never written by coder, they are read as 0
+        while (range < RANGE_TOP) {
+            code = (code << BITS_IN_BYTE) | (position < end ? data[position] : 0);
+            position++;
+            range <<= BITS_IN_BYTE;
+        }
+        pixels[pixel] = symbol;
+        updateModel(&model, symbol);
+    }
+    if (position > end) {
+        printf("Skompresowany plik jest niekompletny!\n");
+        return 1;
+    }
+    this->output->currentByte += numberOfPixels;
+    this->input->currentByte = position;
+    return 0;
+}
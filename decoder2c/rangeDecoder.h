@@ -0,0 +1,35 @@
+#ifndef RANGE_DECODER_H
+#define RANGE_DECODER_H
+
+#define RANGE_SYMBOLS 256
+// Frequencies are halved when their total would exceed RANGE_MAX_TOTAL
+#define RANGE_MAX_TOTAL (1 << 16)
+#define RANGE_INCREMENT 24
+#define RANGE_TOP (1u << 24)
+#define RANGE_FLUSH_BYTES 5
+
+#include "decoderOperations.h"
+
+/**
+ * @brief:  Adaptive frequency model of 8 bit symbols, the same as coder's. Cumulative
+ *          frequencies are kept in Fenwick tree, which is also searched for decoded symbol.
+ * @frequency: Current frequency of each symbol, never 0.
+ * @fenwick: Fenwick tree of frequencies, entry i holds sum of frequencies (i - lowbit(i), i].
+ * @total: Sum of all frequencies.
+ */
+typedef struct frequencyModel {
+    uint16_t frequency[RANGE_SYMBOLS];
+    uint32_t fenwick[RANGE_SYMBOLS + 1];
+    uint32_t total;
+} frequencyModel;
+
+/**
+  * @brief: Decodes data compressed with range coder, updating frequency model after each
+  *         symbol exactly as coder did.
+  * @param  pointer to the tree struct holding input and output buffers.
+  * @param  numberOfPixels number of pixels appended to output
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t decodeRange(tree* this, uint64_t numberOfPixels);
+
+#endif
@@ -0,0 +1,47 @@
+#include "runLengthDecoder.h"
+
+uint8_t decodeRunLength(tree* this, uint64_t numberOfPixels)
+{
+    const uint8_t* data = this->input->baseBuffer->dataBuffer;
+    uint64_t position = this->input->currentByte;
+    uint64_t end = this->input->lastByte;
+
+    uint8_t bytesPerSample = this->header.bytesPerSample;
+    if (reserveBytes(this->output, this->output->currentByte + numberOfPixels * bytesPerSample)) return 1;
+    uint8_t* pixels = &this->output->baseBuffer->dataBuffer[this->output->currentByte];
+
+    uint64_t pixel = 0;
+    while (pixel < numberOfPixels) {
+        if (end - position < bytesPerSample) {
+            printf("Skompresowany plik jest niekompletny!\n");
+            return 1;
+        }
+        const uint8_t* value = &data[position];
+        position += bytesPerSample;
+        uint64_t length = 0;
+        uint8_t shift = 0;
+        do {
+            if (position >= end || shift >= 64) {
+                printf("Skompresowany plik jest niekompletny lub uszkodzony!\n");
+                return 1;
+            }
+            length |= (uint64_t)(data[position] & RUN_LENGTH_PAYLOAD) << shift;
+            shift += RUN_LENGTH_PAYLOAD_BITS;
+        } while (data[position++] & RUN_LENGTH_CONTINUE);
+
+        if (length >= numberOfPixels - pixel) {
+            printf("Skompresowany plik jest uszkodzony!\n");
+            return 1;
+        }
+        if (bytesPerSample == 1) {
+            memset(&pixels[pixel], value[0], length + 1);
+        } else {
+            for (uint64_t i = pixel; i <= pixel + length; i++)
+                memcpy(&pixels[2 * i], value, 2);
+        }
+        pixel += length + 1;
+    }
+    this->output->currentByte += numberOfPixels * bytesPerSample;
+    this->input->currentByte = position;
+    return 0;
+}
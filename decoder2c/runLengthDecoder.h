@@ -0,0 +1,20 @@
+#ifndef RUN_LENGTH_DECODER_H
+#define RUN_LENGTH_DECODER_H
+
+// Run length is written as unsigned LEB128: 7 bits per byte, MSB set if more bytes follow
+#define RUN_LENGTH_CONTINUE 0x80
+#define RUN_LENGTH_PAYLOAD 0x7F
+#define RUN_LENGTH_PAYLOAD_BITS 7
+
+#include "decoderOperations.h"
+
+/**
+  * @brief: Decodes runs of equal samples, each written as sample value (1 or 2 bytes) followed
+  *         by run length minus one in LEB128 bytes. Runs of 8 bit samples are filled with memset.
+  * @param  pointer to the tree struct holding input and output buffers.
+  * @param  numberOfPixels number of pixels appended to output
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t decodeRunLength(tree* this, uint64_t numberOfPixels);
+
+#endif
@@ -0,0 +1,295 @@
+#include "sequenceDecoder.h"
+#include "dictionaryDecoder.h"
+
+/**
+ * @brief:  Leaf of tree rebuilt from counts.
+ * @count: Count of symbol.
+ * @symbol: Sample value.
+ */
+typedef struct countedLeaf {
+    uint64_t count;
+    uint16_t symbol;
+} countedLeaf;
+
+/**
+  * @brief  Orders leaves by count, then by symbol, exactly as coder does.
+  */
+static int compareLeaves(const void* first, const void* second)
+{
+    const countedLeaf* a = (const countedLeaf*)first;
+    const countedLeaf* b = (const countedLeaf*)second;
+    if (a->count != b->count) return a->count < b->count ? -1 : 1;
+    return (a->symbol > b->symbol) - (a->symbol < b->symbol);
+}
+
+/**
+  * @brief  Builds Huffman tree from leaf counts with two queues, sorted leaves and internal
+  *         nodes, numbering nodes from last merge to first exactly as coder does, so counts do
+  *         not grow with position and NewSymbol node of zero count is last.
+  * @param  leaves leaves sorted by count, NewSymbol node first
+  * @param  numberOfLeaves number of leaves, at least 2
+  * @param  nodes array receiving 2 * numberOfLeaves - 1 nodes
+  * @retval 0 on success, 1 if memory allocation fails
+  */
+static uint8_t buildTree(const countedLeaf* leaves, uint32_t numberOfLeaves, dictionaryNode* nodes)
+{
+    uint32_t numberOfNodes = 2 * numberOfLeaves - 1;
+    uint64_t* weight = (uint64_t*)malloc(numberOfNodes * sizeof(uint64_t));
+    uint32_t* smaller = (uint32_t*)malloc(numberOfLeaves * sizeof(uint32_t));
+    uint32_t* larger = (uint32_t*)malloc(numberOfLeaves * sizeof(uint32_t));
+    uint32_t* position = (uint32_t*)malloc(numberOfNodes * sizeof(uint32_t));
+    if (!weight || !smaller || !larger || !position) {
+        printf("Błąd podczas alokowania pamięci na drzewo!\n");
+        free(weight);
+        free(smaller);
+        free(larger);
+        free(position);
+        return 1;
+    }
+    for (uint32_t i = 0; i < numberOfLeaves; i++)
+        weight[i] = leaves[i].count;
+
+    // Two smallest of leaf and internal queue are merged, leaves win ties
+    uint32_t nextLeaf = 0, nextInternal = numberOfLeaves;
+    for (uint32_t merge = 0; merge + 1 < numberOfLeaves; merge++) {
+        uint32_t pair[2];
+        for (uint8_t i = 0; i < 2; i++) {
+            if (nextLeaf < numberOfLeaves && (nextInternal == numberOfLeaves + merge || weight[nextLeaf] <= weight[nextInternal]))
+                pair[i] = nextLeaf++;
+            else
+                pair[i] = nextInternal++;
+        }
+        smaller[merge] = pair[0];
+        larger[merge] = pair[1];
+        weight[numberOfLeaves + merge] = weight[pair[0]] + weight[pair[1]];
+    }
+
+    position[numberOfNodes - 1] = 0;
+    nodes[0].count = weight[numberOfNodes - 1];
+    nodes[0].parent = 0;
+    nodes[0].symbol = 0;
+    nodes[0].flags = 0;
+    uint32_t nextPosition = 1;
+    for (uint32_t merge = numberOfLeaves - 1; merge-- > 0;) {
+        uint32_t parent = position[numberOfLeaves + merge];
+        uint32_t children[2] = { larger[merge], smaller[merge] };
+        for (uint8_t i = 0; i < 2; i++) {
+            dictionaryNode* node = &nodes[nextPosition];
+            position[children[i]] = nextPosition++;
+            node->count = weight[children[i]];
+            node->parent = parent;
+            node->symbol = children[i] < numberOfLeaves ? leaves[children[i]].symbol : 0;
+            node->flags = (children[i] < numberOfLeaves ? DICTIONARY_LEAF : 0) | (i ? DICTIONARY_LINK1 : 0);
+        }
+    }
+    free(weight);
+    free(smaller);
+    free(larger);
+    free(position);
+    return 0;
+}
+
+/**
+  * @brief  Ages tree carried from previous frame as coder does: counts of its symbols are
+  *         divided by 2 to given power, rounding up, and tree is built again from them.
+  * @param  this pointer to the tree struct with tree of previous frame
+  * @param  shift power of 2 counts are divided by, 0 to keep tree unchanged
+  * @retval 0 if tree was aged, 1 if memory allocation fails
+  */
+static uint8_t ageTree(tree* this, uint8_t shift)
+{
+    if (!shift) return 0;
+    // Leaves are nodes without children, except NewSymbol node, which is last
+    uint32_t numberOfLeaves = 1;
+    for (uint32_t i = 1; i < this->lastNode; i++)
+        numberOfLeaves += this->nodes[i]->link0 == NULL;
+    countedLeaf* leaves = (countedLeaf*)malloc(numberOfLeaves * sizeof(countedLeaf));
+    dictionaryNode* nodes = (dictionaryNode*)malloc((2 * (size_t)numberOfLeaves - 1) * sizeof(dictionaryNode));
+    if (!leaves || !nodes || numberOfLeaves < 2) {
+        printf(numberOfLeaves < 2 ? "Skompresowany plik jest uszkodzony!\n" : "Błąd podczas alokowania pamięci na drzewo!\n");
+        free(leaves);
+        free(nodes);
+        return 1;
+    }
+    uint64_t rootCount = this->nodes[0]->count;
+    while (shift < 63 && (rootCount >> shift) + numberOfLeaves - 1 > UINT32_MAX)
+        shift++;
+    leaves[0].count = 0;
+    leaves[0].symbol = 0;
+    uint32_t leaf = 1;
+    for (uint32_t i = 1; i < this->lastNode; i++) {
+        const node* _node = this->nodes[i];
+        if (_node->link0) continue;
+        leaves[leaf].count = ((_node->count - 1) >> shift) + 1;
+        leaves[leaf++].symbol = _node->value;
+    }
+    qsort(&leaves[1], numberOfLeaves - 1, sizeof(countedLeaf), compareLeaves);
+    uint8_t status = buildTree(leaves, numberOfLeaves, nodes) || restoreTree(this, nodes, 2 * numberOfLeaves - 1);
+    free(leaves);
+    free(nodes);
+    return status;
+}
+
+/**
+  * @brief  Adds samples of previous frame to differences decoded for frame, modulo alphabet
+  *         size, 16 bit samples in big-endian order.
+  * @param  samples differences, replaced by samples of frame
+  * @param  previous samples of previous frame
+  * @param  numberOfSamples number of samples of frame
+  * @param  bytesPerSample size of samples
+  * @retval None
+  */
+static void restoreFrame(uint8_t* samples, const uint8_t* previous, uint64_t numberOfSamples, uint8_t bytesPerSample)
+{
+    if (bytesPerSample == 1) {
+        for (uint64_t i = 0; i < numberOfSamples; i++)
+            samples[i] = (uint8_t)(samples[i] + previous[i]);
+        return;
+    }
+    for (uint64_t i = 0; i < 2 * numberOfSamples; i += 2) {
+        uint16_t sample = (uint16_t)(((samples[i] << BITS_IN_BYTE) | samples[i + 1]) + ((previous[i] << BITS_IN_BYTE) | previous[i + 1]));
+        samples[i] = (uint8_t)(sample >> BITS_IN_BYTE);
+        samples[i + 1] = (uint8_t)sample;
+    }
+}
+
+/**
+  * @brief  Reads whole sequence file into memory.
+  * @param  path to sequence file
+  * @param  length pointer receiving length of file
+  * @retval pointer to allocated contents of file, NULL otherwise
+  */
+static uint8_t* loadSequence(const char* path, uint64_t* length)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Nie udało się otworzyć sekwencji %s!\n", path);
+        return NULL;
+    }
+    long size = fseek(file, 0, SEEK_END) ? -1 : ftell(file);
+    uint8_t* data = size > 0 ? (uint8_t*)malloc((size_t)size) : NULL;
+    uint8_t status = !data || fseek(file, 0, SEEK_SET) || fread(data, 1, (size_t)size, file) != (size_t)size;
+    fclose(file);
+    if (status) {
+        printf("Nie udało się wczytać sekwencji %s!\n", path);
+        free(data);
+        return NULL;
+    }
+    *length = (uint64_t)size;
+    return data;
+}
+
+/**
+  * @brief  Checks header of compressed file of frame: single channel image coded as single
+  *         adaptive block, of the same size as first decoded frame.
+  * @param  header header of frame
+  * @param  first header of first decoded frame
+  * @retval 0 if frame can be decoded, 1 otherwise
+  */
+static uint8_t checkFrame(const imageHeader* header, const imageHeader* first)
+{
+    if (header->mode != MODE_ADAPTIVE_HUFFMAN || header->channels != 1 || header->dictionaryId || header->scanOrder != SCAN_ROW ||
+        header->width != first->width || header->height != first->height || header->maxGreyLevel != first->maxGreyLevel) {
+        printf("Klatka sekwencji jest uszkodzona!\n");
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t decodeSequence(const char* sequencePath, uint32_t firstFrame, uint32_t numberOfFrames, const char* outputPrefix)
+{
+    uint64_t length = 0;
+    uint8_t* data = loadSequence(sequencePath, &length);
+    if (!data) return 1;
+    const uint8_t magic[] = SEQUENCE_MAGIC;
+    if (length < SEQUENCE_HEADER_LENGTH || memcmp(data, magic, sizeof(magic)) || data[4] != SEQUENCE_VERSION) {
+        printf("Plik nie jest sekwencją klatek!\n");
+        free(data);
+        return 1;
+    }
+    uint8_t predictor = data[5] & SEQUENCE_PREDICT_PREVIOUS;
+    uint8_t ageShift = data[6];
+    uint32_t storedFrames = loadBigEndian(&data[12], 4);
+    if (!numberOfFrames || firstFrame >= storedFrames || numberOfFrames > storedFrames - firstFrame) {
+        printf("Sekwencja zawiera tylko %u klatek!\n", storedFrames);
+        free(data);
+        return 1;
+    }
+
+    // Frames are walked up to last requested one, decoding starts at nearest keyframe before first
+    uint32_t lastFrame = firstFrame + numberOfFrames;
+    uint64_t* offsets = (uint64_t*)malloc(lastFrame * sizeof(uint64_t));
+    char* path = (char*)malloc(strlen(outputPrefix) + 16);
+    uint8_t status = !offsets || !path;
+    if (status) printf("Błąd podczas alokowania pamięci na sekwencję!\n");
+    uint64_t offset = SEQUENCE_HEADER_LENGTH;
+    uint32_t startFrame = 0;
+    for (uint32_t frame = 0; frame < lastFrame && !status; frame++) {
+        if (length - offset < SEQUENCE_FRAME_HEADER_LENGTH ||
+            loadBigEndian(&data[offset + 1], 4) > length - offset - SEQUENCE_FRAME_HEADER_LENGTH) {
+            printf("Sekwencja jest niekompletna lub uszkodzona!\n");
+            status = 1;
+            break;
+        }
+        offsets[frame] = offset;
+        if (frame <= firstFrame && data[offset] & SEQUENCE_KEYFRAME)
+            startFrame = frame;
+        offset += SEQUENCE_FRAME_HEADER_LENGTH + loadBigEndian(&data[offset + 1], 4);
+    }
+    if (!status && !(data[offsets[startFrame]] & SEQUENCE_KEYFRAME)) {
+        printf("Sekwencja nie zaczyna się od klatki kluczowej!\n");
+        status = 1;
+    }
+
+    // Tree and its nodes are kept from frame to frame, only compressed data is replaced
+    tree* tree = NULL;
+    imageHeader first;
+    uint8_t* previous = NULL;
+    for (uint32_t frame = startFrame; frame < lastFrame && !status; frame++) {
+        const uint8_t* stored = &data[offsets[frame]];
+        uint8_t flags = stored[0];
+        uint32_t frameLength = loadBigEndian(&stored[1], 4);
+        if (!tree) {
+            tree = createTreeFromMemory(&stored[SEQUENCE_FRAME_HEADER_LENGTH], frameLength);
+            status = !tree;
+            if (tree) first = tree->header;
+        } else {
+            uint32_t lastNode = tree->lastNode;
+            status = restartTree(tree, &stored[SEQUENCE_FRAME_HEADER_LENGTH], frameLength);
+            tree->lastNode = lastNode;
+        }
+        if (status || checkFrame(&tree->header, &first)) {
+            status = 1;
+            break;
+        }
+        uint64_t numberOfPixels = (uint64_t)first.width * first.height;
+        uint64_t numberOfBytes = numberOfPixels * first.bytesPerSample;
+        status = reserveBytes(tree->output, numberOfBytes) ||
+                 (flags & (SEQUENCE_KEYFRAME | SEQUENCE_NEW_TREE) ? decodeBlock(tree, MODE_ADAPTIVE_HUFFMAN, numberOfPixels)
+                                                                  : ageTree(tree, ageShift) || resumeAdaptive(tree, numberOfBytes));
+        if (status) break;
+
+        uint8_t* samples = tree->output->baseBuffer->dataBuffer;
+        if (predictor) {
+            if (!previous) previous = (uint8_t*)malloc(numberOfBytes);
+            if (!previous) {
+                printf("Błąd podczas alokowania pamięci na klatkę!\n");
+                status = 1;
+                break;
+            }
+            if (!(flags & SEQUENCE_KEYFRAME))
+                restoreFrame(samples, previous, numberOfPixels, first.bytesPerSample);
+            memcpy(previous, samples, numberOfBytes);
+        }
+        if (frame >= firstFrame) {
+            sprintf(path, "%s%u.pgm", outputPrefix, frame);
+            status = writeDecompressedFile(tree->output, &tree->header, path);
+        }
+    }
+    if (tree) freeTree(&tree);
+    free(previous);
+    free(path);
+    free(offsets);
+    free(data);
+    return status;
+}
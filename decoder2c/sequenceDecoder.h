@@ -0,0 +1,31 @@
+#ifndef SEQUENCE_DECODER_H
+#define SEQUENCE_DECODER_H
+
+// Sequence: header followed by frames. Header: magic, version, flags, age shift, reserved byte,
+// keyframe interval (4 bytes) and number of frames (4 bytes).
+#define SEQUENCE_MAGIC { 0x8B, 'K', 'D', 'S' }
+#define SEQUENCE_VERSION 1
+#define SEQUENCE_HEADER_LENGTH 16
+#define SEQUENCE_PREDICT_PREVIOUS 0x01
+// Frame: flags and length (4 bytes) of compressed file of frame, single adaptive block of
+// single channel image. Frames other than keyframes continue tree of previous frame, aged
+// first when age shift is set, and with predictor hold differences from previous frame.
+#define SEQUENCE_FRAME_HEADER_LENGTH 5
+#define SEQUENCE_KEYFRAME 0x01
+#define SEQUENCE_NEW_TREE 0x02
+
+#include "decoderOperations.h"
+
+/**
+  * @brief: Decodes frames of sequence into PGM files named after prefix and number of frame.
+  *         Decoding starts at nearest keyframe before first requested frame, frames before
+  *         first requested one are decoded, but not written.
+  * @param  sequencePath path to sequence file
+  * @param  firstFrame number of first decoded frame, counted from 0
+  * @param  numberOfFrames number of decoded frames
+  * @param  outputPrefix prefix of paths to PGM files, followed by number of frame and ".pgm"
+  * @retval 0 if every frame was decoded, 1 otherwise
+  */
+uint8_t decodeSequence(const char* sequencePath, uint32_t firstFrame, uint32_t numberOfFrames, const char* outputPrefix);
+
+#endif
@@ -0,0 +1,75 @@
+#include "staticDecoder.h"
+
+uint8_t buildLookupTable(const uint8_t* lengths, uint8_t maxLength, uint16_t* table)
+{
+    uint32_t nextCode = 0;
+    uint32_t tableSize = (uint32_t)1 << maxLength;
+    memset(table, 0, tableSize * sizeof(uint16_t));
+
+    // Canonical codes: consecutive values within each length, ordered by symbol value
+    for (uint8_t length = 1; length <= maxLength; length++) {
+        for (uint16_t symbol = 0; symbol < NUMBER_OF_SYMBOLS; symbol++) {
+            if (lengths[symbol] != length) continue;
+            uint32_t first = nextCode << (maxLength - length);
+            uint32_t last = (nextCode + 1) << (maxLength - length);
+            if (last > tableSize) {
+                printf("Nieprawidłowe długości słów kodowych!\n");
+                return 1;
+            }
+            for (uint32_t entry = first; entry < last; entry++)
+                table[entry] = (symbol << LENGTH_BITS) | length;
+            nextCode++;
+        }
+        nextCode <<= 1;
+    }
+    return 0;
+}
+
+uint8_t decodeStatic(tree* this, uint64_t numberOfPixels)
+{
+    uint8_t lengths[NUMBER_OF_SYMBOLS];
+    uint16_t table[LOOKUP_TABLE_SIZE];
+    const uint8_t* data = this->input->baseBuffer->dataBuffer;
+    uint64_t position = this->input->currentByte;
+    uint64_t end = this->input->lastByte;
+
+    if (this->header.bytesPerSample > 1) {
+        printf("Kod statyczny obsługuje tylko próbki 8-bitowe!\n");
+        return 1;
+    }
+    if (end - position < CODE_LENGTHS_BYTES) {
+        printf("Skompresowany plik jest niekompletny!\n");
+        return 1;
+    }
+    for (uint16_t i = 0; i < CODE_LENGTHS_BYTES; i++) {
+        lengths[2 * i] = data[position] >> LENGTH_BITS;
+        lengths[2 * i + 1] = data[position] & LENGTH_MASK;
+        position++;
+    }
+    if (buildLookupTable(lengths, MAX_CODE_LENGTH, table)) return 1;
+    if (reserveBytes(this->output, this->output->currentByte + numberOfPixels)) return 1;
+
+    // Bits are consumed from MSB of window, which is refilled byte by byte
+    uint8_t* pixels = &this->output->baseBuffer->dataBuffer[this->output->currentByte];
+    uint64_t window = 0;
+    uint8_t bitsInWindow = 0;
+    for (uint64_t pixel = 0; pixel < numberOfPixels; pixel++) {
+        while (bitsInWindow <= 56 && position < end) {
+            window |= (uint64_t)data[position++] << (56 - bitsInWindow);
+            bitsInWindow += BITS_IN_BYTE;
+        }
+        uint16_t entry = table[window >> (64 - MAX_CODE_LENGTH)];
+        uint8_t length = entry & LENGTH_MASK;
+        if (!length || length > bitsInWindow) {
+            printf("Skompresowany plik jest niekompletny lub uszkodzony!\n");
+            return 1;
+        }
+        pixels[pixel] = entry >> LENGTH_BITS;
+        window <<= length;
+        bitsInWindow -= length;
+    }
+    this->output->currentByte += numberOfPixels;
+    // Whole bytes left in window belong to next block
+    this->input->currentByte = position - bitsInWindow / BITS_IN_BYTE;
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef STATIC_DECODER_H
+#define STATIC_DECODER_H
+
+#define NUMBER_OF_SYMBOLS 256
+#define MAX_CODE_LENGTH 12
+#define CODE_LENGTHS_BYTES (NUMBER_OF_SYMBOLS / 2)
+#define LOOKUP_TABLE_SIZE (1 << MAX_CODE_LENGTH)
+#define LENGTH_BITS 4
+#define LENGTH_MASK 0x0F
+
+#include "decoderOperations.h"
+
+/**
+  * @brief  Builds lookup table from code lengths. Each entry holds symbol value and length
+  *         of its code, all entries starting with the same code point to the same symbol.
+  * @param  lengths Code length of each symbol, 0 for absent symbols
+  * @param  maxLength Longest code length, table is indexed with this many bits
+  * @param  table Array of 2^maxLength entries, entries not covered by any code are 0
+  * @retval 0 if lengths describe valid prefix code, 1 otherwise
+  */
+uint8_t buildLookupTable(const uint8_t* lengths, uint8_t maxLength, uint16_t* table);
+
+/**
+  * @brief: Decodes data compressed with static canonical Huffman code. Code lengths stored
+  *         before codes are turned into lookup table indexed with next MAX_CODE_LENGTH
+  *         bits of stream, so each symbol is decoded with single table access.
+  * @param  pointer to the tree struct holding input and output buffers.
+  * @param  numberOfPixels number of pixels appended to output
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t decodeStatic(tree* this, uint64_t numberOfPixels);
+
+#endif
@@ -0,0 +1,257 @@
+#include "tileDecoder.h"
+
+/**
+ * @brief: Position of block placed into image along scan path.
+ * @block: next sample of block
+ * @image: first sample of block channel in image
+ * @rowLength: number of bytes of image row
+ * @pixelLength: number of bytes of image pixel
+ * @bytesPerSample: number of bytes of sample
+ */
+typedef struct placement {
+    const uint8_t* block;
+    uint8_t* image;
+    uint64_t rowLength;
+    uint64_t pixelLength;
+    uint8_t bytesPerSample;
+} placement;
+
+/**
+  * @brief  Decodes block of samples into block buffer instead of image.
+  * @param  this pointer to the tree struct with input positioned at block
+  * @param  block buffer receiving block samples
+  * @param  mode coding mode of block
+  * @param  numberOfPixels number of samples in block
+  * @retval 0 if block decompressed successfully, 1 on error
+  */
+static uint8_t decodeIntoBuffer(tree* this, byteBuffer* block, uint8_t mode, uint64_t numberOfPixels)
+{
+    byteBuffer* image = this->output;
+    block->currentByte = 0;
+    this->output = block;
+    uint8_t status = decodeBlock(this, mode, numberOfPixels);
+    this->output = image;
+    return status;
+}
+
+/**
+  * @brief  Copies segment of scan path of block from block samples into image.
+  * @param  context pointer to placement
+  * @param  row row of first sample, relative to block
+  * @param  column column of first sample, relative to block
+  * @param  length number of samples of segment
+  * @param  rowStep row step between samples
+  * @param  columnStep column step between samples
+  * @retval None
+  */
+static void placeSegment(void* context, uint32_t row, uint32_t column, uint32_t length, int8_t rowStep, int8_t columnStep)
+{
+    placement* target = (placement*)context;
+    uint8_t bytesPerSample = target->bytesPerSample;
+    int64_t step = rowStep * (int64_t)target->rowLength + columnStep * (int64_t)target->pixelLength;
+    uint8_t* destination = &target->image[row * target->rowLength + column * target->pixelLength];
+
+    // Forward segments of single channel rows are consecutive bytes
+    if (target->pixelLength == bytesPerSample && step == bytesPerSample) {
+        memcpy(destination, target->block, (size_t)length * bytesPerSample);
+        target->block += (size_t)length * bytesPerSample;
+        return;
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        destination[0] = target->block[0];
+        if (bytesPerSample == 2)
+            destination[1] = target->block[1];
+        target->block += bytesPerSample;
+        destination += step;
+    }
+}
+
+/**
+  * @brief  Copies samples of single channel block into their place in image, following scan
+  *         path of file. Rows of single channel images read row by row are copied whole.
+  * @param  this pointer to the tree struct holding image header and output buffer
+  * @param  block samples of block in scan order
+  * @param  row first row of block in image
+  * @param  column first column of block in image
+  * @param  rows number of rows of block
+  * @param  columns number of columns of block
+  * @param  channel channel of block
+  * @retval None
+  */
+static void placeBlock(tree* this, const uint8_t* block, uint32_t row, uint32_t column, uint32_t rows, uint32_t columns, uint8_t channel)
+{
+    uint8_t bytesPerSample = this->header.bytesPerSample;
+    uint64_t pixelLength = (uint64_t)this->header.channels * bytesPerSample;
+    uint64_t rowLength = (uint64_t)this->header.width * pixelLength;
+    uint8_t* image = this->output->baseBuffer->dataBuffer;
+    placement target = {
+        .block = block,
+        .image = &image[row * rowLength + column * pixelLength + channel * bytesPerSample],
+        .rowLength = rowLength,
+        .pixelLength = pixelLength,
+        .bytesPerSample = bytesPerSample,
+    };
+    walkScan(this->header.scanOrder, rows, columns, placeSegment, &target);
+}
+
+/**
+  * @brief  Decodes single tile into tile buffer. Input is limited to tile payload, so
+  *         damaged tile can not read data of the next one.
+  * @param  this pointer to the tree struct with input positioned at tile header
+  * @param  tile buffer receiving tile pixels
+  * @param  numberOfPixels number of pixels in tile
+  * @retval 0 if tile decompressed successfully, 1 on error
+  */
+static uint8_t decodeTile(tree* this, byteBuffer* tile, uint64_t numberOfPixels)
+{
+    bitBuffer* input = this->input;
+    if (input->lastByte - input->currentByte < TILE_HEADER_LENGTH) {
+        printf("Skompresowany plik jest niekompletny!\n");
+        return 1;
+    }
+    const uint8_t* tileHeader = &input->baseBuffer->dataBuffer[input->currentByte];
+    uint8_t mode = tileHeader[0];
+    uint64_t payloadLength = loadBigEndian(&tileHeader[1], TILE_HEADER_LENGTH - 1);
+    input->currentByte += TILE_HEADER_LENGTH;
+    if (mode == MODE_TILED || mode == MODE_PAIR_HUFFMAN || mode == MODE_BIT_PLANE || input->lastByte - input->currentByte < payloadLength) {
+        printf("Skompresowany plik jest niekompletny lub uszkodzony!\n");
+        return 1;
+    }
+
+    // Decode into tile buffer, limiting input to payload of the tile
+    uint64_t lastByte = input->lastByte;
+    uint64_t tileEnd = input->currentByte + payloadLength;
+    input->lastByte = tileEnd;
+    input->currentShift = 0;
+    uint8_t status = decodeIntoBuffer(this, tile, mode, numberOfPixels);
+    input->lastByte = lastByte;
+    input->currentByte = tileEnd;
+    input->currentShift = 0;
+    return status;
+}
+
+/**
+  * @brief  Copies samples of earlier tile, already placed in image, to place of tile whose
+  *         header refers to it. Referred tile may belong to other channel.
+  * @param  this pointer to the tree struct with input positioned at tile header
+  * @param  tileSide side of tiles
+  * @param  block number of tile, counting channels of every tile
+  * @param  row first row of tile
+  * @param  column first column of tile
+  * @param  rows number of rows of tile
+  * @param  columns number of columns of tile
+  * @param  channel channel of tile
+  * @retval 0 if tile was copied, 1 if reference is not valid
+  */
+static uint8_t copyTile(tree* this, uint32_t tileSide, uint64_t block, uint32_t row, uint32_t column, uint32_t rows,
+                        uint32_t columns, uint8_t channel)
+{
+    bitBuffer* input = this->input;
+    const uint8_t* tileHeader = &input->baseBuffer->dataBuffer[input->currentByte];
+    if (input->lastByte - input->currentByte < TILE_HEADER_LENGTH + TILE_REFERENCE_LENGTH ||
+        loadBigEndian(&tileHeader[1], TILE_HEADER_LENGTH - 1) != TILE_REFERENCE_LENGTH) {
+        printf("Skompresowany plik jest niekompletny lub uszkodzony!\n");
+        return 1;
+    }
+    uint64_t reference = loadBigEndian(&tileHeader[TILE_HEADER_LENGTH], TILE_REFERENCE_LENGTH);
+    input->currentByte += TILE_HEADER_LENGTH + TILE_REFERENCE_LENGTH;
+
+    // Tiles are numbered in raster order, channels of each tile one after another
+    uint64_t tilesAcross = ((uint64_t)this->header.width + tileSide - 1) / tileSide;
+    // Earlier tile lies inside image, so its position does not need checking
+    uint64_t tile = reference / this->header.channels;
+    uint64_t otherRow = tile / tilesAcross * tileSide;
+    uint64_t otherColumn = tile % tilesAcross * tileSide;
+    uint64_t otherRows = this->header.height - otherRow < tileSide ? this->header.height - otherRow : tileSide;
+    uint64_t otherColumns = this->header.width - otherColumn < tileSide ? this->header.width - otherColumn : tileSide;
+    if (reference >= block || otherRows != rows || otherColumns != columns) {
+        printf("Kafelek odwołuje się do nieprawidłowego kafelka!\n");
+        return 1;
+    }
+
+    uint8_t bytesPerSample = this->header.bytesPerSample;
+    uint64_t pixelLength = (uint64_t)this->header.channels * bytesPerSample;
+    uint64_t rowLength = (uint64_t)this->header.width * pixelLength;
+    uint8_t* image = this->output->baseBuffer->dataBuffer;
+    const uint8_t* source = &image[otherRow * rowLength + otherColumn * pixelLength + reference % this->header.channels * bytesPerSample];
+    uint8_t* destination = &image[row * rowLength + column * pixelLength + channel * bytesPerSample];
+    for (uint32_t i = 0; i < rows; i++, source += rowLength, destination += rowLength) {
+        if (this->header.channels == 1) {
+            memcpy(destination, source, (size_t)columns * bytesPerSample);
+            continue;
+        }
+        for (uint64_t j = 0; j < (uint64_t)columns * pixelLength; j += pixelLength)
+            memcpy(&destination[j], &source[j], bytesPerSample);
+    }
+    return 0;
+}
+
+uint8_t decodeTiled(tree* this)
+{
+    bitBuffer* input = this->input;
+    uint32_t width = this->header.width;
+    uint32_t height = this->header.height;
+    uint64_t imageLength = (uint64_t)width * height * this->header.channels * this->header.bytesPerSample;
+
+    if (input->lastByte - input->currentByte < TILE_SIDE_LENGTH) {
+        printf("Skompresowany plik jest niekompletny!\n");
+        return 1;
+    }
+    uint32_t tileSide = loadBigEndian(&input->baseBuffer->dataBuffer[input->currentByte], TILE_SIDE_LENGTH);
+    input->currentByte += TILE_SIDE_LENGTH;
+    if (!tileSide) {
+        printf("Nieprawidłowy rozmiar kafelka!\n");
+        return 1;
+    }
+
+    // Tile side comes from file, so buffer holds largest tile of image rather than full tile
+    uint64_t tileRows = height < tileSide ? height : tileSide;
+    uint64_t tileColumns = width < tileSide ? width : tileSide;
+    byteBuffer* tile = createByteBuffer(BASE_BUFFER_SIZE);
+    if (!tile) return 1;
+    uint8_t status = reserveBytes(tile, tileRows * tileColumns * this->header.bytesPerSample) ||
+                     reserveBytes(this->output, imageLength);
+
+    uint64_t block = 0;
+    for (uint32_t row = 0; row < height && !status; row += tileSide) {
+        uint32_t rows = height - row < tileSide ? height - row : tileSide;
+        for (uint32_t column = 0; column < width && !status; column += tileSide) {
+            uint32_t columns = width - column < tileSide ? width - column : tileSide;
+            for (uint8_t channel = 0; channel < this->header.channels && !status; channel++, block++) {
+                // Tile equal to earlier one is copied from image, its payload was decoded once
+                if (input->currentByte < input->lastByte && input->baseBuffer->dataBuffer[input->currentByte] == MODE_DUPLICATE_TILE) {
+                    status = copyTile(this, tileSide, block, row, column, rows, columns, channel);
+                    continue;
+                }
+                status = decodeTile(this, tile, (uint64_t)rows * columns);
+                if (!status)
+                    placeBlock(this, tile->baseBuffer->dataBuffer, row, column, rows, columns, channel);
+            }
+        }
+    }
+    if (!status)
+        this->output->currentByte = imageLength;
+    tile->killMe(&tile);
+    return status;
+}
+
+uint8_t decodePlanes(tree* this)
+{
+    uint64_t numberOfPixels = (uint64_t)this->header.width * this->header.height;
+    uint64_t imageLength = numberOfPixels * this->header.channels * this->header.bytesPerSample;
+
+    byteBuffer* plane = createByteBuffer(BASE_BUFFER_SIZE);
+    if (!plane) return 1;
+    uint8_t status = reserveBytes(plane, numberOfPixels * this->header.bytesPerSample) ||
+                     reserveBytes(this->output, imageLength);
+
+    for (uint8_t channel = 0; channel < this->header.channels && !status; channel++) {
+        status = decodeIntoBuffer(this, plane, this->header.mode, numberOfPixels);
+        if (!status)
+            placeBlock(this, plane->baseBuffer->dataBuffer, 0, 0, this->header.height, this->header.width, channel);
+    }
+    if (!status)
+        this->output->currentByte = imageLength;
+    plane->killMe(&plane);
+    return status;
+}
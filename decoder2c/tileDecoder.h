@@ -0,0 +1,23 @@
+#ifndef TILE_DECODER_H
+#define TILE_DECODER_H
+
+#include "decoderOperations.h"
+
+/**
+  * @brief: Decodes image split into square tiles. Every channel of every tile is decoded with
+  *         its own mode into tile buffer, which is then copied into its place in image.
+  * @param  pointer to the tree struct holding input and output buffers and image header.
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t decodeTiled(tree* this);
+
+/**
+  * @brief: Decodes colour image, or image not read row by row, coded without tiles. Channels
+  *         are coded one after another, each plane is decoded into plane buffer and placed
+  *         into image along scan path of file.
+  * @param  pointer to the tree struct holding input and output buffers and image header.
+  * @retval 0 if data decompressed successfully, 1 on error
+  */
+uint8_t decodePlanes(tree* this);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef KODA_CODEC_H
+#define KODA_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief:  Image described by compressed file header.
+ * @width: Number of columns.
+ * @height: Number of rows.
+ * @maxGreyLevel: Max grey level of samples.
+ * @channels: 1 for grey image, 3 for colour image.
+ * @bytesPerSample: 1 for max grey level up to 255, 2 otherwise.
+ * @mode: Coding mode written in header.
+ * @dictionaryId: Identifier of dictionary adaptive blocks start from, 0 if none.
+ */
+typedef struct kodaImage {
+    uint32_t width;
+    uint32_t height;
+    uint16_t maxGreyLevel;
+    uint8_t channels;
+    uint8_t bytesPerSample;
+    uint8_t mode;
+    uint16_t dictionaryId;
+} kodaImage;
+
+/**
+  * @brief  Compresses raw samples with coder library into memory, without printing anything
+  *         on success.
+  * @param  samples Rows of interleaved samples, 16 bit samples in big-endian order
+  * @param  image Pointer to description of samples, mode is coding mode or MODE_AUTO
+  * @param  tileSide Side of tiles used in tiled mode, 0 for coder default
+  * @param  compressed Pointer receiving compressed file allocated with malloc()
+  * @param  compressedLength Pointer receiving length of compressed file
+  * @retval 0 if image was compressed, 1 otherwise
+  */
+uint8_t kodaEncode(uint8_t* samples, const kodaImage* image, uint16_t tileSide, uint8_t** compressed,
+                   size_t* compressedLength);
+
+/**
+  * @brief  Parses name of coding mode accepted by coder.
+  * @param  name Name of mode, e.g. "auto" or "adaptive"
+  * @param  mode Pointer receiving mode
+  * @retval 0 if name is known, 1 otherwise
+  */
+uint8_t kodaParseMode(const char* name, uint8_t* mode);
+
+/**
+  * @brief  Reads header of compressed file with decoder library.
+  * @param  data Compressed file
+  * @param  length Length of compressed file
+  * @param  image Pointer to structure receiving image description
+  * @retval 0 if header is valid, 1 otherwise
+  */
+uint8_t kodaReadHeader(const uint8_t* data, uint64_t length, kodaImage* image);
+
+/**
+  * @brief  Decompresses file with decoder library straight into caller buffer, samples are
+  *         interleaved and 16 bit samples are in big-endian order.
+  * @param  data Compressed file
+  * @param  length Length of compressed file
+  * @param  pixels Buffer receiving samples
+  * @param  capacity Size of buffer, all samples of image must fit in it
+  * @retval 0 if file was decompressed, 1 otherwise
+  */
+uint8_t kodaDecode(const uint8_t* data, uint64_t length, uint8_t* pixels, uint64_t capacity);
+
+/**
+  * @brief  Returns name of coding mode written in compressed file header.
+  * @param  mode Coding mode
+  * @retval Name accepted by coder, "unknown" for unknown mode
+  */
+const char* kodaModeName(uint8_t mode);
+
+#endif // KODA_CODEC_H
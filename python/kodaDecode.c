@@ -0,0 +1,57 @@
+#include "kodaCodec.h"
+#include "decoderOperations.h"
+#include "outputSink.h"
+
+uint8_t kodaReadHeader(const uint8_t* data, uint64_t length, kodaImage* image)
+{
+    // Header is read from copy of its own bytes only, not of whole compressed file
+    imageHeader header;
+    bitBuffer* input = createBitBufferFromMemory(BASE_BUFFER_SIZE, data, length < HEADER_LENGTH ? length : HEADER_LENGTH);
+    if (!input) return 1;
+    uint8_t status = readHeader(input, &header);
+    input->killMe(&input);
+    if (status) return 1;
+    image->width = header.width;
+    image->height = header.height;
+    image->maxGreyLevel = header.maxGreyLevel;
+    image->channels = header.channels;
+    image->bytesPerSample = header.bytesPerSample;
+    image->mode = header.mode;
+    image->dictionaryId = header.dictionaryId;
+    return 0;
+}
+
+uint8_t kodaDecode(const uint8_t* data, uint64_t length, uint8_t* pixels, uint64_t capacity)
+{
+    tree* tree = createTreeFromMemory(data, length);
+    if (!tree) return 1;
+    uint8_t status = useCallerBuffer(tree->output, pixels, capacity) || decodeData(tree);
+    freeTree(&tree);
+    return status;
+}
+
+const char* kodaModeName(uint8_t mode)
+{
+    switch (mode) {
+    case MODE_ADAPTIVE_HUFFMAN:
+        return "adaptive";
+    case MODE_STATIC_HUFFMAN:
+        return "static";
+    case MODE_STORED:
+        return "stored";
+    case MODE_RUN_LENGTH:
+        return "runlength";
+    case MODE_TILED:
+        return "tiled";
+    case MODE_RANGE:
+        return "range";
+    case MODE_PAIR_HUFFMAN:
+        return "pair";
+    case MODE_BIT_PLANE:
+        return "bitplane";
+    case MODE_PERIODIC_HUFFMAN:
+        return "periodic";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,45 @@
+// Compressed file is built in memory stream, open_memstream() is POSIX
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#define KODA_MEMORY_OUTPUT
+#endif
+#include "kodaCodec.h"
+#include "fileOperations.h"
+
+uint8_t kodaEncode(uint8_t* samples, const kodaImage* image, uint16_t tileSide, uint8_t** compressed,
+                   size_t* compressedLength)
+{
+    *compressed = NULL;
+    *compressedLength = 0;
+#ifdef KODA_MEMORY_OUTPUT
+    handler* handler = createHandler();
+    if (!handler) return 1;
+    handler->mode = image->mode;
+    if (tileSide) handler->tileSide = tileSide;
+    handler->quiet = 1;
+    handler->compressedFile = open_memstream((char**)compressed, compressedLength);
+    uint8_t status = !handler->compressedFile ||
+                     readDataFromPixels(&handler->records, samples, image->width, image->height, image->maxGreyLevel,
+                                        image->channels) ||
+                     initialize(handler, NULL, NULL) || compressData(handler);
+    freeAlocatedMemory(handler);
+    free(handler);
+    if (status) {
+        free(*compressed);
+        *compressed = NULL;
+        *compressedLength = 0;
+    }
+    return status;
+#else
+    (void)samples;
+    (void)image;
+    (void)tileSide;
+    printf("Error: Compressing into memory is not supported on this platform\n");
+    return 1;
+#endif
+}
+
+uint8_t kodaParseMode(const char* name, uint8_t* mode)
+{
+    return parseMode(name, mode);
+}
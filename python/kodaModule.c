@@ -0,0 +1,274 @@
+// Python extension "koda": encode() and decode() run coder and decoder libraries on pixels
+// held by any object exporting buffer protocol, e.g. numpy arrays
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "kodaCodec.h"
+
+#define KODA_MAX_DIMENSION UINT32_MAX
+
+/**
+  * @brief  Checks whether 16 bit samples of buffer format are stored in big-endian order.
+  * @param  format Struct format of buffer, NULL for unsigned bytes
+  * @param  itemSize Pointer receiving size of sample, 0 for unsupported format
+  * @retval 1 for big-endian samples, 0 otherwise
+  */
+static int isBigEndianFormat(const char* format, Py_ssize_t* itemSize)
+{
+    const uint16_t probe = 1;
+    int bigEndian = *(const uint8_t*)&probe == 0;
+    if (!format) format = "B";
+    if (*format == '<' || *format == '>' || *format == '!') {
+        bigEndian = *format != '<';
+        format++;
+    } else if (*format == '@' || *format == '=') {
+        format++;
+    }
+    *itemSize = !strcmp(format, "B") ? 1 : !strcmp(format, "H") ? 2 : 0;
+    return bigEndian;
+}
+
+/**
+  * @brief  Swaps bytes of every 16 bit sample, converting between big-endian and native order.
+  * @param  destination Buffer receiving swapped samples, may be the same as source
+  * @param  source Samples to swap
+  * @param  numberOfSamples Number of samples
+  * @retval None
+  */
+static void swapSamples(uint8_t* destination, const uint8_t* source, uint64_t numberOfSamples)
+{
+    for (uint64_t i = 0; i < numberOfSamples; i++) {
+        uint8_t high = source[2 * i];
+        destination[2 * i] = source[2 * i + 1];
+        destination[2 * i + 1] = high;
+    }
+}
+
+/**
+  * @brief  Describes image held in buffer: rows, columns and optional channels, 8 or 16 bit
+  *         unsigned samples.
+  * @param  view Pointer to C-contiguous buffer
+  * @param  image Pointer to image description receiving dimensions
+  * @param  bigEndian Pointer receiving 1 if 16 bit samples are in big-endian order
+  * @retval 0 if buffer holds supported image, -1 with Python exception set otherwise
+  */
+static int describeBuffer(const Py_buffer* view, kodaImage* image, int* bigEndian)
+{
+    Py_ssize_t itemSize;
+    *bigEndian = isBigEndianFormat(view->format, &itemSize);
+    if (!itemSize || itemSize != view->itemsize) {
+        PyErr_Format(PyExc_TypeError, "samples must be uint8 or uint16, got format '%s'", view->format ? view->format : "B");
+        return -1;
+    }
+    if (view->ndim != 2 && view->ndim != 3) {
+        PyErr_SetString(PyExc_ValueError, "image must have shape (height, width) or (height, width, channels)");
+        return -1;
+    }
+    Py_ssize_t channels = view->ndim == 3 ? view->shape[2] : 1;
+    if (channels != 1 && channels != 3) {
+        PyErr_SetString(PyExc_ValueError, "image must have 1 or 3 channels");
+        return -1;
+    }
+    if (view->shape[0] < 1 || view->shape[1] < 1 || (uint64_t)view->shape[0] > KODA_MAX_DIMENSION ||
+        (uint64_t)view->shape[1] > KODA_MAX_DIMENSION) {
+        PyErr_SetString(PyExc_ValueError, "image must have between 1 and 4294967295 rows and columns");
+        return -1;
+    }
+    image->height = (uint32_t)view->shape[0];
+    image->width = (uint32_t)view->shape[1];
+    image->channels = (uint8_t)channels;
+    image->bytesPerSample = (uint8_t)itemSize;
+    return 0;
+}
+
+static PyObject* encode(PyObject* self, PyObject* args, PyObject* keywords)
+{
+    static char* keywordNames[] = { "image", "mode", "max_grey_level", "tile", NULL };
+    PyObject* object;
+    const char* modeName = "auto";
+    PyObject* maxGreyLevelObject = Py_None;
+    unsigned long tileSide = 0;
+    kodaImage image;
+    int bigEndian;
+    (void)self;
+
+    if (!PyArg_ParseTupleAndKeywords(args, keywords, "O|$sOk", keywordNames, &object, &modeName, &maxGreyLevelObject,
+                                     &tileSide))
+        return NULL;
+    if (kodaParseMode(modeName, &image.mode)) {
+        PyErr_Format(PyExc_ValueError, "unknown mode '%s'", modeName);
+        return NULL;
+    }
+    if (tileSide > UINT16_MAX) {
+        PyErr_SetString(PyExc_ValueError, "tile side must be between 1 and 65535");
+        return NULL;
+    }
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(object, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT)) return NULL;
+    if (describeBuffer(&view, &image, &bigEndian)) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    // Sample size follows max grey level, so it must agree with sample type of buffer
+    long maxGreyLevel = image.bytesPerSample == 1 ? 255 : 65535;
+    if (maxGreyLevelObject != Py_None) {
+        maxGreyLevel = PyLong_AsLong(maxGreyLevelObject);
+        if (maxGreyLevel == -1 && PyErr_Occurred()) {
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+    }
+    if (image.bytesPerSample == 1 ? maxGreyLevel < 1 || maxGreyLevel > 255 : maxGreyLevel < 256 || maxGreyLevel > 65535) {
+        PyErr_SetString(PyExc_ValueError, image.bytesPerSample == 1 ? "max_grey_level of uint8 image must be between 1 and 255"
+                                                                    : "max_grey_level of uint16 image must be between 256 and 65535");
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    image.maxGreyLevel = (uint16_t)maxGreyLevel;
+
+    // Coder reads 16 bit samples in big-endian order, other samples are coded in place
+    uint8_t* samples = (uint8_t*)view.buf;
+    uint64_t numberOfSamples = (uint64_t)image.width * image.height * image.channels;
+    uint8_t* swapped = NULL;
+    if (image.bytesPerSample == 2 && !bigEndian) {
+        swapped = (uint8_t*)PyMem_RawMalloc((size_t)numberOfSamples * 2);
+        if (!swapped) {
+            PyBuffer_Release(&view);
+            return PyErr_NoMemory();
+        }
+    }
+
+    uint8_t* compressed;
+    size_t compressedLength;
+    uint8_t status;
+    Py_BEGIN_ALLOW_THREADS
+    if (swapped) {
+        swapSamples(swapped, samples, numberOfSamples);
+        samples = swapped;
+    }
+    status = kodaEncode(samples, &image, (uint16_t)tileSide, &compressed, &compressedLength);
+    Py_END_ALLOW_THREADS
+    PyMem_RawFree(swapped);
+    PyBuffer_Release(&view);
+    if (status) {
+        PyErr_SetString(PyExc_RuntimeError, "compression failed");
+        return NULL;
+    }
+    PyObject* result = PyBytes_FromStringAndSize((const char*)compressed, (Py_ssize_t)compressedLength);
+    free(compressed);
+    return result;
+}
+
+/**
+  * @brief  Reads header of compressed file held in buffer.
+  * @param  view Pointer to buffer with compressed file
+  * @param  image Pointer to image description receiving header
+  * @retval 0 if header is valid, -1 with Python exception set otherwise
+  */
+static int readImage(const Py_buffer* view, kodaImage* image)
+{
+    if (kodaReadHeader((const uint8_t*)view->buf, (uint64_t)view->len, image)) {
+        PyErr_SetString(PyExc_ValueError, "invalid compressed file header");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject* decode(PyObject* self, PyObject* object)
+{
+    kodaImage image;
+    Py_buffer view;
+    (void)self;
+
+    if (PyObject_GetBuffer(object, &view, PyBUF_SIMPLE)) return NULL;
+    if (readImage(&view, &image)) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    if (image.dictionaryId) {
+        PyErr_SetString(PyExc_ValueError, "files compressed with dictionary are not supported");
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    uint64_t numberOfSamples = (uint64_t)image.width * image.height * image.channels;
+    if (numberOfSamples > (uint64_t)PY_SSIZE_T_MAX / image.bytesPerSample) {
+        PyBuffer_Release(&view);
+        return PyErr_NoMemory();
+    }
+    uint64_t length = numberOfSamples * image.bytesPerSample;
+
+    // Decoder writes straight into bytearray returned to caller
+    PyObject* pixels = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t)length);
+    if (!pixels) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    uint8_t* samples = (uint8_t*)PyByteArray_AS_STRING(pixels);
+    const uint16_t probe = 1;
+    int littleEndian = *(const uint8_t*)&probe == 1;
+    uint8_t status;
+    Py_BEGIN_ALLOW_THREADS
+    status = kodaDecode((const uint8_t*)view.buf, (uint64_t)view.len, samples, length);
+    if (!status && image.bytesPerSample == 2 && littleEndian)
+        swapSamples(samples, samples, numberOfSamples);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    if (status) {
+        Py_DECREF(pixels);
+        PyErr_SetString(PyExc_ValueError, "corrupt compressed file");
+        return NULL;
+    }
+
+    // Flat bytearray is viewed as rows, columns and channels of samples without copying
+    PyObject* flat = PyMemoryView_FromObject(pixels);
+    Py_DECREF(pixels);
+    if (!flat) return NULL;
+    PyObject* shape = image.channels == 1 ? Py_BuildValue("(kk)", (unsigned long)image.height, (unsigned long)image.width)
+                                          : Py_BuildValue("(kkk)", (unsigned long)image.height, (unsigned long)image.width,
+                                                          (unsigned long)image.channels);
+    PyObject* result = shape ? PyObject_CallMethod(flat, "cast", "sO", image.bytesPerSample == 1 ? "B" : "H", shape) : NULL;
+    Py_XDECREF(shape);
+    Py_DECREF(flat);
+    return result;
+}
+
+static PyObject* info(PyObject* self, PyObject* object)
+{
+    kodaImage image;
+    Py_buffer view;
+    (void)self;
+
+    if (PyObject_GetBuffer(object, &view, PyBUF_SIMPLE)) return NULL;
+    int status = readImage(&view, &image);
+    PyBuffer_Release(&view);
+    if (status) return NULL;
+    return Py_BuildValue("{s:k,s:k,s:i,s:i,s:s,s:i}", "width", (unsigned long)image.width, "height",
+                         (unsigned long)image.height, "max_grey_level", image.maxGreyLevel, "channels", image.channels,
+                         "mode", kodaModeName(image.mode), "dictionary_id", image.dictionaryId);
+}
+
+static PyMethodDef kodaMethods[] = {
+    { "encode", (PyCFunction)(void (*)(void))encode, METH_VARARGS | METH_KEYWORDS,
+      "encode(image, *, mode='auto', max_grey_level=None, tile=0) -> bytes\n\n"
+      "Compresses image of shape (height, width) or (height, width, 3) with uint8 or uint16 samples.\n"
+      "max_grey_level defaults to 255 or 65535, tile 0 keeps default tile side of coder." },
+    { "decode", decode, METH_O,
+      "decode(data) -> memoryview\n\n"
+      "Decompresses file into writable memoryview of shape (height, width) or (height, width, 3),\n"
+      "numpy.asarray() wraps it without copying." },
+    { "info", info, METH_O,
+      "info(data) -> dict\n\n"
+      "Reads width, height, max_grey_level, channels, mode and dictionary_id from file header." },
+    { NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef kodaModule = {
+    PyModuleDef_HEAD_INIT, "koda", "Lossless image codec: adaptive and static Huffman, range and run-length coding.", -1,
+    kodaMethods, NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_koda(void)
+{
+    return PyModule_Create(&kodaModule);
+}
@@ -0,0 +1,17 @@
+#!/bin/sh
+# Builds profile-guided optimised coder and decoder2c in build/pgo:
+#   1. instrumented build, 2. training run, 3. rebuild using collected profile.
+# Usage: scripts/buildPgo.sh [directory with training PGM images]
+set -eu
+
+cd "$(dirname "$0")/.."
+
+TRAINING_DIR="${1:-}"
+
+rm -rf build/pgo
+cmake --preset pgo-generate -DKODA_PGO_TRAINING_DIR="$TRAINING_DIR"
+cmake --build --preset pgo-generate
+cmake --build --preset pgo-train
+cmake --preset pgo-use -DKODA_PGO_TRAINING_DIR="$TRAINING_DIR"
+cmake --build --preset pgo-use
+ctest --preset pgo-use
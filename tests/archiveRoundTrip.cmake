@@ -0,0 +1,75 @@
+# Appends synthetic images to archive with several coder runs, the second one replacing one of
+# the images, and checks that the first run's bytes are kept intact, that directory lists
+# every image once, that copy of image is not stored again and that every image decompresses
+# from archive to the original.
+#
+# Required variables: GENERATOR, CODER, DECODER, WORK_DIR
+
+set(archive "${WORK_DIR}/images.kda")
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/first" "${WORK_DIR}/second")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+    set(output "${output}" PARENT_SCOPE)
+endfunction()
+
+# run:pattern:width:height:maxGreyLevel:channels, image named the same in both runs is replaced
+set(first "")
+set(second "")
+foreach(case IN ITEMS first:constant:64:64:255:1 first:gradient:512:512:255:1 first:checker:100:37:255:3
+                      second:skewed:300:200:4095:1 second:noise:256:256:255:1 second:gradient:200:100:255:1)
+    string(REPLACE ":" ";" case "${case}")
+    list(GET case 0 run)
+    list(GET case 1 pattern)
+    list(GET case 2 width)
+    list(GET case 3 height)
+    list(GET case 4 maxGreyLevel)
+    list(GET case 5 channels)
+    set(image "${WORK_DIR}/${run}/${pattern}.pgm")
+    run_step("${GENERATOR}" "${pattern}" "${width}" "${height}" 12345 "${image}" "${maxGreyLevel}" "${channels}")
+    list(APPEND ${run} "${image}")
+endforeach()
+
+run_step("${CODER}" --archive "${archive}" ${first})
+file(SIZE "${archive}" firstLength)
+file(READ "${archive}" firstBytes HEX)
+run_step("${CODER}" --mode periodic --archive "${archive}" "${WORK_DIR}/second/gradient.pgm")
+run_step("${CODER}" --archive "${archive}" "${WORK_DIR}/second/skewed.pgm" "${WORK_DIR}/second/noise.pgm")
+file(READ "${archive}" keptBytes LIMIT ${firstLength} HEX)
+if(NOT keptBytes STREQUAL firstBytes)
+    message(FATAL_ERROR "Appending changed bytes already in archive")
+endif()
+
+# Copy of image under other name refers to compressed file already in archive
+file(SIZE "${archive}" lengthBeforeCopy)
+file(COPY_FILE "${WORK_DIR}/second/noise.pgm" "${WORK_DIR}/second/copy.pgm")
+run_step("${CODER}" --archive "${archive}" "${WORK_DIR}/second/copy.pgm")
+file(SIZE "${archive}" lengthAfterCopy)
+math(EXPR growth "${lengthAfterCopy} - ${lengthBeforeCopy}")
+if(growth GREATER 4096)
+    message(FATAL_ERROR "Copy of image grew archive by ${growth} bytes")
+endif()
+
+run_step("${DECODER}" --list "${archive}")
+string(REGEX MATCHALL "[^\n]+" lines "${output}")
+list(LENGTH lines numberOfEntries)
+if(NOT numberOfEntries EQUAL 6 OR NOT output MATCHES "gradient.pgm\t200\t100\t1\t255\t8\t")
+    message(FATAL_ERROR "Unexpected archive directory:\n${output}")
+endif()
+
+foreach(image IN ITEMS first/constant first/checker second/skewed second/noise second/gradient second/copy)
+    get_filename_component(name "${image}" NAME)
+    set(decompressed "${WORK_DIR}/${name}_decom.pgm")
+    run_step("${DECODER}" --archive "${archive}" "${name}.pgm" "${decompressed}")
+    run_step("${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/${image}.pgm" "${decompressed}")
+endforeach()
+
+execute_process(COMMAND "${DECODER}" --archive "${archive}" missing.pgm "${WORK_DIR}/missing.pgm" RESULT_VARIABLE result
+                OUTPUT_QUIET ERROR_QUIET)
+if(result EQUAL 0)
+    message(FATAL_ERROR "Decoder extracted image missing from archive")
+endif()
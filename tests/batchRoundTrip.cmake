@@ -0,0 +1,44 @@
+# Compresses several synthetic images with single batch run of coder and checks that every
+# compressed file is identical to the one coder writes for the image alone and decompresses
+# to the original.
+#
+# Required variables: GENERATOR, CODER, DECODER, ENGINE, WORK_DIR
+
+set(outputDirectory "${WORK_DIR}/${ENGINE}")
+file(REMOVE_RECURSE "${outputDirectory}")
+file(MAKE_DIRECTORY "${outputDirectory}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+# pattern:width:height:maxGreyLevel:channels
+set(images "")
+foreach(case IN ITEMS constant:64:64:255:1 gradient:512:512:255:1 checker:100:37:255:3 skewed:300:200:4095:1
+                      noise:256:256:255:1 skewed:64:64:65535:3)
+    string(REPLACE ":" ";" case "${case}")
+    list(GET case 0 pattern)
+    list(GET case 1 width)
+    list(GET case 2 height)
+    list(GET case 3 maxGreyLevel)
+    list(GET case 4 channels)
+    set(image "${WORK_DIR}/${ENGINE}_${pattern}_${width}x${height}_${maxGreyLevel}x${channels}.pgm")
+    run_step("${GENERATOR}" "${pattern}" "${width}" "${height}" 12345 "${image}" "${maxGreyLevel}" "${channels}")
+    list(APPEND images "${image}")
+endforeach()
+
+# Queue shallower than batch and more threads than processors exercise waiting on both sides
+run_step("${CODER}" --io "${ENGINE}" --threads 3 --queue-depth 2 --batch "${outputDirectory}" ${images})
+foreach(image IN LISTS images)
+    get_filename_component(name "${image}" NAME_WE)
+    set(single "${WORK_DIR}/${name}_single.bin")
+    set(decompressed "${WORK_DIR}/${name}_decom.pgm")
+    run_step("${CODER}" "${image}" "${single}")
+    run_step("${CMAKE_COMMAND}" -E compare_files "${single}" "${outputDirectory}/${name}.bin")
+    file(REMOVE "${decompressed}")
+    run_step("${DECODER}" "${outputDirectory}/${name}.bin" "${decompressed}")
+    run_step("${CMAKE_COMMAND}" -E compare_files "${image}" "${decompressed}")
+endforeach()
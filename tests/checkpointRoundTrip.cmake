@@ -0,0 +1,39 @@
+# Compresses synthetic image in adaptive mode with checkpoint index, decompresses it with
+# several threads started at checkpoints and checks that decompressed file is identical to the
+# original. Index built by decoder2c from file compressed without index must be identical to
+# the one written by coder.
+#
+# Required variables: GENERATOR, CODER, DECODER, PATTERN, WIDTH, HEIGHT, MAX_GREY_LEVEL,
+# INTERVAL, WORK_DIR
+
+set(name "checkpoint_${PATTERN}_${WIDTH}x${HEIGHT}_${MAX_GREY_LEVEL}_${INTERVAL}")
+set(original "${WORK_DIR}/${name}.pgm")
+set(compressed "${WORK_DIR}/${name}.bin")
+set(index "${WORK_DIR}/${name}.kdx")
+set(plain "${WORK_DIR}/${name}_plain.bin")
+set(builtIndex "${WORK_DIR}/${name}_built.kdx")
+set(decompressed "${WORK_DIR}/${name}_decom.pgm")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 12345 "${original}" "${MAX_GREY_LEVEL}" 1)
+run_step("${CODER}" --mode adaptive --index "${index}" --checkpoint-interval "${INTERVAL}" "${original}" "${compressed}")
+foreach(threads 1 4)
+    file(REMOVE "${decompressed}")
+    run_step("${DECODER}" --index "${index}" --threads ${threads} "${compressed}" "${decompressed}")
+    run_step("${CMAKE_COMMAND}" -E compare_files "${original}" "${decompressed}")
+endforeach()
+
+# Index does not change compressed stream, so it can be built for files compressed before
+run_step("${CODER}" --mode adaptive "${original}" "${plain}")
+run_step("${CMAKE_COMMAND}" -E compare_files "${compressed}" "${plain}")
+file(REMOVE "${decompressed}")
+run_step("${DECODER}" --build-index "${builtIndex}" --checkpoint-interval "${INTERVAL}" "${plain}" "${decompressed}")
+run_step("${CMAKE_COMMAND}" -E compare_files "${original}" "${decompressed}")
+run_step("${CMAKE_COMMAND}" -E compare_files "${index}" "${builtIndex}")
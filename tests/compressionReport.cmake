@@ -0,0 +1,85 @@
+# Compresses synthetic images with single image run and with batch run of coder and checks
+# JSON and CSV reports against sizes of original and compressed files.
+#
+# Required variables: GENERATOR, CODER, WORK_DIR
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/batch")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+# Checks that JSON object of single image agrees with its compressed file
+function(check_entry json compressed samples)
+    file(SIZE "${compressed}" compressedBytes)
+    string(JSON reported GET "${json}" compressed_bytes)
+    string(JSON originalBytes GET "${json}" original_bytes)
+    string(JSON status GET "${json}" status)
+    if(NOT status STREQUAL "ok" OR NOT reported EQUAL compressedBytes OR NOT originalBytes EQUAL samples)
+        message(FATAL_ERROR "Report does not match ${compressed}: ${json}")
+    endif()
+endfunction()
+
+set(grey "${WORK_DIR}/grey.pgm")
+set(colour "${WORK_DIR}/colour.pgm")
+run_step("${GENERATOR}" skewed 300 200 1 "${grey}" 4095 1)
+run_step("${GENERATOR}" gradient 64 48 1 "${colour}" 255 3)
+
+run_step("${CODER}" --report "${WORK_DIR}/single.json" "${grey}" "${WORK_DIR}/grey.bin")
+file(READ "${WORK_DIR}/single.json" json)
+string(JSON entry GET "${json}" files 0)
+check_entry("${entry}" "${WORK_DIR}/grey.bin" 120000)
+string(JSON entropy GET "${entry}" entropy)
+string(JSON efficiency GET "${entry}" efficiency)
+if(NOT entropy GREATER 0 OR NOT efficiency GREATER 0)
+    message(FATAL_ERROR "Report lacks entropy or efficiency: ${entry}")
+endif()
+
+# Missing image fails batch, but is still reported
+execute_process(COMMAND "${CODER}" --report "${WORK_DIR}/batch.json" --batch "${WORK_DIR}/batch"
+                        "${grey}" "${WORK_DIR}/missing.pgm" "${colour}"
+                RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+if(result EQUAL 0)
+    message(FATAL_ERROR "Batch with missing image succeeded")
+endif()
+file(READ "${WORK_DIR}/batch.json" json)
+string(JSON files LENGTH "${json}" files)
+string(JSON failedImages GET "${json}" total failed)
+string(JSON missing GET "${json}" files 1 status)
+string(JSON totalBytes GET "${json}" total compressed_bytes)
+if(NOT files EQUAL 3 OR NOT failedImages EQUAL 1 OR NOT missing STREQUAL "failed")
+    message(FATAL_ERROR "Batch report does not count missing image: ${json}")
+endif()
+string(JSON entry GET "${json}" files 0)
+check_entry("${entry}" "${WORK_DIR}/batch/grey.bin" 120000)
+string(JSON entry GET "${json}" files 2)
+check_entry("${entry}" "${WORK_DIR}/batch/colour.bin" 9216)
+file(SIZE "${WORK_DIR}/batch/grey.bin" greyBytes)
+file(SIZE "${WORK_DIR}/batch/colour.bin" colourBytes)
+math(EXPR expectedBytes "${greyBytes} + ${colourBytes}")
+if(NOT totalBytes EQUAL expectedBytes)
+    message(FATAL_ERROR "Batch total ${totalBytes} differs from ${expectedBytes}")
+endif()
+
+# CSV report holds header, row of every image and total row, all with the same columns
+run_step("${CODER}" --report "${WORK_DIR}/batch.csv" --batch "${WORK_DIR}/batch" "${grey}" "${colour}")
+file(STRINGS "${WORK_DIR}/batch.csv" rows)
+list(LENGTH rows numberOfRows)
+if(NOT numberOfRows EQUAL 4)
+    message(FATAL_ERROR "CSV report has ${numberOfRows} rows instead of 4")
+endif()
+foreach(row IN LISTS rows)
+    string(REGEX REPLACE "[^,]" "" commas "${row}")
+    string(LENGTH "${commas}" columns)
+    if(NOT columns EQUAL 15)
+        message(FATAL_ERROR "CSV row has wrong number of columns: ${row}")
+    endif()
+endforeach()
+list(GET rows 3 total)
+if(NOT total MATCHES "^\"total\",0 failed,")
+    message(FATAL_ERROR "CSV report lacks total row: ${total}")
+endif()
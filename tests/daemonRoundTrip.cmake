@@ -0,0 +1,91 @@
+# Starts compression daemon and sends it encode and decode requests with client, over socket
+# and in shared memory. Daemon must compress images exactly as coder does and decompress files
+# of coder back to original images; broken request must not stop it.
+#
+# Required variables: GENERATOR, CODER, DAEMON, CLIENT, WORK_DIR
+# STEP=client runs requests while daemon started by first step is listening.
+
+set(socketPath "koda.sock")
+set(images grey_255x1 tiled_65535x1 colour_4095x3 single_255x1)
+
+if(STEP STREQUAL "client")
+    set(errors "")
+    function(request)
+        execute_process(COMMAND "${CLIENT}" ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+        if(NOT result EQUAL 0)
+            set(errors "${errors}Request failed (${result}): ${ARGN}\n${output}\n" PARENT_SCOPE)
+        endif()
+    endfunction()
+    function(compare expected actual)
+        execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${expected}" "${actual}" RESULT_VARIABLE different)
+        if(different)
+            set(errors "${errors}${actual} differs from ${expected}\n" PARENT_SCOPE)
+        endif()
+    endfunction()
+
+    foreach(transport IN ITEMS inline shared)
+        set(flags "")
+        if(transport STREQUAL "shared")
+            set(flags --shared)
+        endif()
+        foreach(image IN LISTS images)
+            request(${flags} ${socketPath} encode ${image}.pgm ${image}_${transport}.bin)
+            compare(${image}.bin ${image}_${transport}.bin)
+            request(${flags} ${socketPath} decode ${image}.bin ${image}_${transport}_decom.pgm)
+            compare(${image}.pgm ${image}_${transport}_decom.pgm)
+        endforeach()
+        # Repeated requests reuse contexts of the same worker
+        request(${flags} --repeat 20 --mode adaptive ${socketPath} encode grey_255x1.pgm grey_${transport}_adaptive.bin)
+        request(${flags} --repeat 20 ${socketPath} decode grey_${transport}_adaptive.bin grey_${transport}_adaptive.pgm)
+        compare(grey_255x1.pgm grey_${transport}_adaptive.pgm)
+
+        # Broken file fails its request only
+        execute_process(COMMAND "${CLIENT}" ${flags} ${socketPath} decode broken.bin broken.pgm
+                        RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+        if(result EQUAL 0)
+            set(errors "${errors}Broken file was decoded over ${transport} transport\n")
+        endif()
+    endforeach()
+
+    request(${socketPath} shutdown)
+    if(errors)
+        message(FATAL_ERROR "${errors}")
+    endif()
+    return()
+endif()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} WORKING_DIRECTORY "${WORK_DIR}" RESULT_VARIABLE result OUTPUT_VARIABLE output
+                    ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+run_step("${GENERATOR}" skewed 300 200 1 grey_255x1.pgm 255 1)
+run_step("${GENERATOR}" gradient 600 300 2 tiled_65535x1.pgm 65535 1)
+run_step("${GENERATOR}" noise 64 48 3 colour_4095x3.pgm 4095 3)
+run_step("${GENERATOR}" noise 1 1 4 single_255x1.pgm 255 1)
+foreach(image IN LISTS images)
+    run_step("${CODER}" ${image}.pgm ${image}.bin)
+endforeach()
+file(WRITE "${WORK_DIR}/broken.bin" "KDA broken")
+
+# Socket path is relative, because absolute path of build directory may not fit in socket
+# address; output of daemon goes to client step, which ignores it
+execute_process(COMMAND "${DAEMON}" --threads 2 ${socketPath}
+                COMMAND "${CMAKE_COMMAND}" -DSTEP=client -DCLIENT=${CLIENT} -P "${CMAKE_CURRENT_LIST_FILE}"
+                WORKING_DIRECTORY "${WORK_DIR}"
+                TIMEOUT 120
+                RESULTS_VARIABLE results
+                OUTPUT_VARIABLE output
+                ERROR_VARIABLE output)
+if(NOT results STREQUAL "0;0")
+    message(FATAL_ERROR "Daemon round trip failed (${results}):\n${output}")
+endif()
+if(EXISTS "${WORK_DIR}/${socketPath}")
+    message(FATAL_ERROR "Daemon did not remove its socket")
+endif()
@@ -0,0 +1,37 @@
+# Trains dictionary on synthetic images, compresses another image of the same kind with it,
+# decompresses it with decoder2c and the same dictionary and checks that decompressed file is
+# identical to the original. Decoding without dictionary must fail.
+#
+# Required variables: GENERATOR, CODER, DECODER, MODE, PATTERN, WIDTH, HEIGHT,
+# MAX_GREY_LEVEL, CHANNELS, WORK_DIR
+
+set(name "dictionary_${MODE}_${PATTERN}_${WIDTH}x${HEIGHT}_${MAX_GREY_LEVEL}x${CHANNELS}")
+set(dictionary "${WORK_DIR}/${name}.kdd")
+set(original "${WORK_DIR}/${name}.pgm")
+set(compressed "${WORK_DIR}/${name}.bin")
+set(decompressed "${WORK_DIR}/${name}_decom.pgm")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+set(training "")
+foreach(seed 1 2 3)
+    set(image "${WORK_DIR}/${name}_train${seed}.pgm")
+    run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" ${seed} "${image}" "${MAX_GREY_LEVEL}" "${CHANNELS}")
+    list(APPEND training "${image}")
+endforeach()
+run_step("${CODER}" --train-dictionary "${dictionary}" ${training})
+run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 12345 "${original}" "${MAX_GREY_LEVEL}" "${CHANNELS}")
+run_step("${CODER}" --mode "${MODE}" --dictionary "${dictionary}" "${original}" "${compressed}")
+run_step("${DECODER}" --dictionary "${dictionary}" "${compressed}" "${decompressed}")
+run_step("${CMAKE_COMMAND}" -E compare_files "${original}" "${decompressed}")
+
+execute_process(COMMAND "${DECODER}" "${compressed}" "${decompressed}" RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+if(result EQUAL 0)
+    message(FATAL_ERROR "File compressed with dictionary was decoded without it")
+endif()
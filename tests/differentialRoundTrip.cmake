@@ -0,0 +1,50 @@
+# Compresses synthetic image with coder in every mode and checks that decoder2c restores the
+# original exactly. Adaptive stream is also decoded by Python decoder, which must give the same
+# pixels as decoder2c.
+#
+# Required variables: GENERATOR, CODER, DECODER, PATTERN, WIDTH, HEIGHT, MAX_GREY_LEVEL, SEED,
+# WORK_DIR
+# Optional variables: PYTHON, PYTHON_DECODER (Python decoder is skipped without them)
+
+set(name "differential_${PATTERN}_${WIDTH}x${HEIGHT}_${MAX_GREY_LEVEL}_${SEED}")
+set(original "${WORK_DIR}/${name}.pgm")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" "${SEED}" "${original}" "${MAX_GREY_LEVEL}" 1)
+
+set(modes adaptive stored runlength tiled)
+# Static and range code handle only 8 bit samples
+if(MAX_GREY_LEVEL LESS_EQUAL 255)
+    list(APPEND modes static range)
+endif()
+foreach(mode IN LISTS modes)
+    set(compressed "${WORK_DIR}/${name}_${mode}.bin")
+    set(decompressed "${WORK_DIR}/${name}_${mode}_decom.pgm")
+    file(REMOVE "${decompressed}")
+    run_step("${CODER}" --mode ${mode} --tile 32 "${original}" "${compressed}")
+    run_step("${DECODER}" "${compressed}" "${decompressed}")
+    run_step("${CMAKE_COMMAND}" -E compare_files "${original}" "${decompressed}")
+endforeach()
+
+# Python decoder asks for input path and output name without extension on standard input,
+# native module koda is not used even where it is installed
+if(PYTHON AND PYTHON_DECODER)
+    set(ENV{KODA_PURE_PYTHON} 1)
+    set(pythonOutput "${WORK_DIR}/${name}_python")
+    file(REMOVE "${pythonOutput}.pgm")
+    file(WRITE "${WORK_DIR}/${name}_python.txt" "${WORK_DIR}/${name}_adaptive.bin\n${pythonOutput}\n")
+    execute_process(COMMAND "${PYTHON}" "${PYTHON_DECODER}"
+        INPUT_FILE "${WORK_DIR}/${name}_python.txt"
+        RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Python decoder failed (${result})\n${output}")
+    endif()
+    run_step("${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/${name}_adaptive_decom.pgm" "${pythonOutput}.pgm")
+endif()
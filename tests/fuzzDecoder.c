@@ -0,0 +1,26 @@
+#include "decoderOperations.h"
+#include "outputSink.h"
+
+// Larger images are rejected before decoding, so fuzzer does not stop on memory limit
+#define FUZZ_MAX_OUTPUT (1 << 24)
+
+/**
+  * @brief  Fuzzer entry point: decodes arbitrary compressed file into buffer of the size its
+  *         header declares. Decoder must reject malformed input without reading or writing
+  *         outside of its buffers.
+  * @param  data Contents of compressed file
+  * @param  size Length of compressed file
+  * @retval 0
+  */
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    tree* tree = createTreeFromMemory(data, size);
+    if (!tree) return 0;
+    uint64_t length = (uint64_t)tree->header.width * tree->header.height * tree->header.channels * tree->header.bytesPerSample;
+    uint8_t* pixels = length <= FUZZ_MAX_OUTPUT ? (uint8_t*)malloc(length ? length : 1) : NULL;
+    if (pixels && !useCallerBuffer(tree->output, pixels, length))
+        decodeData(tree);
+    freeTree(&tree);
+    free(pixels);
+    return 0;
+}
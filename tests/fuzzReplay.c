@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_MUTATIONS 200
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+/**
+  * @brief  Advances xorshift32 generator state and returns next pseudo random value.
+  * @param  state Pointer to generator state, must not be 0
+  * @retval Next pseudo random value
+  */
+static uint32_t nextRandom(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+  * @brief  Reads whole file into allocated buffer.
+  * @param  filePath Path to file
+  * @param  size Pointer to variable receiving length of file
+  * @retval Allocated contents of file, NULL if it cannot be read
+  */
+static uint8_t* readFile(const char* filePath, size_t* size)
+{
+    FILE* file = fopen(filePath, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    rewind(file);
+    uint8_t* data = length >= 0 ? malloc(length ? (size_t)length : 1) : NULL;
+    if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+}
+
+/**
+  * @brief  Runs fuzz target on seed file and on its mutations: truncations, bit flips, bytes
+  *         overwritten with random and extreme values, both in header and in payload.
+  * @param  seed Contents of seed file
+  * @param  size Length of seed file
+  * @param  mutations Number of random mutations
+  * @param  state Pointer to state of pseudo random generator
+  * @retval Number of inputs run
+  */
+static uint32_t replaySeed(const uint8_t* seed, size_t size, uint32_t mutations, uint32_t* state)
+{
+    uint8_t* input = malloc(size ? size : 1);
+    uint32_t runs = 0;
+    if (!input) return 0;
+
+    memcpy(input, seed, size);
+    LLVMFuzzerTestOneInput(input, size);
+    runs++;
+    for (uint32_t i = 0; i < mutations; i++) {
+        memcpy(input, seed, size);
+        size_t length = size;
+        // Mutations mostly hit header and start of payload, where lengths and modes are
+        size_t window = size < 64 || (nextRandom(state) & 1) ? size : 64;
+        switch (nextRandom(state) % 4) {
+        case 0:
+            length = size ? nextRandom(state) % size : 0;
+            break;
+        case 1:
+            for (uint32_t flips = 1 + nextRandom(state) % 4; flips && size; flips--)
+                input[nextRandom(state) % window] ^= (uint8_t)(1 << (nextRandom(state) % 8));
+            break;
+        case 2:
+            if (size)
+                input[nextRandom(state) % window] = (uint8_t)nextRandom(state);
+            break;
+        default:
+            if (size)
+                input[nextRandom(state) % window] = (nextRandom(state) & 1) ? 0xFF : 0x00;
+            break;
+        }
+        LLVMFuzzerTestOneInput(input, length);
+        runs++;
+    }
+    free(input);
+    return runs;
+}
+
+/**
+  * @brief  Runs fuzz target without libFuzzer, on given seed files and their deterministic
+  *         mutations, so compilers without libFuzzer check decoder on malformed input too.
+  */
+int main(int argc, char** argv)
+{
+    uint32_t mutations = DEFAULT_MUTATIONS;
+    uint32_t state = 12345;
+    uint32_t runs = 0;
+    int firstFile = 1;
+
+    if (argc > 2 && !strcmp(argv[1], "--mutations")) {
+        mutations = strtoul(argv[2], NULL, 10);
+        firstFile = 3;
+    }
+    if (firstFile >= argc) {
+        printf("Usage: %s [--mutations N] seed.bin...\n", argv[0]);
+        return 1;
+    }
+    for (int i = firstFile; i < argc; i++) {
+        size_t size;
+        uint8_t* seed = readFile(argv[i], &size);
+        if (!seed) {
+            printf("Error: Could not read %s\n", argv[i]);
+            return 1;
+        }
+        runs += replaySeed(seed, size, mutations, &state);
+        free(seed);
+    }
+    // Summary goes to stderr, so it is not lost among decoder messages
+    fprintf(stderr, "%u inputs decoded without crash\n", runs);
+    return 0;
+}
@@ -0,0 +1,48 @@
+# Builds seed corpus of files compressed in every mode and runs decoder fuzz target on seeds
+# and their deterministic mutations. Decoder must reject malformed files without crashing.
+#
+# Required variables: GENERATOR, CODER, REPLAY, MUTATIONS, SEED_DIR, WORK_DIR
+
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+# pattern:width:height:maxGreyLevel:channels
+set(seeds "")
+foreach(case IN ITEMS skewed:40:30:255:1 alternating:33:17:255:1 gradient:20:20:255:3 sweep:40:24:4095:1)
+    string(REPLACE ":" ";" case "${case}")
+    list(GET case 0 pattern)
+    list(GET case 1 width)
+    list(GET case 2 height)
+    list(GET case 3 maxGreyLevel)
+    list(GET case 4 channels)
+    set(image "${WORK_DIR}/${pattern}_${width}x${height}_${maxGreyLevel}x${channels}.pgm")
+    run_step("${GENERATOR}" "${pattern}" "${width}" "${height}" 12345 "${image}" "${maxGreyLevel}" "${channels}")
+    set(modes adaptive stored runlength tiled)
+    if(maxGreyLevel LESS_EQUAL 255)
+        list(APPEND modes static range pair bitplane bitplane-gray periodic)
+    endif()
+    foreach(mode IN LISTS modes)
+        set(seed "${WORK_DIR}/${pattern}_${width}x${height}_${maxGreyLevel}x${channels}_${mode}.bin")
+        set(coderOptions --mode ${mode})
+        # Bit-plane mode is replayed with samples coded plainly and in Gray code
+        if(mode STREQUAL "bitplane-gray")
+            set(coderOptions --mode bitplane --planes gray)
+        endif()
+        run_step("${CODER}" ${coderOptions} --tile 16 "${image}" "${seed}")
+        list(APPEND seeds "${seed}")
+    endforeach()
+endforeach()
+
+# Malformed streams that crashed decoder once: repeatedNewSymbol.bin sends symbol 0 as new
+# symbol 5000 times, which grew tree past its largest size; hugeTiledImage.bin has sides whose
+# image length wraps modulo 2^64, so small output buffer was written at unwrapped rows
+file(GLOB fixedSeeds "${SEED_DIR}/*.bin")
+list(APPEND seeds ${fixedSeeds})
+
+run_step("${REPLAY}" --mutations ${MUTATIONS} ${seeds})
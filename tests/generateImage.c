@@ -0,0 +1,74 @@
+#include "imageGenerator.h"
+
+/**
+  * @brief  Replaces rectangle of samples with noise, as if region of image was edited.
+  * @param  samples Buffer of image samples
+  * @param  width Number of columns of image
+  * @param  height Number of rows of image
+  * @param  seed Seed of noise
+  * @param  maxGreyLevel Maximum sample value
+  * @param  channels Number of interleaved channels
+  * @param  rectangle Text "row,column,rows,columns" of rectangle, clipped to image
+  * @retval 0 if rectangle was replaced, 1 otherwise
+  */
+static uint8_t patchSamples(uint8_t* samples, uint32_t width, uint32_t height, uint32_t seed, uint16_t maxGreyLevel,
+                            uint8_t channels, const char* rectangle)
+{
+    unsigned long row, column, rows, columns;
+    if (sscanf(rectangle, "%lu,%lu,%lu,%lu", &row, &column, &rows, &columns) != 4 || row >= height || column >= width) {
+        printf("Error: Patch must be row,column,rows,columns inside image\n");
+        return 1;
+    }
+    rows = rows < height - row ? rows : height - row;
+    columns = columns < width - column ? columns : width - column;
+    uint64_t pixelLength = (uint64_t)channels * (maxGreyLevel > 255 ? 2 : 1);
+    uint8_t* patch = malloc(rows * columns * pixelLength + 1);
+    if (!patch || generateSamples("noise", (uint32_t)columns, (uint32_t)rows, seed + 1000, maxGreyLevel, channels, patch)) {
+        free(patch);
+        return 1;
+    }
+    for (unsigned long i = 0; i < rows; i++)
+        memcpy(&samples[((row + i) * width + column) * pixelLength], &patch[i * columns * pixelLength], columns * pixelLength);
+    free(patch);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    // Optional leading "--patch row,column,rows,columns" replaces rectangle of image with noise
+    const char* program = argv[0];
+    const char* rectangle = argc > 2 && !strcmp(argv[1], "--patch") ? argv[2] : NULL;
+    if (rectangle) {
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 6 || argc == 7 || argc > 9) {
+        printf("Usage: %s [--patch row,column,rows,columns] <pattern> <width> <height> <seed> <output.pgm> [maxGreyLevel channels [comment]]\n", program);
+        return 1;
+    }
+    uint32_t width = strtoul(argv[2], NULL, 10);
+    uint32_t height = strtoul(argv[3], NULL, 10);
+    uint32_t seed = strtoul(argv[4], NULL, 10);
+    unsigned long maxGreyLevel = argc >= 8 ? strtoul(argv[6], NULL, 10) : 255;
+    unsigned long channels = argc >= 8 ? strtoul(argv[7], NULL, 10) : 1;
+    const char* comment = argc == 9 ? argv[8] : NULL;
+    if (!width || !height) {
+        printf("Error: Image dimensions must be positive\n");
+        return 1;
+    }
+    if (maxGreyLevel < 255 || maxGreyLevel > UINT16_MAX || (channels != 1 && channels != 3)) {
+        printf("Error: Max grey level must be between 255 and 65535, channels 1 or 3\n");
+        return 1;
+    }
+    uint64_t length = (uint64_t)width * height * channels * (maxGreyLevel > 255 ? 2 : 1);
+    uint8_t* samples = malloc(length);
+    if (!samples) {
+        printf("Error: Cannot allocate image\n");
+        return 1;
+    }
+    uint8_t status = generateSamples(argv[1], width, height, seed, (uint16_t)maxGreyLevel, (uint8_t)channels, samples) ||
+                     (rectangle && patchSamples(samples, width, height, seed, (uint16_t)maxGreyLevel, (uint8_t)channels, rectangle)) ||
+                     writePnm(argv[5], samples, width, height, (uint16_t)maxGreyLevel, (uint8_t)channels, comment);
+    free(samples);
+    return status;
+}
@@ -0,0 +1,134 @@
+#include "imageGenerator.h"
+
+/**
+  * @brief  Advances xorshift32 generator state and returns next pseudo random value.
+  * @param  state Pointer to generator state, must not be 0
+  * @retval Next pseudo random value
+  */
+static uint32_t nextRandom(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+uint8_t generateImage(const char* pattern, uint32_t width, uint32_t height, uint32_t seed, uint8_t* pixels)
+{
+    uint32_t state = seed ? seed : 1;
+    uint64_t numberOfPixels = (uint64_t)width * height;
+
+    if (!strcmp(pattern, "constant")) {
+        memset(pixels, nextRandom(&state) & 0xFF, numberOfPixels);
+        return 0;
+    }
+    for (uint32_t row = 0; row < height; row++) {
+        uint8_t* line = pixels + (uint64_t)row * width;
+        for (uint32_t col = 0; col < width; col++) {
+            if (!strcmp(pattern, "gradient")) {
+                line[col] = (uint8_t)((row + col) * 255 / (width + height));
+            } else if (!strcmp(pattern, "checker")) {
+                line[col] = ((row / 8 + col / 8) & 1) ? 255 : 0;
+            } else if (!strcmp(pattern, "skewed")) {
+                // Count trailing ones of random word -> P(k) = 2^-(k+1)
+                uint32_t random = nextRandom(&state);
+                uint8_t k = 0;
+                while ((random & 1) && k < 31) {
+                    random >>= 1;
+                    k++;
+                }
+                line[col] = (uint8_t)(128 + ((random & 2) ? k : -k));
+            } else if (!strcmp(pattern, "noise")) {
+                line[col] = nextRandom(&state) >> 24;
+            } else if (!strcmp(pattern, "distinct")) {
+                // Odd multiplier permutes values of every 256 consecutive pixels
+                line[col] = (uint8_t)(((uint64_t)row * width + col) * 167 + seed);
+            } else if (!strcmp(pattern, "alternating")) {
+                line[col] = ((row + col) & 1) ? 255 : 0;
+            } else if (!strcmp(pattern, "sweep")) {
+                uint8_t spread = (uint8_t)((uint64_t)row * 8 / height);
+                uint32_t random = nextRandom(&state);
+                uint8_t offset = (uint8_t)((random >> 8) & ((1u << spread) - 1));
+                line[col] = (uint8_t)((random & 1) ? 128 + offset : 128 - offset);
+            } else {
+                printf("Error: Unknown image pattern \"%s\"\n", pattern);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+uint8_t generateSamples(const char* pattern, uint32_t width, uint32_t height, uint32_t seed,
+                        uint16_t maxGreyLevel, uint8_t channels, uint8_t* samples)
+{
+    uint64_t numberOfPixels = (uint64_t)width * height;
+    uint8_t bytesPerSample = maxGreyLevel > 255 ? 2 : 1;
+    uint32_t lowLevels = (maxGreyLevel + 1u) / 256;
+    uint32_t state = seed ? seed : 1;
+
+    uint8_t* plane = malloc(numberOfPixels);
+    if (!plane) {
+        printf("Error: Cannot allocate image\n");
+        return 1;
+    }
+    for (uint8_t channel = 0; channel < channels; channel++) {
+        if (generateImage(pattern, width, height, seed + channel, plane)) {
+            free(plane);
+            return 1;
+        }
+        for (uint64_t pixel = 0; pixel < numberOfPixels; pixel++) {
+            uint8_t* sample = &samples[(pixel * channels + channel) * bytesPerSample];
+            if (bytesPerSample == 1) {
+                sample[0] = plane[pixel];
+                continue;
+            }
+            uint16_t value = plane[pixel] * lowLevels + nextRandom(&state) % lowLevels;
+            sample[0] = value >> 8;
+            sample[1] = value & 0xFF;
+        }
+    }
+    free(plane);
+    return 0;
+}
+
+uint8_t writePnm(const char* filePath, const uint8_t* samples, uint32_t width, uint32_t height,
+                 uint16_t maxGreyLevel, uint8_t channels, const char* comment)
+{
+    FILE* file = fopen(filePath, "wb");
+    if (!file) {
+        printf("Error: Could not create file %s\n", filePath);
+        return 1;
+    }
+    if (comment)
+        fprintf(file, "P%c # %s\n#%s\n \t%u\n# %s\n%u\r\n%u\n", channels == 3 ? '6' : '5', comment, comment,
+                width, comment, height, maxGreyLevel);
+    else
+        fprintf(file, "P%c\n%u %u\n%u\n", channels == 3 ? '6' : '5', width, height, maxGreyLevel);
+    uint64_t length = (uint64_t)width * height * channels * (maxGreyLevel > 255 ? 2 : 1);
+    if (fwrite(samples, 1, length, file) != length) {
+        printf("Error: Could not write pixels to %s\n", filePath);
+        fclose(file);
+        return 1;
+    }
+    return fclose(file) ? 1 : 0;
+}
+
+uint8_t writePgm(const char* filePath, const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    FILE* file = fopen(filePath, "wb");
+    if (!file) {
+        printf("Error: Could not create file %s\n", filePath);
+        return 1;
+    }
+    fprintf(file, "P5\n%u %u\n255\n", width, height);
+    uint64_t numberOfPixels = (uint64_t)width * height;
+    if (fwrite(pixels, 1, numberOfPixels, file) != numberOfPixels) {
+        printf("Error: Could not write pixels to %s\n", filePath);
+        fclose(file);
+        return 1;
+    }
+    return fclose(file) ? 1 : 0;
+}
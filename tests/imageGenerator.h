@@ -0,0 +1,72 @@
+#ifndef IMAGE_GENERATOR_H
+#define IMAGE_GENERATOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+  * @brief  Fills pixel buffer with synthetic image. Available patterns:
+  *         "constant" - every pixel has the same value,
+  *         "gradient" - smooth diagonal ramp,
+  *         "checker"  - 8x8 black and white squares,
+  *         "skewed"   - geometric distribution concentrated around one grey level,
+  *         "noise"    - uniformly distributed random pixels,
+  *         "distinct" - every 256 consecutive pixels hold all distinct values, in scrambled order,
+  *         "alternating" - neighbouring pixels alternate between 0 and 255,
+  *         "sweep"    - skewed distribution whose spread doubles every eighth of rows, from
+  *                      single grey level to uniform noise.
+  * @param  pattern Name of pattern to generate
+  * @param  width Number of columns of image
+  * @param  height Number of rows of image
+  * @param  seed Seed of pseudo random generator, equal seeds give equal images
+  * @param  pixels Buffer of width * height bytes receiving image
+  * @retval 0 if image was generated, 1 if pattern is unknown
+  */
+uint8_t generateImage(const char* pattern, uint32_t width, uint32_t height, uint32_t seed, uint8_t* pixels);
+
+/**
+  * @brief  Fills sample buffer with synthetic image of any sample size and number of channels.
+  *         Each channel is generated from pattern with its own seed. Samples above 8 bits
+  *         keep 8 bit pattern in their top bits and random lower bits, and are stored in
+  *         big-endian order, as in PGM and PPM files.
+  * @param  pattern Name of pattern to generate, see generateImage()
+  * @param  width Number of columns of image
+  * @param  height Number of rows of image
+  * @param  seed Seed of pseudo random generator
+  * @param  maxGreyLevel Maximum sample value, above 255 samples take 2 bytes
+  * @param  channels Number of interleaved channels
+  * @param  samples Buffer of width * height * channels samples receiving image
+  * @retval 0 if image was generated, 1 if pattern is unknown or memory allocation fails
+  */
+uint8_t generateSamples(const char* pattern, uint32_t width, uint32_t height, uint32_t seed,
+                        uint16_t maxGreyLevel, uint8_t channels, uint8_t* samples);
+
+/**
+  * @brief  Writes samples as binary PGM (P5) or, for 3 channels, PPM (P6) file. Header values
+  *         are separated by single line breaks, or, if comment is given, by comment lines
+  *         and mixed whitespace that readers must skip.
+  * @param  filePath Path to created file
+  * @param  samples Buffer of width * height * channels samples
+  * @param  width Number of columns of image
+  * @param  height Number of rows of image
+  * @param  maxGreyLevel Maximum sample value written to header
+  * @param  channels Number of channels, 1 or 3
+  * @param  comment Text of header comments, or NULL for plain header
+  * @retval 0 if file was written, 1 otherwise
+  */
+uint8_t writePnm(const char* filePath, const uint8_t* samples, uint32_t width, uint32_t height,
+                 uint16_t maxGreyLevel, uint8_t channels, const char* comment);
+
+/**
+  * @brief  Writes pixels as binary PGM (P5) file with 255 max grey level.
+  * @param  filePath Path to created file
+  * @param  pixels Buffer of width * height bytes
+  * @param  width Number of columns of image
+  * @param  height Number of rows of image
+  * @retval 0 if file was written, 1 otherwise
+  */
+uint8_t writePgm(const char* filePath, const uint8_t* pixels, uint32_t width, uint32_t height);
+
+#endif // IMAGE_GENERATOR_H
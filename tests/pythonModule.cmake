@@ -0,0 +1,30 @@
+# Compresses synthetic image with coder in every mode and checks that Python module koda gives
+# the same compressed files and decodes them to the original.
+#
+# Required variables: GENERATOR, CODER, PYTHON, MODULE_DIR, SCRIPT, PATTERN, WIDTH, HEIGHT,
+# MAX_GREY_LEVEL, CHANNELS, WORK_DIR
+
+set(name "python_${PATTERN}_${WIDTH}x${HEIGHT}_${MAX_GREY_LEVEL}x${CHANNELS}")
+set(original "${WORK_DIR}/${name}.pgm")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 1 "${original}" "${MAX_GREY_LEVEL}" "${CHANNELS}")
+
+set(modes auto adaptive stored runlength tiled)
+# Static and range code handle only 8 bit samples
+if(MAX_GREY_LEVEL LESS_EQUAL 255)
+    list(APPEND modes static range)
+endif()
+foreach(mode IN LISTS modes)
+    run_step("${CODER}" --mode ${mode} --tile 32 "${original}" "${WORK_DIR}/${name}_${mode}.bin")
+endforeach()
+
+run_step("${CMAKE_COMMAND}" -E env "PYTHONPATH=${MODULE_DIR}"
+         "${PYTHON}" "${SCRIPT}" "${original}" "${WORK_DIR}/${name}" ${modes})
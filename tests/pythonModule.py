@@ -0,0 +1,67 @@
+# Checks Python module koda against coder and decoder2c programs: encode() must give the same
+# compressed file as coder and decode() must restore pixels of the original image.
+#
+# Usage: pythonModule.py image.pgm compressed_prefix mode [mode...]
+# Compressed file of coder for every mode is expected at compressed_prefix_<mode>.bin
+import array
+import sys
+
+import koda
+
+def read_image(path):
+    with open(path, 'rb') as file:
+        content = file.read()
+    fields, position = [], 0
+    while len(fields) < 4:
+        while content[position:position + 1].isspace():
+            position += 1
+        if content[position:position + 1] == b'#':
+            position = content.index(b'\n', position)
+            continue
+        end = position
+        while not content[end:end + 1].isspace():
+            end += 1
+        fields.append(content[position:end])
+        position = end
+    width, height, max_grey_level = int(fields[1]), int(fields[2]), int(fields[3])
+    channels = 3 if fields[0] == b'P6' else 1
+    return width, height, max_grey_level, channels, content[position + 1:]
+
+def as_samples(raster, width, height, max_grey_level, channels):
+    shape = (height, width) if channels == 1 else (height, width, channels)
+    if max_grey_level <= 255:
+        return memoryview(bytearray(raster)).cast('B', shape)
+    samples = array.array('H', raster)
+    if sys.byteorder == 'little':
+        samples.byteswap()
+    return memoryview(samples).cast('B').cast('H', shape)
+
+def check(condition, message):
+    if not condition:
+        sys.exit(message)
+
+image_path, prefix, modes = sys.argv[1], sys.argv[2], sys.argv[3:]
+width, height, max_grey_level, channels, raster = read_image(image_path)
+samples = as_samples(raster, width, height, max_grey_level, channels)
+for mode in modes:
+    with open(prefix + '_' + mode + '.bin', 'rb') as file:
+        expected = file.read()
+    compressed = koda.encode(samples, mode=mode, max_grey_level=max_grey_level, tile=32)
+    check(compressed == expected, mode + ': encode() differs from coder')
+    header = koda.info(compressed)
+    check((header['width'], header['height'], header['max_grey_level'], header['channels'])
+          == (width, height, max_grey_level, channels), mode + ': wrong header ' + str(header))
+    decoded = koda.decode(compressed)
+    check(decoded.shape == samples.shape and decoded.format == samples.format, mode + ': wrong shape or format')
+    check(decoded.tobytes() == samples.tobytes(), mode + ': decode() does not restore image')
+
+try:
+    koda.decode(b'\x8bKDA\x02')
+    sys.exit('decode() accepted truncated header')
+except ValueError:
+    pass
+try:
+    koda.encode(memoryview(bytearray(4)))
+    sys.exit('encode() accepted one dimensional buffer')
+except ValueError:
+    pass
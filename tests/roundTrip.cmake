@@ -0,0 +1,60 @@
+# Generates synthetic image, compresses it with coder, decompresses it with
+# decoder2c and checks that decompressed file is identical to the original.
+#
+# Required variables: GENERATOR, CODER, DECODER, MODE, PATTERN, WIDTH, HEIGHT,
+# MAX_GREY_LEVEL, CHANNELS, WORK_DIR. Optional HEADER_COMMENT writes original with
+# comments in header, decompressed file is then compared with plain header image. Optional
+# OUTPUT selects output of decoder2c, optional SCAN selects scan order of coder, optional
+# PLANES selects coding of bit planes, optional TILE sets tile side and optional
+# CODER_OUTPUT is regular expression coder output must match.
+
+set(name "${MODE}_${PATTERN}_${WIDTH}x${HEIGHT}_${MAX_GREY_LEVEL}x${CHANNELS}")
+if(HEADER_COMMENT)
+    string(APPEND name "_comment")
+endif()
+set(decoderOptions "")
+set(coderOptions "")
+if(SCAN)
+    string(APPEND name "_${SCAN}")
+    set(coderOptions --scan "${SCAN}")
+endif()
+if(PLANES)
+    string(APPEND name "_${PLANES}")
+    list(APPEND coderOptions --planes "${PLANES}")
+endif()
+if(TILE)
+    string(APPEND name "_tile${TILE}")
+    list(APPEND coderOptions --tile "${TILE}")
+endif()
+if(OUTPUT)
+    string(APPEND name "_${OUTPUT}")
+    set(decoderOptions --output "${OUTPUT}")
+endif()
+set(original "${WORK_DIR}/${name}.pgm")
+set(compressed "${WORK_DIR}/${name}.bin")
+set(decompressed "${WORK_DIR}/${name}_decom.pgm")
+set(expected "${original}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+    set(output "${output}" PARENT_SCOPE)
+endfunction()
+
+if(HEADER_COMMENT)
+    set(expected "${WORK_DIR}/${name}_plain.pgm")
+    run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 12345 "${expected}" "${MAX_GREY_LEVEL}" "${CHANNELS}")
+    run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 12345 "${original}" "${MAX_GREY_LEVEL}" "${CHANNELS}" "${HEADER_COMMENT}")
+else()
+    run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 12345 "${original}" "${MAX_GREY_LEVEL}" "${CHANNELS}")
+endif()
+run_step("${CODER}" --mode "${MODE}" ${coderOptions} "${original}" "${compressed}")
+if(CODER_OUTPUT AND NOT output MATCHES "${CODER_OUTPUT}")
+    message(FATAL_ERROR "Coder output does not match \"${CODER_OUTPUT}\":\n${output}")
+endif()
+file(REMOVE "${decompressed}")
+run_step("${DECODER}" ${decoderOptions} "${compressed}" "${decompressed}")
+run_step("${CMAKE_COMMAND}" -E compare_files "${expected}" "${decompressed}")
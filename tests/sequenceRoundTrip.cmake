@@ -0,0 +1,53 @@
+# Compresses frames of synthetic image with moving noise rectangle into sequence, decodes all
+# frames and frames from middle of sequence, and checks that frame of other size is refused.
+#
+# Required variables: GENERATOR, CODER, DECODER, PATTERN, WIDTH, HEIGHT, MAX_GREY_LEVEL,
+# KEYFRAME_INTERVAL, AGE, PREDICT, WORK_DIR.
+
+set(frames 6)
+set(name "${PATTERN}_${WIDTH}x${HEIGHT}_${MAX_GREY_LEVEL}_key${KEYFRAME_INTERVAL}_age${AGE}_${PREDICT}")
+set(framePaths "")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+endfunction()
+
+math(EXPR lastFrame "${frames} - 1")
+foreach(frame RANGE ${lastFrame})
+    math(EXPR row "${frame} * ${HEIGHT} / ${frames}")
+    math(EXPR column "${frame} * ${WIDTH} / (2 * ${frames})")
+    math(EXPR rows "${HEIGHT} / 4 + 1")
+    math(EXPR columns "${WIDTH} / 3 + 1")
+    run_step("${GENERATOR}" --patch "${row},${column},${rows},${columns}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 12345
+             "${WORK_DIR}/${name}_${frame}.pgm" "${MAX_GREY_LEVEL}" 1)
+    list(APPEND framePaths "${WORK_DIR}/${name}_${frame}.pgm")
+endforeach()
+
+set(sequence "${WORK_DIR}/${name}.kds")
+run_step("${CODER}" --keyframe-interval "${KEYFRAME_INTERVAL}" --age "${AGE}" --predict "${PREDICT}" --sequence "${sequence}" ${framePaths})
+run_step("${DECODER}" --sequence "${sequence}" 0 ${frames} "${WORK_DIR}/${name}_all")
+foreach(frame RANGE ${lastFrame})
+    run_step("${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/${name}_${frame}.pgm" "${WORK_DIR}/${name}_all${frame}.pgm")
+endforeach()
+
+# Decoding from middle of sequence starts at keyframe before it and writes only asked frames
+run_step("${DECODER}" --sequence "${sequence}" 4 2 "${WORK_DIR}/${name}_seek")
+foreach(frame 4 5)
+    run_step("${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/${name}_${frame}.pgm" "${WORK_DIR}/${name}_seek${frame}.pgm")
+endforeach()
+if(EXISTS "${WORK_DIR}/${name}_seek3.pgm")
+    message(FATAL_ERROR "Decoder wrote frame that was not asked for")
+endif()
+
+# Frames must have size of first frame, tree carried between them would not fit otherwise
+math(EXPR otherWidth "${WIDTH} + 1")
+run_step("${GENERATOR}" "${PATTERN}" "${otherWidth}" "${HEIGHT}" 12345 "${WORK_DIR}/${name}_other.pgm" "${MAX_GREY_LEVEL}" 1)
+execute_process(COMMAND "${CODER}" --sequence "${WORK_DIR}/${name}_other.kds" "${WORK_DIR}/${name}_0.pgm" "${WORK_DIR}/${name}_other.pgm"
+                RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+if(result EQUAL 0)
+    message(FATAL_ERROR "Coder accepted frame of other size")
+endif()
@@ -0,0 +1,44 @@
+# Compresses synthetic image in tiled mode, replaces rectangle of it with noise, updates
+# compressed file from changed rectangle and checks that tiles outside it were copied, that
+# updated file decompresses to the changed image and that image of other size is refused.
+#
+# Required variables: GENERATOR, CODER, DECODER, PATTERN, WIDTH, HEIGHT, MAX_GREY_LEVEL,
+# CHANNELS, TILE, RECTANGLE, WORK_DIR. Optional SCAN selects scan order of coder.
+
+set(name "${PATTERN}_${WIDTH}x${HEIGHT}_${MAX_GREY_LEVEL}x${CHANNELS}_tile${TILE}")
+set(coderOptions --tile "${TILE}")
+if(SCAN)
+    string(APPEND name "_${SCAN}")
+    list(APPEND coderOptions --scan "${SCAN}")
+endif()
+set(original "${WORK_DIR}/${name}.pgm")
+set(changed "${WORK_DIR}/${name}_changed.pgm")
+set(decompressed "${WORK_DIR}/${name}_decom.pgm")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Command failed (${result}): ${ARGN}\n${output}")
+    endif()
+    set(output "${output}" PARENT_SCOPE)
+endfunction()
+
+run_step("${GENERATOR}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 12345 "${original}" "${MAX_GREY_LEVEL}" "${CHANNELS}")
+run_step("${GENERATOR}" --patch "${RECTANGLE}" "${PATTERN}" "${WIDTH}" "${HEIGHT}" 12345 "${changed}" "${MAX_GREY_LEVEL}" "${CHANNELS}")
+run_step("${CODER}" ${coderOptions} "${original}" "${WORK_DIR}/${name}.bin")
+run_step("${CODER}" --update "${WORK_DIR}/${name}.bin" --dirty "${RECTANGLE}" "${changed}" "${WORK_DIR}/${name}_updated.bin")
+if(NOT output MATCHES "[1-9][0-9]* reused")
+    message(FATAL_ERROR "No tile was copied from previous compressed file:\n${output}")
+endif()
+run_step("${DECODER}" "${WORK_DIR}/${name}_updated.bin" "${decompressed}")
+run_step("${CMAKE_COMMAND}" -E compare_files "${changed}" "${decompressed}")
+
+# Image must match previous compressed file, tiles copied from it would be wrong otherwise
+math(EXPR otherWidth "${WIDTH} + 1")
+run_step("${GENERATOR}" "${PATTERN}" "${otherWidth}" "${HEIGHT}" 12345 "${WORK_DIR}/${name}_other.pgm" "${MAX_GREY_LEVEL}" "${CHANNELS}")
+execute_process(COMMAND "${CODER}" --update "${WORK_DIR}/${name}.bin" "${WORK_DIR}/${name}_other.pgm" "${WORK_DIR}/${name}_other.bin"
+                RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+if(result EQUAL 0)
+    message(FATAL_ERROR "Coder updated compressed file of image of other size")
+endif()